@@ -232,8 +232,13 @@ function optimize.optimize( p, cores, outfit_list, params )
    params = params or eparams.default()
    params.goodness = params.goodness or optimize.goodness_default
    local sparams = optimize.sparams
+   if params.rnd == 0 and (sparams == nil or sparams.memo == nil) then
+      -- Without noise the same ship and parameters always give the same problem
+      sparams = tmerge( tmerge( {}, sparams ), { memo=true } )
+   end
    local pm = p:memory()
    pm.equipopt_params = params
+   optimize.solved = false
 
    -- Naked ship
    local ps = p:ship()
@@ -700,6 +705,9 @@ function optimize.optimize( p, cores, outfit_list, params )
       return false
    end
 
+   -- Bioships also depend on their simulated stage, so only the rest can be reused
+   optimize.solved = not pt.bioship
+
    -- Fill ammo
    p:fillAmmo()
 
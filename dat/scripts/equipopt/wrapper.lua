@@ -1,16 +1,46 @@
+local ai_setup = require "ai.core.setup"
+
 local equipopt = {}
 equipopt.optimize = require 'equipopt.optimize'
 equipopt.params   = require 'equipopt.params'
 equipopt.cores    = require 'equipopt.cores'
 
+--[[
+   Solving the loadout is expensive, so the engine keeps a pool of the ones
+   solved for each ship and set of arguments, and once it is full, pilots get
+   a random loadout from it instead.
+--]]
+local function pooled( name, equip )
+   return function( p, ... )
+      local data, key = p:equipPoolGet( name, ... )
+      if data then
+         local mem = p:memory()
+         mem.equip = data.equip
+         mem.equipopt_params = data.params
+         p:fillAmmo()
+         ai_setup.setup(p)
+         return true
+      end
+
+      local tstart = naev.clock()
+      equipopt.optimize.solved = false
+      local ret = equip( p, ... )
+      if key and ret and equipopt.optimize.solved then
+         local mem = p:memory()
+         p:equipPoolAdd( key, { equip=mem.equip, params=mem.equipopt_params }, naev.clock()-tstart )
+      end
+      return ret
+   end
+end
+
 -- Main equipment functions
-equipopt.generic  = require 'equipopt.templates.generic'
-equipopt.empire   = require 'equipopt.templates.empire'
-equipopt.zalek    = require 'equipopt.templates.zalek'
-equipopt.dvaered  = require 'equipopt.templates.dvaered'
-equipopt.sirius   = require 'equipopt.templates.sirius'
-equipopt.soromid  = require 'equipopt.templates.soromid'
-equipopt.pirate   = require 'equipopt.templates.pirate'
-equipopt.thurion  = require 'equipopt.templates.thurion'
-equipopt.proteron = require 'equipopt.templates.proteron'
+equipopt.generic  = pooled( "generic",  require 'equipopt.templates.generic' )
+equipopt.empire   = pooled( "empire",   require 'equipopt.templates.empire' )
+equipopt.zalek    = pooled( "zalek",    require 'equipopt.templates.zalek' )
+equipopt.dvaered  = pooled( "dvaered",  require 'equipopt.templates.dvaered' )
+equipopt.sirius   = pooled( "sirius",   require 'equipopt.templates.sirius' )
+equipopt.soromid  = pooled( "soromid",  require 'equipopt.templates.soromid' )
+equipopt.pirate   = pooled( "pirate",   require 'equipopt.templates.pirate' )
+equipopt.thurion  = pooled( "thurion",  require 'equipopt.templates.thurion' )
+equipopt.proteron = pooled( "proteron", require 'equipopt.templates.proteron' )
 return equipopt
@@ -74,6 +74,8 @@
 #include "conf.h"
 #include "array.h"
 #include "board.h"
+#include "camera.h"
+#include "equippool.h"
 #include "escort.h"
 #include "faction.h"
 #include "hook.h"
@@ -92,8 +94,10 @@
 #include "physics.h"
 #include "pilot.h"
 #include "player.h"
+#include "profile.h"
 #include "rng.h"
 #include "space.h"
+#include "start.h"
 
 /*
  * ai flags
@@ -108,11 +112,35 @@
 #define AI_SECONDARY    (1<<1)   /**< Firing secondary weapon */
 #define AI_DISTRESS     (1<<2)   /**< Sent distress signal. */
 
+/*
+ * Level of detail scheduling.
+ */
+#define AI_LOD_MARGIN   500.  /**< Margin around the view within which pilots count as on screen. */
+#define AI_LOD_DIST     5000. /**< Distance from the camera beyond which idle pilots think least often. */
+#define AI_LOD_STRIDE_OFFSCREEN  2 /**< Off screen pilots, fighting or close by, run their task once every this many frames. */
+#define AI_LOD_STRIDE_FAR        4 /**< Idle off screen pilots far away run their task once every this many frames. */
+
+/*
+ * Level of detail comparison.
+ */
+#define AI_LODCMP_TRIALS   16    /**< Battles fought per mode. */
+#define AI_LODCMP_SHIPS    5     /**< Ships per side. */
+#define AI_LODCMP_TIME     180.  /**< Longest a battle can last, in seconds. */
+#define AI_LODCMP_DT       (1./60.) /**< Time step of the battles. */
+#define AI_LODCMP_DIST     8000. /**< Distance of the battles from the camera, so they are off screen. */
+#define AI_LODCMP_SEED     1337u /**< Seed of the first battle. */
+#define AI_LODCMP_MAXT     3.    /**< Largest t statistic of the outcome differences still considered equivalent. */
+
 /*
  * all the AI profiles
  */
 static AI_Profile* profiles = NULL; /**< Array of AI_Profiles loaded. */
 static nlua_env equip_env = LUA_NOREF; /**< Equipment enviornment. */
+static unsigned int ai_frame  = 0; /**< Current AI frame, used to phase level of detail. */
+static int ai_ncalls          = 0; /**< Lua AI calls done this frame. */
+static int ai_nskipped        = 0; /**< Pilots that skipped their task this frame. */
+static int ai_ncalls_last     = 0; /**< Lua AI calls done last frame. */
+static int ai_nskipped_last   = 0; /**< Pilots that skipped their task last frame. */
 
 /*
  * prototypes
@@ -124,6 +152,8 @@ static void ai_setMemory (void);
 static void ai_create( Pilot* pilot );
 static int ai_loadEquip (void);
 static int ai_sort( const void *p1, const void *p2 );
+static double ai_phase( const Pilot *p );
+static int ai_lodStride( const Pilot *p );
 /* Task management. */
 static void ai_taskGC( Pilot* pilot );
 static Task* ai_createTask( lua_State *L, int subtask );
@@ -416,6 +446,7 @@ void ai_setPilot( Pilot *p )
  */
 static void ai_run( nlua_env env, int nargs )
 {
+   ai_ncalls++;
    if (nlua_pcall(env, nargs, 0)) { /* error has occurred */
       WARN( _("Pilot '%s' ai '%s' error: %s"), cur_pilot->name, cur_pilot->ai->name, lua_tostring(naevL,-1));
       lua_pop(naevL,1);
@@ -648,6 +679,11 @@ static int ai_loadProfile( AI_Profile *prof, const char* filename )
    }
    free(buf);
 
+   /* Control rate is a constant of the profile, so only look it up once. */
+   nlua_getenv(naevL, env, "control_rate");
+   prof->control_rate = lua_tonumber(naevL,-1);
+   lua_pop(naevL,1);
+
    /* Find and set up the necessary references. */
    str = _("AI Profile '%s' is missing '%s' function!");
    prof->ref_control = nlua_refenvtype( env, "control", LUA_TFUNCTION );
@@ -698,6 +734,226 @@ void ai_exit (void)
    equip_env = LUA_NOREF;
 }
 
+/**
+ * @brief Starts a new AI frame, should be called once before the pilots think.
+ */
+void ai_frameStart (void)
+{
+   ai_frame++;
+   ai_ncalls_last    = ai_ncalls;
+   ai_nskipped_last  = ai_nskipped;
+   ai_ncalls         = 0;
+   ai_nskipped       = 0;
+}
+
+/**
+ * @brief Gets the AI statistics of the last frame.
+ *
+ *    @param[out] calls Number of Lua AI calls done.
+ *    @param[out] skipped Number of pilots that skipped their task.
+ */
+void ai_getStats( int *calls, int *skipped )
+{
+   *calls   = ai_ncalls_last;
+   *skipped = ai_nskipped_last;
+}
+
+/**
+ * @brief Outcome of a level of detail comparison battle.
+ */
+typedef struct AILodBattle_ {
+   int survivors[2]; /**< Ships left of each side. */
+   double armour;    /**< Armour left of the first side, in fractions of a ship. */
+   double time;      /**< Time until a side was eliminated. */
+   double calls;     /**< Lua AI calls done. */
+   double skipped;   /**< Tasks skipped. */
+} AILodBattle;
+
+/**
+ * @brief Fights a seeded battle off screen.
+ *
+ *    @param seed Seed of the battle.
+ *    @param[out] out Outcome of the battle.
+ */
+static void ai_lodBattle( unsigned int seed, AILodBattle *out )
+{
+   const char *fname[2] = { "Empire", "Pirate" };
+   const char *sname[2] = { "Empire Shark", "Pirate Shark" };
+   PilotFlags flags;
+   double cx, cy;
+
+   memset( out, 0, sizeof(AILodBattle) );
+   pilots_cleanAll();
+   equippool_clear();
+   rng_seed( seed );
+   pilot_clearFlagsRaw( flags );
+
+   /* Both sides face each other well off screen. */
+   cam_getPos( &cx, &cy );
+   for (int s=0; s<2; s++) {
+      int f = faction_get( fname[s] );
+      const Ship *ship = ship_get( sname[s] );
+      for (int i=0; i<AI_LODCMP_SHIPS; i++) {
+         vec2 pos, vel;
+         double a = (s==0) ? 0. : M_PI;
+         vec2_cset( &pos, cx + AI_LODCMP_DIST + 750.*cos(a+M_PI) + RNGF()*200.,
+               cy + (i-AI_LODCMP_SHIPS/2)*200. );
+         vec2_cset( &vel, 0., 0. );
+         pilot_create( ship, NULL, f, faction_default_ai(f), a, &pos, &vel,
+               flags, 0, 0 );
+      }
+   }
+
+   /* Fight until a side is eliminated. */
+   for (out->time=0.; out->time<AI_LODCMP_TIME; out->time+=AI_LODCMP_DT) {
+      int calls, skipped;
+      Pilot *const* pilots;
+
+      update_routine( AI_LODCMP_DT, 0 );
+      ai_getStats( &calls, &skipped );
+      out->calls   += calls;
+      out->skipped += skipped;
+
+      out->survivors[0] = out->survivors[1] = 0;
+      out->armour = 0.;
+      pilots = pilot_getAll();
+      for (int i=0; i<array_size(pilots); i++) {
+         const Pilot *p = pilots[i];
+         if (pilot_isFlag(p, PILOT_DEAD) || pilot_isFlag(p, PILOT_DELETE))
+            continue;
+         for (int s=0; s<2; s++) {
+            if (p->faction != faction_get( fname[s] ))
+               continue;
+            out->survivors[s]++;
+            if (s==0)
+               out->armour += p->armour / p->armour_max;
+         }
+      }
+      if ((out->survivors[0]==0) || (out->survivors[1]==0))
+         break;
+   }
+}
+
+/**
+ * @brief Fights the same seeded battles off screen with and without the AI
+ *        level of detail and compares the outcomes.
+ *
+ * The comparison uses a Welch t test on the surviving ships of the first
+ * side, anything beyond AI_LODCMP_MAXT counts as a change in the outcomes.
+ *
+ *    @return 0 if the outcomes are equivalent.
+ */
+int ai_lodCompare (void)
+{
+   double mean[2], var[2], t;
+   int old_lod   = conf.ai_lod;
+   int old_spawn = space_spawn;
+
+   space_spawn = 0;
+   space_init( start_system(), 0 );
+
+   for (int m=0; m<2; m++) {
+      AILodBattle b;
+      double surv[AI_LODCMP_TRIALS];
+      double wins = 0., armour = 0., time = 0., calls = 0., skipped = 0.;
+      Uint64 tstart = SDL_GetPerformanceCounter();
+      double wall;
+
+      conf.ai_lod = m;
+      mean[m] = var[m] = 0.;
+      for (int i=0; i<AI_LODCMP_TRIALS; i++) {
+         ai_lodBattle( AI_LODCMP_SEED+i, &b );
+         surv[i]  = b.survivors[0] - b.survivors[1];
+         mean[m] += surv[i];
+         wins    += (b.survivors[1]==0) ? 1. : 0.;
+         armour  += b.armour;
+         time    += b.time;
+         calls   += b.calls;
+         skipped += b.skipped;
+      }
+      wall = (double)(SDL_GetPerformanceCounter() - tstart) / (double)SDL_GetPerformanceFrequency();
+      mean[m] /= AI_LODCMP_TRIALS;
+      for (int i=0; i<AI_LODCMP_TRIALS; i++)
+         var[m] += pow2(surv[i]-mean[m]);
+      var[m] /= AI_LODCMP_TRIALS-1;
+
+      LOG(_("AI level of detail %s: %.0f/%d won, %.2f ship lead, %.2f armour left, %.1f s per battle, %.0f AI calls and %.0f skipped tasks per battle, %.3f s wall time"),
+            m ? _("on") : _("off"), wins, AI_LODCMP_TRIALS, mean[m],
+            armour / AI_LODCMP_TRIALS, time / AI_LODCMP_TRIALS,
+            calls / AI_LODCMP_TRIALS, skipped / AI_LODCMP_TRIALS, wall );
+   }
+
+   pilots_cleanAll();
+   conf.ai_lod = old_lod;
+   space_spawn = old_spawn;
+
+   /* Identical outcomes have no variance, nothing to test. */
+   if (var[0]+var[1] <= 0.)
+      t = (mean[0]==mean[1]) ? 0. : INFINITY;
+   else
+      t = (mean[1]-mean[0]) / sqrt( (var[0]+var[1]) / AI_LODCMP_TRIALS );
+   if (FABS(t) > AI_LODCMP_MAXT) {
+      WARN(_("AI level of detail changes battle outcomes (t = %.2f)"), t);
+      return -1;
+   }
+   LOG(_("AI level of detail battle outcomes are equivalent (t = %.2f)"), t);
+   return 0;
+}
+
+/**
+ * @brief Gets a pseudo-random phase of a pilot derived from its ID.
+ *
+ *    @param p Pilot to get phase of.
+ *    @return Phase in the (0,1] range.
+ */
+static double ai_phase( const Pilot *p )
+{
+   /* Knuth multiplicative hash, so consecutive IDs get spread out. */
+   unsigned int h = p->id * 2654435761u;
+   return (double)((h >> 24) + 1) / 256.;
+}
+
+/**
+ * @brief Gets how often a pilot runs its task, depending on how relevant it
+ *        is to the player.
+ *
+ * There are three tiers:
+ *  - The player, escorts, scripted pilots and anything on screen think every
+ *    frame.
+ *  - Off screen pilots that are fighting or close by think every
+ *    AI_LOD_STRIDE_OFFSCREEN frames.
+ *  - Idle off screen pilots far away think every AI_LOD_STRIDE_FAR frames.
+ *
+ *    @param p Pilot to check.
+ *    @return Number of frames between runs of the task.
+ */
+static int ai_lodStride( const Pilot *p )
+{
+   double cx, cy, dx, dy, z;
+
+   if (!conf.ai_lod)
+      return 1;
+
+   /* Player, escorts and scripted pilots always think. */
+   if (pilot_isFlag(p, PILOT_PLAYER) || pilot_isWithPlayer(p) ||
+         pilot_isFlag(p, PILOT_MANUAL_CONTROL))
+      return 1;
+
+   /* Pilots on screen always think. */
+   cam_getPos( &cx, &cy );
+   z  = cam_getZoom();
+   dx = FABS( p->solid->pos.x-cx );
+   dy = FABS( p->solid->pos.y-cy );
+   if ((dx < SCREEN_W/(2.*z) + AI_LOD_MARGIN) && (dy < SCREEN_H/(2.*z) + AI_LOD_MARGIN))
+      return 1;
+
+   /* Off screen pilots in combat or close by. */
+   if ((p->target != p->id) || (pow2(dx) + pow2(dy) < pow2(AI_LOD_DIST)))
+      return AI_LOD_STRIDE_OFFSCREEN;
+
+   return AI_LOD_STRIDE_FAR;
+}
+
 /**
  * @brief Heart of the AI, brains of the pilot.
  *
@@ -715,6 +971,17 @@ void ai_think( Pilot* pilot, const double dt )
    if (pilot->ai == NULL)
       return;
 
+   /* Off screen pilots keep their last thrust, turn and weapon sets on
+    * skipped frames, but control ticks always run on time. The pilots are
+    * spread over the frames by their ID. */
+   t = ai_curTask( pilot );
+   if ((pilot->tcontrol >= 0.) && (t != NULL) &&
+         ((ai_frame + pilot->id) % ai_lodStride( pilot ) != 0)) {
+      ai_nskipped++;
+      return;
+   }
+
+   NPROFILE_ZONE_DYN( "ai", pilot->ai->name );
    ai_setPilot(pilot);
    env = cur_pilot->ai->env; /* set the AI profile to the current pilot's */
 
@@ -730,26 +997,28 @@ void ai_think( Pilot* pilot, const double dt )
    if (cur_pilot->id != PLAYER_ID)
       pilot_weapSetAIClear( cur_pilot );
 
-   /* Get current task. */
-   t = ai_curTask( cur_pilot );
-
    /* control function if pilot is idle or tick is up */
    if ((cur_pilot->tcontrol < 0.) || (t == NULL)) {
-      double crate;
-      nlua_getenv(naevL, env, "control_rate");
-      crate = lua_tonumber(naevL,-1);
-      lua_pop(naevL,1);
+      double crate = cur_pilot->ai->control_rate;
+      double elapsed = (cur_pilot->tcontrol_len > 0.) ? cur_pilot->tcontrol_len : crate;
+      elapsed -= cur_pilot->tcontrol;
       if (pilot_isFlag(pilot,PILOT_PLAYER) ||
           pilot_isFlag(cur_pilot, PILOT_MANUAL_CONTROL)) {
          lua_rawgeti( naevL, LUA_REGISTRYINDEX, cur_pilot->ai->ref_control_manual );
-         lua_pushnumber( naevL, crate-cur_pilot->tcontrol );
+         lua_pushnumber( naevL, elapsed );
          ai_run(env, 1);
       } else {
          lua_rawgeti( naevL, LUA_REGISTRYINDEX, cur_pilot->ai->ref_control );
-         lua_pushnumber( naevL, crate-cur_pilot->tcontrol );
+         lua_pushnumber( naevL, elapsed );
          ai_run(env, 1); /* run control */
       }
-      cur_pilot->tcontrol = crate;
+      /* The first tick is shortened by a per-pilot phase so that pilots
+       * created together don't all run their control on the same frame. */
+      if (cur_pilot->tcontrol_len > 0.)
+         cur_pilot->tcontrol_len = crate;
+      else
+         cur_pilot->tcontrol_len = crate * ai_phase( cur_pilot );
+      cur_pilot->tcontrol = cur_pilot->tcontrol_len;
 
       /* Task may have changed due to control tick. */
       t = ai_curTask( cur_pilot );
@@ -46,6 +46,7 @@ typedef struct AI_Profile_ {
    int ref_control_manual; /**< Profile manual control reference function. */
    int ref_refuel;   /**< Profile refuel reference function. */
    int ref_create;   /**< Run when pilot is created (or initialized in the case of persistent pilots). */
+   double control_rate; /**< Time between control ticks, from the "control_rate" global. */
 } AI_Profile;
 
 /*
@@ -82,5 +83,8 @@ void ai_hail( Pilot* recipient );
 void ai_refuel( Pilot* refueler, unsigned int target );
 void ai_getDistress( Pilot *p, const Pilot *distressed, const Pilot *attacker );
 void ai_think( Pilot* pilot, const double dt );
+void ai_frameStart (void);
+void ai_getStats( int *calls, int *skipped );
+int ai_lodCompare (void);
 void ai_setPilot( Pilot *p );
 void ai_init( Pilot *p );
@@ -671,7 +671,7 @@ static int asteroid_loadPLG( AsteroidType *temp, const char *buf )
    polygon->npt = 0;
 
    /* See if the file does exist. */
-   if (!PHYSFS_exists(file)) {
+   if (!ndata_exists(file)) {
       WARN(_("%s xml collision polygon does not exist!\n \
                Please use the script 'polygon_from_sprite.py'\n \
                This file can be found in Naev's artwork repo."), file);
@@ -71,11 +71,10 @@ typedef struct CommodityPrice_ {
    double sysPeriod; /** Major time period */
    double spobVariation; /**< Mmount by which a commodity price varies */
    double sysVariation; /**< System level commodity price variation.  At a given time, commodity price is equal to price + sysVariation*sin(2pi t/sysPeriod) + spobVariation*sin(2pi t/spobPeriod) */
-   int64_t updateTime; /**< used for averaging and to hold the time last average was calculated. */
-   char *name;     /**< used for keeping tabs during averaging */
+   int64_t updateTime; /**< used to hold the time last average was calculated. */
    double sum;     /**< used when averaging over jump points during setup, and then for capturing the moving average when the player visits a spob. */
    double sum2;    /**< sum of (squared prices seen), used for calc of standard deviation. */
-   int cnt;        /**< used for calc of mean and standard deviation - number of records in the data. */
+   int cnt;        /**< used for calc of mean and standard deviation - number of records in the data. Number of spobs averaged during setup. */
 } CommodityPrice;
 
 /*
@@ -103,6 +103,18 @@ static void print_usage( void )
    LOG(_("   -s f, --svol f        sets the sound volume to f"));
    LOG(_("   -d, --datapath        adds a new datapath to be mounted (i.e., appends it to the search path for game assets)"));
    LOG(_("   -X, --scale           defines the scale factor"));
+   LOG(_("   --build-datapack      packs the XML data into the cache for faster loading and exits"));
+   LOG(_("   --no-datapack         loads the XML data even if the data pack is up to date"));
+   LOG(_("   --universe-digest     logs a digest of the loaded data and the load time and exits"));
+   LOG(_("   --ai-lod-compare      fights seeded battles with and without the AI level of detail, compares them and exits"));
+   LOG(_("   --lua-gc-test         fights a battle collecting Lua garbage every frame, checks it keeps to the budget and exits"));
+   LOG(_("   --save-test           saves a new pilot in the background and synchronously, checks both are identical and exits"));
+   LOG(_("   --profile f           profiles from the start and writes a Chrome trace to f at exit"));
+   LOG(_("   --record f            records the input, random seed and frame timing to f"));
+   LOG(_("   --replay f            plays back the session recorded in f and exits"));
+   LOG(_("   --replay-headless     doesn't render while playing back"));
+   LOG(_("   --replay-uncapped     doesn't limit the frame rate while playing back"));
+   LOG(_("   --replay-test         runs a scripted session to record or play back and exits"));
 #ifdef DEBUGGING
    LOG(_("   --devmode             enables dev mode perks like the editors"));
 #endif /* DEBUGGING */
@@ -142,6 +154,7 @@ void conf_setDefaults (void)
    conf.font_size_intro   = FONT_SIZE_INTRO_DEFAULT;
    conf.font_size_def     = FONT_SIZE_DEF_DEFAULT;
    conf.font_size_small   = FONT_SIZE_SMALL_DEFAULT;
+   conf.font_sdf_legacy   = 0;
 
    /* Misc. */
    conf.redirect_file = 1;
@@ -150,6 +163,22 @@ void conf_setDefaults (void)
    conf.devautosave  = 0;
    conf.lua_enet     = 0;
    conf.lua_repl     = 0;
+   conf.lua_gc_budget = 1.;
+   conf.datapack     = 1;
+   conf.datapack_build = 0;
+   conf.universe_digest = 0;
+   conf.ai_lod_compare = 0;
+   conf.lua_gc_test = 0;
+   conf.save_test = 0;
+   conf.profile_trace = NULL;
+   conf.replay_record = NULL;
+   conf.replay_play  = NULL;
+   conf.replay_headless = 0;
+   conf.replay_uncapped = 0;
+   conf.replay_test = 0;
+   conf.ai_lod       = 1;
+   conf.equip_pool   = 8;
+   conf.jump_warmup  = 1;
    conf.lastversion = strdup( "" );
    conf.translation_warning_seen = 0;
 
@@ -200,6 +229,7 @@ void conf_setAudioDefaults (void)
    /* Sound. */
    conf.al_efx       = USE_EFX_DEFAULT;
    conf.nosound      = MUTE_SOUND_DEFAULT;
+   conf.sound_lazy   = 0;
    conf.sound        = SOUND_VOLUME_DEFAULT;
    conf.music        = MUSIC_VOLUME_DEFAULT;
    conf.engine_vol   = ENGINE_VOLUME_DEFAULT;
@@ -360,6 +390,7 @@ int conf_loadConfig ( const char* file )
       /* Sound. */
       conf_loadBool( lEnv, "al_efx", conf.al_efx );
       conf_loadBool( lEnv, "nosound", conf.nosound );
+      conf_loadBool( lEnv, "sound_lazy", conf.sound_lazy );
       conf_loadFloat( lEnv, "sound", conf.sound );
       conf_loadFloat( lEnv, "music", conf.music );
       conf_loadFloat( lEnv, "engine_vol", conf.engine_vol );
@@ -397,6 +428,7 @@ int conf_loadConfig ( const char* file )
       conf_loadInt( lEnv, "font_size_intro", conf.font_size_intro );
       conf_loadInt( lEnv, "font_size_def", conf.font_size_def );
       conf_loadInt( lEnv, "font_size_small", conf.font_size_small );
+      conf_loadBool( lEnv, "font_sdf_legacy", conf.font_sdf_legacy );
 
       /* Misc. */
       conf_loadString( lEnv, "difficulty", conf.difficulty );
@@ -414,7 +446,12 @@ int conf_loadConfig ( const char* file )
       conf_loadBool( lEnv, "devautosave", conf.devautosave );
       conf_loadBool( lEnv, "lua_enet", conf.lua_enet );
       conf_loadBool( lEnv, "lua_repl", conf.lua_repl );
+      conf_loadFloat( lEnv, "lua_gc_budget", conf.lua_gc_budget );
       conf_loadBool( lEnv, "conf_nosave", conf.nosave );
+      conf_loadBool( lEnv, "datapack", conf.datapack );
+      conf_loadBool( lEnv, "ai_lod", conf.ai_lod );
+      conf_loadInt( lEnv, "equip_pool", conf.equip_pool );
+      conf_loadBool( lEnv, "jump_warmup", conf.jump_warmup );
       conf_loadString( lEnv, "lastversion", conf.lastversion );
       conf_loadBool( lEnv, "translation_warning_seen", conf.translation_warning_seen );
 
@@ -564,6 +601,18 @@ void conf_parseCLI( int argc, char** argv )
 #ifdef DEBUGGING
       { "devmode", no_argument, 0, 'D' },
 #endif /* DEBUGGING */
+      { "build-datapack", no_argument, 0, 'P' },
+      { "no-datapack", no_argument, 0, 'K' },
+      { "universe-digest", no_argument, 0, 'G' },
+      { "ai-lod-compare", no_argument, 0, 'A' },
+      { "lua-gc-test", no_argument, 0, 'C' },
+      { "save-test", no_argument, 0, 'B' },
+      { "profile", required_argument, 0, 'T' },
+      { "record", required_argument, 0, 'R' },
+      { "replay", required_argument, 0, 'Y' },
+      { "replay-headless", no_argument, 0, 'L' },
+      { "replay-uncapped", no_argument, 0, 'U' },
+      { "replay-test", no_argument, 0, 'E' },
       { "help", no_argument, 0, 'h' },
       { "version", no_argument, 0, 'v' },
       { NULL, 0, 0, 0 } };
@@ -631,6 +680,48 @@ void conf_parseCLI( int argc, char** argv )
             break;
 #endif /* DEBUGGING */
 
+         case 'P':
+            conf.datapack_build = 1;
+            break;
+         case 'K':
+            conf.datapack = 0;
+            break;
+         case 'G':
+            conf.universe_digest = 1;
+            break;
+         case 'A':
+            conf.ai_lod_compare = 1;
+            break;
+         case 'C':
+            conf.lua_gc_test = 1;
+            break;
+         case 'B':
+            conf.save_test = 1;
+            break;
+
+         case 'T':
+            free(conf.profile_trace);
+            conf.profile_trace = strdup(optarg);
+            break;
+
+         case 'R':
+            free(conf.replay_record);
+            conf.replay_record = strdup(optarg);
+            break;
+         case 'Y':
+            free(conf.replay_play);
+            conf.replay_play = strdup(optarg);
+            break;
+         case 'L':
+            conf.replay_headless = 1;
+            break;
+         case 'U':
+            conf.replay_uncapped = 1;
+            break;
+         case 'E':
+            conf.replay_test = 1;
+            break;
+
          case 'v':
             /* by now it has already displayed the version */
             exit(EXIT_SUCCESS);
@@ -938,6 +1029,10 @@ int conf_saveConfig ( const char* file )
    conf_saveBool("nosound",conf.nosound);
    conf_saveEmptyLine();
 
+   conf_saveComment(_("Decode sound effects the first time they are played instead of at start up"));
+   conf_saveBool("sound_lazy",conf.sound_lazy);
+   conf_saveEmptyLine();
+
    conf_saveComment(_("Volume of sound effects and music, between 0.0 and 1.0"));
    conf_saveFloat("sound",(sound_disabled) ? conf.sound : sound_getVolume());
    conf_saveFloat("music",(music_disabled) ? conf.music : music_getVolume());
@@ -1005,6 +1100,8 @@ int conf_saveConfig ( const char* file )
    conf_saveInt("font_size_def",conf.font_size_def);
    pos += scnprintf(&buf[pos], sizeof(buf)-pos, _("-- Small size: %d\n"), FONT_SIZE_SMALL_DEFAULT);
    conf_saveInt("font_size_small",conf.font_size_small);
+   conf_saveComment(_("Generate glyph distance fields with the old, slower, anti-aliasing aware transform"));
+   conf_saveBool("font_sdf_legacy",conf.font_sdf_legacy);
 
    /* Misc. */
    conf_saveComment(_("Sets the velocity (px/s) to compress up to when time compression is enabled."));
@@ -1061,10 +1158,30 @@ int conf_saveConfig ( const char* file )
    conf_saveBool("lua_repl",conf.lua_repl);
    conf_saveEmptyLine();
 
+   conf_saveComment(_("Time in milliseconds to spend collecting Lua garbage after every frame, 0 leaves it all to Lua"));
+   conf_saveFloat("lua_gc_budget",conf.lua_gc_budget);
+   conf_saveEmptyLine();
+
    conf_saveComment(_("Save the config every time game exits (rewriting this bit)"));
    conf_saveInt("conf_nosave",conf.nosave);
    conf_saveEmptyLine();
 
+   conf_saveComment(_("Load the XML data from the precompiled data pack when it is up to date"));
+   conf_saveBool("datapack",conf.datapack);
+   conf_saveEmptyLine();
+
+   conf_saveComment(_("Let idle pilots far away from the camera run their AI less often"));
+   conf_saveBool("ai_lod",conf.ai_lod);
+   conf_saveEmptyLine();
+
+   conf_saveComment(_("Number of solved loadouts to keep and reuse per NPC ship and equipment parameters, 0 solves every pilot"));
+   conf_saveInt("equip_pool",conf.equip_pool);
+   conf_saveEmptyLine();
+
+   conf_saveComment(_("Fast forward the simulation of a system when jumping in with larger time steps and no collisions"));
+   conf_saveBool("jump_warmup",conf.jump_warmup);
+   conf_saveEmptyLine();
+
    conf_saveComment(_("Indicates the last version the game has run in before"));
    conf_saveString("lastversion", conf.lastversion);
    conf_saveEmptyLine();
@@ -1181,6 +1298,9 @@ void conf_copy( PlayerConf_t *dest, const PlayerConf_t *src )
    STRDUP(dev_save_sys);
    STRDUP(dev_save_map);
    STRDUP(dev_save_spob);
+   STRDUP(profile_trace);
+   STRDUP(replay_record);
+   STRDUP(replay_play);
    if (src->difficulty != NULL)
       STRDUP(difficulty);
 #undef STRDUP
@@ -1199,6 +1319,9 @@ void conf_free( PlayerConf_t *config )
    free(config->dev_save_sys);
    free(config->dev_save_map);
    free(config->dev_save_spob);
+   free(config->profile_trace);
+   free(config->replay_record);
+   free(config->replay_play);
    free(config->difficulty);
 
    /* Clear memory. */
@@ -103,6 +103,7 @@ typedef struct PlayerConf_s {
    /* Sound. */
    int al_efx; /**< Should EFX extension be used? (only applicable for OpenAL) */
    int nosound; /**< Whether or not sound is on. */
+   int sound_lazy; /**< Decode sound effects on first use instead of at start up. */
    double sound; /**< Sound level for sound effects. */
    double music; /**< Sound level for music. */
    double engine_vol; /**< Sound level for engines (relative). */
@@ -140,6 +141,7 @@ typedef struct PlayerConf_s {
    int font_size_intro;   /**< Intro text font size. */
    int font_size_def;     /**< Default large font size. */
    int font_size_small;   /**< Default small font size. */
+   int font_sdf_legacy;   /**< Use the old double precision distance transform for glyphs. */
 
    /* Misc. */
    char *difficulty; /**< Global difficulty setting. */
@@ -157,7 +159,23 @@ typedef struct PlayerConf_s {
    int devautosave; /**< Developer mode autosave. */
    int lua_enet; /**< Enable the lua-enet library. */
    int lua_repl; /**< Enable the experimental CLI based on lua-repl. */
+   double lua_gc_budget; /**< Time in ms to spend collecting Lua garbage every frame. */
    int nosave; /**< Disables conf saving. */
+   int datapack; /**< Use the precompiled data pack when it matches the data. */
+   int datapack_build; /**< Build the data pack and exit, only set from the CLI. */
+   int universe_digest; /**< Log a digest of the loaded universe and exit, only set from the CLI. */
+   int ai_lod_compare; /**< Compare battles with and without the AI level of detail and exit, only set from the CLI. */
+   int lua_gc_test; /**< Check that Lua garbage collection keeps to its budget in a battle and exit, only set from the CLI. */
+   int save_test; /**< Check that background and synchronous saves are identical and exit, only set from the CLI. */
+   char *profile_trace; /**< Profile from the start and write the trace there at exit, only set from the CLI. */
+   char *replay_record; /**< Record the session to this replay, only set from the CLI. */
+   char *replay_play; /**< Play back the session from this replay, only set from the CLI. */
+   int replay_headless; /**< Don't render when playing back, only set from the CLI. */
+   int replay_uncapped; /**< Don't limit the frame rate when playing back, only set from the CLI. */
+   int replay_test; /**< Run the scripted session of the replay test and exit, only set from the CLI. */
+   int ai_lod; /**< Far away idle pilots run their AI tasks less often. */
+   int equip_pool; /**< Solved NPC loadouts to keep per ship and equipment parameters, 0 disables. */
+   int jump_warmup; /**< Fast forward the system simulation when jumping in. */
    char *lastversion; /**< The last version the game was ran in. */
    int translation_warning_seen; /**< No need to warn about incomplete game translations again. */
 
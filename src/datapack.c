@@ -0,0 +1,1187 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file datapack.c
+ *
+ * @brief Precompiled pack of the XML data loaded at start up.
+ *
+ * Loading the universe opens, reads and parses thousands of small XML files
+ *  through PhysicsFS and libxml2. The data pack stores all of them already
+ *  parsed, as a preorder dump of their document trees, in a single file in the
+ *  cache directory. It is memory mapped while loading and xml_parsePhysFS()
+ *  rebuilds the documents straight from it, skipping both the file system and
+ *  the XML tokenizer. Documents using XML features the dump does not cover
+ *  (DTDs, namespaces, entity references...) are stored as text and parsed as
+ *  usual.
+ *
+ * The pack is keyed on a manifest of the data: the game version, the path,
+ *  size and modification time of every entry of the search path, and the name
+ *  of every packed file along with where it comes from. Files from mounted
+ *  directories also add their own size and modification time, so adding,
+ *  removing or editing any of them makes the pack out of date. The file list
+ *  comes from the ndata index, so this only takes a stat per packed file.
+ *
+ * The pack is built with the --build-datapack command line option and has the
+ *  following native endian layout:
+ *  - DataPackHeader
+ *  - DataPackRecord[nrecords], sorted by file name
+ *  - String table with the NUL-terminated file names
+ *  - Record contents, each aligned to 8 bytes
+ *
+ * A tree record is a list of nodes ended by DATAPACK_END. Each node is its
+ *  type byte followed by:
+ *  - DATAPACK_ELEMENT: the name, the number of attributes (u32), the name and
+ *    value of each attribute and then the list of children.
+ *  - DATAPACK_TEXT, DATAPACK_CDATA and DATAPACK_COMMENT: the content.
+ *  Strings are their length (u32) followed by the bytes and a NUL.
+ */
+/** @cond */
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#if HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif /* HAVE_SYS_MMAN_H */
+
+#include "physfs.h"
+
+#include "naev.h"
+/** @endcond */
+
+#include "datapack.h"
+
+#include "array.h"
+#include "commodity.h"
+#include "conf.h"
+#include "faction.h"
+#include "log.h"
+#include "ndata.h"
+#include "nfile.h"
+#include "nstring.h"
+#include "outfit.h"
+#include "ship.h"
+#include "shipstats.h"
+#include "space.h"
+#include "tech.h"
+
+#define DATAPACK_MAGIC        "NAEVPAK" /**< Magic at the start of the pack, including the NUL. */
+#define DATAPACK_BYTEORDER    0x01020304 /**< Used to detect packs written on a different endianness. */
+#define DATAPACK_ALIGN(x)     (((x)+7) & ~((uint64_t)7)) /**< Aligns offsets to 8 bytes. */
+#define DATAPACK_HASH_INIT    14695981039346656037ULL /**< Initial value of the FNV-1a hash. */
+
+/*
+ * Record kinds.
+ */
+#define DATAPACK_RAW       0 /**< XML text, parsed as usual. */
+#define DATAPACK_TREE      1 /**< Dump of the parsed document tree. */
+
+/*
+ * Node types of the tree records.
+ */
+#define DATAPACK_END       0 /**< End of a list of nodes. */
+#define DATAPACK_ELEMENT   1 /**< Element node. */
+#define DATAPACK_TEXT      2 /**< Text node. */
+#define DATAPACK_CDATA     3 /**< CDATA section. */
+#define DATAPACK_COMMENT   4 /**< Comment. */
+
+/**
+ * @brief Header of the data pack.
+ */
+typedef struct DataPackHeader_ {
+   char magic[8];       /**< DATAPACK_MAGIC. */
+   uint32_t version;    /**< DATAPACK_VERSION. */
+   uint32_t byteorder;  /**< DATAPACK_BYTEORDER. */
+   uint64_t manifest;   /**< Hash of the manifest of the data the pack was built from. */
+   uint32_t nrecords;   /**< Number of packed files. */
+   uint32_t padding;    /**< Unused, keeps the layout explicit. */
+   uint64_t records;    /**< Offset of the record table. */
+   uint64_t strings;    /**< Offset of the string table. */
+   uint64_t data;       /**< Offset of the record contents. */
+   uint64_t size;       /**< Total size of the pack. */
+} DataPackHeader;
+
+/**
+ * @brief A single file in the data pack.
+ */
+typedef struct DataPackRecord_ {
+   uint32_t name;       /**< Offset of the name in the string table. */
+   uint32_t namelen;    /**< Length of the name, without the NUL. */
+   uint32_t kind;       /**< DATAPACK_RAW or DATAPACK_TREE. */
+   uint32_t padding;    /**< Unused, keeps the layout explicit. */
+   uint64_t offset;     /**< Offset of the contents in the data section. */
+   uint64_t size;       /**< Size of the contents. */
+} DataPackRecord;
+
+/**
+ * @brief Growing buffer a tree record is dumped into.
+ */
+typedef struct DataPackBuf_ {
+   char *data;    /**< Contents. */
+   size_t len;    /**< Used length. */
+   size_t size;   /**< Allocated size. */
+} DataPackBuf;
+
+/**
+ * @brief Cursor over a tree record.
+ */
+typedef struct DataPackReader_ {
+   const char *p;    /**< Current position. */
+   const char *end;  /**< End of the record. */
+} DataPackReader;
+
+/**
+ * @brief Data directories whose XML files get packed.
+ */
+static const char *datapack_dirs[] = {
+   COMMODITY_DATA_PATH,
+   FACTION_DATA_PATH,
+   OUTFIT_DATA_PATH,
+   SHIP_DATA_PATH,
+   SPOB_DATA_PATH,
+   SYSTEM_DATA_PATH,
+   TECH_DATA_PATH,
+   VIRTUALSPOB_DATA_PATH,
+   NULL
+};
+
+/*
+ * The currently open pack.
+ */
+static char *datapack_mem     = NULL; /**< Contents of the pack. */
+static size_t datapack_size   = 0; /**< Size of the pack. */
+static int datapack_mapped    = 0; /**< Whether the pack is memory mapped or read into memory. */
+static const DataPackRecord *datapack_records = NULL; /**< Record table. */
+static const char *datapack_strings = NULL; /**< String table. */
+static const char *datapack_data = NULL; /**< Record contents. */
+static int datapack_nrecords  = 0; /**< Number of records. */
+
+/*
+ * Prototypes.
+ */
+static char **datapack_listFiles (void);
+static uint64_t datapack_hashData( uint64_t h, const void *data, size_t len );
+static uint64_t datapack_hashStr( uint64_t h, const char *s );
+static uint64_t datapack_hashInt( uint64_t h, int64_t i );
+static uint64_t datapack_hashNum( uint64_t h, double d );
+static uint64_t datapack_hashPath( uint64_t h, const char *path );
+static uint64_t datapack_manifest( char *const *files );
+static void datapack_path( char *path, size_t len );
+static int datapack_pad( FILE *f, uint64_t len );
+/* Tree records. */
+static void datapack_bufPut( DataPackBuf *b, const void *data, size_t len );
+static void datapack_bufByte( DataPackBuf *b, uint8_t c );
+static void datapack_bufStr( DataPackBuf *b, const xmlChar *s );
+static int datapack_dumpNodes( DataPackBuf *b, xmlNodePtr node );
+static int datapack_readU32( DataPackReader *r, uint32_t *v );
+static const xmlChar *datapack_readStr( DataPackReader *r, uint32_t *len );
+static int datapack_loadNodes( DataPackReader *r, xmlDocPtr doc, xmlNodePtr parent );
+static const xmlChar *datapack_attrValue( xmlAttrPtr attr );
+static int datapack_cmpNodes( xmlNodePtr a, xmlNodePtr b );
+/* Pack. */
+static int datapack_map( const char *path );
+static int datapack_check (void);
+static int datapack_cmp( const void *key, const void *elem );
+static const DataPackRecord *datapack_find( const char *filename );
+/* Universe digest. */
+static uint64_t datapack_hashStats( uint64_t h, const ShipStatList *ll );
+static uint64_t datapack_hashTags( uint64_t h, char *const *tags );
+static uint64_t datapack_hashTech( uint64_t h, const tech_group_t *tech );
+static uint64_t datapack_hashPresence( uint64_t h, const SpobPresence *p );
+
+/**
+ * @brief Lists all the XML files that go into the pack.
+ *
+ *    @return Sorted array of file names (must be freed).
+ */
+static char **datapack_listFiles (void)
+{
+   char **files = array_create( char* );
+   for (int i=0; datapack_dirs[i]!=NULL; i++) {
+      char **list = ndata_listRecursive( datapack_dirs[i] );
+      for (int j=0; j<array_size(list); j++) {
+         if (ndata_matchExt( list[j], "xml" ))
+            array_push_back( &files, list[j] );
+         else
+            free( list[j] );
+      }
+      array_free( list );
+   }
+   qsort( files, array_size(files), sizeof(char*), strsort );
+   return files;
+}
+
+/**
+ * @brief Adds data to a 64 bit FNV-1a hash.
+ */
+static uint64_t datapack_hashData( uint64_t h, const void *data, size_t len )
+{
+   const unsigned char *p = data;
+   for (size_t i=0; i<len; i++) {
+      h ^= p[i];
+      h *= 1099511628211ULL;
+   }
+   return h;
+}
+
+/**
+ * @brief Adds a string, which may be NULL, to a hash.
+ */
+static uint64_t datapack_hashStr( uint64_t h, const char *s )
+{
+   if (s == NULL)
+      return datapack_hashData( h, "\xff", 1 );
+   return datapack_hashData( h, s, strlen(s)+1 );
+}
+
+/**
+ * @brief Adds an integer to a hash.
+ */
+static uint64_t datapack_hashInt( uint64_t h, int64_t i )
+{
+   return datapack_hashData( h, &i, sizeof(i) );
+}
+
+/**
+ * @brief Adds a number to a hash.
+ */
+static uint64_t datapack_hashNum( uint64_t h, double d )
+{
+   return datapack_hashData( h, &d, sizeof(d) );
+}
+
+/**
+ * @brief Adds a path and the size and modification time of what it points to
+ *        to a hash.
+ */
+static uint64_t datapack_hashPath( uint64_t h, const char *path )
+{
+   struct stat st;
+   h = datapack_hashStr( h, path );
+   if (stat( path, &st ) != 0)
+      return datapack_hashInt( h, -1 );
+   h = datapack_hashInt( h, st.st_size );
+   return datapack_hashInt( h, st.st_mtime );
+}
+
+/**
+ * @brief Hashes the manifest of the data the pack is built from.
+ *
+ * Archives are covered by their own size and modification time, files in
+ * mounted directories by theirs.
+ *
+ *    @param files Files that go into the pack, from datapack_listFiles().
+ *    @return Hash of the manifest.
+ */
+static uint64_t datapack_manifest( char *const *files )
+{
+   uint64_t h = DATAPACK_HASH_INIT;
+   char **search = PHYSFS_getSearchPath();
+   int *isdir = array_create( int );
+
+   h = datapack_hashStr( h, naev_version(1) );
+   for (char **p=search; *p!=NULL; p++) {
+      h = datapack_hashPath( h, *p );
+      array_push_back( &isdir, nfile_dirExists( *p ) );
+   }
+   for (int i=0; i<array_size(files); i++) {
+      const char *dir = PHYSFS_getRealDir( files[i] );
+      int j;
+      h = datapack_hashStr( h, files[i] );
+      h = datapack_hashStr( h, dir );
+      if (dir == NULL)
+         continue;
+      for (j=0; search[j]!=NULL; j++)
+         if (strcmp( search[j], dir ) == 0)
+            break;
+      if ((search[j] != NULL) && isdir[j]) {
+         char path[PATH_MAX];
+         snprintf( path, sizeof(path), "%s/%s", dir, files[i] );
+         h = datapack_hashPath( h, path );
+      }
+   }
+   array_free( isdir );
+   PHYSFS_freeList( search );
+   return h;
+}
+
+/**
+ * @brief Gets the path of the data pack.
+ */
+static void datapack_path( char *path, size_t len )
+{
+   snprintf( path, len, "%s"DATAPACK_FILE, nfile_cachePath() );
+}
+
+/**
+ * @brief Writes up to 7 bytes of zero padding.
+ */
+static int datapack_pad( FILE *f, uint64_t len )
+{
+   static const char zero[8] = { 0 };
+   if (len == 0)
+      return 0;
+   return (fwrite( zero, 1, len, f ) != len);
+}
+
+/**
+ * @brief Appends data to a buffer.
+ */
+static void datapack_bufPut( DataPackBuf *b, const void *data, size_t len )
+{
+   if (b->len+len > b->size) {
+      b->size = MAX( 2*b->size, b->len+len+1024 );
+      b->data = realloc( b->data, b->size );
+   }
+   memcpy( &b->data[ b->len ], data, len );
+   b->len += len;
+}
+
+/**
+ * @brief Appends a byte to a buffer.
+ */
+static void datapack_bufByte( DataPackBuf *b, uint8_t c )
+{
+   datapack_bufPut( b, &c, 1 );
+}
+
+/**
+ * @brief Appends a string, which may be NULL for an empty one, to a buffer.
+ */
+static void datapack_bufStr( DataPackBuf *b, const xmlChar *s )
+{
+   uint32_t len = (s==NULL) ? 0 : (uint32_t)xmlStrlen( s );
+   datapack_bufPut( b, &len, sizeof(len) );
+   if (len > 0)
+      datapack_bufPut( b, s, len );
+   datapack_bufByte( b, '\0' );
+}
+
+/**
+ * @brief Dumps a list of sibling nodes and their children.
+ *
+ *    @param b Buffer to dump into.
+ *    @param node First node of the list.
+ *    @return 0 on success, -1 if a node can't be dumped.
+ */
+static int datapack_dumpNodes( DataPackBuf *b, xmlNodePtr node )
+{
+   for (xmlNodePtr n=node; n!=NULL; n=n->next) {
+      uint32_t nattr;
+      switch (n->type) {
+         case XML_ELEMENT_NODE:
+            if ((n->ns != NULL) || (n->nsDef != NULL))
+               return -1;
+            nattr = 0;
+            for (xmlAttrPtr a=n->properties; a!=NULL; a=a->next) {
+               if ((a->ns != NULL) || ((a->children != NULL) &&
+                     ((a->children->type != XML_TEXT_NODE) || (a->children->next != NULL))))
+                  return -1;
+               nattr++;
+            }
+            datapack_bufByte( b, DATAPACK_ELEMENT );
+            datapack_bufStr( b, n->name );
+            datapack_bufPut( b, &nattr, sizeof(nattr) );
+            for (xmlAttrPtr a=n->properties; a!=NULL; a=a->next) {
+               datapack_bufStr( b, a->name );
+               datapack_bufStr( b, datapack_attrValue( a ) );
+            }
+            if (datapack_dumpNodes( b, n->children ))
+               return -1;
+            break;
+
+         case XML_TEXT_NODE:
+            datapack_bufByte( b, DATAPACK_TEXT );
+            datapack_bufStr( b, n->content );
+            break;
+
+         case XML_CDATA_SECTION_NODE:
+            datapack_bufByte( b, DATAPACK_CDATA );
+            datapack_bufStr( b, n->content );
+            break;
+
+         case XML_COMMENT_NODE:
+            datapack_bufByte( b, DATAPACK_COMMENT );
+            datapack_bufStr( b, n->content );
+            break;
+
+         default:
+            return -1;
+      }
+   }
+   datapack_bufByte( b, DATAPACK_END );
+   return 0;
+}
+
+/**
+ * @brief Reads a 32 bit number from a tree record.
+ */
+static int datapack_readU32( DataPackReader *r, uint32_t *v )
+{
+   if ((size_t)(r->end - r->p) < sizeof(*v))
+      return -1;
+   memcpy( v, r->p, sizeof(*v) );
+   r->p += sizeof(*v);
+   return 0;
+}
+
+/**
+ * @brief Reads a string from a tree record.
+ *
+ *    @return The NUL-terminated string, pointing into the pack, or NULL if the
+ *            record is corrupt.
+ */
+static const xmlChar *datapack_readStr( DataPackReader *r, uint32_t *len )
+{
+   const char *s;
+   if (datapack_readU32( r, len ))
+      return NULL;
+   if (((size_t)(r->end - r->p) <= *len) || (r->p[ *len ] != '\0'))
+      return NULL;
+   s = r->p;
+   r->p += *len+1;
+   return (const xmlChar*) s;
+}
+
+/**
+ * @brief Rebuilds a list of sibling nodes and their children.
+ *
+ *    @param r Record to read from.
+ *    @param doc Document being rebuilt.
+ *    @param parent Node to add the list to.
+ *    @return 0 on success.
+ */
+static int datapack_loadNodes( DataPackReader *r, xmlDocPtr doc, xmlNodePtr parent )
+{
+   while (r->p < r->end) {
+      const xmlChar *s, *name;
+      uint32_t len, nattr;
+      xmlNodePtr n;
+      uint8_t type = *r->p++;
+
+      switch (type) {
+         case DATAPACK_END:
+            return 0;
+
+         case DATAPACK_ELEMENT:
+            s = datapack_readStr( r, &len );
+            if ((s == NULL) || datapack_readU32( r, &nattr ))
+               return -1;
+            /* Attach right away, so it's freed with the document on error. */
+            n = xmlNewDocNode( doc, NULL, s, NULL );
+            xmlAddChild( parent, n );
+            for (uint32_t i=0; i<nattr; i++) {
+               name = datapack_readStr( r, &len );
+               if (name == NULL)
+                  return -1;
+               s = datapack_readStr( r, &len );
+               if (s == NULL)
+                  return -1;
+               xmlNewProp( n, name, (len > 0) ? s : NULL );
+            }
+            if (datapack_loadNodes( r, doc, n ))
+               return -1;
+            continue;
+
+         case DATAPACK_TEXT:
+            s = datapack_readStr( r, &len );
+            if (s == NULL)
+               return -1;
+            n = xmlNewDocTextLen( doc, s, len );
+            break;
+
+         case DATAPACK_CDATA:
+            s = datapack_readStr( r, &len );
+            if (s == NULL)
+               return -1;
+            n = xmlNewCDataBlock( doc, s, len );
+            break;
+
+         case DATAPACK_COMMENT:
+            s = datapack_readStr( r, &len );
+            if (s == NULL)
+               return -1;
+            n = xmlNewDocComment( doc, s );
+            break;
+
+         default:
+            return -1;
+      }
+      xmlAddChild( parent, n );
+   }
+   return -1; /* Missing the end of the list. */
+}
+
+/**
+ * @brief Gets the value of an attribute, empty ones being NULL.
+ */
+static const xmlChar *datapack_attrValue( xmlAttrPtr attr )
+{
+   if ((attr->children == NULL) || (attr->children->content == NULL) ||
+         (attr->children->content[0] == '\0'))
+      return NULL;
+   return attr->children->content;
+}
+
+/**
+ * @brief Compares two lists of sibling nodes and their children.
+ *
+ *    @return 0 if they are the same.
+ */
+static int datapack_cmpNodes( xmlNodePtr a, xmlNodePtr b )
+{
+   for (; (a!=NULL) && (b!=NULL); a=a->next, b=b->next) {
+      xmlAttrPtr pa, pb;
+      if ((a->type != b->type) || (xmlStrcmp( a->name, b->name ) != 0) ||
+            (xmlStrcmp( a->content, b->content ) != 0))
+         return -1;
+      if (a->type != XML_ELEMENT_NODE)
+         continue;
+      for (pa=a->properties, pb=b->properties; (pa!=NULL) && (pb!=NULL); pa=pa->next, pb=pb->next)
+         if ((xmlStrcmp( pa->name, pb->name ) != 0) ||
+               (xmlStrcmp( datapack_attrValue(pa), datapack_attrValue(pb) ) != 0))
+            return -1;
+      if ((pa != NULL) || (pb != NULL))
+         return -1;
+      if (datapack_cmpNodes( a->children, b->children ))
+         return -1;
+   }
+   return ((a != NULL) || (b != NULL)) ? -1 : 0;
+}
+
+/**
+ * @brief Packs all the XML data into the cache directory.
+ *
+ *    @return 0 on success.
+ */
+int datapack_build (void)
+{
+   char path[PATH_MAX], tmppath[PATH_MAX];
+   char **files, **bufs;
+   DataPackHeader hdr;
+   DataPackRecord *recs;
+   uint64_t strsize, datasize;
+   FILE *f;
+   int n, nraw, ret;
+   Uint32 time = SDL_GetTicks();
+
+   files = datapack_listFiles();
+   n     = array_size(files);
+   bufs  = calloc( n, sizeof(char*) );
+   recs  = calloc( n, sizeof(DataPackRecord) );
+   nraw  = 0;
+   ret   = -1;
+   f     = NULL;
+
+   /* Parse everything and lay out the records. */
+   strsize  = 0;
+   datasize = 0;
+   for (int i=0; i<n; i++) {
+      size_t size;
+      xmlDocPtr doc;
+      bufs[i] = ndata_read( files[i], &size );
+      if (bufs[i] == NULL) {
+         WARN(_("Unable to read data from '%s'"), files[i]);
+         goto err;
+      }
+      recs[i].kind = DATAPACK_RAW;
+      doc = (size > 0) ? xmlParseMemory( bufs[i], size ) : NULL;
+      if (doc != NULL) {
+         DataPackBuf b = { .data = NULL };
+         if (datapack_dumpNodes( &b, doc->children ) == 0) {
+            free( bufs[i] );
+            bufs[i] = b.data;
+            size = b.len;
+            recs[i].kind = DATAPACK_TREE;
+         }
+         else
+            free( b.data );
+         xmlFreeDoc( doc );
+      }
+      if (recs[i].kind == DATAPACK_RAW)
+         nraw++;
+      recs[i].name      = strsize;
+      recs[i].namelen   = strlen( files[i] );
+      recs[i].offset    = datasize;
+      recs[i].size      = size;
+      strsize  += recs[i].namelen+1;
+      datasize += DATAPACK_ALIGN( size );
+   }
+
+   memset( &hdr, 0, sizeof(hdr) );
+   memcpy( hdr.magic, DATAPACK_MAGIC, sizeof(hdr.magic) );
+   hdr.version    = DATAPACK_VERSION;
+   hdr.byteorder  = DATAPACK_BYTEORDER;
+   hdr.manifest   = datapack_manifest( files );
+   hdr.nrecords   = n;
+   hdr.records    = sizeof(hdr);
+   hdr.strings    = hdr.records + n*sizeof(DataPackRecord);
+   hdr.data       = DATAPACK_ALIGN( hdr.strings + strsize );
+   hdr.size       = hdr.data + datasize;
+
+   /* Write to a temporary file so a failed build never leaves a broken pack. */
+   if (nfile_dirMakeExist( nfile_cachePath() )) {
+      WARN(_("Unable to create cache directory '%s'"), nfile_cachePath());
+      goto err;
+   }
+   datapack_path( path, sizeof(path) );
+   snprintf( tmppath, sizeof(tmppath), "%s.tmp", path );
+   f = fopen( tmppath, "wb" );
+   if (f == NULL) {
+      WARN(_("Unable to open '%s' for writing: %s"), tmppath, strerror(errno));
+      goto err;
+   }
+   if (fwrite( &hdr, sizeof(hdr), 1, f ) != 1)
+      goto err_write;
+   if ((n > 0) && (fwrite( recs, sizeof(DataPackRecord), n, f ) != (size_t)n))
+      goto err_write;
+   for (int i=0; i<n; i++)
+      if (fwrite( files[i], 1, recs[i].namelen+1, f ) != recs[i].namelen+1)
+         goto err_write;
+   if (datapack_pad( f, hdr.data - hdr.strings - strsize ))
+      goto err_write;
+   for (int i=0; i<n; i++) {
+      if (fwrite( bufs[i], 1, recs[i].size, f ) != recs[i].size)
+         goto err_write;
+      if (datapack_pad( f, DATAPACK_ALIGN(recs[i].size) - recs[i].size ))
+         goto err_write;
+   }
+   if (fclose( f )) {
+      f = NULL;
+      goto err_write;
+   }
+   f = NULL;
+#if WIN32
+   remove( path ); /* rename() does not overwrite on Windows. */
+#endif /* WIN32 */
+   if (rename( tmppath, path )) {
+      WARN(_("Unable to move '%s' to '%s': %s"), tmppath, path, strerror(errno));
+      remove( tmppath );
+      goto err;
+   }
+
+   time = SDL_GetTicks() - time;
+   LOG(n_("Wrote data pack '%s' with %d file (%d stored as text, %.1f MiB) in %.3f s",
+          "Wrote data pack '%s' with %d files (%d stored as text, %.1f MiB) in %.3f s", n),
+         path, n, nraw, (double)hdr.size / (1024.*1024.), time/1000.);
+   ret = 0;
+   goto err;
+
+err_write:
+   WARN(_("Unable to write data pack '%s': %s"), tmppath, strerror(errno));
+   if (f != NULL)
+      fclose( f );
+   remove( tmppath );
+err:
+   for (int i=0; i<n; i++) {
+      free( bufs[i] );
+      free( files[i] );
+   }
+   free( bufs );
+   free( recs );
+   array_free( files );
+   return ret;
+}
+
+/**
+ * @brief Loads the contents of the pack, memory mapping it if possible.
+ */
+static int datapack_map( const char *path )
+{
+#if HAVE_SYS_MMAN_H
+   struct stat st;
+   void *mem;
+   int fd = open( path, O_RDONLY );
+   if (fd < 0)
+      return -1;
+   if ((fstat( fd, &st ) != 0) || (st.st_size < (off_t)sizeof(DataPackHeader))) {
+      close( fd );
+      return -1;
+   }
+   mem = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+   close( fd );
+   if (mem == MAP_FAILED) {
+      WARN(_("Unable to map data pack '%s': %s"), path, strerror(errno));
+      return -1;
+   }
+   datapack_mem      = mem;
+   datapack_size     = st.st_size;
+   datapack_mapped   = 1;
+#else /* HAVE_SYS_MMAN_H */
+   datapack_mem      = nfile_readFile( &datapack_size, path );
+   datapack_mapped   = 0;
+   if (datapack_mem == NULL)
+      return -1;
+#endif /* HAVE_SYS_MMAN_H */
+   return 0;
+}
+
+/**
+ * @brief Checks that the open pack is well formed and matches the data.
+ *
+ *    @return 0 if the pack can be used, 1 if it is out of date and -1 if it is
+ *            corrupt.
+ */
+static int datapack_check (void)
+{
+   const DataPackHeader *hdr = (const DataPackHeader*) datapack_mem;
+   uint64_t strsize, datasize, manifest;
+   char **files;
+
+   /* Header. */
+   if (datapack_size < sizeof(DataPackHeader))
+      return -1;
+   if ((memcmp( hdr->magic, DATAPACK_MAGIC, sizeof(hdr->magic) ) != 0) ||
+         (hdr->byteorder != DATAPACK_BYTEORDER) ||
+         (hdr->size != datapack_size))
+      return -1;
+   if (hdr->version != DATAPACK_VERSION)
+      return 1;
+   files    = datapack_listFiles();
+   manifest = datapack_manifest( files );
+   for (int i=0; i<array_size(files); i++)
+      free( files[i] );
+   array_free( files );
+   if (hdr->manifest != manifest)
+      return 1;
+   if ((hdr->records != sizeof(DataPackHeader)) ||
+         (hdr->nrecords > (datapack_size - hdr->records) / sizeof(DataPackRecord)) ||
+         (hdr->strings != hdr->records + hdr->nrecords*sizeof(DataPackRecord)) ||
+         (hdr->data < hdr->strings) || (hdr->data > datapack_size))
+      return -1;
+   datapack_records  = (const DataPackRecord*) &datapack_mem[ hdr->records ];
+   datapack_strings  = &datapack_mem[ hdr->strings ];
+   datapack_data     = &datapack_mem[ hdr->data ];
+   datapack_nrecords = hdr->nrecords;
+   strsize  = hdr->data - hdr->strings;
+   datasize = datapack_size - hdr->data;
+
+   /* Records. */
+   for (int i=0; i<datapack_nrecords; i++) {
+      const DataPackRecord *r = &datapack_records[i];
+      if (((uint64_t)r->name + r->namelen >= strsize) ||
+            (datapack_strings[ r->name + r->namelen ] != '\0') ||
+            ((r->kind != DATAPACK_RAW) && (r->kind != DATAPACK_TREE)) ||
+            (r->offset > datasize) || (r->size > datasize - r->offset))
+         return -1;
+      if ((i > 0) && (strcmp( &datapack_strings[ datapack_records[i-1].name ],
+            &datapack_strings[ r->name ] ) >= 0))
+         return -1;
+   }
+
+   return 0;
+}
+
+/**
+ * @brief Opens the data pack if it exists and matches the data.
+ *
+ *    @return 0 if the pack is in use.
+ */
+int datapack_open (void)
+{
+   char path[PATH_MAX];
+   int ret;
+   Uint32 time = SDL_GetTicks();
+
+   datapack_close();
+
+   datapack_path( path, sizeof(path) );
+   if (!nfile_fileExists( path ))
+      return -1;
+   if (datapack_map( path ))
+      return -1;
+
+   ret = datapack_check();
+   if (ret != 0) {
+      if (ret > 0)
+         DEBUG(_("Data pack '%s' is out of date, loading XML data instead."), path);
+      else
+         WARN(_("Data pack '%s' is corrupt, loading XML data instead."), path);
+      datapack_close();
+      return -1;
+   }
+
+   if (conf.devmode) {
+      time = SDL_GetTicks() - time;
+      DEBUG( n_( "Opened data pack with %d file in %.3f s", "Opened data pack with %d files in %.3f s", datapack_nrecords ), datapack_nrecords, time/1000. );
+   }
+   return 0;
+}
+
+/**
+ * @brief Closes the data pack.
+ */
+void datapack_close (void)
+{
+   if (datapack_mem != NULL) {
+#if HAVE_SYS_MMAN_H
+      if (datapack_mapped)
+         munmap( datapack_mem, datapack_size );
+      else
+#endif /* HAVE_SYS_MMAN_H */
+         free( datapack_mem );
+   }
+   datapack_mem      = NULL;
+   datapack_size     = 0;
+   datapack_mapped   = 0;
+   datapack_records  = NULL;
+   datapack_strings  = NULL;
+   datapack_data     = NULL;
+   datapack_nrecords = 0;
+}
+
+/**
+ * @brief Compares a file name to a pack record for bsearch.
+ */
+static int datapack_cmp( const void *key, const void *elem )
+{
+   const DataPackRecord *r = elem;
+   return strcmp( key, &datapack_strings[ r->name ] );
+}
+
+/**
+ * @brief Finds the record of a file.
+ */
+static const DataPackRecord *datapack_find( const char *filename )
+{
+   if (datapack_nrecords <= 0)
+      return NULL;
+   return bsearch( filename, datapack_records, datapack_nrecords, sizeof(DataPackRecord), datapack_cmp );
+}
+
+/**
+ * @brief Gets the document of a file from the data pack.
+ *
+ *    @param filename Name of the file as used by PhysicsFS.
+ *    @param[out] packed Set to whether or not the document came from the pack.
+ *    @return The document or NULL if it is empty or invalid.
+ */
+xmlDocPtr datapack_parse( const char *filename, int *packed )
+{
+   DataPackReader r;
+   xmlDocPtr doc;
+   const char *data;
+   const DataPackRecord *rec = datapack_find( filename );
+
+   *packed = (rec != NULL);
+   if (rec == NULL)
+      return NULL;
+   data = &datapack_data[ rec->offset ];
+
+   if (rec->kind == DATAPACK_RAW) {
+      /* Empty file, we ignore these. */
+      if (rec->size == 0)
+         return NULL;
+      doc = xmlParseMemory( data, rec->size );
+      if (doc == NULL)
+         WARN( _("Unable to parse document '%s'"), filename );
+      return doc;
+   }
+
+   r.p   = data;
+   r.end = data + rec->size;
+   doc   = xmlNewDoc( BAD_CAST "1.0" );
+   if (datapack_loadNodes( &r, doc, (xmlNodePtr)doc ) || (r.p != r.end)) {
+      WARN(_("Data pack record of '%s' is corrupt, reading the file instead."), filename);
+      xmlFreeDoc( doc );
+      *packed = 0;
+      return NULL;
+   }
+   return doc;
+}
+
+/**
+ * @brief Checks that every packed document is identical to parsing its file.
+ *
+ *    @return 0 if the pack matches.
+ */
+int datapack_verify (void)
+{
+   char **files;
+   int errors = 0;
+
+   if (datapack_mem == NULL) {
+      WARN(_("No data pack is open."));
+      return -1;
+   }
+
+   files = datapack_listFiles();
+   if (array_size(files) != datapack_nrecords) {
+      WARN(_("Data pack has %d files, but the data has %d."), datapack_nrecords, array_size(files));
+      errors++;
+   }
+   for (int i=0; i<array_size(files); i++) {
+      size_t size;
+      int packed;
+      xmlDocPtr pdoc = datapack_parse( files[i], &packed );
+      char *buf = ndata_read( files[i], &size );
+      xmlDocPtr doc = ((buf != NULL) && (size > 0)) ? xmlParseMemory( buf, size ) : NULL;
+      if (!packed || ((doc == NULL) != (pdoc == NULL)) ||
+            ((doc != NULL) && datapack_cmpNodes( doc->children, pdoc->children ))) {
+         WARN(_("Data pack does not match '%s'."), files[i]);
+         errors++;
+      }
+      xmlFreeDoc( doc );
+      xmlFreeDoc( pdoc );
+      free( buf );
+      free( files[i] );
+   }
+   array_free( files );
+
+   if (errors > 0)
+      return -1;
+   LOG(n_("Data pack verified: %d document matches the XML data.",
+          "Data pack verified: %d documents match the XML data.", datapack_nrecords), datapack_nrecords);
+   return 0;
+}
+
+/**
+ * @brief Adds a ship stat list to a hash.
+ */
+static uint64_t datapack_hashStats( uint64_t h, const ShipStatList *ll )
+{
+   char buf[STRMAX];
+   if (ll == NULL)
+      return datapack_hashInt( h, 0 );
+   ss_statsListDesc( ll, buf, sizeof(buf), 0 );
+   return datapack_hashStr( h, buf );
+}
+
+/**
+ * @brief Adds a tag array (array.h) to a hash.
+ */
+static uint64_t datapack_hashTags( uint64_t h, char *const *tags )
+{
+   h = datapack_hashInt( h, array_size(tags) );
+   for (int i=0; i<array_size(tags); i++)
+      h = datapack_hashStr( h, tags[i] );
+   return h;
+}
+
+/**
+ * @brief Adds the items of a tech group to a hash.
+ */
+static uint64_t datapack_hashTech( uint64_t h, const tech_group_t *tech )
+{
+   int n = 0;
+   char **names = (tech==NULL) ? NULL : tech_getItemNames( tech, &n );
+   h = datapack_hashInt( h, n );
+   for (int i=0; i<n; i++) {
+      h = datapack_hashStr( h, names[i] );
+      free( names[i] );
+   }
+   free( names );
+   return h;
+}
+
+/**
+ * @brief Adds a spob presence to a hash.
+ */
+static uint64_t datapack_hashPresence( uint64_t h, const SpobPresence *p )
+{
+   h = datapack_hashInt( h, p->faction );
+   h = datapack_hashNum( h, p->base );
+   h = datapack_hashNum( h, p->bonus );
+   return datapack_hashInt( h, p->range );
+}
+
+/**
+ * @brief Hashes the loaded universe.
+ *
+ * Covers what is loaded from the packed data: commodities, outfits, ships,
+ *  factions, spobs, virtual spobs and systems. Loading from the pack and from
+ *  the XML files must give the same digest.
+ *
+ *    @return Digest of the loaded universe.
+ */
+uint64_t datapack_universeDigest (void)
+{
+   uint64_t h = DATAPACK_HASH_INIT;
+   const Commodity *commodities = commodity_getAll();
+   const Outfit *outfits = outfit_getAll();
+   const Ship *ships = ship_getAll();
+   const Spob *spobs = spob_getAll();
+   const VirtualSpob *vspobs = virtualspob_getAll();
+   const StarSystem *systems = system_getAll();
+   int *factions = faction_getAll();
+
+   h = datapack_hashInt( h, array_size(commodities) );
+   for (int i=0; i<array_size(commodities); i++) {
+      const Commodity *c = &commodities[i];
+      h = datapack_hashStr( h, c->name );
+      h = datapack_hashStr( h, c->description );
+      h = datapack_hashInt( h, c->flags );
+      h = datapack_hashNum( h, c->raw_price );
+      h = datapack_hashNum( h, c->price );
+      h = datapack_hashNum( h, c->period );
+      h = datapack_hashNum( h, c->population_modifier );
+   }
+
+   h = datapack_hashInt( h, array_size(outfits) );
+   for (int i=0; i<array_size(outfits); i++) {
+      const Outfit *o = &outfits[i];
+      h = datapack_hashStr( h, o->name );
+      h = datapack_hashStr( h, o->typename );
+      h = datapack_hashInt( h, o->type );
+      h = datapack_hashInt( h, o->rarity );
+      h = datapack_hashInt( h, o->slot.spid );
+      h = datapack_hashInt( h, o->slot.type );
+      h = datapack_hashInt( h, o->slot.size );
+      h = datapack_hashStr( h, o->license );
+      h = datapack_hashStr( h, o->cond );
+      h = datapack_hashNum( h, o->mass );
+      h = datapack_hashNum( h, o->cpu );
+      h = datapack_hashStr( h, o->limit );
+      h = datapack_hashInt( h, o->price );
+      h = datapack_hashStr( h, o->desc_raw );
+      h = datapack_hashStr( h, o->summary_raw );
+      h = datapack_hashInt( h, o->priority );
+      h = datapack_hashInt( h, o->properties );
+      h = datapack_hashStats( h, o->stats );
+      h = datapack_hashTags( h, o->tags );
+      h = datapack_hashStr( h, o->lua_file );
+   }
+
+   h = datapack_hashInt( h, array_size(ships) );
+   for (int i=0; i<array_size(ships); i++) {
+      const Ship *s = &ships[i];
+      const ShipOutfitSlot *slots[3] = { s->outfit_structure, s->outfit_utility, s->outfit_weapon };
+      h = datapack_hashStr( h, s->name );
+      h = datapack_hashStr( h, s->base_type );
+      h = datapack_hashInt( h, s->class );
+      h = datapack_hashInt( h, s->points );
+      h = datapack_hashInt( h, s->rarity );
+      h = datapack_hashInt( h, s->flags );
+      h = datapack_hashInt( h, s->price );
+      h = datapack_hashStr( h, s->license );
+      h = datapack_hashStr( h, s->fabricator );
+      h = datapack_hashStr( h, s->description );
+      h = datapack_hashNum( h, s->thrust );
+      h = datapack_hashNum( h, s->turn );
+      h = datapack_hashNum( h, s->speed );
+      h = datapack_hashInt( h, s->crew );
+      h = datapack_hashNum( h, s->mass );
+      h = datapack_hashNum( h, s->cpu );
+      h = datapack_hashInt( h, s->fuel );
+      h = datapack_hashInt( h, s->fuel_consumption );
+      h = datapack_hashNum( h, s->cap_cargo );
+      h = datapack_hashNum( h, s->armour );
+      h = datapack_hashNum( h, s->armour_regen );
+      h = datapack_hashNum( h, s->shield );
+      h = datapack_hashNum( h, s->shield_regen );
+      h = datapack_hashNum( h, s->energy );
+      h = datapack_hashNum( h, s->energy_regen );
+      h = datapack_hashNum( h, s->dmg_absorb );
+      for (int k=0; k<3; k++) {
+         h = datapack_hashInt( h, array_size(slots[k]) );
+         for (int j=0; j<array_size(slots[k]); j++) {
+            const ShipOutfitSlot *sl = &slots[k][j];
+            h = datapack_hashInt( h, sl->slot.spid );
+            h = datapack_hashInt( h, sl->slot.size );
+            h = datapack_hashInt( h, sl->exclusive );
+            h = datapack_hashInt( h, sl->required );
+            h = datapack_hashInt( h, sl->locked );
+            h = datapack_hashStr( h, (sl->data==NULL) ? NULL : sl->data->name );
+         }
+      }
+      h = datapack_hashStats( h, s->stats );
+      h = datapack_hashTags( h, s->tags );
+   }
+
+   h = datapack_hashInt( h, array_size(factions) );
+   for (int i=0; i<array_size(factions); i++) {
+      const int *allies = faction_getAllies( factions[i] );
+      const int *enemies = faction_getEnemies( factions[i] );
+      h = datapack_hashStr( h, faction_name( factions[i] ) );
+      h = datapack_hashInt( h, array_size(allies) );
+      for (int j=0; j<array_size(allies); j++)
+         h = datapack_hashInt( h, allies[j] );
+      h = datapack_hashInt( h, array_size(enemies) );
+      for (int j=0; j<array_size(enemies); j++)
+         h = datapack_hashInt( h, enemies[j] );
+   }
+   array_free( factions );
+
+   h = datapack_hashInt( h, array_size(spobs) );
+   for (int i=0; i<array_size(spobs); i++) {
+      const Spob *p = &spobs[i];
+      h = datapack_hashStr( h, p->name );
+      h = datapack_hashStr( h, p->display );
+      h = datapack_hashStr( h, p->feature );
+      h = datapack_hashNum( h, p->pos.x );
+      h = datapack_hashNum( h, p->pos.y );
+      h = datapack_hashStr( h, p->class );
+      h = datapack_hashInt( h, p->population );
+      h = datapack_hashPresence( h, &p->presence );
+      h = datapack_hashNum( h, p->hide );
+      h = datapack_hashStr( h, p->land_msg );
+      h = datapack_hashStr( h, p->description );
+      h = datapack_hashStr( h, p->bar_description );
+      h = datapack_hashInt( h, p->services );
+      h = datapack_hashInt( h, array_size(p->commodities) );
+      for (int j=0; j<array_size(p->commodities); j++)
+         h = datapack_hashStr( h, p->commodities[j]->name );
+      h = datapack_hashTech( h, p->tech );
+      h = datapack_hashStr( h, p->gfx_spacePath );
+      h = datapack_hashStr( h, p->gfx_exteriorPath );
+      h = datapack_hashTags( h, p->tags );
+      h = datapack_hashInt( h, p->flags );
+      h = datapack_hashInt( h, p->sys_id );
+      h = datapack_hashStr( h, p->lua_file );
+   }
+
+   h = datapack_hashInt( h, array_size(vspobs) );
+   for (int i=0; i<array_size(vspobs); i++) {
+      h = datapack_hashStr( h, vspobs[i].name );
+      h = datapack_hashInt( h, array_size(vspobs[i].presences) );
+      for (int j=0; j<array_size(vspobs[i].presences); j++)
+         h = datapack_hashPresence( h, &vspobs[i].presences[j] );
+   }
+
+   h = datapack_hashInt( h, array_size(systems) );
+   for (int i=0; i<array_size(systems); i++) {
+      const StarSystem *s = &systems[i];
+      h = datapack_hashStr( h, s->name );
+      h = datapack_hashNum( h, s->pos.x );
+      h = datapack_hashNum( h, s->pos.y );
+      h = datapack_hashInt( h, s->stars );
+      h = datapack_hashNum( h, s->interference );
+      h = datapack_hashNum( h, s->nebu_hue );
+      h = datapack_hashNum( h, s->nebu_density );
+      h = datapack_hashNum( h, s->nebu_volatility );
+      h = datapack_hashNum( h, s->radius );
+      h = datapack_hashStr( h, s->background );
+      h = datapack_hashStr( h, s->features );
+      h = datapack_hashInt( h, s->faction );
+      h = datapack_hashInt( h, array_size(s->spobs) );
+      for (int j=0; j<array_size(s->spobs); j++)
+         h = datapack_hashStr( h, s->spobs[j]->name );
+      h = datapack_hashInt( h, array_size(s->spobs_virtual) );
+      for (int j=0; j<array_size(s->spobs_virtual); j++)
+         h = datapack_hashStr( h, s->spobs_virtual[j]->name );
+      h = datapack_hashInt( h, array_size(s->jumps) );
+      for (int j=0; j<array_size(s->jumps); j++) {
+         const JumpPoint *jp = &s->jumps[j];
+         h = datapack_hashInt( h, jp->targetid );
+         h = datapack_hashNum( h, jp->pos.x );
+         h = datapack_hashNum( h, jp->pos.y );
+         h = datapack_hashInt( h, jp->flags );
+         h = datapack_hashNum( h, jp->hide );
+      }
+      h = datapack_hashInt( h, array_size(s->asteroids) );
+      h = datapack_hashInt( h, array_size(s->astexclude) );
+      h = datapack_hashNum( h, s->asteroid_density );
+      h = datapack_hashNum( h, s->ownerpresence );
+      h = datapack_hashStr( h, s->map_shader );
+      h = datapack_hashTags( h, s->tags );
+      h = datapack_hashInt( h, s->flags );
+      h = datapack_hashStats( h, s->stats );
+   }
+
+   return h;
+}
@@ -0,0 +1,21 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+#pragma once
+
+/** @cond */
+#include <stddef.h>
+#include <stdint.h>
+/** @endcond */
+
+#include "nxml.h"
+
+#define DATAPACK_FILE      "datapack.bin" /**< Name of the data pack in the cache directory. */
+#define DATAPACK_VERSION   2 /**< Version of the data pack format, bump on any layout change. */
+
+int datapack_build (void);
+int datapack_open (void);
+void datapack_close (void);
+int datapack_verify (void);
+xmlDocPtr datapack_parse( const char *filename, int *packed );
+uint64_t datapack_universeDigest (void);
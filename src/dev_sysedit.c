@@ -389,6 +389,7 @@ static void sysedit_btnNewSpob( unsigned int wid_unused, const char *unused )
    /* Create the new spob. */
    p        = spob_new();
    p->name  = name;
+   space_namesChanged();
 
    /* Base spob data off another. */
    b                    = spob_get( space_getRndSpob(0, 0, NULL) );
@@ -404,6 +405,7 @@ static void sysedit_btnNewSpob( unsigned int wid_unused, const char *unused )
 
    /* Add new spob. */
    system_addSpob( sysedit_sys, name );
+   space_updatePresences();
 
    /* Update economy due to galaxy modification. */
    economy_execQueued();
@@ -504,6 +506,7 @@ static void sysedit_btnRename( unsigned int wid_unused, const char *unused )
          free(p->name);
 
          p->name = name;
+         space_namesChanged();
          window_modifyText( sysedit_widEdit, "txtName", p->name );
          dpl_saveSpob( p );
       }
@@ -532,6 +535,7 @@ static void sysedit_btnRemove( unsigned int wid_unused, const char *unused )
             free(file);
 
             system_rmSpob( sysedit_sys, sp->name );
+            space_updatePresences();
          }
          else if (sel->type == SELECT_ASTEROID) {
             AsteroidAnchor *ast = &sysedit_sys->asteroids[ sel->u.asteroid ];
@@ -1296,6 +1296,7 @@ static void uniedit_renameSys (void)
       free(sys->name);
 
       sys->name = name;
+      space_namesChanged();
       dsys_saveSystem(sys);
 
       /* Re-save adjacent systems. */
@@ -1331,6 +1332,7 @@ static void uniedit_newSys( double x, double y )
    /* Create the system. */
    sys         = system_new();
    sys->name   = name;
+   space_namesChanged();
    sys->pos.x  = x;
    sys->pos.y  = y;
    sys->stars  = STARS_DENSITY_DEFAULT;
@@ -1963,6 +1965,7 @@ static void uniedit_btnEditRmSpob( unsigned int wid, const char *unused )
       dialogue_alert( _("Failed to remove virtual spob '%s'!"), selected );
       return;
    }
+   space_updatePresences();
 
    /* Update economy due to galaxy modification. */
    economy_execQueued();
@@ -2029,6 +2032,7 @@ static void uniedit_btnEditAddSpobAdd( unsigned int wid, const char *unused )
       dialogue_alert( _("Failed to add virtual spob '%s'!"), selected );
       return;
    }
+   space_updatePresences();
 
    /* Update economy due to galaxy modification. */
    economy_execQueued();
@@ -33,6 +33,7 @@
 #include "nstring.h"
 #include "opengl.h"
 #include "pause.h"
+#include "replay.h"
 #include "toolkit.h"
 
 static int dialogue_open; /**< Number of dialogues open. */
@@ -990,7 +991,7 @@ int dialogue_customResize( int width, int height )
  */
 static int toolkit_loop( int *loop_done, dialogue_update_t *du )
 {
-   unsigned int time_ms = SDL_GetTicks();
+   unsigned int time_ms = replay_getTicks();
    const double fps_max = (conf.fps_max > 0) ? 1./(double)conf.fps_max : fps_min;
    int quit_game = 0;
 
@@ -1009,7 +1010,7 @@ static int toolkit_loop( int *loop_done, dialogue_update_t *du )
       /* Loop first so exit condition is checked before next iteration. */
       main_loop( 1 );
 
-      while (!naev_isQuit() && SDL_PollEvent(&event)) { /* event loop */
+      while (!naev_isQuit() && replay_pollEvent(&event)) { /* event loop */
          if (event.type == SDL_QUIT) {
             if (menu_askQuit()) {
                naev_quit(); /* Quit is handled here */
@@ -1032,11 +1033,11 @@ static int toolkit_loop( int *loop_done, dialogue_update_t *du )
 
       /* FPS Control. */
       /* Get elapsed. */
-      t  = SDL_GetTicks();
+      t  = replay_getTicks();
       dt = (double)(t - time_ms) / 1000.;
       time_ms = t;
       /* Sleep if necessary. */
-      if (dt < fps_max) {
+      if ((dt < fps_max) && !replay_isUncapped()) {
          double delay = fps_max - dt;
          SDL_Delay( (unsigned int)(delay * 1000.) );
       }
@@ -160,3 +160,204 @@ make_distance_mapbf( unsigned char *img,
 
     return out;
 }
+
+
+/*
+ * Scratch space for make_distance_mapbf_fh(). Glyphs are rasterized one at a
+ * time, so the buffers are kept between calls and only ever grown.
+ */
+#define EDT_INF 1e20f   /**< "Infinite" squared distance. Finite so that INF-INF is not NaN. */
+static float *edt_outer = NULL;     /**< Squared distance to the inside, per pixel. */
+static float *edt_inner = NULL;     /**< Squared distance to the outside, per pixel. */
+static float *edt_tmp   = NULL;     /**< Transposed image used by the column pass. */
+static size_t edt_size  = 0;        /**< Allocated pixels in edt_outer/edt_inner/edt_tmp. */
+static float *edt_f     = NULL;     /**< 1D pass: copy of the sampled function. */
+static float *edt_z     = NULL;     /**< 1D pass: parabola boundaries (length+1). */
+static unsigned int *edt_v = NULL;  /**< 1D pass: parabola vertices. */
+static size_t edt_len   = 0;        /**< Allocated length of edt_f/edt_v (edt_z has one more). */
+
+/**
+ * @brief Makes sure the scratch buffers can hold a width*height image.
+ */
+static void edt_reserve( unsigned int width, unsigned int height )
+{
+    size_t n = (size_t)width * height;
+    size_t l = (width > height) ? width : height;
+    if (n > edt_size) {
+        edt_size  = n;
+        edt_outer = realloc( edt_outer, n * sizeof(float) );
+        edt_inner = realloc( edt_inner, n * sizeof(float) );
+        edt_tmp   = realloc( edt_tmp,   n * sizeof(float) );
+    }
+    if (l > edt_len) {
+        edt_len = l;
+        edt_f   = realloc( edt_f, l * sizeof(float) );
+        edt_z   = realloc( edt_z, (l+1) * sizeof(float) );
+        edt_v   = realloc( edt_v, l * sizeof(unsigned int) );
+    }
+}
+
+/**
+ * @brief Exact 1D squared distance transform of a sampled function
+ *        (Felzenszwalb & Huttenlocher, "Distance Transforms of Sampled Functions").
+ *
+ * Computes the lower envelope of the parabolas rooted at every sample in place.
+ *    @param row Contiguous samples, overwritten with the transform.
+ *    @param length Number of samples.
+ */
+static void edt_1d( float *restrict row, unsigned int length )
+{
+    float *restrict f = edt_f;
+    float *restrict z = edt_z;
+    unsigned int *restrict v = edt_v;
+    unsigned int q, k;
+
+    if (length == 0)
+        return;
+
+    memcpy( f, row, length * sizeof(float) );
+
+    k    = 0;
+    v[0] = 0;
+    z[0] = -EDT_INF;
+    z[1] = +EDT_INF;
+    for (q=1; q<length; q++) {
+        float s;
+        /* Pop parabolas hidden by the new one. Terminates as z[0] is below any s. */
+        for (;;) {
+            unsigned int r = v[k];
+            s = ((f[q] + (float)q*q) - (f[r] + (float)r*r)) / (float)(2*(q-r));
+            if (s > z[k])
+                break;
+            k--;
+        }
+        k++;
+        v[k]   = q;
+        z[k]   = s;
+        z[k+1] = +EDT_INF;
+    }
+
+    k = 0;
+    for (q=0; q<length; q++) {
+        float d;
+        while (z[k+1] < (float)q)
+            k++;
+        d = (float)q - (float)v[k];
+        row[q] = f[v[k]] + d*d;
+    }
+}
+
+/**
+ * @brief Transposes a width*height row-major image into dst (height*width).
+ */
+static void edt_transpose( float *restrict dst, const float *restrict src,
+                           unsigned int width, unsigned int height )
+{
+    unsigned int x, y;
+    for (y=0; y<height; y++)
+        for (x=0; x<width; x++)
+            dst[ x*height+y ] = src[ y*width+x ];
+}
+
+/**
+ * @brief Separable 2D squared distance transform, in place.
+ *
+ * Both passes run over contiguous memory: the columns are done on a
+ * transposed copy.
+ */
+static void edt_2d( float *grid, unsigned int width, unsigned int height )
+{
+    unsigned int i;
+    edt_transpose( edt_tmp, grid, width, height );
+    for (i=0; i<width; i++)
+        edt_1d( &edt_tmp[ i*height ], height );
+    edt_transpose( grid, edt_tmp, height, width );
+    for (i=0; i<height; i++)
+        edt_1d( &grid[ i*width ], width );
+}
+
+/**
+ * @brief Single precision alternative to make_distance_mapbf().
+ *
+ * Runs an exact separable Euclidean distance transform on the inside and the
+ * outside of the glyph, seeding partially covered pixels with their estimated
+ * sub-pixel distance to the edge. All the per-pixel stages are branch-free
+ * loops over contiguous floats so the compiler can vectorize them, and no
+ * buffers other than the returned one are allocated once the scratch space
+ * has grown to the largest glyph.
+ *
+ * Input, output and vmax have the same meaning as in make_distance_mapbf(),
+ * so the two are interchangeable.
+ *
+ * @note Uses static scratch space: not reentrant.
+ */
+float*
+make_distance_mapbf_fh( unsigned char *img,
+                        unsigned int width, unsigned int height, double *vmax )
+{
+    size_t n = (size_t)width * height;
+    float *restrict out = malloc( n * sizeof(float) );
+    float *restrict outer, *restrict inner;
+    float img_min = 255.f, img_max = 0.f;
+    float fmax, scale;
+    size_t i;
+
+    edt_reserve( width, height );
+    outer = edt_outer;
+    inner = edt_inner;
+
+    for (i=0; i<n; i++) {
+        float v = img[i];
+        img_min = (v < img_min) ? v : img_min;
+        img_max = (v > img_max) ? v : img_max;
+    }
+    scale = (img_max > 0.f) ? 1.f / img_max : 0.f;
+
+    /* Seed: 0 on the far side of the edge, estimated squared sub-pixel
+     * distance on anti-aliased pixels and "infinity" elsewhere. */
+    for (i=0; i<n; i++) {
+        float a  = ((float)img[i] - img_min) * scale;
+        float eo = fmaxf( 0.f, 0.5f - a );
+        float ei = fmaxf( 0.f, a - 0.5f );
+        outer[i] = (a >= 1.f) ? 0.f : (a <= 0.f) ? EDT_INF : eo*eo;
+        inner[i] = (a >= 1.f) ? EDT_INF : (a <= 0.f) ? 0.f : ei*ei;
+    }
+
+    edt_2d( outer, width, height );
+    edt_2d( inner, width, height );
+
+    /* Bipolar distance field, positive outside. */
+    fmax = 0.f;
+    for (i=0; i<n; i++) {
+        float d  = sqrtf( outer[i] ) - sqrtf( inner[i] );
+        outer[i] = d;
+        fmax     = fmaxf( fmax, fabsf( d ) );
+    }
+    if (fmax <= 0.f)
+        fmax = 1.f;
+
+    /* Same normalization as make_distance_mapbf(). */
+    scale = 0.5f / fmax;
+    for (i=0; i<n; i++)
+        out[i] = 0.5f - outer[i] * scale;
+
+    *vmax = fmax;
+    return out;
+}
+
+/**
+ * @brief Frees the scratch space used by make_distance_mapbf_fh().
+ */
+void distance_field_cleanup( void )
+{
+    free( edt_outer );
+    free( edt_inner );
+    free( edt_tmp );
+    free( edt_f );
+    free( edt_z );
+    free( edt_v );
+    edt_outer = edt_inner = edt_tmp = edt_f = edt_z = NULL;
+    edt_v     = NULL;
+    edt_size  = 0;
+    edt_len   = 0;
+}
@@ -6,3 +6,9 @@ make_distance_mapd( double *data, unsigned int width, unsigned int height, doubl
 float*
 make_distance_mapbf( unsigned char *img,
                     unsigned int width, unsigned int height, double *vmax );
+
+float*
+make_distance_mapbf_fh( unsigned char *img,
+                        unsigned int width, unsigned int height, double *vmax );
+
+void distance_field_cleanup( void );
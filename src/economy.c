@@ -67,6 +67,10 @@ int *econ_comm         = NULL; /**< Commodities to calculate. */
 //static double econ_calcJumpR( StarSystem *A, StarSystem *B );
 //static double econ_calcSysI( unsigned int dt, StarSystem *sys, int price );
 //static int econ_createGMatrix (void);
+static int econ_commodityIndex( const Commodity *com );
+static int econ_isComputed( const Commodity *com );
+static int econ_spobCommodityIndex( const Spob *p, const Commodity *com );
+static CommodityPrice *econ_createAveragePrice (void);
 
 /*
  * Externed prototypes.
@@ -74,6 +78,69 @@ int *econ_comm         = NULL; /**< Commodities to calculate. */
 int economy_sysSave( xmlTextWriterPtr writer );
 int economy_sysLoad( xmlNodePtr parent );
 
+/**
+ * @brief Gets the stable index of a commodity in the commodity stack.
+ *
+ * Indices are fixed once the commodities are loaded, so they can be used to
+ * address dense per-commodity tables.
+ *
+ *    @param com Commodity to get index of.
+ *    @return Index of the commodity or -1 if it is temporary.
+ */
+static int econ_commodityIndex( const Commodity *com )
+{
+   if (com->istemp)
+      return -1;
+   return com - commodity_stack;
+}
+
+/**
+ * @brief Checks to see if a commodity has its price computed by the economy.
+ *
+ *    @param com Commodity to check.
+ *    @return 1 if the economy handles the commodity, 0 otherwise.
+ */
+static int econ_isComputed( const Commodity *com )
+{
+   int k = econ_commodityIndex( com );
+   for (int i=0; i<array_size(econ_comm); i++)
+      if (econ_comm[i] == k)
+         return 1;
+   return 0;
+}
+
+/**
+ * @brief Gets the index of a commodity in a spob's commodity and price arrays.
+ *
+ * Spob commodities always point into the commodity stack, so comparing the
+ *  pointers is enough and there is no need to compare names.
+ *
+ *    @param p Spob to look up.
+ *    @param com Commodity to find.
+ *    @return Index into p->commodities and p->commodityPrice or -1 if not sold.
+ */
+static int econ_spobCommodityIndex( const Spob *p, const Commodity *com )
+{
+   for (int i=0; i<array_size(p->commodities); i++)
+      if (p->commodities[i] == com)
+         return i;
+   return -1;
+}
+
+/**
+ * @brief Creates a zeroed system price table indexed by commodity stack index.
+ *
+ *    @return Newly allocated array with one entry per commodity.
+ */
+static CommodityPrice *econ_createAveragePrice (void)
+{
+   int n = array_size(commodity_stack);
+   CommodityPrice *avprice = array_create_size( CommodityPrice, n );
+   array_resize( &avprice, n );
+   memset( avprice, 0, n*sizeof(CommodityPrice) );
+   return avprice;
+}
+
 /**
  * @brief Gets the price of a good on a spob in a system.
  *
@@ -102,7 +169,7 @@ credits_t economy_getPriceAtTime( const Commodity *com,
       const StarSystem *sys, const Spob *p, ntime_t tme )
 {
    (void) sys;
-   int i, k;
+   int i;
    double price;
    double t;
    CommodityPrice *commPrice;
@@ -126,26 +193,15 @@ credits_t economy_getPriceAtTime( const Commodity *com,
     * Journey with a single jump takes approx 3e7, so about 3 periods. */
    t = ntime_convertSeconds( tme ) / NT_PERIOD_SECONDS;
 
-   /* Get position in stack. */
-   k = com - commodity_stack;
-
-   /* Find what commodity that is. */
-   for (i=0; i<array_size(econ_comm); i++)
-      if (econ_comm[i] == k)
-         break;
-
-   /* Check if found. */
-   if (i >= array_size(econ_comm)) {
+   /* Check if the economy knows about the commodity. */
+   if (!econ_isComputed( com )) {
       WARN(_("Price for commodity '%s' not known."), com->name);
       return 0;
    }
 
    /* and get the index on this spob */
-   for (i=0; i<array_size(p->commodities); i++) {
-      if ((strcmp(p->commodities[i]->name, com->name)==0))
-         break;
-   }
-   if (i >= array_size(p->commodities)) {
+   i = econ_spobCommodityIndex( p, com );
+   if (i < 0) {
       WARN(_("Price for commodity '%s' not known on this spob."), com->name);
       return 0;
    }
@@ -171,7 +227,7 @@ credits_t economy_getPriceAtTime( const Commodity *com,
  */
 int economy_getAverageSpobPrice( const Commodity *com, const Spob *p, credits_t *mean, double *std )
 {
-   int i,k;
+   int i;
    CommodityPrice *commPrice;
 
    if (com->price_ref != NULL) {
@@ -191,16 +247,8 @@ int economy_getAverageSpobPrice( const Commodity *com, const Spob *p, credits_t
       return com->price;
    }
 
-   /* Get position in stack */
-   k = com - commodity_stack;
-
-   /* Find what commodity this is */
-   for (i=0; i<array_size(econ_comm); i++)
-      if (econ_comm[i] == k)
-         break;
-
-   /* Check if found */
-   if (i >= array_size(econ_comm)) {
+   /* Check if the economy knows about the commodity. */
+   if (!econ_isComputed( com )) {
       WARN(_("Average price for commodity '%s' not known."), com->name);
       *mean = 0;
       *std  = 0;
@@ -208,11 +256,8 @@ int economy_getAverageSpobPrice( const Commodity *com, const Spob *p, credits_t
    }
 
    /* and get the index on this spob */
-   for (i=0; i<array_size(p->commodities); i++) {
-      if ((strcmp(p->commodities[i]->name, com->name) == 0))
-         break;
-   }
-   if (i >= array_size(p->commodities)) {
+   i = econ_spobCommodityIndex( p, com );
+   if (i < 0) {
       WARN(_("Price for commodity '%s' not known on this spob."), com->name);
       *mean = 0;
       *std  = 0;
@@ -241,8 +286,6 @@ int economy_getAverageSpobPrice( const Commodity *com, const Spob *p, credits_t
  */
 int economy_getAveragePrice( const Commodity *com, credits_t *mean, double *std )
 {
-   int i, k;
-   CommodityPrice *commPrice;
    double av = 0;
    double av2 = 0;
    int cnt = 0;
@@ -264,33 +307,22 @@ int economy_getAveragePrice( const Commodity *com, credits_t *mean, double *std
       return com->price;
    }
 
-   /* Get position in stack */
-   k = com - commodity_stack;
-
-   /* Find what commodity this is */
-   for (i=0; i<array_size(econ_comm); i++)
-      if (econ_comm[i] == k)
-         break;
-
-   /* Check if found */
-   if (i >= array_size(econ_comm)) {
+   /* Check if the economy knows about the commodity. */
+   if (!econ_isComputed( com )) {
       WARN(_("Average price for commodity '%s' not known."), com->name);
       *mean = 0;
       *std = 0;
       return 1;
    }
-   for (i=0; i<array_size(systems_stack) ; i++) {
+   for (int i=0; i<array_size(systems_stack) ; i++) {
       StarSystem *sys = &systems_stack[i];
       for (int j=0; j<array_size(sys->spobs); j++) {
          Spob *p = sys->spobs[j];
 
          /* and get the index on this spob */
-         for (k=0; k<array_size(p->commodities); k++) {
-            if ((strcmp(p->commodities[k]->name, com->name) == 0 ))
-               break;
-         }
-         if (k < array_size(p->commodityPrice)) {
-            commPrice=&p->commodityPrice[k];
+         int k = econ_spobCommodityIndex( p, com );
+         if (k >= 0) {
+            const CommodityPrice *commPrice = &p->commodityPrice[k];
             if ( commPrice->cnt>0) {
                av  += commPrice->sum/commPrice->cnt;
                av2 += commPrice->sum*commPrice->sum/(commPrice->cnt*commPrice->cnt);
@@ -710,73 +742,61 @@ static int economy_calcPrice( Spob *spob, Commodity *commodity, CommodityPrice *
  */
 static void economy_modifySystemCommodityPrice( StarSystem *sys )
 {
-   int k;
-   CommodityPrice *avprice;
+   CommodityPrice *avprice = econ_createAveragePrice();
 
-   avprice = array_create( CommodityPrice );
    for (int i=0; i<array_size(sys->spobs); i++) {
       Spob *spob = sys->spobs[i];
       for (int j=0; j<array_size(spob->commodityPrice); j++) {
+         CommodityPrice *cp = &spob->commodityPrice[j];
+         int k = econ_commodityIndex( spob->commodities[j] );
+
         /* Largest is approx 35000.  Increased radius will increase price since further to travel,
            and also increase stability, since longer for prices to fluctuate, but by a larger amount when they do.*/
-         spob->commodityPrice[j].price *= 1 + sys->radius/200e3;
-         spob->commodityPrice[j].spobPeriod *= 1 / (1 - sys->radius/200e3);
-         spob->commodityPrice[j].spobVariation *= 1 / (1 - sys->radius/300e3);
+         cp->price *= 1 + sys->radius/200e3;
+         cp->spobPeriod *= 1 / (1 - sys->radius/200e3);
+         cp->spobVariation *= 1 / (1 - sys->radius/300e3);
 
          /* Increase price with volatility, which goes up to about 600.
             And with interference, since systems are harder to find, which goes up to about 1000.*/
-         spob->commodityPrice[j].price *= 1 + sys->nebu_volatility/600.;
-         spob->commodityPrice[j].price *= 1 + sys->interference/10e3;
+         cp->price *= 1 + sys->nebu_volatility/600.;
+         cp->price *= 1 + sys->interference/10e3;
 
          /* Use number of jumps to determine sytsem time period.  More jumps means more options for trade
             so shorter period.  Between 1 to 6 jumps.  Make the base time 1000.*/
-         spob->commodityPrice[j].sysPeriod = 2000. / (array_size(sys->jumps) + 1);
-
-         for (k=0; k<array_size(avprice); k++) {
-            if ( ( strcmp( spob->commodities[j]->name, avprice[k].name ) == 0 ) ) {
-               avprice[k].updateTime++;
-               avprice[k].price+=spob->commodityPrice[j].price;
-               avprice[k].spobPeriod+=spob->commodityPrice[j].spobPeriod;
-               avprice[k].sysPeriod+=spob->commodityPrice[j].sysPeriod;
-               avprice[k].spobVariation+=spob->commodityPrice[j].spobVariation;
-               avprice[k].sysVariation+=spob->commodityPrice[j].sysVariation;
-               break;
-            }
-         }
-         if ( k == array_size(avprice) ) {/* first visit of this commodity for this system */
-            (void)array_grow( &avprice );
-            avprice[k].name=spob->commodities[j]->name;
-            avprice[k].updateTime=1;
-            avprice[k].price=spob->commodityPrice[j].price;
-            avprice[k].spobPeriod=spob->commodityPrice[j].spobPeriod;
-            avprice[k].sysPeriod=spob->commodityPrice[j].sysPeriod;
-            avprice[k].spobVariation=spob->commodityPrice[j].spobVariation;
-            avprice[k].sysVariation=spob->commodityPrice[j].sysVariation;
-         }
+         cp->sysPeriod = 2000. / (array_size(sys->jumps) + 1);
+
+         if (k < 0)
+            continue;
+         avprice[k].cnt++;
+         avprice[k].price += cp->price;
+         avprice[k].spobPeriod += cp->spobPeriod;
+         avprice[k].sysPeriod += cp->sysPeriod;
+         avprice[k].spobVariation += cp->spobVariation;
+         avprice[k].sysVariation += cp->sysVariation;
       }
    }
    /* Do some inter-spob averaging */
-   for ( k=0; k<array_size(avprice); k++ ) {
-      avprice[k].price/=avprice[k].updateTime;
-      avprice[k].spobPeriod/=avprice[k].updateTime;
-      avprice[k].sysPeriod/=avprice[k].updateTime;
-      avprice[k].spobVariation/=avprice[k].updateTime;
-      avprice[k].sysVariation/=avprice[k].updateTime;
+   for (int k=0; k<array_size(avprice); k++) {
+      if (avprice[k].cnt <= 0)
+         continue;
+      avprice[k].price /= avprice[k].cnt;
+      avprice[k].spobPeriod /= avprice[k].cnt;
+      avprice[k].sysPeriod /= avprice[k].cnt;
+      avprice[k].spobVariation /= avprice[k].cnt;
+      avprice[k].sysVariation /= avprice[k].cnt;
    }
    /* And now apply the averaging */
    for (int i=0; i<array_size(sys->spobs); i++) {
       Spob *spob = sys->spobs[i];
       for (int j=0; j<array_size(spob->commodities); j++) {
-         for ( k=0; k<array_size(avprice); k++ ) {
-            if ( ( strcmp( spob->commodities[j]->name, avprice[k].name ) == 0 ) ) {
-               spob->commodityPrice[j].price*=0.25;
-               spob->commodityPrice[j].price+=0.75*avprice[k].price;
-               spob->commodityPrice[j].sysVariation=0.2*avprice[k].spobVariation;
-            }
-         }
+         int k = econ_commodityIndex( spob->commodities[j] );
+         if (k < 0)
+            continue;
+         spob->commodityPrice[j].price *= 0.25;
+         spob->commodityPrice[j].price += 0.75*avprice[k].price;
+         spob->commodityPrice[j].sysVariation = 0.2*avprice[k].spobVariation;
       }
    }
-   array_shrink( &avprice );
    array_free( sys->averagePrice );
    sys->averagePrice = avprice;
 }
@@ -788,30 +808,26 @@ static void economy_modifySystemCommodityPrice( StarSystem *sys )
  */
 static void economy_smoothCommodityPrice(StarSystem *sys)
 {
-   StarSystem *neighbour;
    CommodityPrice *avprice=sys->averagePrice;
-   double price;
-   int n,i,j,k;
    /*Now modify based on neighbouring systems */
    /*First, calculate mean price of neighbouring systems */
 
-   for ( j =0; j<array_size(avprice); j++ ) {/* for each commodity in this system */
-      price=0.;
-      n=0;
-      for ( i=0; i<array_size(sys->jumps); i++ ) {/* for each neighbouring system */
-         neighbour=sys->jumps[i].target;
-         for ( k=0; k<array_size(neighbour->averagePrice); k++ ) {
-            if ( ( strcmp( neighbour->averagePrice[k].name, avprice[j].name ) == 0 ) ) {
-               price+=neighbour->averagePrice[k].price;
-               n++;
-               break;
-            }
+   for (int k=0; k<array_size(avprice); k++) {/* for each commodity in this system */
+      double price = 0.;
+      int n = 0;
+      if (avprice[k].cnt <= 0)
+         continue;
+      for (int i=0; i<array_size(sys->jumps); i++) {/* for each neighbouring system */
+         const StarSystem *neighbour = sys->jumps[i].target;
+         if ((neighbour->averagePrice != NULL) && (neighbour->averagePrice[k].cnt > 0)) {
+            price += neighbour->averagePrice[k].price;
+            n++;
          }
       }
       if (n!=0)
-         avprice[j].sum=price/n;
+         avprice[k].sum=price/n;
       else
-         avprice[j].sum=avprice[j].price;
+         avprice[k].sum=avprice[k].price;
    }
 }
 
@@ -823,29 +839,23 @@ static void economy_smoothCommodityPrice(StarSystem *sys)
 static void economy_calcUpdatedCommodityPrice(StarSystem *sys)
 {
    CommodityPrice *avprice=sys->averagePrice;
-   Spob *spob;
-   int i,j,k;
-   for ( j=0; j<array_size(avprice); j++ ) {
+   for (int k=0; k<array_size(avprice); k++) {
       /*Use mean price to adjust current price */
-      avprice[j].price=0.5*(avprice[j].price + avprice[j].sum);
+      avprice[k].price=0.5*(avprice[k].price + avprice[k].sum);
    }
    /*and finally modify spobs based on the means */
-   for ( i=0; i<array_size(sys->spobs); i++ ) {
-      spob=sys->spobs[i];
-      for ( j=0; j<array_size(spob->commodities); j++ ) {
-         for ( k=0; k<array_size(avprice); k++ ) {
-            if ( ( strcmp(avprice[k].name, spob->commodities[j]->name) == 0 ) ) {
-               spob->commodityPrice[j].price = (
-                     0.25*spob->commodityPrice[j].price
-                        + 0.75*avprice[k].price );
-               spob->commodityPrice[j].spobVariation = (
-                     0.1 * (0.5*avprice[k].spobVariation
-                           + 0.5*spob->commodityPrice[j].spobVariation) );
-               spob->commodityPrice[j].spobVariation *= spob->commodityPrice[j].price;
-               spob->commodityPrice[j].sysVariation *= spob->commodityPrice[j].price;
-               break;
-            }
-         }
+   for (int i=0; i<array_size(sys->spobs); i++) {
+      Spob *spob = sys->spobs[i];
+      for (int j=0; j<array_size(spob->commodities); j++) {
+         CommodityPrice *cp = &spob->commodityPrice[j];
+         int k = econ_commodityIndex( spob->commodities[j] );
+         if (k < 0)
+            continue;
+         cp->price = 0.25*cp->price + 0.75*avprice[k].price;
+         cp->spobVariation = 0.1 * (0.5*avprice[k].spobVariation
+               + 0.5*cp->spobVariation);
+         cp->spobVariation *= cp->price;
+         cp->sysVariation *= cp->price;
       }
    }
    array_free( sys->averagePrice );
@@ -1029,11 +1039,11 @@ int economy_sysLoad( xmlNodePtr parent )
                         if (xml_isNode(nodeCommodity, "commodity")) {
                            xmlr_attr_strd(nodeCommodity,"name",str);
                            CommodityPrice *cp = NULL;
-                           for (int i=0; i<array_size(spob->commodities); i++) {
-                              if ( (strcmp(str,spob->commodities[i]->name) == 0) ) {
+                           const Commodity *com = commodity_getW( str );
+                           if (com != NULL) {
+                              int i = econ_spobCommodityIndex( spob, com );
+                              if (i >= 0)
                                  cp = &spob->commodityPrice[i];
-                                 break;
-                              }
                            }
                            free(str);
                            if (cp != NULL) {
@@ -1580,7 +1580,7 @@ static void equipment_genOutfitList( unsigned int wid )
    const char *tabnames[] = {
       _("All"), _(OUTFIT_LABEL_WEAPON), _(OUTFIT_LABEL_UTILITY), _(OUTFIT_LABEL_STRUCTURE), _(OUTFIT_LABEL_CORE)
    };
-   int noutfits, active;
+   int noutfits, nfound, active;
    ImageArrayCell *coutfits;
    int iconsize;
    Pilot *p = eq_wgt.selected;
@@ -1646,7 +1646,8 @@ static void equipment_genOutfitList( unsigned int wid )
 
    /* Get the outfits. */
    noutfits = player_getOutfitsFiltered( (const Outfit**)iar_outfits[active], tabfilters[active], filtertext );
-   coutfits = outfits_imageArrayCells( (const Outfit**)iar_outfits[active], &noutfits, (p==NULL) ? player.p : p );
+   nfound   = noutfits;
+   coutfits = outfits_imageArrayCells( (const Outfit**)iar_outfits[active], &noutfits );
 
    /* Create the actual image array. */
    iw = ow - 6;
@@ -1664,6 +1665,8 @@ static void equipment_genOutfitList( unsigned int wid )
          equipment_updateOutfits,
          equipment_rightClickOutfits,
          equipment_rightClickOutfits );
+   outfits_imageArrayFill( wid, EQUIPMENT_OUTFITS, (const Outfit**)iar_outfits[active],
+         nfound, (p==NULL) ? player.p : p );
 
    toolkit_setImageArrayAccept( wid, EQUIPMENT_OUTFITS, equipment_rightClickOutfits );
 }
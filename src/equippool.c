@@ -0,0 +1,261 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file equippool.c
+ *
+ * @brief Pools of solved loadouts for NPC equipping.
+ *
+ * Equipping a pilot through equipopt builds and solves a mixed integer
+ * program, which is by far the most expensive part of spawning a fleet. The
+ * result only depends on the ship, the equipment script and its parameters
+ * plus some random noise, so the first few loadouts solved for each of those
+ * keys are kept and later pilots get one of them at random instead.
+ *
+ * Each loadout is stored as the outfit in every slot of the ship along with a
+ * Lua value (stored in the registry) the equipment script wants to restore
+ * on the pilot, such as its parameters.
+ */
+/** @cond */
+#include <stdlib.h>
+#include <string.h>
+
+#include "naev.h"
+/** @endcond */
+
+#include "equippool.h"
+
+#include "array.h"
+#include "conf.h"
+#include "log.h"
+#include "nlua.h"
+#include "pilot_outfit.h"
+#include "rng.h"
+
+#define EQUIPPOOL_MAX   1024 /**< Maximum number of pools, keys past it don't get pooled. */
+
+/**
+ * @brief A solved loadout.
+ */
+typedef struct EquipLoadout_ {
+   const Outfit **outfits; /**< Outfit per ship slot, NULL if empty (array.h). */
+   int data;               /**< Lua registry reference to the data to restore. */
+} EquipLoadout;
+
+/**
+ * @brief All the loadouts solved for a key.
+ */
+typedef struct EquipPool_ {
+   uint64_t key;           /**< Key of the pool. */
+   const Ship *ship;       /**< Ship the loadouts belong to. */
+   EquipLoadout *loadouts; /**< Solved loadouts (array.h). */
+   double solvetime;       /**< Total time spent solving the loadouts. */
+   int nsolved;            /**< Number of loadouts solved. */
+} EquipPool;
+
+static EquipPool *equippool_pools = NULL; /**< Pools sorted by key (array.h). */
+static int equippool_hits   = 0;    /**< Pilots equipped from a pool. */
+static int equippool_misses = 0;    /**< Pilots that had to be solved. */
+static double equippool_saved = 0.; /**< Estimated solving time saved in seconds. */
+
+/*
+ * Prototypes.
+ */
+static EquipPool *equippool_find( uint64_t key, int create );
+static void equippool_freeLoadout( EquipLoadout *l );
+static void equippool_apply( Pilot *p, const EquipLoadout *l );
+
+/**
+ * @brief Finds the pool of a key.
+ *
+ *    @param key Key to look up.
+ *    @param create Whether to create the pool if it doesn't exist.
+ *    @return The pool or NULL if not found.
+ */
+static EquipPool *equippool_find( uint64_t key, int create )
+{
+   int lo = 0;
+   int hi = array_size(equippool_pools);
+   EquipPool *ep;
+
+   /* Lower bound. */
+   while (lo < hi) {
+      int mid = (lo+hi)/2;
+      if (equippool_pools[mid].key < key)
+         lo = mid+1;
+      else
+         hi = mid;
+   }
+   if ((lo < array_size(equippool_pools)) && (equippool_pools[lo].key == key))
+      return &equippool_pools[lo];
+   if (!create)
+      return NULL;
+
+   if (equippool_pools == NULL)
+      equippool_pools = array_create( EquipPool );
+   array_grow( &equippool_pools ).key = key;
+   memmove( &equippool_pools[lo+1], &equippool_pools[lo],
+         sizeof(EquipPool) * (array_size(equippool_pools)-lo-1) );
+   ep = &equippool_pools[lo];
+   memset( ep, 0, sizeof(EquipPool) );
+   ep->key = key;
+   return ep;
+}
+
+/**
+ * @brief Frees a loadout.
+ */
+static void equippool_freeLoadout( EquipLoadout *l )
+{
+   array_free( l->outfits );
+   luaL_unref( naevL, LUA_REGISTRYINDEX, l->data );
+}
+
+/**
+ * @brief Puts a loadout on a pilot.
+ *
+ * Locked slots are left alone like p:outfitRm("all") does.
+ *
+ *    @param p Pilot to equip.
+ *    @param l Loadout to equip.
+ */
+static void equippool_apply( Pilot *p, const EquipLoadout *l )
+{
+   for (int i=0; i<array_size(p->outfits); i++) {
+      PilotOutfitSlot *s = p->outfits[i];
+      const Outfit *o = l->outfits[i];
+
+      if (s->sslot->locked || (s->outfit == o))
+         continue;
+
+      if (s->outfit != NULL)
+         pilot_rmOutfitRaw( p, s );
+      if ((o != NULL) && (pilot_addOutfitRaw( p, o, s ) == 0)) {
+         pilot_outfitLInit( p, s );
+         pilot_addAmmo( p, s, pilot_maxAmmoO(p,o) );
+      }
+   }
+
+   pilot_calcStats( p );
+   if (p->autoweap)
+      pilot_weaponAuto( p );
+}
+
+/**
+ * @brief Equips a pilot from the pool of a key if it is full.
+ *
+ * While the pool is not full the caller is expected to solve the loadout and
+ * add it with equippool_add().
+ *
+ *    @param p Pilot to equip.
+ *    @param key Key identifying the ship, equipment script and parameters.
+ *    @param[out] data Registry reference to the data stored with the loadout.
+ *    @return 1 if the pilot was equipped, 0 if it has to be solved.
+ */
+int equippool_get( Pilot *p, uint64_t key, int *data )
+{
+   EquipPool *ep;
+   const EquipLoadout *l;
+
+   if (conf.equip_pool <= 0)
+      return 0;
+
+   ep = equippool_find( key, 0 );
+   if ((ep == NULL) || (ep->ship != p->ship) ||
+         (array_size(ep->loadouts) < conf.equip_pool)) {
+      equippool_misses++;
+      return 0;
+   }
+
+   /* Sample a loadout to keep variety. */
+   l = &ep->loadouts[ RNG( 0, array_size(ep->loadouts)-1 ) ];
+   equippool_apply( p, l );
+   *data = l->data;
+
+   equippool_hits++;
+   equippool_saved += ep->solvetime / (double)ep->nsolved;
+   return 1;
+}
+
+/**
+ * @brief Adds the loadout a pilot was just equipped with to a pool.
+ *
+ *    @param p Pilot that was equipped.
+ *    @param key Key identifying the ship, equipment script and parameters.
+ *    @param data Registry reference to data to store with the loadout, the pool takes ownership.
+ *    @param solvetime Time it took to solve the loadout in seconds.
+ */
+void equippool_add( const Pilot *p, uint64_t key, int data, double solvetime )
+{
+   EquipPool *ep;
+   EquipLoadout *l;
+
+   if (conf.equip_pool <= 0) {
+      luaL_unref( naevL, LUA_REGISTRYINDEX, data );
+      return;
+   }
+
+   ep = equippool_find( key, 0 );
+   if ((ep == NULL) && (array_size(equippool_pools) >= EQUIPPOOL_MAX)) {
+      luaL_unref( naevL, LUA_REGISTRYINDEX, data );
+      return;
+   }
+   if (ep == NULL)
+      ep = equippool_find( key, 1 );
+   if (ep->loadouts == NULL) {
+      ep->ship = p->ship;
+      ep->loadouts = array_create_size( EquipLoadout, conf.equip_pool );
+   }
+   else if (ep->ship != p->ship) {
+      WARN(_("Loadout pool key collision between ships '%s' and '%s'!"), ep->ship->name, p->ship->name);
+      luaL_unref( naevL, LUA_REGISTRYINDEX, data );
+      return;
+   }
+   ep->solvetime += solvetime;
+   ep->nsolved++;
+
+   /* Replace a random one if full, which can happen if the pool size changes. */
+   if (array_size(ep->loadouts) >= conf.equip_pool) {
+      l = &ep->loadouts[ RNG( 0, array_size(ep->loadouts)-1 ) ];
+      equippool_freeLoadout( l );
+   }
+   else
+      l = &array_grow( &ep->loadouts );
+
+   l->outfits = array_create_size( const Outfit*, array_size(p->outfits) );
+   for (int i=0; i<array_size(p->outfits); i++)
+      array_push_back( &l->outfits, p->outfits[i]->outfit );
+   l->data = data;
+}
+
+/**
+ * @brief Clears all the pools.
+ *
+ * Has to be called whenever what the equipment scripts do may change, such as
+ * when unidiffs are applied.
+ */
+void equippool_clear (void)
+{
+   for (int i=0; i<array_size(equippool_pools); i++) {
+      EquipPool *ep = &equippool_pools[i];
+      for (int j=0; j<array_size(ep->loadouts); j++)
+         equippool_freeLoadout( &ep->loadouts[j] );
+      array_free( ep->loadouts );
+   }
+   array_free( equippool_pools );
+   equippool_pools = NULL;
+}
+
+/**
+ * @brief Gets the statistics of the loadout pools.
+ *
+ *    @param[out] hits Number of pilots equipped from a pool.
+ *    @param[out] misses Number of pilots that had to be solved.
+ *    @param[out] saved Estimated solving time saved in seconds.
+ */
+void equippool_stats( int *hits, int *misses, double *saved )
+{
+   *hits   = equippool_hits;
+   *misses = equippool_misses;
+   *saved  = equippool_saved;
+}
@@ -0,0 +1,15 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+#pragma once
+
+/** @cond */
+#include <stdint.h>
+/** @endcond */
+
+#include "pilot.h"
+
+int equippool_get( Pilot *p, uint64_t key, int *data );
+void equippool_add( const Pilot *p, uint64_t key, int data, double solvetime );
+void equippool_clear (void);
+void equippool_stats( int *hits, int *misses, double *saved );
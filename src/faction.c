@@ -20,6 +20,7 @@
 #include "colour.h"
 #include "hook.h"
 #include "log.h"
+#include "nameidx.h"
 #include "ndata.h"
 #include "nlua.h"
 #include "nluadef.h"
@@ -104,6 +105,7 @@ typedef struct Faction_ {
 } Faction;
 
 static Faction* faction_stack = NULL; /**< Faction stack. */
+static NameIdx faction_nidx = NAMEIDX_INIT( Faction, name ); /**< Index of the factions by name, dynamic ones included. */
 static int* faction_grid = NULL; /**< Grid of faction status. */
 static size_t faction_mgrid = 0; /**< Allocated memory. */
 
@@ -139,27 +141,15 @@ static int faction_cmp( const void *p1, const void *p2 )
  */
 static int faction_getRaw( const char* name )
 {
+   if (name == NULL)
+      return -1;
+
    /* Escorts are part of the "player" faction. */
    if (strcmp(name, "Escort") == 0)
       return FACTION_PLAYER;
 
-   if (name != NULL) {
-      int i;
-      for (i=0; i<array_size(faction_stack); i++)
-         if (strcmp(faction_stack[i].name, name)==0)
-            break;
-
-      if (i != array_size(faction_stack))
-         return i;
-
-      /* Dynamic factions are why we can't have nice things.
-      const Faction f = { .name = (char*)name };
-      Faction *found = bsearch( &f, faction_stack, array_size(faction_stack), sizeof(Faction), faction_cmp );
-      if (found != NULL)
-         return found - faction_stack;
-      */
-   }
-   return -1;
+   /* Dynamic factions are appended unsorted, so a hash is used instead of bsearch. */
+   return nameidx_get( &faction_nidx, faction_stack, array_size(faction_stack), name );
 }
 
 /**
@@ -1606,6 +1596,7 @@ int factions_load (void)
 
    /* Sort by name. */
    qsort( faction_stack, array_size(faction_stack), sizeof(Faction), faction_cmp );
+   nameidx_invalidate( &faction_nidx );
    faction_player = faction_get("Player");
 
    /* Second pass - sets allies and enemies */
@@ -1700,6 +1691,7 @@ void factions_free (void)
       faction_freeOne( &faction_stack[i] );
    array_free(faction_stack);
    faction_stack = NULL;
+   nameidx_free( &faction_nidx );
 
    /* Clean up faction grid. */
    free( faction_grid );
@@ -1856,6 +1848,7 @@ void factions_clearDynamic (void)
          i--;
       }
    }
+   nameidx_invalidate( &faction_nidx );
    faction_computeGrid();
 }
 
@@ -1872,6 +1865,7 @@ int faction_dynAdd( int base, const char* name, const char* display, const char*
    Faction *f = &array_grow( &faction_stack );
    memset( f, 0, sizeof(Faction) );
    f->name        = strdup( name );
+   nameidx_invalidate( &faction_nidx );
    f->displayname = (display==NULL) ? NULL : strdup( display );
    f->ai          = (ai==NULL) ? NULL : strdup( ai );
    f->allies      = array_create( int );
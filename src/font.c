@@ -16,9 +16,6 @@
 #include FT_FREETYPE_H
 #include FT_GLYPH_H
 #include FT_MODULE_H
-#include <wctype.h>
-#include "linebreak.h"
-#include "linebreakdef.h"
 
 #include "naev.h"
 /** @endcond */
@@ -28,6 +25,7 @@
 #include "array.h"
 #include "conf.h"
 #include "distance_field.h"
+#include "font_layout.h"
 #include "log.h"
 #include "ndata.h"
 #include "nfile.h"
@@ -158,15 +156,20 @@ glFont gl_defFontMono; /**< Default mono font. */
 static const glColour *font_lastCol    = NULL; /**< Stores last colour used (activated by FONT_COLOUR_CODE). */
 static int font_restoreLast      = 0; /**< Restore last colour. */
 
+/* Layout cache. */
+static const char *font_layoutLang = NULL; /**< Language the cached layouts were made for. */
+
 /*
  * prototypes
  */
 static int gl_fontstashAddFallback( glFontStash* stsh, const char *fname, unsigned int h );
 static size_t font_limitSize( glFontStash *stsh, int *width, const char *text, const int max );
 static const glColour* gl_fontGetColour( uint32_t ch );
-static uint32_t font_nextChar( const char *s, size_t *i );
 /* Get unicode glyphs from cache. */
 static glFontGlyph* gl_fontGetGlyph( glFontStash *stsh, uint32_t ch );
+static float gl_fontAdvance( void *data, uint32_t ch );
+static const glFontLayout* font_layoutLines( const glFont *ft_font, int width, const char *text );
+static void font_layoutCheckLang (void);
 /* Render.
  * TODO this should be changed to be more like font-stash (https://github.com/akrinke/Font-Stash)
  * In particular, instead of writing char by char, they should be batched up by textures and rendered
@@ -457,11 +460,20 @@ static size_t font_limitSize( glFontStash *stsh, int *width, const char *text, c
    GLfloat n;
    size_t i;
    uint32_t ch;
+   glFontLayout *l;
 
    /* Avoid segfaults. */
    if ((text == NULL) || (text[0]=='\0'))
       return 0;
 
+   /* See if it's cached. */
+   l = font_layoutGet( stsh - avail_fonts, FONT_LAYOUT_LIMIT, max, text );
+   if (l != NULL) {
+      if (width != NULL)
+         (*width) = l->w;
+      return l->limit;
+   }
+
    /* limit size */
    gl_fontKernStart();
    i = 0;
@@ -489,11 +501,57 @@ static size_t font_limitSize( glFontStash *stsh, int *width, const char *text, c
       }
    }
 
+   l = font_layoutAdd( stsh - avail_fonts, FONT_LAYOUT_LIMIT, max, text );
+   l->w     = (int)round(n);
+   l->limit = i;
+
    if (width != NULL)
       (*width) = (int)round(n);
    return i;
 }
 
+/**
+ * @brief Gets the line breaks of a text, using the layout cache.
+ *
+ * The layout is only valid until the next layout is computed.
+ *
+ *    @param ft_font Font to use.
+ *    @param width Maximum width of a line.
+ *    @param text Text to split.
+ *    @return The layout of the text.
+ */
+static const glFontLayout* font_layoutLines( const glFont *ft_font, int width, const char *text )
+{
+   glPrintLineIterator iter;
+   glFontLayout *l;
+
+   font_layoutCheckLang();
+   l = font_layoutGet( ft_font->id, FONT_LAYOUT_LINES, width, text );
+   if (l != NULL)
+      return l;
+
+   l = font_layoutAdd( ft_font->id, FONT_LAYOUT_LINES, width, text );
+   gl_printLineIteratorInit( &iter, ft_font, text, width );
+   while (gl_printLineIteratorNext( &iter ))
+      font_layoutAddLine( l, iter.l_begin, iter.l_end, iter.l_width );
+   return l;
+}
+
+/**
+ * @brief Checks to see if the cached layouts are still valid.
+ *
+ * Line breaking depends on the language, so they have to be redone if it
+ * changes.
+ */
+static void font_layoutCheckLang (void)
+{
+   const char *lang = gettext_getLanguage();
+   if (lang == font_layoutLang)
+      return;
+   font_layoutClear();
+   font_layoutLang = lang;
+}
+
 /**
  * @brief Initialize an iterator object for breaking text into lines.
  *
@@ -510,11 +568,15 @@ void gl_printLineIteratorInit( glPrintLineIterator *iter, const glFont *ft_font,
    iter->width = width;
 }
 
-typedef struct _linepos_t_ {
-   size_t i;    /**< Byte index of the current char */
-   uint32_t ch; /**< Current code point */
-   GLfloat w;   /**< Current width (line start to left side of current character) */
-} _linepos_t;
+/**
+ * @brief Gets the advance of a character for breaking lines.
+ */
+static float gl_fontAdvance( void *data, uint32_t ch )
+{
+   glFontStash *stsh = data;
+   glFontGlyph *glyph = gl_fontGetGlyph( stsh, ch );
+   return (glyph==NULL) ? 0 : gl_fontKernGlyph( stsh, ch, glyph ) + glyph->adv_x;
+}
 
 /**
  * @brief Updates \p iter with the next line's information.
@@ -524,81 +586,9 @@ typedef struct _linepos_t_ {
  */
 int gl_printLineIteratorNext( glPrintLineIterator* iter )
 {
-   glFontStash *stsh = gl_fontGetStash( iter->ft_font );
-   int brk, can_break, can_fit, any_char_fit = 0, any_word_fit;
-   size_t char_end = iter->l_next;
-   struct LineBreakContext lbc;
-
-   if (iter->dead)
-      return 0;
-
    /* limit size per line */
    gl_fontKernStart();
-
-   /* Initialize line break stuff. */
-   iter->l_begin = iter->l_next;
-   iter->l_end = iter->l_begin;
-   _linepos_t pos = { .i = char_end, .w = 0. };
-   pos.ch = font_nextChar( iter->text, &char_end );
-   lb_init_break_context( &lbc, pos.ch, gettext_getLanguage() );
-
-   while (pos.ch != '\0') {
-      glFontGlyph *glyph = gl_fontGetGlyph( stsh, pos.ch );
-      GLfloat glyph_w = glyph==NULL ? 0 : gl_fontKernGlyph( stsh, pos.ch, glyph ) + glyph->adv_x;
-      _linepos_t nextpos = { .i = char_end, .w = pos.w + glyph_w };
-      nextpos.ch = font_nextChar( iter->text, &char_end );
-      brk = lb_process_next_char( &lbc, nextpos.ch );
-      can_break = (brk == LINEBREAK_ALLOWBREAK && !iter->no_soft_breaks) || brk == LINEBREAK_MUSTBREAK;
-      can_fit = (iter->width >= (int)round(nextpos.w));
-      any_word_fit = (iter->l_end != iter->l_begin);
-      /* Emergency situations: */
-      can_break |= !can_fit && !any_word_fit;
-      can_fit |= !any_char_fit;
-
-      if (can_break && iswspace( pos.ch )) {
-         iter->l_width = (int)round(pos.w);
-         /* IMPORTANT: when eating a space, we can't backtrack to a previous position, because there might be a skipped font markup sequence in between. */
-         iter->l_end = iter->l_next = nextpos.i;
-         u8_dec( iter->text, &iter->l_end );
-      }
-      else if (can_break && can_fit) {
-         iter->l_width = (int)round(nextpos.w);
-         iter->l_end = iter->l_next = nextpos.i;
-      }
-      else if (!can_fit && !any_word_fit) {
-         iter->l_width = (int)round(pos.w);
-         iter->l_end = iter->l_next = pos.i;
-      }
-
-      if (!can_fit || brk == LINEBREAK_MUSTBREAK)
-         return 1;
-
-      any_char_fit = 1;
-      pos = nextpos;
-   }
-
-   /* Ran out of text. */
-   iter->l_width = (int)round(pos.w);
-   iter->l_end = iter->l_next = char_end;
-   iter->dead = 1;
-   return 1;
-}
-
-/** @brief Reads the next utf-8 sequence out of a string, updating an index. Skips font markup directives.
- * @TODO For now, this enforces font.c's inability to handle tabs.
- */
-static uint32_t font_nextChar( const char *s, size_t *i )
-{
-   uint32_t ch = s[*i]; /* To be corrected: the character starting at byte *i. Whether it's zero or not is already correct. */
-   while (ch != 0) {
-      ch = u8_nextchar(s, i);
-      if (ch != FONT_COLOUR_CODE)
-         return ch;
-      ch = u8_nextchar(s, i); /* Skip the operand and try again. */
-      if (ch == FONT_COLOUR_CODE)
-         return ch; /* Doubled escape char represents the escape char itself. */
-   }
-   return 0;
+   return font_breakNext( iter, gettext_getLanguage(), gl_fontAdvance, gl_fontGetStash( iter->ft_font ) );
 }
 
 /**
@@ -874,7 +864,7 @@ int gl_printTextRaw( const glFont *ft_font,
       const char *text
     )
 {
-   glPrintLineIterator iter;
+   const glFontLayout *layout;
    int s;
    double x,y;
    uint32_t ch;
@@ -894,14 +884,16 @@ int gl_printTextRaw( const glFont *ft_font,
    gl_printRestoreClear();
 
    s = 0;
-   gl_printLineIteratorInit( &iter, ft_font, text, width );
-   while ((y - by > -1e-5) && gl_printLineIteratorNext( &iter )) {
+   layout = font_layoutLines( ft_font, width, text );
+   for (int l=0; (l<layout->nlines) && (y - by > -1e-5); l++) {
+      const glFontLayoutLine *line = &layout->lines[l];
+
       /* Must restore stuff. */
       gl_printRestoreLast();
 
       /* Render it. */
       gl_fontRenderStart( stsh, x, y, c, outlineR );
-      for (size_t i = iter.l_begin; i < iter.l_end; ) {
+      for (size_t i = line->begin; i < line->end; ) {
          ch = u8_nextchar( text, &i );
          s = gl_fontRenderGlyph( stsh, ch, c, s );
       }
@@ -962,11 +954,17 @@ int gl_printWidthRaw( const glFont *ft_font, const char *text )
    GLfloat n, nmax;
    size_t i;
    uint32_t ch;
+   glFontLayout *l;
 
    if (ft_font == NULL)
       ft_font = &gl_defFont;
    glFontStash *stsh = gl_fontGetStash( ft_font );
 
+   /* See if it's cached. */
+   l = font_layoutGet( ft_font->id, FONT_LAYOUT_WIDTH, 0, text );
+   if (l != NULL)
+      return l->w;
+
    gl_fontKernStart();
    nmax = n = 0.;
    i = 0;
@@ -985,7 +983,9 @@ int gl_printWidthRaw( const glFont *ft_font, const char *text )
    }
    nmax = MAX( nmax, n );
 
-   return (int)round(nmax);
+   l = font_layoutAdd( ft_font->id, FONT_LAYOUT_WIDTH, 0, text );
+   l->w = (int)round(nmax);
+   return l->w;
 }
 
 /**
@@ -1026,9 +1026,9 @@ int gl_printWidth( const glFont *ft_font, const char *fmt, ... )
 int gl_printHeightRaw( const glFont *ft_font,
       const int width, const char *text )
 {
-   glPrintLineIterator iter;
+   const glFontLayout *layout;
    int line_height;
-   double y = 0.;
+   double y;
 
    /* Check 0 length strings. */
    if (text[0] == '\0')
@@ -1038,9 +1038,8 @@ int gl_printHeightRaw( const glFont *ft_font,
       ft_font = &gl_defFont;
 
    line_height = 1.5*(double)ft_font->h;
-   gl_printLineIteratorInit( &iter, ft_font, text, width );
-   while (gl_printLineIteratorNext( &iter ))
-      y += line_height;
+   layout = font_layoutLines( ft_font, width, text );
+   y = (double)layout->nlines * line_height;
 
    return (int)y - line_height + ft_font->h + 1;
 }
@@ -1085,9 +1084,6 @@ int gl_printHeight( const glFont *ft_font,
 int gl_printLinesRaw( const glFont *ft_font,
       const int width, const char *text )
 {
-   glPrintLineIterator iter;
-   int n = 0;
-
    /* Check 0 length strings. */
    if (text[0] == '\0')
       return 0;
@@ -1095,11 +1091,7 @@ int gl_printLinesRaw( const glFont *ft_font,
    if (ft_font == NULL)
       ft_font = &gl_defFont;
 
-   gl_printLineIteratorInit( &iter, ft_font, text, width );
-   while (gl_printLineIteratorNext( &iter ))
-      n++;
-
-   return n;
+   return font_layoutLines( ft_font, width, text )->nlines;
 }
 
 /**
@@ -1196,7 +1188,10 @@ static int font_makeChar( glFontStash *stsh, font_char_t *c, uint32_t ch )
             for (int u=0; u<w; u++)
                buffer[ (b+v)*rw+(b+u) ] = bitmap.buffer[ v*w+u ];
          /* Compute signed fdistance field with buffered glyph. */
-         c->dataf = make_distance_mapbf( buffer, rw, rh, &vmax );
+         if (conf.font_sdf_legacy)
+            c->dataf = make_distance_mapbf( buffer, rw, rh, &vmax );
+         else
+            c->dataf = make_distance_mapbf_fh( buffer, rw, rh, &vmax );
          free( buffer );
       }
       c->w     = rw;
@@ -1532,6 +1527,9 @@ int gl_fontInit( glFont* font, const char *fname, const unsigned int h, const ch
    if (fname == NULL)
       fname = FONT_DEFAULT_PATH;
 
+   /* Font IDs and metrics may change. */
+   font_layoutClear();
+
    /* Get font stash. */
    if (avail_fonts==NULL)
       avail_fonts = array_create( glFontStash );
@@ -1651,6 +1649,9 @@ static int gl_fontstashAddFallback( glFontStash* stsh, const char *fname, unsign
 {
    glFontStashFreetype ft = {.file=NULL, .face=NULL};
 
+   /* Metrics may change. */
+   font_layoutClear();
+
    /* Set up file data. Reference a loaded copy if we have one. */
    for (int i=0; i<array_size(avail_fonts); i++) {
       if (avail_fonts[i].ft == NULL)
@@ -1730,6 +1731,7 @@ void gl_freeFont( glFont* font )
    if (stsh->refcount > 0)
       return;
    /* Not references and must eliminate. */
+   font_layoutClear();
 
    for (int i=0; i<array_size(stsh->ft); i++)
       gl_fontstashftDestroy( &stsh->ft[i] );
@@ -1769,8 +1771,10 @@ static void gl_fontstashftDestroy( glFontStashFreetype *ft )
  */
 void gl_fontExit (void)
 {
+   font_layoutClear();
    FT_Done_FreeType( font_library );
    font_library = NULL;
+   distance_field_cleanup();
    array_free( avail_fonts );
    avail_fonts = NULL;
 }
@@ -3,11 +3,10 @@
  */
 #pragma once
 
+#include "font_break.h"
 #include "nstring.h"
 #include "opengl.h"
 
-#define FONT_COLOUR_CODE      '#'
-
 #define FONT_FLAG_DONTREUSE   (1<<1) /**< Don't reuse the font if it's loaded somewhere else. */
 
 /**
@@ -28,26 +27,6 @@ typedef struct glFontRestore_s {
    const glColour *col; /**< Colour to restore. */
 } glFontRestore;
 
-/**
- * @brief The state of a line iteration. This matches the process of rendering text into an on-screen box:
- * An empty string produces a zero-width line. Each regular, fitting character expands its line horizontally.
- * A newline or wrapping leads to vertical expansion.
- * Word-wrapping happens at "line break opportunities" (defined by Unicode), or mid-word if there's no other way to fit in the width limit.
- * The iterator honors the width limit if at all possible; the only exception is when a single character is enough to overflow it.
- * The layout calculation is iterative; one may for instance change the width limit between lines.
- * \see gl_printLineIteratorInit, gl_printLineIteratorNext.
- */
-typedef struct glPrintLineIterator_s {
-   const char *text;            /**< Text to split. */
-   const glFont *ft_font;       /**< Font to use. */
-   int width;                   /**< Maximum width of a line. */
-   int l_width;                 /**< The current line's actual width. */
-   size_t l_begin, l_end;       /**< The current line's location (&text[l_begin], inclusive, to &text[l_end], exclusive). */
-   size_t l_next;               /**< Starting point for next iteration, i.e., l_end plus any spaces that became a line break. */
-   uint8_t dead;                /**< Did we emit a line where the text ends? */
-   uint8_t no_soft_breaks;      /**< Disable word wrapping, e.g. for one-line input widgets. */
-} glPrintLineIterator;
-
 /*
  * glFont loading / freeing
  *
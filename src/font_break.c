@@ -0,0 +1,115 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file font_break.c
+ *
+ * @brief Breaks text into lines that fit a width, following the Unicode line
+ * breaking rules.
+ *
+ * Glyph metrics come from the caller so that this doesn't depend on OpenGL
+ * or the rest of the game, and can be used by the font layout benchmark.
+ */
+/** @cond */
+#include <math.h>
+#include <wctype.h>
+#include "linebreak.h"
+#include "linebreakdef.h"
+/** @endcond */
+
+#include "font_break.h"
+
+#include "utf8.h"
+
+/**
+ * @brief A position in the line being broken.
+ */
+typedef struct _linepos_t_ {
+   size_t i;    /**< Byte index of the current char */
+   uint32_t ch; /**< Current code point */
+   float w;     /**< Current width (line start to left side of current character) */
+} _linepos_t;
+
+/**
+ * @brief Updates \p iter with the next line's information.
+ *
+ *    @param iter Iterator to update.
+ *    @param lang Language to break the text for.
+ *    @param advance Gets the advance of each character, called in order
+ *           starting from the beginning of the line.
+ *    @param data Passed to \p advance.
+ *    @return nonzero if there's a line.
+ */
+int font_breakNext( glPrintLineIterator* iter, const char *lang, FontBreakAdvance advance, void *data )
+{
+   int brk, can_break, can_fit, any_char_fit = 0, any_word_fit;
+   size_t char_end = iter->l_next;
+   struct LineBreakContext lbc;
+
+   if (iter->dead)
+      return 0;
+
+   /* Initialize line break stuff. */
+   iter->l_begin = iter->l_next;
+   iter->l_end = iter->l_begin;
+   _linepos_t pos = { .i = char_end, .w = 0. };
+   pos.ch = font_nextChar( iter->text, &char_end );
+   lb_init_break_context( &lbc, pos.ch, lang );
+
+   while (pos.ch != '\0') {
+      float glyph_w = advance( data, pos.ch );
+      _linepos_t nextpos = { .i = char_end, .w = pos.w + glyph_w };
+      nextpos.ch = font_nextChar( iter->text, &char_end );
+      brk = lb_process_next_char( &lbc, nextpos.ch );
+      can_break = (brk == LINEBREAK_ALLOWBREAK && !iter->no_soft_breaks) || brk == LINEBREAK_MUSTBREAK;
+      can_fit = (iter->width >= (int)round(nextpos.w));
+      any_word_fit = (iter->l_end != iter->l_begin);
+      /* Emergency situations: */
+      can_break |= !can_fit && !any_word_fit;
+      can_fit |= !any_char_fit;
+
+      if (can_break && iswspace( pos.ch )) {
+         iter->l_width = (int)round(pos.w);
+         /* IMPORTANT: when eating a space, we can't backtrack to a previous position, because there might be a skipped font markup sequence in between. */
+         iter->l_end = iter->l_next = nextpos.i;
+         u8_dec( iter->text, &iter->l_end );
+      }
+      else if (can_break && can_fit) {
+         iter->l_width = (int)round(nextpos.w);
+         iter->l_end = iter->l_next = nextpos.i;
+      }
+      else if (!can_fit && !any_word_fit) {
+         iter->l_width = (int)round(pos.w);
+         iter->l_end = iter->l_next = pos.i;
+      }
+
+      if (!can_fit || brk == LINEBREAK_MUSTBREAK)
+         return 1;
+
+      any_char_fit = 1;
+      pos = nextpos;
+   }
+
+   /* Ran out of text. */
+   iter->l_width = (int)round(pos.w);
+   iter->l_end = iter->l_next = char_end;
+   iter->dead = 1;
+   return 1;
+}
+
+/** @brief Reads the next utf-8 sequence out of a string, updating an index. Skips font markup directives.
+ * @TODO For now, this enforces font.c's inability to handle tabs.
+ */
+uint32_t font_nextChar( const char *s, size_t *i )
+{
+   uint32_t ch = s[*i]; /* To be corrected: the character starting at byte *i. Whether it's zero or not is already correct. */
+   while (ch != 0) {
+      ch = u8_nextchar(s, i);
+      if (ch != FONT_COLOUR_CODE)
+         return ch;
+      ch = u8_nextchar(s, i); /* Skip the operand and try again. */
+      if (ch == FONT_COLOUR_CODE)
+         return ch; /* Doubled escape char represents the escape char itself. */
+   }
+   return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file font_layout.c
+ *
+ * @brief Cache of text layouts so strings drawn every frame don't have to be
+ * decoded, measured and wrapped every frame.
+ *
+ * The cache is set associative with LRU eviction within each set. Entries
+ * are only valid until the next call to font_layoutAdd(), as it may evict
+ * them. Doesn't depend on OpenGL or the rest of the game so it can be used by
+ * the font layout benchmark.
+ */
+/** @cond */
+#include <stdlib.h>
+#include <string.h>
+/** @endcond */
+
+#include "font_layout.h"
+
+#define FONT_LAYOUT_SETS   256 /**< Number of sets, must be a power of two. */
+#define FONT_LAYOUT_WAYS   4   /**< Entries per set. */
+
+static glFontLayout font_layouts[FONT_LAYOUT_SETS][FONT_LAYOUT_WAYS]; /**< The cache. */
+static unsigned int font_layout_clock = 0; /**< Increases with each use, for LRU. */
+static int font_layout_hits   = 0; /**< Number of layouts found in the cache. */
+static int font_layout_misses = 0; /**< Number of layouts not found in the cache. */
+
+/*
+ * Prototypes.
+ */
+static uint32_t font_layoutHash( int font, glFontLayoutType type, int width, const char *text );
+
+/**
+ * @brief Hashes the key of a layout (FNV-1a).
+ */
+static uint32_t font_layoutHash( int font, glFontLayoutType type, int width, const char *text )
+{
+   uint32_t h = 2166136261u;
+   for (const unsigned char *c=(const unsigned char*)text; *c!='\0'; c++) {
+      h ^= *c;
+      h *= 16777619u;
+   }
+   h ^= (uint32_t)font * 0x9E3779B1u;
+   h ^= (uint32_t)type * 0x85EBCA77u;
+   h ^= (uint32_t)width * 0xC2B2AE3Du;
+   return h ^ (h >> 16);
+}
+
+/**
+ * @brief Looks up a layout in the cache.
+ *
+ *    @param font Font ID.
+ *    @param type Type of layout.
+ *    @param width Width the layout is for.
+ *    @param text Text of the layout.
+ *    @return The layout or NULL if not cached.
+ */
+glFontLayout *font_layoutGet( int font, glFontLayoutType type, int width, const char *text )
+{
+   uint32_t h = font_layoutHash( font, type, width, text );
+   glFontLayout *set = font_layouts[ h & (FONT_LAYOUT_SETS-1) ];
+   for (int i=0; i<FONT_LAYOUT_WAYS; i++) {
+      glFontLayout *l = &set[i];
+      if ((l->text == NULL) || (l->hash != h) || (l->font != font) ||
+            (l->type != type) || (l->width != width) || (strcmp( l->text, text ) != 0))
+         continue;
+      l->used = ++font_layout_clock;
+      font_layout_hits++;
+      return l;
+   }
+   font_layout_misses++;
+   return NULL;
+}
+
+/**
+ * @brief Adds an empty layout to the cache, evicting the least recently used
+ * layout of its set if necessary.
+ *
+ *    @param font Font ID.
+ *    @param type Type of layout.
+ *    @param width Width the layout is for.
+ *    @param text Text of the layout.
+ *    @return The new layout to fill in.
+ */
+glFontLayout *font_layoutAdd( int font, glFontLayoutType type, int width, const char *text )
+{
+   uint32_t h = font_layoutHash( font, type, width, text );
+   glFontLayout *set = font_layouts[ h & (FONT_LAYOUT_SETS-1) ];
+   glFontLayout *l = &set[0];
+   for (int i=1; i<FONT_LAYOUT_WAYS; i++) {
+      if (l->text == NULL)
+         break;
+      if ((set[i].text == NULL) || (set[i].used < l->used))
+         l = &set[i];
+   }
+
+   /* Reuse the memory of the lines. */
+   free( l->text );
+   l->font     = font;
+   l->type     = type;
+   l->width    = width;
+   l->hash     = h;
+   l->text     = strdup( text );
+   l->nlines   = 0;
+   l->w        = 0;
+   l->limit    = 0;
+   l->used     = ++font_layout_clock;
+   return l;
+}
+
+/**
+ * @brief Appends a line to a layout.
+ *
+ *    @param layout Layout to add to.
+ *    @param begin Byte offset where the line starts.
+ *    @param end Byte offset where the line ends (exclusive).
+ *    @param width Width of the line in pixels.
+ */
+void font_layoutAddLine( glFontLayout *layout, size_t begin, size_t end, int width )
+{
+   glFontLayoutLine *line;
+   if (layout->nlines >= layout->mlines) {
+      layout->mlines = (layout->mlines > 0) ? 2*layout->mlines : 4;
+      layout->lines  = realloc( layout->lines, layout->mlines * sizeof(glFontLayoutLine) );
+   }
+   line = &layout->lines[ layout->nlines++ ];
+   line->begin = begin;
+   line->end   = end;
+   line->width = width;
+   if (width > layout->w)
+      layout->w = width;
+}
+
+/**
+ * @brief Clears the cache, has to be done when fonts change.
+ */
+void font_layoutClear (void)
+{
+   for (int i=0; i<FONT_LAYOUT_SETS; i++) {
+      for (int j=0; j<FONT_LAYOUT_WAYS; j++) {
+         free( font_layouts[i][j].text );
+         free( font_layouts[i][j].lines );
+      }
+   }
+   memset( font_layouts, 0, sizeof(font_layouts) );
+   font_layout_clock = 0;
+}
+
+/**
+ * @brief Gets the hit and miss counts of the cache.
+ *
+ *    @param[out] hits Number of layouts found in the cache.
+ *    @param[out] misses Number of layouts that had to be computed.
+ */
+void font_layoutStats( int *hits, int *misses )
+{
+   *hits    = font_layout_hits;
+   *misses  = font_layout_misses;
+}
@@ -0,0 +1,53 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+#pragma once
+
+/** @cond */
+#include <stddef.h>
+#include <stdint.h>
+/** @endcond */
+
+/**
+ * @brief What a cached layout describes.
+ */
+typedef enum glFontLayoutType_ {
+   FONT_LAYOUT_LINES,   /**< Line breaks when wrapping to a width. */
+   FONT_LAYOUT_WIDTH,   /**< Width of the widest line. */
+   FONT_LAYOUT_LIMIT,   /**< How much fits in a width without wrapping. */
+} glFontLayoutType;
+
+/**
+ * @brief A line of a cached layout.
+ */
+typedef struct glFontLayoutLine_ {
+   size_t begin;  /**< Byte offset where the line starts. */
+   size_t end;    /**< Byte offset where the line ends (exclusive). */
+   int width;     /**< Width of the line in pixels. */
+} glFontLayoutLine;
+
+/**
+ * @brief A cached layout of a string.
+ */
+typedef struct glFontLayout_ {
+   /* Key. */
+   int font;               /**< Font ID. */
+   glFontLayoutType type;  /**< Type of layout. */
+   int width;              /**< Width the layout is for. */
+   uint32_t hash;          /**< Hash of the text. */
+   char *text;             /**< Copy of the text, NULL if the entry is unused. */
+   /* Layout. */
+   glFontLayoutLine *lines; /**< Lines for FONT_LAYOUT_LINES. */
+   int nlines;             /**< Number of lines. */
+   int mlines;             /**< Allocated lines. */
+   int w;                  /**< Width in pixels. */
+   size_t limit;           /**< Bytes that fit for FONT_LAYOUT_LIMIT. */
+   /* Cache management. */
+   unsigned int used;      /**< Last time the entry was used, for LRU eviction. */
+} glFontLayout;
+
+glFontLayout *font_layoutGet( int font, glFontLayoutType type, int width, const char *text );
+glFontLayout *font_layoutAdd( int font, glFontLayoutType type, int width, const char *text );
+void font_layoutAddLine( glFontLayout *layout, size_t begin, size_t end, int width );
+void font_layoutClear (void);
+void font_layoutStats( int *hits, int *misses );
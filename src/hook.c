@@ -41,6 +41,7 @@
 #include "nstring.h"
 #include "nxml.h"
 #include "player.h"
+#include "profile.h"
 #include "space.h"
 
 /**
@@ -864,6 +865,8 @@ static int hooks_executeParam( const char* stack, const HookParam *param )
    if ((player.p == NULL) || player_isFlag(PLAYER_DESTROYED))
       return 0;
 
+   NPROFILE_ZONE_DYN( "hook", stack );
+
    /* Reset the current stack's ran and creation flags. */
    for (Hook *h=hook_list; h!=NULL; h=h->next)
       if (strcmp(stack, h->stack)==0) {
@@ -30,6 +30,7 @@
 #include "pause.h"
 #include "pilot.h"
 #include "player.h"
+#include "replay.h"
 #include "toolkit.h"
 #include "weapon.h"
 #include "utf8.h"
@@ -635,7 +636,7 @@ void input_update( double dt )
          return;
 
       /* Get time. */
-      t = SDL_GetTicks();
+      t = replay_getTicks();
 
       /* Should be repeating. */
       if (repeat_keyTimer + conf.repeat_delay + repeat_keyCounter*conf.repeat_freq > t)
@@ -671,7 +672,7 @@ static void input_key( int keynum, double value, double kabs, int repeat )
    if (conf.repeat_delay != 0) {
       if ((value == KEY_PRESS) && !repeat) {
          repeat_key        = keynum;
-         repeat_keyTimer   = SDL_GetTicks();
+         repeat_keyTimer   = replay_getTicks();
          repeat_keyCounter = 0;
       }
       else if (value == KEY_RELEASE) {
@@ -709,7 +710,7 @@ static void input_key( int keynum, double value, double kabs, int repeat )
          }
 
          /* double tap accel = afterburn! */
-         t = SDL_GetTicks();
+         t = replay_getTicks();
          if ((conf.doubletap_sens != 0) &&
                (value==KEY_PRESS) && INGAME() && NOHYP() && NODEAD() &&
                (t-input_accelLast <= conf.doubletap_sens))
@@ -777,7 +778,7 @@ static void input_key( int keynum, double value, double kabs, int repeat )
       }
 
       /* double tap reverse = cooldown! */
-      t = SDL_GetTicks();
+      t = replay_getTicks();
       if ((conf.doubletap_sens != 0) &&
             (value==KEY_PRESS) && INGAME() && NOHYP() && NODEAD() &&
             (t-input_revLast <= conf.doubletap_sens))
@@ -1453,7 +1454,7 @@ void input_clicked( void *clicked )
       return;
 
    input_lastClicked = clicked;
-   input_mouseClickLast = SDL_GetTicks();
+   input_mouseClickLast = replay_getTicks();
 }
 
 /**
@@ -1470,7 +1471,7 @@ int input_isDoubleClick( void *clicked )
    /* Most recent time that constitutes a valid double-click. */
    threshold = input_mouseClickLast + (int)(conf.mouse_doubleclick * 1000);
 
-   if ((SDL_GetTicks() <= threshold) && (clicked == input_lastClicked))
+   if ((replay_getTicks() <= threshold) && (clicked == input_lastClicked))
       return 1;
 
    return 0;
@@ -1487,6 +1488,9 @@ void input_handle( SDL_Event* event )
 {
    int ismouse;
 
+   /* Record before anything can change the state. */
+   replay_event( event );
+
    /* Special case mouse stuff. */
    if ((event->type == SDL_MOUSEMOTION)  ||
          (event->type == SDL_MOUSEBUTTONDOWN) ||
@@ -1505,7 +1509,11 @@ void input_handle( SDL_Event* event )
       if ((input_paste->key == event->key.keysym.sym) &&
             (input_paste->mod & mod)) {
          SDL_Event evt;
-         char *txt = SDL_GetClipboardText();
+         char *txt;
+         /* The pasted text was recorded as it came in. */
+         if (replay_isPlaying())
+            return;
+         txt = SDL_GetClipboardText();
          evt.type = SDL_TEXTINPUT;
          size_t i = 0;
          uint32_t ch;
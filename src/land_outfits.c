@@ -328,7 +328,7 @@ static void outfits_genList( unsigned int wid )
    int active;
    int fx, fy, fw, fh, barw; /* Input filter. */
    ImageArrayCell *coutfits;
-   int noutfits;
+   int noutfits, nfound;
    int w, h, iw, ih;
    const char *filtertext;
    LandOutfitData *data;
@@ -383,7 +383,8 @@ static void outfits_genList( unsigned int wid )
    /* Use custom list; default to landed outfits. */
    iar_outfits[active] = data!=NULL ? array_copy( Outfit*, data->outfits ) : tech_getOutfit( land_spob->tech );
    noutfits = outfits_filter( (const Outfit**)iar_outfits[active], array_size(iar_outfits[active]), tabfilters[active], filtertext );
-   coutfits = outfits_imageArrayCells( (const Outfit**)iar_outfits[active], &noutfits, player.p );
+   nfound   = noutfits;
+   coutfits = outfits_imageArrayCells( (const Outfit**)iar_outfits[active], &noutfits );
 
    iconsize = 128;
    if (!conf.big_icons) {
@@ -395,6 +396,7 @@ static void outfits_genList( unsigned int wid )
    window_addImageArray( wid, 20, 20,
          iw, ih - 34, OUTFITS_IAR, iconsize, iconsize,
          coutfits, noutfits, outfits_update, outfits_rmouse, NULL );
+   outfits_imageArrayFill( wid, OUTFITS_IAR, (const Outfit**)iar_outfits[active], nfound, player.p );
 
    /* write the outfits stuff */
    outfits_update( wid, NULL );
@@ -580,24 +582,27 @@ static void outfits_changeTab( unsigned int wid, const char *wgt, int old, int t
  *    @param outfits Array of outfits to filter.
  *    @param n Number of outfits in the array.
  *    @param filter Filter function to run on each outfit.
- *    @param name Name fragment that each outfit name must contain.
+ *    @param name Name fragment that each translated outfit name must contain.
  *    @return Number of outfits.
  */
 int outfits_filter( const Outfit **outfits, int n,
       int(*filter)( const Outfit *o ), const char *name )
 {
    int j = 0;
+   const Outfit *all = outfit_getAll();
+   char *match = (name != NULL) ? outfit_searchText( name, 0 ) : NULL;
    for (int i=0; i<n; i++) {
       if ((filter != NULL) && !filter(outfits[i]))
          continue;
 
-      if ((name != NULL) && (strcasestr( outfits[i]->name, name ) == NULL))
+      if ((match != NULL) && !match[ outfits[i] - all ])
          continue;
 
       /* Shift matches downward. */
       outfits[j] = outfits[i];
       j++;
    }
+   free( match );
 
    return j;
 }
@@ -681,8 +686,11 @@ int outfit_altText( char *buf, int n, const Outfit *o, const Pilot *plt )
 
 /**
  * @brief Generates image array cells corresponding to outfits.
+ *
+ * Only the captions are set, the rest is filled in lazily once the image
+ * array is created, see outfits_imageArrayFill().
  */
-ImageArrayCell *outfits_imageArrayCells( const Outfit **outfits, int *noutfits, const Pilot *p )
+ImageArrayCell *outfits_imageArrayCells( const Outfit **outfits, int *noutfits )
 {
    ImageArrayCell *coutfits = calloc( MAX(1,*noutfits), sizeof(ImageArrayCell) );
 
@@ -692,48 +700,112 @@ ImageArrayCell *outfits_imageArrayCells( const Outfit **outfits, int *noutfits,
       coutfits[0].caption = strdup( _("None") );
    }
    else {
-      /* Set alt text. */
-      for (int i=0; i<*noutfits; i++) {
-         const glColour *c;
-         const char *typename;
-         glTexture *t;
-         const Outfit *o = outfits[i];
-
-         coutfits[i].image = gl_dupTexture( o->gfx_store );
-         coutfits[i].caption = strdup( _(o->name) );
-         coutfits[i].quantity = player_outfitOwned(o);
-
-         /* Background colour. */
-         c = outfit_slotSizeColour( &o->slot );
-         if (c == NULL)
-            c = &cBlack;
-         col_blend( &coutfits[i].bg, c, &cGrey70, 1 );
-
-         /* Short description. */
-         coutfits[i].alt = strdup( pilot_outfitSummary( p, o ) );
-
-         /* Slot type. */
-         if ( (strcmp(outfit_slotName(o), "N/A") != 0)
-               && (strcmp(outfit_slotName(o), "NULL") != 0) ) {
-            size_t sz = 0;
-            typename       = _(outfit_slotName(o));
-            u8_inc( typename, &sz );
-            coutfits[i].slottype = malloc( sz+1 );
-            memcpy( coutfits[i].slottype, typename, sz );
-            coutfits[i].slottype[sz] = '\0';
-         }
-
-         /* Layers. */
-         coutfits[i].layers = gl_copyTexArray( o->gfx_overlays, &coutfits[i].nlayers );
-         if (o->rarity > 0) {
-            t = rarity_texture( o->rarity );
-            coutfits[i].layers = gl_addTexArray( coutfits[i].layers, &coutfits[i].nlayers, t );
-         }
-      }
+      for (int i=0; i<*noutfits; i++)
+         coutfits[i].caption = strdup( _(outfits[i]->name) );
    }
    return coutfits;
 }
 
+/**
+ * @brief Outfits the cells of an image array are filled in with.
+ */
+typedef struct OutfitsCellData_ {
+   const Outfit **outfits; /**< Outfits of the cells. */
+   int n;                  /**< Number of outfits. */
+   char *pname;            /**< Name of the player's ship the alt text is for, may be NULL. */
+} OutfitsCellData;
+
+/**
+ * @brief Fills in an image array cell of an outfit.
+ */
+static void outfits_fillCell( ImageArrayCell *cell, int pos, void *data )
+{
+   const OutfitsCellData *cd = data;
+   const glColour *c;
+   const char *typename;
+   const Outfit *o;
+   const Pilot *p;
+
+   if (pos >= cd->n)
+      return;
+   o = cd->outfits[pos];
+
+   /* The ship may have been sold since the image array was made. */
+   p = ((cd->pname != NULL) && player_hasShip( cd->pname )) ?
+         player_getShip( cd->pname ) : NULL;
+
+   cell->image = gl_dupTexture( o->gfx_store );
+   cell->quantity = player_outfitOwned(o);
+
+   /* Background colour. */
+   c = outfit_slotSizeColour( &o->slot );
+   if (c == NULL)
+      c = &cBlack;
+   col_blend( &cell->bg, c, &cGrey70, 1 );
+
+   /* Short description. */
+   cell->alt = strdup( pilot_outfitSummary( p, o ) );
+
+   /* Slot type. */
+   if ( (strcmp(outfit_slotName(o), "N/A") != 0)
+         && (strcmp(outfit_slotName(o), "NULL") != 0) ) {
+      size_t sz = 0;
+      typename       = _(outfit_slotName(o));
+      u8_inc( typename, &sz );
+      cell->slottype = malloc( sz+1 );
+      memcpy( cell->slottype, typename, sz );
+      cell->slottype[sz] = '\0';
+   }
+
+   /* Layers. */
+   cell->layers = gl_copyTexArray( o->gfx_overlays, &cell->nlayers );
+   if (o->rarity > 0) {
+      glTexture *t = rarity_texture( o->rarity );
+      cell->layers = gl_addTexArray( cell->layers, &cell->nlayers, t );
+   }
+}
+
+/**
+ * @brief Frees the data of outfits_fillCell().
+ */
+static void outfits_freeCellData( void *data )
+{
+   OutfitsCellData *cd = data;
+   free( cd->outfits );
+   free( cd->pname );
+   free( cd );
+}
+
+/**
+ * @brief Makes an image array created with outfits_imageArrayCells() fill in
+ *        its cells as they are shown.
+ *
+ * Getting the owned amount and alt text of every outfit up front can take a
+ * long time with big lists, especially since the alt text may run Lua.
+ *
+ *    @param wid Window of the image array.
+ *    @param iar Name of the image array.
+ *    @param outfits Outfits of the cells (copied).
+ *    @param n Number of outfits, before outfits_imageArrayCells() added a
+ *           placeholder if there were none.
+ *    @param plt Pilot to compare the outfits with in the alt text.
+ */
+void outfits_imageArrayFill( unsigned int wid, const char *iar,
+      const Outfit **outfits, int n, const Pilot *plt )
+{
+   OutfitsCellData *cd;
+
+   if (n <= 0)
+      return;
+
+   cd = malloc( sizeof(OutfitsCellData) );
+   cd->outfits = malloc( n * sizeof(Outfit*) );
+   memcpy( cd->outfits, outfits, n * sizeof(Outfit*) );
+   cd->n = n;
+   cd->pname = (plt != NULL) ? strdup( plt->name ) : NULL;
+   toolkit_setImageArrayFill( wid, iar, outfits_fillCell, cd, outfits_freeCellData );
+}
+
 /**
  * Functions for the popdown menu (filter outfits by size)
  */
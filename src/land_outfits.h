@@ -16,7 +16,9 @@ void outfits_update( unsigned int wid, const char* str );
 void outfits_updateEquipmentOutfits( void );
 int outfits_filter( const Outfit **outfits, int n,
       int(*filter)( const Outfit *o ), const char *name );
-ImageArrayCell *outfits_imageArrayCells( const Outfit **outfits, int *n, const Pilot *plt );
+ImageArrayCell *outfits_imageArrayCells( const Outfit **outfits, int *n );
+void outfits_imageArrayFill( unsigned int wid, const char *iar,
+      const Outfit **outfits, int n, const Pilot *plt );
 int outfit_canBuy( const char *outfit, const Spob *spob );
 int outfit_canSell( const char *outfit );
 void outfits_cleanup( void );
@@ -51,6 +51,7 @@ static void shipyard_rmouse( unsigned int wid, const char* widget_name );
 static void shipyard_renderSlots( double bx, double by, double bw, double bh, void *data );
 static void shipyard_renderSlotsRow( double bx, double by, double bw, const char *str, ShipOutfitSlot *s );
 static void shipyard_find( unsigned int wid, const char* str );
+static void shipyard_fillCell( ImageArrayCell *cell, int pos, void *data );
 
 /**
  * @brief Opens the shipyard window.
@@ -130,15 +131,9 @@ void shipyard_open( unsigned int wid )
       nships    = 1;
    }
    else {
-      for (int i=0; i<nships; i++) {
+      /* The rest is filled in as the ships are shown. */
+      for (int i=0; i<nships; i++)
          cships[i].caption = strdup( _(shipyard_list[i]->name) );
-         cships[i].image = gl_dupTexture(shipyard_list[i]->gfx_store);
-         cships[i].layers = gl_copyTexArray( shipyard_list[i]->gfx_overlays, &cships[i].nlayers );
-         if (shipyard_list[i]->rarity > 0) {
-            glTexture *t = rarity_texture( shipyard_list[i]->rarity );
-            cships[i].layers = gl_addTexArray( cships[i].layers, &cships[i].nlayers, t );
-         }
-      }
    }
 
    iconsize = 128;
@@ -153,12 +148,33 @@ void shipyard_open( unsigned int wid )
    window_addImageArray( wid, 20, 20,
          iw, ih, "iarShipyard", iconsize, iconsize,
          cships, nships, shipyard_update, shipyard_rmouse, NULL );
+   toolkit_setImageArrayFill( wid, "iarShipyard", shipyard_fillCell, NULL, NULL );
 
    /* write the shipyard stuff */
    shipyard_update(wid, NULL);
    /* Set default keyboard focuse to the list */
    window_setFocus( wid , "iarShipyard" );
 }
+/**
+ * @brief Fills in the image array cell of a ship in the shipyard.
+ */
+static void shipyard_fillCell( ImageArrayCell *cell, int pos, void *data )
+{
+   (void) data;
+   const Ship *s;
+
+   if (pos >= array_size(shipyard_list))
+      return;
+   s = shipyard_list[pos];
+
+   cell->image = gl_dupTexture( s->gfx_store );
+   cell->layers = gl_copyTexArray( s->gfx_overlays, &cell->nlayers );
+   if (s->rarity > 0) {
+      glTexture *t = rarity_texture( s->rarity );
+      cell->layers = gl_addTexArray( cell->layers, &cell->nlayers, t );
+   }
+}
+
 /**
  * @brief Updates the ships in the shipyard window.
  *    @param wid Window to update the ships in.
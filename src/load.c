@@ -16,6 +16,7 @@
 #include "load.h"
 
 #include "array.h"
+#include "conf.h"
 #include "dialogue.h"
 #include "economy.h"
 #include "event.h"
@@ -103,6 +104,8 @@ static void load_snapshot_menu_save( unsigned int wdw, const char *str );
 static void display_save_info( unsigned int wid, const nsave_t *ns );
 static void move_old_save( const char *path, const char *fname, const char *ext, const char *new_name );
 static int load_load( nsave_t *save, const char *path );
+static int load_loadIndex( nsave_t *save, const char *path, const PHYSFS_Stat *stat );
+static void load_freeSave( nsave_t *ns );
 static int load_game( nsave_t *ns );
 static int load_gameInternal( const char* file, const char* version );
 static int load_gameInternalHook( void *data );
@@ -227,11 +230,117 @@ static int load_load( nsave_t *save, const char *path )
    return 0;
 }
 
+/**
+ * @brief Loads the header information of a save from its index (\see save_writeIndex).
+ *
+ * Only reads a bounded amount of data, and refuses the index if it doesn't
+ * describe the current version of the save.
+ *
+ * @param[out] save Structure to populate.
+ * @param path PhysicsFS path of the save.
+ * @param stat Stat of the save.
+ * @return 0 on success, -1 if the save has to be parsed instead.
+ */
+static int load_loadIndex( nsave_t *save, const char *path, const PHYSFS_Stat *stat )
+{
+   char buf[SAVE_INDEX_MAX], *idx, *line, *next;
+   PHYSFS_File *f;
+   PHYSFS_sint64 n;
+   int valid, done;
+
+   memset( save, 0, sizeof(nsave_t) );
+
+   asprintf( &idx, "%s"SAVE_INDEX_EXT, path );
+   f = PHYSFS_openRead( idx );
+   free( idx );
+   if (f == NULL)
+      return -1;
+   n = PHYSFS_readBytes( f, buf, sizeof(buf)-1 );
+   PHYSFS_close( f );
+   if (n <= 0)
+      return -1;
+   buf[n] = '\0';
+
+   valid = done = 0;
+   for (line=buf; (line!=NULL) && !done; line=next) {
+      char *val;
+
+      next = strchr( line, '\n' );
+      if (next == NULL)
+         break; /* Truncated. */
+      *next++ = '\0';
+
+      if (line == buf) {
+         if (strcmp( line, SAVE_INDEX_HEADER ) != 0)
+            break;
+         continue;
+      }
+
+      val = strchr( line, ' ' );
+      if (val == NULL)
+         break;
+      *val++ = '\0';
+
+      if (strcmp( line, "size" )==0)
+         valid |= (strtoll( val, NULL, 10 ) == stat->filesize) ? 1 : 0;
+      else if (strcmp( line, "modtime" )==0)
+         valid |= (strtoll( val, NULL, 10 ) == stat->modtime) ? 2 : 0;
+      else if (strcmp( line, "credits" )==0)
+         save->credits = strtoull( val, NULL, 10 );
+      else if (strcmp( line, "date" )==0) {
+         int cycles = 0, periods = 0, seconds = 0;
+         sscanf( val, "%d %d %d", &cycles, &periods, &seconds );
+         save->date = ntime_create( cycles, periods, seconds );
+      }
+      else if (strcmp( line, "naev" )==0)
+         save->version = strdup( val );
+      else if (strcmp( line, "data" )==0)
+         save->data = strdup( val );
+      else if (strcmp( line, "name" )==0)
+         save->player_name = strdup( val );
+      else if (strcmp( line, "location" )==0)
+         save->spob = strdup( val );
+      else if (strcmp( line, "chapter" )==0)
+         save->chapter = strdup( val );
+      else if (strcmp( line, "difficulty" )==0)
+         save->difficulty = strdup( val );
+      else if (strcmp( line, "ship_name" )==0)
+         save->shipname = strdup( val );
+      else if (strcmp( line, "ship_model" )==0)
+         save->shipmodel = strdup( val );
+      else if (strcmp( line, "plugin" )==0) {
+         if (save->plugins == NULL)
+            save->plugins = array_create( char* );
+         array_push_back( &save->plugins, strdup(val) );
+      }
+      else if (strcmp( line, "end" )==0)
+         done = 1;
+   }
+
+   /* Stale, truncated or unknown format. */
+   if (!done || (valid != 3) || (save->player_name == NULL)) {
+      load_freeSave( save );
+      memset( save, 0, sizeof(nsave_t) );
+      return -1;
+   }
+
+   save->path = strdup( path );
+   if (save->chapter==NULL)
+      save->chapter = strdup( start_chapter() );
+   save->compatible = load_compatibility( save );
+   return 0;
+}
+
 /**
  * @brief Loads or refreshes saved games for the player.
  */
 int load_refresh (void)
 {
+   Uint32 time = SDL_GetTicks();
+
+   /* Saves being written have to be done first. */
+   save_sync();
+
    if (load_saves != NULL)
       load_free();
 
@@ -240,6 +349,14 @@ int load_refresh (void)
    PHYSFS_enumerate( "saves", load_enumerateCallback, NULL );
    qsort( load_saves, array_size(load_saves), sizeof(player_saves_t), load_sortComparePlayers );
 
+   if (conf.devmode) {
+      int n = 0;
+      for (int i=0; i<array_size(load_saves); i++)
+         n += array_size( load_saves[i].saves );
+      time = SDL_GetTicks() - time;
+      DEBUG( n_("Loaded %d Save in %.3f s", "Loaded %d Saves in %.3f s", n ), n, time/1000. );
+   }
+
    return 0;
 }
 
@@ -247,13 +364,31 @@ static int load_enumerateCallbackPlayer( void* data, const char* origdir, const
 {
    char *path;
    const char *fmt;
-   size_t dir_len;
+   size_t dir_len, name_len, ext_len;
    PHYSFS_Stat stat;
 
+   /* Header indices are read along with their save. */
+   name_len = strlen( fname );
+   ext_len = strlen( SAVE_INDEX_EXT );
+   if ((name_len >= ext_len) && (strcmp( &fname[name_len-ext_len], SAVE_INDEX_EXT )==0))
+      return PHYSFS_ENUM_OK;
+
    dir_len = strlen( origdir );
 
    fmt = dir_len && origdir[dir_len-1]=='/' ? "%s%s" : "%s/%s";
    asprintf( &path, fmt, origdir, fname );
+
+   /* Saves are only written after load_refresh() called save_sync(), so
+    * temporary files are left over from crashing while writing. */
+   ext_len = strlen( SAVE_TMP_EXT );
+   if ((name_len >= ext_len) && (strcmp( &fname[name_len-ext_len], SAVE_TMP_EXT )==0)) {
+      LOG(_("Removing unfinished save '%s'"), path);
+      if (!PHYSFS_delete( path ))
+         WARN(_("Unable to delete '%s': %s"), path,
+               _(PHYSFS_getErrorByCode( PHYSFS_getLastErrorCode() ) ) );
+      free( path );
+      return PHYSFS_ENUM_OK;
+   }
    if (!PHYSFS_stat( path, &stat ))
       WARN( _("PhysicsFS: Cannot stat %s: %s"), path,
             _(PHYSFS_getErrorByCode( PHYSFS_getLastErrorCode() ) ) );
@@ -261,7 +396,9 @@ static int load_enumerateCallbackPlayer( void* data, const char* origdir, const
    else if (stat.filetype == PHYSFS_FILETYPE_REGULAR) {
       player_saves_t *ps = (player_saves_t*) data;
       nsave_t ns;
-      int ret = load_load( &ns, path );
+      int ret = load_loadIndex( &ns, path, &stat );
+      if (ret != 0)
+         ret = load_load( &ns, path );
       if (ret == 0) {
          ns.save_name = strdup( fname );
          ns.save_name[ strlen(ns.save_name)-3 ] = '\0';
@@ -453,28 +590,34 @@ void load_free (void)
    for (int i=0; i<array_size(load_saves); i++) {
       player_saves_t *ps = &load_saves[i];
       free( ps->name );
-      for (int j=0; j<array_size(ps->saves); j++) {
-         nsave_t *ns = &ps->saves[j];
-         for (int k=0; k<array_size(ns->plugins); k++)
-            free( ns->plugins[k] );
-         array_free( ns->plugins );
-         free(ns->save_name);
-         free(ns->player_name);
-         free(ns->path);
-         free(ns->version);
-         free(ns->data);
-         free(ns->spob);
-         free(ns->chapter);
-         free(ns->difficulty);
-         free(ns->shipname);
-         free(ns->shipmodel);
-      }
+      for (int j=0; j<array_size(ps->saves); j++)
+         load_freeSave( &ps->saves[j] );
       array_free( ps->saves );
    }
    array_free( load_saves );
    load_saves = NULL;
 }
 
+/**
+ * @brief Frees the contents of a save entry.
+ */
+static void load_freeSave( nsave_t *ns )
+{
+   for (int k=0; k<array_size(ns->plugins); k++)
+      free( ns->plugins[k] );
+   array_free( ns->plugins );
+   free(ns->save_name);
+   free(ns->player_name);
+   free(ns->path);
+   free(ns->version);
+   free(ns->data);
+   free(ns->spob);
+   free(ns->chapter);
+   free(ns->difficulty);
+   free(ns->shipname);
+   free(ns->shipmodel);
+}
+
 /**
  * @brief Gets the array (array.h) of loaded saves.
  */
@@ -676,7 +819,8 @@ static void load_snapshot_menu_save( unsigned int wdw, const char *str )
          return;
       }
    }
-   if (save_all_with_name(save_name) < 0)
+   /* Errors writing to disk are only known once the save is written. */
+   if ((save_all_with_name(save_name) < 0) || (save_sync() < 0))
       dialogue_alert( _("Failed to save the game! You should exit and check the log to see what happened and then file a bug report!") );
    else {
       load_refresh();
@@ -941,9 +1085,12 @@ static void load_menu_delete( unsigned int wdw, const char *str )
 
    /* Remove it. */
    n = array_size( load_saves[pos].saves );
-   for (int i = 0; i < n; i++)
+   for (int i = 0; i < n; i++) {
       if (!PHYSFS_delete( load_saves[pos].saves[i].path ))
          dialogue_alert( _("Unable to delete %s"), load_saves[pos].saves[i].path );
+      snprintf( path, sizeof(path), "%s"SAVE_INDEX_EXT, load_saves[pos].saves[i].path );
+      PHYSFS_delete( path );
+   }
    snprintf(path, sizeof(path), "saves/%s", load_saves[pos].name);
    if (!PHYSFS_delete( path ))
       dialogue_alert( _("Unable to delete '%s' directory"), load_saves[pos].name );
@@ -964,6 +1111,7 @@ static void load_snapshot_menu_delete( unsigned int wdw, const char *str )
 {
    unsigned int wid;
    int pos;
+   char path[PATH_MAX];
 
    wid = window_get( "wdwLoadSnapshotMenu" );
 
@@ -978,6 +1126,8 @@ static void load_snapshot_menu_delete( unsigned int wdw, const char *str )
 
    /* Remove it. */
    PHYSFS_delete( load_player->saves[pos].path );
+   snprintf( path, sizeof(path), "%s"SAVE_INDEX_EXT, load_player->saves[pos].path );
+   PHYSFS_delete( path );
 
    load_refresh();
 
@@ -1106,6 +1256,7 @@ static int load_gameInternal( const char* file, const char* version )
    const char** data;
 
    /* Make sure it exists. */
+   save_sync();
    if (!PHYSFS_exists( file )) {
       dialogue_alert( _("Saved game file seems to have been deleted.") );
       return -1;
@@ -21,6 +21,27 @@
 #include "ndata.h"
 #include "nstring.h"
 
+#define LOG_FLUSH_INTERVAL   250   /**< Time in ms between flushes of the log writer. */
+#define LOG_PENDING_MAX      65536 /**< Pending bytes that wake up the log writer early. */
+#define LOG_REPEAT_INTERVAL  1000  /**< Time in ms between summaries of a line that keeps repeating. */
+
+/**
+ * @brief A stream being logged to.
+ */
+typedef struct LogStream_ {
+   PHYSFS_File **file; /**< Log file the stream is teed to. */
+   int dedup;        /**< Whether or not repeated lines get collapsed. */
+   char *line;       /**< Line being assembled. */
+   size_t nline;     /**< Length of the line being assembled. */
+   size_t mline;     /**< Allocated size of line. */
+   char *last;       /**< Last complete line, used to detect repeats. */
+   int repeats;      /**< Number of times the last line was dropped as a repeat. */
+   Uint32 trepeat;   /**< Time the first of the dropped repeats came in. */
+   char *pending;    /**< Complete lines waiting to be written. */
+   size_t npending;  /**< Length of pending. */
+   size_t mpending;  /**< Allocated size of pending. */
+} LogStream;
+
 /**< Temporary storage buffers. */
 static char *outcopy = NULL;
 static char *errcopy = NULL;
@@ -42,6 +63,15 @@ static int copying = 0;
 static PHYSFS_File *logout_file = NULL;
 static PHYSFS_File *logerr_file = NULL;
 
+/* Background writer. */
+static LogStream log_out = { .file = &logout_file, .dedup = 0 }; /**< Standard output. */
+static LogStream log_err = { .file = &logerr_file, .dedup = 1 }; /**< Standard error. */
+static SDL_mutex *log_lock       = NULL; /**< Protects the stream buffers. */
+static SDL_mutex *log_write_lock = NULL; /**< Serializes writing out the pending buffers. */
+static SDL_cond *log_cond        = NULL; /**< Wakes up the writer. */
+static SDL_Thread *log_thread    = NULL; /**< Writer thread. */
+static int log_quit              = 0; /**< Whether or not the writer should stop. */
+
 /*
  * Prototypes
  */
@@ -49,56 +79,232 @@ static void log_copy( int enable );
 static void log_append( FILE *stream, char *str );
 static void log_cleanStream( PHYSFS_File **file, const char *fname, const char *filedouble );
 static void log_purge (void);
+static void log_write( LogStream *ls, const char *str, size_t len );
+static int log_line( LogStream *ls, const char *str, size_t len );
+static void log_pend( LogStream *ls, const char *str, size_t len );
+static void log_repeats( LogStream *ls );
+static void log_flushStream( LogStream *ls, int force );
+static void log_flushAll( int force );
+static int log_writer( void *data );
 
 /**
  * @brief Like fprintf, but automatically teed to log files (and line-terminated if \p newline is true).
+ *
+ * Output is buffered and written out by a background thread, see log_flush().
  */
 int logprintf( FILE *stream, int newline, const char *fmt, ... )
 {
    va_list ap;
-   char *buf;
-   size_t n;
+   char stackbuf[STRMAX];
+   char *buf = stackbuf;
+   int n;
 
-   /* Offset to add error colour header as necessary. */
-   va_start( ap, fmt );
-   n = vsnprintf( NULL, 0, fmt, ap );
-   va_end( ap );
-   buf = malloc( 2+n+2 );
+   /* Format into the stack buffer, only allocate for huge messages. */
    va_start( ap, fmt );
-   n = vsnprintf( &buf[2], n + 1, fmt, ap );
+   n = vsnprintf( stackbuf, sizeof(stackbuf)-1, fmt, ap );
    va_end( ap );
+   if (n < 0)
+      return n;
+   if (n >= (int)sizeof(stackbuf)-1) {
+      buf = malloc( n+2 );
+      va_start( ap, fmt );
+      vsnprintf( buf, n+1, fmt, ap );
+      va_end( ap );
+   }
 
    /* Finally add newline if necessary. */
-   if (newline) {
-      buf[2+n] = '\n';
-      buf[2+n+1] = '\0';
-   }
+   if (newline)
+      buf[n++] = '\n';
+   buf[n] = '\0';
+
+   if (stream == stdout)
+      log_write( &log_out, buf, n );
+   else if (stream == stderr)
+      log_write( &log_err, buf, n );
    else
-      buf[2+n] = '\0';
+      fprintf( stream, "%s", buf );
+
+   if (buf != stackbuf)
+      free( buf );
+   return n;
+}
+
+/**
+ * @brief Adds output to a stream, splitting it into lines.
+ */
+static void log_write( LogStream *ls, const char *str, size_t len )
+{
+   int wake = 0;
+
+   if (log_lock != NULL)
+      SDL_LockMutex( log_lock );
+
+   for (size_t i=0; i<len; i++) {
+      /* Assemble the line until it is complete. */
+      if (ls->nline+2 > ls->mline) {
+         ls->mline = MAX( 2*ls->mline, 128 );
+         ls->line  = realloc( ls->line, ls->mline );
+      }
+      ls->line[ ls->nline++ ] = str[i];
+      if (str[i] != '\n')
+         continue;
+      ls->line[ ls->nline ] = '\0';
+      /* New errors get written out right away. */
+      if (log_line( ls, ls->line, ls->nline ))
+         wake |= (ls == &log_err);
+      ls->nline = 0;
+   }
+   wake |= (ls->npending > LOG_PENDING_MAX);
+
+   if (log_lock != NULL)
+      SDL_UnlockMutex( log_lock );
+
+   /* Without a writer thread, just write everything out now. */
+   if (log_thread == NULL)
+      log_flushAll( 0 );
+   else if (wake)
+      SDL_CondSignal( log_cond );
+}
+
+/**
+ * @brief Handles a complete line of a stream.
+ *
+ *    @return 1 if the line is to be written, 0 if it was dropped as a repeat.
+ */
+static int log_line( LogStream *ls, const char *str, size_t len )
+{
+   /* Drop repeats, they get summarized periodically or when a different line comes. */
+   if (ls->dedup) {
+      if ((ls->last != NULL) && (strcmp( ls->last, str ) == 0)) {
+         if (ls->repeats++ == 0)
+            ls->trepeat = SDL_GetTicks();
+         return 0;
+      }
+      log_repeats( ls );
+      free( ls->last );
+      ls->last = strdup( str );
+   }
 
    /* Append to buffer. */
    if (copying)
-      log_append(stream, &buf[2]);
+      log_append( ls == &log_out ? stdout : stderr, (char*)str );
 
-   if (stream == stdout && logout_file != NULL) {
-      PHYSFS_writeBytes( logout_file, &buf[2], newline ? n+1 : n );
-      if (newline)
-         PHYSFS_flush( logout_file );
-   }
+   log_pend( ls, str, len );
+   return 1;
+}
 
-   if (stream == stderr && logerr_file != NULL) {
-      PHYSFS_writeBytes( logerr_file, &buf[2], newline ? n+1 : n );
-      if ( newline )
-         PHYSFS_flush( logerr_file );
+/**
+ * @brief Appends data to the pending buffer of a stream.
+ */
+static void log_pend( LogStream *ls, const char *str, size_t len )
+{
+   if (ls->npending+len > ls->mpending) {
+      ls->mpending = MAX( 2*ls->mpending, ls->npending+len );
+      ls->pending  = realloc( ls->pending, ls->mpending );
    }
+   memcpy( &ls->pending[ ls->npending ], str, len );
+   ls->npending += len;
+}
 
-   /* Also print to the stream. */
-   n = fprintf( stream, "%s", &buf[ 2 ] );
-   if (newline)
-      fflush( stream );
+/**
+ * @brief Summarizes dropped repeated lines of a stream.
+ */
+static void log_repeats( LogStream *ls )
+{
+   char buf[STRMAX_SHORT];
+   int n;
+
+   if (ls->repeats <= 0)
+      return;
+   n = snprintf( buf, sizeof(buf), n_("(last message repeated %d time)\n", "(last message repeated %d times)\n", ls->repeats), ls->repeats );
+   ls->repeats = 0;
+   n = MIN( n, (int)sizeof(buf)-1 );
+   if (copying)
+      log_append( ls == &log_out ? stdout : stderr, buf );
+   log_pend( ls, buf, n );
+}
 
+/**
+ * @brief Writes out the pending buffer of a stream.
+ *
+ *    @param ls Stream to write out.
+ *    @param force Whether or not to summarize repeated lines right away.
+ */
+static void log_flushStream( LogStream *ls, int force )
+{
+   FILE *stream;
+   char *buf;
+   size_t len;
+
+   if (log_lock != NULL)
+      SDL_LockMutex( log_lock );
+   if ((ls->repeats > 0) && (force || (SDL_GetTicks()-ls->trepeat >= LOG_REPEAT_INTERVAL)))
+      log_repeats( ls );
+   buf = ls->pending;
+   len = ls->npending;
+   ls->pending  = NULL;
+   ls->npending = 0;
+   ls->mpending = 0;
+   if (log_lock != NULL)
+      SDL_UnlockMutex( log_lock );
+
+   if (len == 0) {
+      free( buf );
+      return;
+   }
+
+   stream = (ls == &log_out) ? stdout : stderr;
+   fwrite( buf, 1, len, stream );
+   fflush( stream );
+   if (*ls->file != NULL) {
+      PHYSFS_writeBytes( *ls->file, buf, len );
+      PHYSFS_flush( *ls->file );
+   }
    free( buf );
-   return n;
+}
+
+/**
+ * @brief Writes out all the buffered log output.
+ *
+ * This is done periodically by the writer thread, but has to be called
+ * before anything that can kill the process, like abort().
+ */
+void log_flush (void)
+{
+   log_flushAll( 1 );
+}
+
+/**
+ * @brief Writes out all the buffered log output.
+ *
+ *    @param force Whether or not to summarize repeated lines right away.
+ */
+static void log_flushAll( int force )
+{
+   if (log_write_lock != NULL)
+      SDL_LockMutex( log_write_lock );
+   log_flushStream( &log_out, force );
+   log_flushStream( &log_err, force );
+   if (log_write_lock != NULL)
+      SDL_UnlockMutex( log_write_lock );
+}
+
+/**
+ * @brief Background thread that writes out the log.
+ */
+static int log_writer( void *data )
+{
+   (void) data;
+
+   SDL_LockMutex( log_lock );
+   while (!log_quit) {
+      SDL_CondWaitTimeout( log_cond, log_lock, LOG_FLUSH_INTERVAL );
+      SDL_UnlockMutex( log_lock );
+      log_flushAll( 0 );
+      SDL_LockMutex( log_lock );
+   }
+   SDL_UnlockMutex( log_lock );
+   return 0;
 }
 
 /**
@@ -114,6 +320,9 @@ void log_redirect (void)
    if (!conf.redirect_file)
       return;
 
+   /* Anything pending is already in the copy buffers. */
+   log_flush();
+
    time(&cur);
    ts = localtime(&cur);
    strftime( timestr, sizeof(timestr), "%Y-%m-%d_%H-%M-%S", ts );
@@ -142,6 +351,16 @@ void log_redirect (void)
 void log_init (void)
 {
    log_copy( conf.redirect_file );
+
+   /* Start the writer, if anything fails we just write synchronously. */
+   log_lock       = SDL_CreateMutex();
+   log_write_lock = SDL_CreateMutex();
+   log_cond       = SDL_CreateCond();
+   if ((log_lock != NULL) && (log_write_lock != NULL) && (log_cond != NULL))
+      log_thread = SDL_CreateThread( log_writer, "log_writer", NULL );
+
+   /* Don't lose anything when exiting. */
+   atexit( log_flush );
 }
 
 /**
@@ -173,6 +392,9 @@ void log_copy( int enable )
       return;
    }
 
+   if (log_write_lock != NULL)
+      SDL_LockMutex( log_write_lock );
+
    if (noutcopy && logout_file != NULL)
       PHYSFS_writeBytes( logout_file, outcopy, strlen(outcopy) );
 
@@ -180,6 +402,9 @@ void log_copy( int enable )
       PHYSFS_writeBytes( logerr_file, errcopy, strlen(errcopy) );
 
    log_purge();
+
+   if (log_write_lock != NULL)
+      SDL_UnlockMutex( log_write_lock );
 }
 
 /**
@@ -204,6 +429,21 @@ static void log_purge (void)
  */
 void log_clean (void)
 {
+   /* Stop the writer and write out everything left, including unfinished lines. */
+   if (log_thread != NULL) {
+      SDL_LockMutex( log_lock );
+      log_quit = 1;
+      SDL_CondSignal( log_cond );
+      SDL_UnlockMutex( log_lock );
+      SDL_WaitThread( log_thread, NULL );
+      log_thread = NULL;
+   }
+   if (log_out.nline > 0)
+      log_write( &log_out, "\n", 1 );
+   if (log_err.nline > 0)
+      log_write( &log_err, "\n", 1 );
+   log_flush();
+
    log_cleanStream( &logout_file, "logs/stdout.txt", outfiledouble );
    log_cleanStream( &logerr_file, "logs/stderr.txt", errfiledouble );
 }
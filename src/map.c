@@ -2920,9 +2920,41 @@ int map_map( const Outfit *map )
    for (int i=0; i<array_size(map->u.map->jumps);i++)
       jp_setFlag(map->u.map->jumps[i], JP_KNOWN);
 
+   /* Everything on the map is known now. */
+   space_knownChanged();
+   map->u.map->unknown = 0;
+   map->u.map->known_gen = space_knownGeneration();
+
    return 1;
 }
 
+/**
+ * @brief Counts how many of the systems, spobs and jumps of a map are unknown.
+ */
+static int map_countUnknown( const OutfitMapData_t *data )
+{
+   int n = 0;
+
+   for (int i=0; i<array_size(data->systems);i++)
+      if (!sys_isKnown(data->systems[i]))
+         n++;
+
+   for (int i=0; i<array_size(data->spobs);i++) {
+      Spob *p = data->spobs[i];
+      if (spob_isKnown(p))
+         continue;
+      if (!spob_hasSystem( p->name ) )
+         continue;
+      n++;
+   }
+
+   for (int i=0; i<array_size(data->jumps);i++)
+      if (!jp_isKnown(data->jumps[i]))
+         n++;
+
+   return n;
+}
+
 /**
  * @brief Check to see if map data is limited to locations which are known
  *        or in a nonexistent status for plot reasons.
@@ -2932,23 +2964,16 @@ int map_map( const Outfit *map )
  */
 int map_isUseless( const Outfit* map )
 {
-   for (int i=0; i<array_size(map->u.map->systems);i++)
-      if (!sys_isKnown(map->u.map->systems[i]))
-         return 0;
+   OutfitMapData_t *data = map->u.map;
+   unsigned int gen = space_knownGeneration();
 
-   for (int i=0; i<array_size(map->u.map->spobs);i++) {
-      Spob *p = map->u.map->spobs[i];
-      if (!spob_hasSystem( p->name ) )
-         continue;
-      if (!spob_isKnown(p))
-         return 0;
+   /* Only recount when something became known or unknown. */
+   if (data->known_gen != gen) {
+      data->unknown = map_countUnknown( data );
+      data->known_gen = gen;
    }
 
-   for (int i=0; i<array_size(map->u.map->jumps);i++)
-      if (!jp_isKnown(map->u.map->jumps[i]))
-         return 0;
-
-   return 1;
+   return (data->unknown == 0);
 }
 
 /**
@@ -2968,8 +2993,10 @@ int localmap_map( const Outfit *lmap )
       JumpPoint *jp = &cur_system->jumps[i];
       if (jp_isFlag(jp, JP_EXITONLY) || jp_isFlag(jp, JP_HIDDEN))
          continue;
-      if (mod*jp->hide <= detect)
+      if ((mod*jp->hide <= detect) && !jp_isKnown(jp)) {
          jp_setFlag( jp, JP_KNOWN );
+         space_knownChanged();
+      }
    }
 
    detect = lmap->u.lmap.spob_detect;
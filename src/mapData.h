@@ -14,4 +14,6 @@ struct OutfitMapData_s {
    StarSystem **systems; /**< systems to mark as known. */
    JumpPoint **jumps; /**< jump points to mark as known. */
    Spob **spobs; /**< spobs to mark as known. */
+   int unknown; /**< Amount of systems, spobs and jumps still unknown. */
+   unsigned int known_gen; /**< Generation of the known flags unknown was counted at. */
 };
@@ -575,20 +575,15 @@ static const char *map_getSpobSymbol( Spob *p )
 static char **map_fuzzyOutfits( Outfit **o, const char *name )
 {
    char **names = array_create( char* );
+   const Outfit *all = outfit_getAll();
+   char *match;
 
-   /* Do fuzzy search. */
-   for (int i=0; i<array_size(o); i++) {
-      if (strcasestr( _(o[i]->name), name ) != NULL)
+   /* Do fuzzy search using the index of names, types, conditions, descriptions and summaries. */
+   match = outfit_searchText( name, 1 );
+   for (int i=0; i<array_size(o); i++)
+      if (match[ o[i] - all ])
          array_push_back( &names, o[i]->name );
-      else if ((o[i]->typename != NULL) && strcasestr( o[i]->typename, name ) != NULL)
-         array_push_back( &names, o[i]->name );
-      else if ((o[i]->condstr != NULL) && strcasestr( o[i]->condstr, name ) != NULL)
-         array_push_back( &names, o[i]->name );
-      else if (strcasestr( outfit_description(o[i]), name ) != NULL)
-         array_push_back( &names, o[i]->name );
-      else if (strcasestr( outfit_summary(o[i]), name ) != NULL)
-         array_push_back( &names, o[i]->name );
-   }
+   free( match );
 
    return names;
 }
@@ -805,20 +800,15 @@ static int map_findSearchOutfits( unsigned int wid_map_find, const char *name )
 static char **map_fuzzyShips( Ship **s, const char *name )
 {
    char **names = array_create( char* );
+   const Ship *all = ship_getAll();
+   char *match;
 
-   /* Do fuzzy search. */
-   for (int i=0; i<array_size(s); i++) {
-      if (strcasestr( _(s[i]->name), name ) != NULL)
+   /* Do fuzzy search using the index of names, licenses, classes, fabricators and descriptions. */
+   match = ship_searchText( name );
+   for (int i=0; i<array_size(s); i++)
+      if (match[ s[i] - all ])
          array_push_back( &names, s[i]->name );
-      else if ((s[i]->license != NULL) && strcasestr( _(s[i]->license), name ) != NULL)
-         array_push_back( &names, s[i]->name );
-      else if (strcasestr( _(ship_classDisplay( s[i] )), name ) != NULL)
-         array_push_back( &names, s[i]->name );
-      else if (strcasestr( _(s[i]->fabricator), name ) != NULL)
-         array_push_back( &names, s[i]->name );
-      else if (strcasestr( _(s[i]->description), name ) != NULL)
-         array_push_back( &names, s[i]->name );
-   }
+   free( match );
 
    return names;
 }
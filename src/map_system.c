@@ -872,7 +872,7 @@ static void map_system_genOutfitsList( unsigned int wid, float goodsSpace, float
 
    if (noutfits <= 0)
       return;
-   coutfits = outfits_imageArrayCells( (const Outfit**)cur_spob_sel_outfits, &noutfits, player.p );
+   coutfits = outfits_imageArrayCells( (const Outfit**)cur_spob_sel_outfits, &noutfits );
 
    xw = ( w - nameWidth - pitch - 60 ) / 2;
    xpos = 35 + pitch + nameWidth + xw;
@@ -886,6 +886,7 @@ static void map_system_genOutfitsList( unsigned int wid, float goodsSpace, float
    window_addImageArray( wid, xpos, ypos,
          xw, yh, MAPSYS_OUTFITS, iconsize, iconsize,
          coutfits, noutfits, map_system_array_update, NULL, NULL );
+   outfits_imageArrayFill( wid, MAPSYS_OUTFITS, (const Outfit**)cur_spob_sel_outfits, noutfits, player.p );
    toolkit_unsetSelection( wid, MAPSYS_OUTFITS );
 }
 
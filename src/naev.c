@@ -33,11 +33,13 @@
 #include "conf.h"
 #include "console.h"
 #include "damagetype.h"
+#include "datapack.h"
 #include "debug.h"
 #include "dialogue.h"
 #include "difficulty.h"
 #include "economy.h"
 #include "env.h"
+#include "equippool.h"
 #include "event.h"
 #include "faction.h"
 #include "font.h"
@@ -79,9 +81,12 @@
 #include "pilot.h"
 #include "player.h"
 #include "plugin.h"
+#include "profile.h"
 #include "render.h"
+#include "replay.h"
 #include "rng.h"
 #include "safelanes.h"
+#include "save.h"
 #include "semver.h"
 #include "ship.h"
 #include "slots.h"
@@ -270,6 +275,22 @@ int main( int argc, char** argv )
    DEBUG( _("Cache location: %s"), nfile_cachePath() );
    LOG( _("Write location: %s\n"), PHYSFS_getWriteDir() );
 
+   /* Tool mode: pack the XML data, check it matches and exit. */
+   if (conf.datapack_build) {
+      int ret = datapack_build();
+      if (ret == 0)
+         ret = datapack_open();
+      if (ret == 0)
+         ret = datapack_verify();
+      datapack_close();
+      exit( (ret==0) ? EXIT_SUCCESS : EXIT_FAILURE );
+   }
+
+   /* Profile from the start when asked to. */
+   profile_init();
+   if (conf.profile_trace != NULL)
+      profile_start();
+
    /* Enable FPU exceptions. */
    if (conf.fpu_except)
       debug_enableFPUExcept();
@@ -286,6 +307,7 @@ int main( int argc, char** argv )
 
    /* random numbers */
    rng_init();
+   replay_init(); /* reseeds when recording or playing back */
 
    /*
     * OpenGL
@@ -360,8 +382,33 @@ int main( int argc, char** argv )
    cond_init(); /* Initialize conditional subsystem. */
    cli_init(); /* Initialize console. */
 
-   /* Data loading */
+   /* Data loading. */
+   Uint64 load_start = SDL_GetPerformanceCounter();
+   int packed = conf.datapack && (datapack_open() == 0);
    load_all();
+   datapack_close();
+
+   /* Tool mode: compare loading with and without the data pack. */
+   if (conf.universe_digest) {
+      char digest[32];
+      double load_time = (double)(SDL_GetPerformanceCounter() - load_start) / (double)SDL_GetPerformanceFrequency();
+      snprintf( digest, sizeof(digest), "%016"PRIx64, datapack_universeDigest() );
+      LOG(_("Universe digest: %s, loaded in %.3f s from the %s"), digest, load_time,
+            packed ? _("data pack") : _("XML files") );
+      exit( EXIT_SUCCESS );
+   }
+
+   /* Tool mode: compare battles with and without the AI level of detail. */
+   if (conf.ai_lod_compare)
+      exit( (ai_lodCompare()==0) ? EXIT_SUCCESS : EXIT_FAILURE );
+
+   /* Tool mode: check that Lua garbage collection keeps to its budget. */
+   if (conf.lua_gc_test)
+      exit( (nlua_gcTest()==0) ? EXIT_SUCCESS : EXIT_FAILURE );
+
+   /* Tool mode: check that background and synchronous saves match. */
+   if (conf.save_test)
+      exit( (save_test()==0) ? EXIT_SUCCESS : EXIT_FAILURE );
 
    /* Detect size changes that occurred during load. */
    naev_resize();
@@ -379,6 +426,10 @@ int main( int argc, char** argv )
 
    fps_init(); /* initializes the time_ms */
 
+   /* Test mode: run the scripted session of the replay test. */
+   if (conf.replay_test)
+      replay_test();
+
    /*
     * main loop
     */
@@ -431,7 +482,7 @@ int main( int argc, char** argv )
 
    /* primary loop */
    while (!quit) {
-      while (!quit && SDL_PollEvent(&event)) { /* event loop */
+      while (!quit && replay_pollEvent(&event)) { /* event loop */
          if (event.type == SDL_QUIT) {
             if (quit || menu_askQuit()) {
                quit = 1; /* quit is handled here */
@@ -449,6 +500,24 @@ int main( int argc, char** argv )
       main_loop( 1 );
    }
 
+   /* Write out the profile. */
+   if (conf.profile_trace != NULL) {
+      SDL_RWops *rw = SDL_RWFromFile( conf.profile_trace, "w" );
+      if (rw == NULL)
+         WARN(_("Unable to open '%s' for writing: %s"), conf.profile_trace, SDL_GetError());
+      else {
+         if (profile_export( rw ) == 0)
+            LOG(_("Wrote profile to '%s'"), conf.profile_trace);
+         SDL_RWclose( rw );
+      }
+   }
+
+   /* Finish the recording or playback. */
+   replay_exit();
+
+   /* Make sure the last save is on disk. */
+   save_sync();
+
    /* Save configuration. */
    conf_saveConfig(conf_file_path);
 
@@ -480,6 +549,7 @@ int main( int argc, char** argv )
    lua_exit(); /* Closes Lua state, and invalidates all Lua. */
    sound_exit(); /* Kills the sound */
    gl_exit(); /* Kills video output */
+   profile_exit(); /* Frees the profiler. */
 
    /* Has to be run last or it will mess up sound settings. */
    conf_cleanup(); /* Free some memory the configuration allocated. */
@@ -501,6 +571,7 @@ int main( int argc, char** argv )
    log_clean();
 
    /* Really turn the lights off. */
+   ndata_indexFree();
    PHYSFS_deinit();
    gl_fontExit();
    gettext_exit();
@@ -585,6 +656,11 @@ void naev_renderLoadscreen (void)
  */
 void loadscreen_update( double done, const char *msg )
 {
+   static int load_zone = 0;
+
+   /* Each stage is profiled until the next one starts. */
+   if (load_zone)
+      profile_pop();
    /* Run Lua. */
    nlua_getenv( naevL, load_env, "update" );
    lua_pushnumber( naevL, done );
@@ -597,6 +673,8 @@ void loadscreen_update( double done, const char *msg )
    /* Force rerender. */
    load_force_render = 1;
    naev_renderLoadscreen();
+
+   load_zone = (done < 1.) && profile_enabled && profile_push( profile_zone( "load", msg ) );
 }
 
 /**
@@ -691,6 +769,7 @@ void unload_all (void)
    gui_free(); /* cleans up the player's GUI */
    weapon_exit(); /* destroys all active weapons */
    pilots_free(); /* frees the pilots, they were locked up :( */
+   equippool_clear(); /* frees the pooled NPC loadouts */
    cond_exit(); /* destroy conditional subsystem. */
    land_exit(); /* Destroys landing vbo and friends. */
    npc_clear(); /* In case exiting while landed. */
@@ -719,6 +798,9 @@ void unload_all (void)
  */
 void main_loop( int update )
 {
+   NPROFILE_BEGIN( main_loop, "frame", "main_loop" );
+   int profile_base = profile_depth();
+
    /*
     * Control FPS.
     */
@@ -749,14 +831,25 @@ void main_loop( int update )
    /*
     * Handle render.
     */
-   if (!quit) { /* So if update sets up a nested main loop, we can end up in a
-                   state where things are corrupted when trying to exit the game.
-                   Avoid rendering when quitting just in case. */
+   /* So if update sets up a nested main loop, we can end up in a state where
+    * things are corrupted when trying to exit the game. Avoid rendering when
+    * quitting just in case. Headless playback doesn't render at all. */
+   if (!quit && !replay_isHeadless()) {
       /* Clear buffer. */
       render_all( game_dt, real_dt );
       /* Draw buffer. */
       SDL_GL_SwapWindow( gl_screen.window );
    }
+
+   /* Collect Lua garbage now instead of whenever it piles up. */
+   NPROFILE_BEGIN( lua_gc, "frame", "lua_gc" );
+   nlua_gcStep( conf.lua_gc_budget );
+   NPROFILE_END( lua_gc );
+
+   /* Close zones Lua left open, e.g. on errors between push and pop. */
+   nlua_profileClose( profile_base );
+   NPROFILE_END( main_loop );
+   profile_frame();
 }
 
 /**
@@ -879,10 +972,11 @@ static void fps_control (void)
 
    /* dt in s */
    real_dt  = fps_elapsed();
+   replay_frame( &real_dt ); /* Recorded or replaced when playing back. */
    game_dt  = real_dt * dt_mod; /* Apply the modifier. */
 
    /* if fps is limited */
-   if (!conf.vsync && conf.fps_max != 0) {
+   if (!conf.vsync && conf.fps_max != 0 && !replay_isUncapped()) {
       const double fps_max = 1./(double)conf.fps_max;
       if (real_dt < fps_max) {
          double delay = fps_max - real_dt;
@@ -929,6 +1023,25 @@ void display_fps( const double dt )
    if (conf.fps_show) {
       gl_print( &gl_defFontMono, x, y, &cFontWhite, "%3.2f", fps );
       y -= gl_defFontMono.h + 5.;
+      if (conf.devmode) {
+         int calls, skipped, full, partial, hits, misses;
+         double gc_last, gc_max, gc_heap, saved;
+         ai_getStats( &calls, &skipped );
+         gl_print( &gl_defFontMono, x, y, &cFontWhite, _("AI: %d calls, %d skipped"), calls, skipped );
+         y -= gl_defFontMono.h + 5.;
+         pilot_calcStatsCount( &full, &partial );
+         gl_print( &gl_defFontMono, x, y, &cFontWhite, _("Stats: %d full, %d partial"), full, partial );
+         y -= gl_defFontMono.h + 5.;
+         nlua_gcStats( &gc_last, &gc_max, &gc_heap );
+         gl_print( &gl_defFontMono, x, y, &cFontWhite, _("Lua: %.0f KiB, GC %.2f ms (max %.2f ms)"), gc_heap, gc_last, gc_max );
+         y -= gl_defFontMono.h + 5.;
+         pilot_outfitLDescExtraCount( &hits, &misses );
+         gl_print( &gl_defFontMono, x, y, &cFontWhite, _("Descriptions: %d cached, %d generated"), hits, misses );
+         y -= gl_defFontMono.h + 5.;
+         equippool_stats( &hits, &misses, &saved );
+         gl_print( &gl_defFontMono, x, y, &cFontWhite, _("Loadouts: %d pooled, %d solved, %.0f ms saved"), hits, misses, saved*1000. );
+         y -= gl_defFontMono.h + 5.;
+      }
    }
 
    if ((player.p != NULL) && !player_isFlag(PLAYER_DESTROYED) &&
@@ -1005,13 +1118,23 @@ void update_routine( double dt, int enter_sys )
    }
 
    /* Update engine stuff. */
+   NPROFILE_BEGIN( space, "update", "space" );
    space_update(dt, real_dt);
+   NPROFILE_END( space );
+   NPROFILE_BEGIN( weapons, "update", "weapons" );
    weapons_update(dt);
+   NPROFILE_END( weapons );
+   NPROFILE_BEGIN( spfx, "update", "spfx" );
    spfx_update(dt, real_dt);
+   NPROFILE_END( spfx );
+   NPROFILE_BEGIN( pilots, "update", "pilots" );
    pilots_update(dt);
+   NPROFILE_END( pilots );
 
    /* Update camera. */
+   NPROFILE_BEGIN( camera, "update", "camera" );
    cam_update( dt );
+   NPROFILE_END( camera );
 
    /* Update the elapsed time, should be with all the modifications and such. */
    elapsed_time_mod += dt;
@@ -0,0 +1,175 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file nameidx.c
+ *
+ * @brief Hashed name lookups for the arrays of named things like spobs,
+ *        systems, outfits, ships and factions.
+ *
+ * Case insensitive lookups fold ASCII only, like strcasecmp() in the C
+ * locale. When several elements have the same name, the first one is found,
+ * just like going through the array in order.
+ */
+/** @cond */
+#include <stdint.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <string.h>
+/** @endcond */
+
+#include "nameidx.h"
+
+/*
+ * Prototypes.
+ */
+static uint32_t nameidx_hash( const char *s, int fold );
+static const char *nameidx_name( const NameIdx *ni, int i );
+static void nameidx_insert( int *table, int size, uint32_t h, int i );
+static void nameidx_build( NameIdx *ni, const void *base, int n );
+
+/**
+ * @brief FNV-1a hash of a name.
+ *
+ *    @param s Name to hash.
+ *    @param fold Whether to fold the case.
+ */
+static uint32_t nameidx_hash( const char *s, int fold )
+{
+   uint32_t h = 2166136261u;
+   for (; *s!='\0'; s++) {
+      unsigned char c = *s;
+      if (fold && (c >= 'A') && (c <= 'Z'))
+         c += 'a' - 'A';
+      h = (h ^ c) * 16777619u;
+   }
+   return h;
+}
+
+/**
+ * @brief Gets the name of an indexed element.
+ */
+static const char *nameidx_name( const NameIdx *ni, int i )
+{
+   const char *elem = (const char*)ni->base + (size_t)i * ni->stride;
+   return *(char* const*)(elem + ni->offset);
+}
+
+/**
+ * @brief Inserts an element in a hash table with linear probing.
+ */
+static void nameidx_insert( int *table, int size, uint32_t h, int i )
+{
+   for (uint32_t s=h; ; s++) {
+      int *slot = &table[ s & (size-1) ];
+      if (*slot == 0) {
+         *slot = i+1;
+         return;
+      }
+   }
+}
+
+/**
+ * @brief Rebuilds the index of an array.
+ */
+static void nameidx_build( NameIdx *ni, const void *base, int n )
+{
+   int size = 16;
+   while (size < 2*n)
+      size *= 2;
+
+   if (size != ni->size) {
+      free( ni->exact );
+      free( ni->folded );
+      ni->exact  = malloc( size * sizeof(int) );
+      ni->folded = malloc( size * sizeof(int) );
+      ni->size   = size;
+   }
+   memset( ni->exact, 0, size * sizeof(int) );
+   memset( ni->folded, 0, size * sizeof(int) );
+   ni->base  = base;
+   ni->n     = n;
+   ni->dirty = 0;
+
+   for (int i=0; i<n; i++) {
+      const char *name = nameidx_name( ni, i );
+      if (name == NULL)
+         continue;
+      nameidx_insert( ni->exact, size, nameidx_hash( name, 0 ), i );
+      nameidx_insert( ni->folded, size, nameidx_hash( name, 1 ), i );
+   }
+}
+
+/**
+ * @brief Marks an index as having to be rebuilt, for when the array is sorted
+ *        or names change.
+ */
+void nameidx_invalidate( NameIdx *ni )
+{
+   ni->dirty = 1;
+}
+
+/**
+ * @brief Frees an index, it can still be used afterwards.
+ */
+void nameidx_free( NameIdx *ni )
+{
+   free( ni->exact );
+   free( ni->folded );
+   ni->exact  = NULL;
+   ni->folded = NULL;
+   ni->size   = 0;
+   ni->base   = NULL;
+   ni->n      = 0;
+   ni->dirty  = 1;
+}
+
+/**
+ * @brief Looks up an element by name.
+ *
+ *    @param ni Index to use.
+ *    @param base Array (array.h) being indexed.
+ *    @param n Number of elements of the array.
+ *    @param name Name to look up.
+ *    @return Index of the element or -1 if not found.
+ */
+int nameidx_get( NameIdx *ni, const void *base, int n, const char *name )
+{
+   if (name == NULL)
+      return -1;
+   if (ni->dirty || (ni->base != base) || (ni->n != n))
+      nameidx_build( ni, base, n );
+
+   for (uint32_t s=nameidx_hash( name, 0 ); ; s++) {
+      int i = ni->exact[ s & (ni->size-1) ];
+      if (i == 0)
+         return -1;
+      if (strcmp( nameidx_name( ni, i-1 ), name )==0)
+         return i-1;
+   }
+}
+
+/**
+ * @brief Looks up an element by name case insensitively.
+ *
+ *    @param ni Index to use.
+ *    @param base Array (array.h) being indexed.
+ *    @param n Number of elements of the array.
+ *    @param name Name to look up.
+ *    @return Index of the element or -1 if not found.
+ */
+int nameidx_getCase( NameIdx *ni, const void *base, int n, const char *name )
+{
+   if (name == NULL)
+      return -1;
+   if (ni->dirty || (ni->base != base) || (ni->n != n))
+      nameidx_build( ni, base, n );
+
+   for (uint32_t s=nameidx_hash( name, 1 ); ; s++) {
+      int i = ni->folded[ s & (ni->size-1) ];
+      if (i == 0)
+         return -1;
+      if (strcasecmp( nameidx_name( ni, i-1 ), name )==0)
+         return i-1;
+   }
+}
@@ -0,0 +1,37 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+#pragma once
+
+/** @cond */
+#include <stddef.h>
+/** @endcond */
+
+/**
+ * @brief Hashed index of the names of an array of structures, both exact and
+ *        case insensitive.
+ *
+ * It gets rebuilt the next time it is used after being invalidated or when
+ * the array it indexes has moved or changed size.
+ */
+typedef struct NameIdx_ {
+   size_t stride;    /**< Size of the elements of the array. */
+   size_t offset;    /**< Offset of the name (char*) in the elements. */
+   int *exact;       /**< Element index plus one by hash of the name, 0 if empty. */
+   int *folded;      /**< Same by hash of the case folded name. */
+   int size;         /**< Number of slots of the tables, power of two. */
+   const void *base; /**< Array that was indexed. */
+   int n;            /**< Number of elements that were indexed. */
+   int dirty;        /**< Has to be rebuilt. */
+} NameIdx;
+
+/**
+ * @brief Initializer for the index of the names in a field of a structure.
+ */
+#define NAMEIDX_INIT( type, field ) \
+   { .stride = sizeof(type), .offset = offsetof(type, field), .dirty = 1 }
+
+void nameidx_invalidate( NameIdx *ni );
+void nameidx_free( NameIdx *ni );
+int nameidx_get( NameIdx *ni, const void *base, int n, const char *name );
+int nameidx_getCase( NameIdx *ni, const void *base, int n, const char *name );
@@ -9,9 +9,11 @@
  *        However, conf.c code may have seeded the search path based on command-line arguments.
  */
 /** @cond */
+#include <dirent.h>
 #include <limits.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #if WIN32
 #include <windows.h>
 #endif /* WIN32 */
@@ -33,14 +35,38 @@
 #include "log.h"
 #include "nfile.h"
 #include "nstring.h"
+#include "physfs_archiver_blacklist.h"
 #include "plugin.h"
 
+/**
+ * @brief An entry of the search path index.
+ */
+typedef struct NdataEntry_ {
+   char *path;             /**< Path relative to the search path root. */
+   PHYSFS_FileType type;   /**< Type of the entry. */
+} NdataEntry;
+
+/**
+ * @brief State of building the search path index.
+ */
+typedef struct NdataIndexer_ {
+   NdataEntry *idx;        /**< Index being built. */
+   const char *archive;    /**< Archive being indexed through PhysicsFS. */
+   int nstat;              /**< Number of entries that had to be stat'd. */
+} NdataIndexer;
+
+static NdataEntry *ndata_idx = NULL; /**< Index of the search path sorted by path, NULL if not built. */
+
 /*
  * Prototypes.
  */
 static void ndata_testVersion (void);
 static int ndata_found (void);
 static int ndata_enumerateCallback( void* data, const char* origdir, const char* fname );
+static int ndata_indexCallback( void* data, const char* origdir, const char* fname );
+static void ndata_indexDir( NdataIndexer *ixr, const char *native, const char *path );
+static int ndata_indexCmp( const void *p1, const void *p2 );
+static const NdataEntry *ndata_indexFind( const char *path );
 
 /**
  * @brief Checks to see if the physfs search path is enough to find game data.
@@ -142,6 +168,229 @@ void ndata_setupReadDirs (void)
    plugin_init();
 
    ndata_testVersion();
+
+   /* Search path is final now. */
+   ndata_index();
+}
+
+/**
+ * @brief Builds the index of the search path used for listing and existence checks.
+ *
+ * Only the read-only data mounts are indexed, the write directory holds saves
+ * and screenshots that change while playing. Mounted directories are walked
+ * directly, as the directory entries already give the file types, archives
+ * go through PhysicsFS.
+ *
+ * Has to be rebuilt whenever the search path changes.
+ */
+void ndata_index (void)
+{
+   Uint64 start = SDL_GetPerformanceCounter();
+   NdataIndexer ixr;
+   char **search;
+   const char *wdir;
+   int j;
+
+   ndata_indexFree();
+
+   ixr.idx     = array_create( NdataEntry );
+   ixr.archive = NULL;
+   ixr.nstat   = 0;
+   wdir        = PHYSFS_getWriteDir();
+   search      = PHYSFS_getSearchPath();
+   for (char **s=search; *s!=NULL; s++) {
+      char mount[PATH_MAX];
+      int len;
+
+      if ((wdir != NULL) && (strcmp( *s, wdir ) == 0))
+         continue;
+      /* Only blanks out files that are in the other mounts. */
+      if (strcmp( *s, BLACKLIST_FILENAME ) == 0)
+         continue;
+
+      /* Mount points are absolute and end with a slash unless at the root. */
+      len = snprintf( mount, sizeof(mount), "%s", PHYSFS_getMountPoint( *s ) + 1 );
+      if ((len > 0) && (mount[len-1] == '/'))
+         mount[len-1] = '\0';
+
+      if (nfile_dirExists( *s ))
+         ndata_indexDir( &ixr, *s, mount );
+      else {
+         ixr.archive = *s;
+         PHYSFS_enumerate( mount, ndata_indexCallback, &ixr );
+      }
+   }
+   PHYSFS_freeList( search );
+   ndata_idx = ixr.idx;
+
+   /* A path can show up multiple times if it's in multiple components of the
+    * union, we only keep one. */
+   qsort( ndata_idx, array_size(ndata_idx), sizeof(NdataEntry), ndata_indexCmp );
+   j = 0;
+   for (int i=0; i<array_size(ndata_idx); i++) {
+      if ((j > 0) && (strcmp( ndata_idx[j-1].path, ndata_idx[i].path ) == 0)) {
+         free( ndata_idx[i].path );
+         continue;
+      }
+      ndata_idx[j++] = ndata_idx[i];
+   }
+   array_resize( &ndata_idx, j );
+   array_shrink( &ndata_idx );
+
+   if (conf.devmode) {
+      double time = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+      DEBUG( n_("Indexed %d data file in %.3f s", "Indexed %d data files in %.3f s", j), j, time );
+      DEBUG( n_("Index needed %d stat call", "Index needed %d stat calls", ixr.nstat), ixr.nstat );
+   }
+   else
+      DEBUG( n_("Indexed %d data file", "Indexed %d data files", j), j );
+}
+
+/**
+ * @brief Frees the index of the search path.
+ */
+void ndata_indexFree (void)
+{
+   for (int i=0; i<array_size(ndata_idx); i++)
+      free( ndata_idx[i].path );
+   array_free( ndata_idx );
+   ndata_idx = NULL;
+}
+
+/**
+ * @brief Indexes a mounted directory.
+ *
+ *    @param ixr Indexer state.
+ *    @param native Native path of the directory.
+ *    @param path Path of the directory in the search path.
+ */
+static void ndata_indexDir( NdataIndexer *ixr, const char *native, const char *path )
+{
+   DIR *d;
+   struct dirent *de;
+
+   d = opendir( native );
+   if (d == NULL)
+      return;
+   while ((de = readdir( d )) != NULL) {
+      char nchild[PATH_MAX];
+      NdataEntry *e;
+      PHYSFS_FileType type;
+
+      if ((strcmp( de->d_name, "." ) == 0) || (strcmp( de->d_name, ".." ) == 0))
+         continue;
+      snprintf( nchild, sizeof(nchild), "%s/%s", native, de->d_name );
+
+      /* Only links and file systems that don't give the type need a stat. */
+#ifdef DT_DIR
+      if (de->d_type == DT_DIR)
+         type = PHYSFS_FILETYPE_DIRECTORY;
+      else if (de->d_type == DT_REG)
+         type = PHYSFS_FILETYPE_REGULAR;
+      else
+#endif /* DT_DIR */
+      {
+         struct stat st;
+         ixr->nstat++;
+         if (stat( nchild, &st ) != 0)
+            continue;
+         if (S_ISDIR( st.st_mode ))
+            type = PHYSFS_FILETYPE_DIRECTORY;
+         else if (S_ISREG( st.st_mode ))
+            type = PHYSFS_FILETYPE_REGULAR;
+         else
+            type = PHYSFS_FILETYPE_OTHER;
+      }
+
+      e = &array_grow( &ixr->idx );
+      if (path[0] == '\0')
+         e->path = strdup( de->d_name );
+      else
+         asprintf( &e->path, "%s/%s", path, de->d_name );
+      e->type = type;
+
+      if (type == PHYSFS_FILETYPE_DIRECTORY)
+         ndata_indexDir( ixr, nchild, e->path );
+   }
+   closedir( d );
+}
+
+/**
+ * @brief The PHYSFS_EnumerateCallback for indexing archives in ndata_index.
+ *
+ * PhysicsFS enumerates the whole union, so only the entries the archive
+ * provides are kept.
+ */
+static int ndata_indexCallback( void* data, const char* origdir, const char* fname )
+{
+   NdataIndexer *ixr = data;
+   NdataEntry *e;
+   const char *realdir;
+   char *path;
+   size_t dir_len;
+   PHYSFS_Stat stat;
+
+   dir_len = strlen( origdir );
+   if ((dir_len == 0) || (origdir[dir_len-1] == '/'))
+      asprintf( &path, "%s%s", origdir, fname );
+   else
+      asprintf( &path, "%s/%s", origdir, fname );
+   ixr->nstat++;
+   if (!PHYSFS_stat( path, &stat )) {
+      WARN( _("PhysicsFS: Cannot stat %s: %s"), path,
+            _(PHYSFS_getErrorByCode( PHYSFS_getLastErrorCode() ) ) );
+      free( path );
+      return PHYSFS_ENUM_OK;
+   }
+
+   /* Directories are always entered, files of the archive can be below any. */
+   realdir = PHYSFS_getRealDir( path );
+   if ((realdir != NULL) && (strcmp( realdir, ixr->archive ) == 0)) {
+      e = &array_grow( &ixr->idx );
+      e->path  = strdup( path );
+      e->type  = stat.filetype;
+   }
+   if (stat.filetype == PHYSFS_FILETYPE_DIRECTORY)
+      PHYSFS_enumerate( path, ndata_indexCallback, data );
+   free( path );
+   return PHYSFS_ENUM_OK;
+}
+
+/**
+ * @brief Compares index entries by path.
+ */
+static int ndata_indexCmp( const void *p1, const void *p2 )
+{
+   const NdataEntry *e1 = p1;
+   const NdataEntry *e2 = p2;
+   return strcmp( e1->path, e2->path );
+}
+
+/**
+ * @brief Looks up a path in the index.
+ *
+ *    @return The entry or NULL if not found.
+ */
+static const NdataEntry *ndata_indexFind( const char *path )
+{
+   const NdataEntry key = { .path = (char*)path };
+   return bsearch( &key, ndata_idx, array_size(ndata_idx), sizeof(NdataEntry), ndata_indexCmp );
+}
+
+/**
+ * @brief Checks to see if a file or directory exists in the game data.
+ *
+ * Uses the index if available, meant for game data and not for files that
+ * get written during the game such as saves.
+ *
+ *    @param path Path to check.
+ *    @return 1 if it exists, 0 otherwise.
+ */
+int ndata_exists( const char *path )
+{
+   if (ndata_idx == NULL)
+      return PHYSFS_exists( path );
+   return (ndata_indexFind( path ) != NULL);
 }
 
 /**
@@ -232,15 +481,51 @@ void* ndata_read( const char* path, size_t *filesize )
 char **ndata_listRecursive( const char *path )
 {
    char **files = array_create( char * );
+   int n;
+
+   /* Use the index, everything below the directory is contiguous in it. */
+   if (ndata_idx != NULL) {
+      char prefix[PATH_MAX];
+      const NdataEntry key = { .path = prefix };
+      int len, lo, hi;
+
+      len = snprintf( prefix, sizeof(prefix), "%s", path );
+      while ((len > 0) && (prefix[len-1] == '/'))
+         prefix[--len] = '\0';
+      if (len > 0)
+         len = scnprintf( &prefix[len], sizeof(prefix)-len, "/" ) + len;
+
+      /* Lower bound of the prefix. */
+      lo = 0;
+      hi = array_size(ndata_idx);
+      while (lo < hi) {
+         int mid = (lo+hi) / 2;
+         if (ndata_indexCmp( &ndata_idx[mid], &key ) < 0)
+            lo = mid+1;
+         else
+            hi = mid;
+      }
+      for (int i=lo; i<array_size(ndata_idx); i++) {
+         if (strncmp( ndata_idx[i].path, prefix, len ) != 0)
+            break;
+         if (ndata_idx[i].type == PHYSFS_FILETYPE_REGULAR)
+            array_push_back( &files, strdup( ndata_idx[i].path ) );
+      }
+      return files;
+   }
+
    PHYSFS_enumerate( path, ndata_enumerateCallback, &files );
    /* Ensure unique. PhysicsFS can enumerate a path twice if it's in multiple components of a union. */
    qsort( files, array_size(files), sizeof(char*), strsort );
-   for (int i=0; i+1<array_size(files); i++)
-      if (strcmp(files[i], files[i+1]) == 0) {
+   n = 0;
+   for (int i=0; i<array_size(files); i++) {
+      if ((n > 0) && (strcmp( files[n-1], files[i] ) == 0)) {
          free( files[i] );
-         array_erase( &files, &files[i], &files[i+1] );
-         i--; /* We're not done checking for dups of files[i]. */
+         continue;
       }
+      files[n++] = files[i];
+   }
+   array_resize( &files, n );
    return files;
 }
 
@@ -87,6 +87,9 @@ void ndata_setupWriteDir (void);
 void ndata_setupReadDirs (void);
 void* ndata_read( const char* filename, size_t *filesize );
 char** ndata_listRecursive( const char *path );
+int ndata_exists( const char *path );
+void ndata_index (void);
+void ndata_indexFree (void);
 int ndata_backupIfExists( const char *path );
 int ndata_copyIfExists( const char *path1, const char *path2 );
 int ndata_matchExt( const char *path, const char *ext );
@@ -17,6 +17,7 @@
 
 #include "log.h"
 #include "conf.h"
+#include "faction.h"
 #include "lua_enet.h"
 #include "lutf8lib.h"
 #include "ndata.h"
@@ -46,12 +47,41 @@
 #include "nlua_vec2.h"
 #include "nluadef.h"
 #include "nstring.h"
+#include "pilot.h"
+#include "replay.h"
+#include "rng.h"
+#include "space.h"
+#include "start.h"
+
+/*
+ * Garbage collection.
+ */
+#define NLUA_GC_PAUSE      150 /**< Heap growth in percent before the automatic collector starts a cycle. */
+#define NLUA_GC_STEPMUL    100 /**< Automatic collector speed in percent relative to allocation. */
+#define NLUA_GC_STEPSIZE   16  /**< Size in KiB of each step of the frame collector. */
+#define NLUA_GC_THRESHOLD  110 /**< Heap growth in percent before the frame collector starts a cycle. */
+#define NLUA_GC_REPLAY     8   /**< Steps of the frame collector per frame when recording or playing back. */
+
+/*
+ * Garbage collection test.
+ */
+#define NLUA_GCTEST_SHIPS  10    /**< Ships per side of the test battle. */
+#define NLUA_GCTEST_TIME   60.   /**< Time the test battle lasts, in seconds. */
+#define NLUA_GCTEST_DT     (1./60.) /**< Time step of the test battle. */
+#define NLUA_GCTEST_SEED   1337u /**< Seed of the test battle. */
+#define NLUA_GCTEST_SLACK  0.5   /**< Time in ms a frame may go past the budget, as the last step can't be cut short. */
+/** Garbage made every frame of the test on top of what the AI makes. */
+#define NLUA_GCTEST_GARBAGE "local t = {} for i=1,2000 do t[i] = { i, tostring(i) } end"
 
 lua_State *naevL = NULL;
 nlua_env __NLUA_CURENV = LUA_NOREF;
 static char *common_script; /**< Common script to run when creating environments. */
 static size_t common_sz; /**< Common script size. */
 static int nlua_envs = LUA_NOREF;
+static double nlua_gc_last = 0.; /**< Time spent collecting garbage last frame in ms. */
+static double nlua_gc_max  = 0.; /**< Worst time spent collecting garbage in a frame in ms. */
+static int nlua_gc_base    = 0; /**< Heap size in KiB after the last collection cycle. */
+static int nlua_gc_cycle   = 0; /**< Whether the frame collector is in the middle of a cycle. */
 
 /*
  * prototypes
@@ -186,6 +216,151 @@ void lua_init (void)
 
    /* Better clean up. */
    lua_atpanic( naevL, nlua_panic );
+
+   /* nlua_gcStep() starts its cycles at NLUA_GC_THRESHOLD, before the
+    * automatic collector does. The automatic collector is only a backstop for
+    * when frames leave no time to collect, its pause is lower than the
+    * default so the heap stays bounded in that case. */
+   lua_gc( naevL, LUA_GCSETPAUSE, NLUA_GC_PAUSE );
+   lua_gc( naevL, LUA_GCSETSTEPMUL, NLUA_GC_STEPMUL );
+   nlua_gc_base = lua_gc( naevL, LUA_GCCOUNT, 0 );
+}
+
+/**
+ * @brief Does incremental garbage collection of the global Lua state.
+ *
+ * Meant to be called once a frame after rendering, so that collection work
+ * happens at a predictable time instead of in the middle of updating. A cycle
+ * is only started once the heap has grown NLUA_GC_THRESHOLD percent past its
+ * size after the last one, and is then stepped every frame until it finishes.
+ * When recording or playing back a replay, a fixed number of steps is done
+ * instead of filling the budget, so collection doesn't depend on timing.
+ *
+ *    @param budget Maximum time to spend collecting in ms.
+ */
+void nlua_gcStep( double budget )
+{
+   Uint64 start, now;
+   double freq;
+   int heap, n, fixed;
+
+   nlua_gc_last = 0.;
+   if (budget <= 0.)
+      return;
+
+   /* The automatic collector may have finished a cycle on its own. */
+   heap = lua_gc( naevL, LUA_GCCOUNT, 0 );
+   nlua_gc_base = MIN( nlua_gc_base, heap );
+   if (!nlua_gc_cycle && (heap*100 < nlua_gc_base*NLUA_GC_THRESHOLD))
+      return;
+   nlua_gc_cycle = 1;
+
+   fixed = replay_isDeterministic();
+   freq  = (double)SDL_GetPerformanceFrequency() / 1000.;
+   start = SDL_GetPerformanceCounter();
+   n     = 0;
+   do {
+      /* Wait for the heap to grow again after finishing a cycle. */
+      if (lua_gc( naevL, LUA_GCSTEP, NLUA_GC_STEPSIZE )) {
+         nlua_gc_cycle = 0;
+         nlua_gc_base  = lua_gc( naevL, LUA_GCCOUNT, 0 );
+         break;
+      }
+      now = SDL_GetPerformanceCounter();
+      n++;
+   } while (fixed ? (n < NLUA_GC_REPLAY) : ((double)(now-start) / freq < budget));
+
+   nlua_gc_last = (double)(SDL_GetPerformanceCounter()-start) / freq;
+   nlua_gc_max  = MAX( nlua_gc_max, nlua_gc_last );
+}
+
+/**
+ * @brief Runs a battle headless, collecting garbage every frame, and checks
+ *        that no frame spends longer than its budget collecting.
+ *
+ * On top of what the AI of the ships makes, every frame runs a chunk making
+ * garbage, so that the collector runs full cycles during the test.
+ *
+ *    @return 0 if every frame kept to the budget.
+ */
+int nlua_gcTest (void)
+{
+   const char *fname[2] = { "Empire", "Pirate" };
+   const char *sname[2] = { "Empire Shark", "Pirate Shark" };
+   double budget = (conf.lua_gc_budget > 0.) ? conf.lua_gc_budget : 1.;
+   int old_spawn = space_spawn;
+   int nframes = 0, ncycles = 0, nover = 0, failed = 0;
+   double last, max, heap;
+   PilotFlags flags;
+
+   space_spawn = 0;
+   space_init( start_system(), 0 );
+   rng_seed( NLUA_GCTEST_SEED );
+   pilot_clearFlagsRaw( flags );
+   for (int s=0; s<2; s++) {
+      int f = faction_get( fname[s] );
+      const Ship *ship = ship_get( sname[s] );
+      for (int i=0; i<NLUA_GCTEST_SHIPS; i++) {
+         vec2 pos, vel;
+         double a = (s==0) ? 0. : M_PI;
+         vec2_cset( &pos, 750.*cos(a+M_PI) + RNGF()*200., (i-NLUA_GCTEST_SHIPS/2)*200. );
+         vec2_cset( &vel, 0., 0. );
+         pilot_create( ship, NULL, f, faction_default_ai(f), a, &pos, &vel,
+               flags, 0, 0 );
+      }
+   }
+
+   nlua_gc_max = 0.;
+   for (double t=0.; t<NLUA_GCTEST_TIME; t+=NLUA_GCTEST_DT) {
+      int cycle;
+      update_routine( NLUA_GCTEST_DT, 0 );
+      if (luaL_dostring( naevL, NLUA_GCTEST_GARBAGE )) {
+         WARN(_("Lua garbage collection test failed to run: %s"), lua_tostring( naevL, -1 ));
+         lua_pop( naevL, 1 );
+         failed = 1;
+         break;
+      }
+      cycle = nlua_gc_cycle;
+      nlua_gcStep( budget );
+      if (cycle && !nlua_gc_cycle)
+         ncycles++;
+      if (nlua_gc_last > budget + NLUA_GCTEST_SLACK)
+         nover++;
+      nframes++;
+   }
+   nlua_gcStats( &last, &max, &heap );
+   pilots_cleanAll();
+   space_spawn = old_spawn;
+
+   LOG(_("Lua garbage collection: %d frames, %d cycles, worst frame %.3f ms of %.3f ms budget, %.0f KiB heap"),
+         nframes, ncycles, max, budget, heap );
+   if (failed)
+      return -1;
+   if (ncycles == 0) {
+      WARN(_("Lua garbage collection test did not finish any cycle"));
+      return -1;
+   }
+   if (nover > 0) {
+      WARN(n_("Lua garbage collection went over budget in %d frame",
+            "Lua garbage collection went over budget in %d frames", nover), nover);
+      return -1;
+   }
+   LOG(_("Lua garbage collection kept to the budget"));
+   return 0;
+}
+
+/**
+ * @brief Gets the garbage collection statistics of the global Lua state.
+ *
+ *    @param[out] last Time spent collecting last frame in ms.
+ *    @param[out] max Worst time spent collecting in a frame in ms.
+ *    @param[out] heap Size of the Lua heap in KiB.
+ */
+void nlua_gcStats( double *last, double *max, double *heap )
+{
+   *last = nlua_gc_last;
+   *max  = nlua_gc_max;
+   *heap = lua_gc( naevL, LUA_GCCOUNT, 0 ) + lua_gc( naevL, LUA_GCCOUNTB, 0 ) / 1024.;
 }
 
 /**
@@ -211,6 +386,8 @@ static int luaB_loadstring( lua_State *L )
  */
 void lua_exit (void)
 {
+   if (conf.devmode)
+      DEBUG( _("Lua GC: worst frame took %.3f ms"), nlua_gc_max );
    free( common_script );
    lua_close(naevL);
    naevL = NULL;
@@ -582,7 +759,7 @@ static int nlua_package_loader_lua( lua_State* L )
             path_filename[i] = '/';
 
       /* Try to load the file. */
-      if (PHYSFS_exists( path_filename )) {
+      if (ndata_exists( path_filename )) {
          buf = ndata_read( path_filename, &bufsize );
          if (buf != NULL)
             break;
@@ -47,6 +47,11 @@ int nlua_reffield( int objref, const char *name );
 int nlua_ref( lua_State *L, int idx );
 void nlua_unref( lua_State *L, int idx );
 
+/* Garbage collection. */
+void nlua_gcStep( double budget );
+void nlua_gcStats( double *last, double *max, double *heap );
+int nlua_gcTest (void);
+
 /* Hack to handle resizes. */
 void nlua_resize (void);
 
@@ -439,6 +439,7 @@ static int jumpL_setKnown( lua_State *L )
       jp_rmFlag( jp, JP_KNOWN );
 
    if (changed) {
+      space_knownChanged();
       /* Update overlay. */
       ovr_refresh();
       /* Update outfits image array - in the case it changes map owned status. */
@@ -10,6 +10,7 @@
 
 /** @cond */
 #include <glpk.h>
+#include <limits.h>
 #include <lauxlib.h>
 #include "physfs.h"
 
@@ -21,8 +22,11 @@
 #include "log.h"
 #include "nstring.h"
 #include "nluadef.h"
+#include "replay.h"
 
 #define LINOPT_MAX_TM   1000  /**< Maximum time to optimize (in ms). Applied to linear relaxation and MIP independently. */
+#define LINOPT_BASIS_CACHE 64 /**< Number of bases kept to warm start new problems with the same shape. */
+#define LINOPT_MEMO_SIZE   256 /**< Number of solutions kept in the memo. */
 
 /**
  * @brief Our cute little linear program wrapper.
@@ -31,8 +35,40 @@ typedef struct LuaLinOpt_s {
    int ncols;        /**< Number of structural variables. */
    int nrows;        /**< Number of auxiliary variables (constraints). */
    glp_prob *prob;   /**< Problem structure itself. */
+   uint64_t pattern; /**< Hash of the sparsity pattern of the matrix. */
+   uint64_t values;  /**< Hash of the coefficients of the matrix. */
+   int solved;       /**< Whether the problem has a basis from a previous solve. */
 } LuaLinOpt_t;
 
+/**
+ * @brief Basis of a solved problem, used to warm start problems with the same shape.
+ */
+typedef struct LinOptBasis_ {
+   uint64_t shape;   /**< Hash of the dimensions and sparsity pattern. */
+   int nrows;        /**< Number of rows. */
+   int ncols;        /**< Number of columns. */
+   int *stat;        /**< Status of the rows followed by the columns. */
+} LinOptBasis;
+
+/**
+ * @brief Memoized solution of a problem.
+ */
+typedef struct LinOptMemo_ {
+   uint64_t key;     /**< Hash of the whole problem and solver parameters. */
+   int nrows;        /**< Number of rows. */
+   int ncols;        /**< Number of columns. */
+   double z;         /**< Value of the objective function. */
+   double *val;      /**< Value of the columns followed by the rows. */
+} LinOptMemo;
+
+static LinOptBasis linopt_basis[LINOPT_BASIS_CACHE]; /**< Bases to warm start new problems. */
+static LinOptMemo linopt_memo[LINOPT_MEMO_SIZE]; /**< Memoized solutions. */
+static int linopt_nsolves     = 0; /**< Number of calls to solve. */
+static int linopt_nmemo       = 0; /**< Solves answered by the memo. */
+static int linopt_nwarm       = 0; /**< Simplex solves started from a previous basis. */
+static int linopt_ncold       = 0; /**< Simplex solves started from the standard basis. */
+static double linopt_time     = 0.; /**< Total time spent solving in seconds. */
+
 /* Optim metatable methods. */
 static int linoptL_gc( lua_State *L );
 static int linoptL_eq( lua_State *L );
@@ -46,6 +82,7 @@ static int linoptL_loadmatrix( lua_State *L );
 static int linoptL_solve( lua_State *L );
 static int linoptL_readProblem( lua_State *L );
 static int linoptL_writeProblem( lua_State *L );
+static int linoptL_stats( lua_State *L );
 static const luaL_Reg linoptL_methods[] = {
    { "__gc", linoptL_gc },
    { "__eq", linoptL_eq },
@@ -59,6 +96,7 @@ static const luaL_Reg linoptL_methods[] = {
    { "solve", linoptL_solve },
    { "read_problem", linoptL_readProblem },
    { "write_problem", linoptL_writeProblem },
+   { "stats", linoptL_stats },
    {0,0}
 }; /**< Optim metatable methods. */
 
@@ -74,6 +112,180 @@ int nlua_loadLinOpt( nlua_env env )
    return 0;
 }
 
+/**
+ * @brief Adds a value to a FNV-1a hash.
+ */
+static uint64_t linopt_hash( uint64_t h, const void *data, size_t len )
+{
+   const unsigned char *c = data;
+   for (size_t i=0; i<len; i++) {
+      h ^= c[i];
+      h *= 1099511628211ULL;
+   }
+   return h;
+}
+#define LINOPT_HASH( h, v )   linopt_hash( (h), &(v), sizeof(v) ) /**< Hashes a variable. */
+#define LINOPT_HASH_INIT      14695981039346656037ULL /**< FNV-1a offset basis. */
+
+/**
+ * @brief Hashes the matrix of a linear program, going over it by column.
+ *
+ *    @param lp Linear program to hash the matrix of.
+ */
+static void linopt_hashMatrix( LuaLinOpt_t *lp )
+{
+   int n = glp_get_num_rows( lp->prob );
+   int *ind = malloc( (n+1) * sizeof(int) );
+   double *val = malloc( (n+1) * sizeof(double) );
+   lp->pattern = lp->values = LINOPT_HASH_INIT;
+   for (int j=1; j<=glp_get_num_cols( lp->prob ); j++) {
+      int len = glp_get_mat_col( lp->prob, j, ind, val );
+      lp->pattern = LINOPT_HASH( lp->pattern, len );
+      lp->pattern = linopt_hash( lp->pattern, &ind[1], len*sizeof(int) );
+      lp->values  = linopt_hash( lp->values, &val[1], len*sizeof(double) );
+   }
+   free( ind );
+   free( val );
+}
+
+/**
+ * @brief Gets the hash identifying the shape of a linear program.
+ */
+static uint64_t linopt_shape( const LuaLinOpt_t *lp )
+{
+   uint64_t h = lp->pattern;
+   h = LINOPT_HASH( h, lp->nrows );
+   h = LINOPT_HASH( h, lp->ncols );
+   return h;
+}
+
+/**
+ * @brief Hashes everything that determines the solution of a linear program.
+ *
+ *    @param lp Linear program to hash.
+ *    @param smcp Simplex parameters.
+ *    @param iocp MIP parameters or NULL if not a MIP.
+ *    @return Hash of the linear program.
+ */
+static uint64_t linopt_hashProblem( const LuaLinOpt_t *lp, const glp_smcp *smcp, const glp_iocp *iocp )
+{
+   uint64_t h = linopt_shape( lp );
+   int dir = glp_get_obj_dir( lp->prob );
+   double c0 = glp_get_obj_coef( lp->prob, 0 );
+   h = LINOPT_HASH( h, lp->values );
+   h = LINOPT_HASH( h, dir );
+   h = LINOPT_HASH( h, c0 );
+   for (int i=1; i<=lp->nrows; i++) {
+      int type = glp_get_row_type( lp->prob, i );
+      double lb = glp_get_row_lb( lp->prob, i );
+      double ub = glp_get_row_ub( lp->prob, i );
+      h = LINOPT_HASH( h, type );
+      h = LINOPT_HASH( h, lb );
+      h = LINOPT_HASH( h, ub );
+   }
+   for (int j=1; j<=lp->ncols; j++) {
+      int type = glp_get_col_type( lp->prob, j );
+      int kind = glp_get_col_kind( lp->prob, j );
+      double lb = glp_get_col_lb( lp->prob, j );
+      double ub = glp_get_col_ub( lp->prob, j );
+      double c = glp_get_obj_coef( lp->prob, j );
+      h = LINOPT_HASH( h, type );
+      h = LINOPT_HASH( h, kind );
+      h = LINOPT_HASH( h, lb );
+      h = LINOPT_HASH( h, ub );
+      h = LINOPT_HASH( h, c );
+   }
+   h = LINOPT_HASH( h, smcp->meth );
+   h = LINOPT_HASH( h, smcp->pricing );
+   h = LINOPT_HASH( h, smcp->r_test );
+   h = LINOPT_HASH( h, smcp->presolve );
+   if (iocp != NULL) {
+      h = LINOPT_HASH( h, iocp->br_tech );
+      h = LINOPT_HASH( h, iocp->bt_tech );
+      h = LINOPT_HASH( h, iocp->pp_tech );
+      h = LINOPT_HASH( h, iocp->sr_heur );
+      h = LINOPT_HASH( h, iocp->fp_heur );
+      h = LINOPT_HASH( h, iocp->ps_heur );
+      h = LINOPT_HASH( h, iocp->gmi_cuts );
+      h = LINOPT_HASH( h, iocp->mir_cuts );
+      h = LINOPT_HASH( h, iocp->cov_cuts );
+      h = LINOPT_HASH( h, iocp->clq_cuts );
+      h = LINOPT_HASH( h, iocp->presolve );
+   }
+   return h;
+}
+
+/**
+ * @brief Sets the basis of a problem to the one of the last solved problem with the same shape.
+ *
+ *    @param lp Linear program to set the basis of.
+ *    @return 1 if a basis was set.
+ */
+static int linopt_loadBasis( LuaLinOpt_t *lp )
+{
+   uint64_t shape = linopt_shape( lp );
+   const LinOptBasis *b = &linopt_basis[ shape % LINOPT_BASIS_CACHE ];
+   if ((b->stat == NULL) || (b->shape != shape) ||
+         (b->nrows != lp->nrows) || (b->ncols != lp->ncols))
+      return 0;
+   for (int i=1; i<=lp->nrows; i++)
+      glp_set_row_stat( lp->prob, i, b->stat[i-1] );
+   for (int j=1; j<=lp->ncols; j++)
+      glp_set_col_stat( lp->prob, j, b->stat[lp->nrows+j-1] );
+   return 1;
+}
+
+/**
+ * @brief Stores the basis of a solved problem for problems with the same shape.
+ *
+ *    @param lp Linear program to store the basis of.
+ */
+static void linopt_saveBasis( const LuaLinOpt_t *lp )
+{
+   uint64_t shape = linopt_shape( lp );
+   LinOptBasis *b = &linopt_basis[ shape % LINOPT_BASIS_CACHE ];
+   if ((b->nrows+b->ncols) != (lp->nrows+lp->ncols)) {
+      free( b->stat );
+      b->stat = malloc( (lp->nrows+lp->ncols) * sizeof(int) );
+   }
+   b->shape = shape;
+   b->nrows = lp->nrows;
+   b->ncols = lp->ncols;
+   for (int i=1; i<=lp->nrows; i++)
+      b->stat[i-1] = glp_get_row_stat( lp->prob, i );
+   for (int j=1; j<=lp->ncols; j++)
+      b->stat[lp->nrows+j-1] = glp_get_col_stat( lp->prob, j );
+}
+
+/**
+ * @brief Pushes a solution onto the stack as returned by solve.
+ *
+ *    @param L Lua state to push to.
+ *    @param z Value of the objective function.
+ *    @param val Values of the columns followed by the rows.
+ *    @param ncols Number of columns.
+ *    @param nrows Number of rows.
+ */
+static void linopt_pushSolution( lua_State *L, double z, const double *val, int ncols, int nrows )
+{
+   /* Output function value. */
+   lua_pushnumber(L,z);
+
+   /* Go over variables and store them. */
+   lua_newtable(L); /* t */
+   for (int i=1; i<=ncols; i++) {
+      lua_pushnumber( L, val[i-1] ); /* t, z */
+      lua_rawseti( L, -2, i ); /* t */
+   }
+
+   /* Go over constraints and store them. */
+   lua_newtable(L); /* t */
+   for (int i=1; i<=nrows; i++) {
+      lua_pushnumber( L, val[ncols+i-1] ); /* t, z */
+      lua_rawseti( L, -2, i ); /* t */
+   }
+}
+
 /**
  * @brief Lua bindings to interact with linopts.
  *
@@ -203,6 +415,8 @@ static int linoptL_new( lua_State *L )
 #endif /* DEBUGGING */
 
    /* Initialize and create. */
+   lp.pattern = lp.values = 0;
+   lp.solved = 0;
    lp.prob = glp_create_prob();
    glp_set_prob_name( lp.prob, name );
    glp_add_cols( lp.prob, lp.ncols );
@@ -411,6 +625,7 @@ static int linoptL_loadmatrix( lua_State *L )
 
    /* Set up the matrix. */
    glp_load_matrix( lp->prob, n, ia, ja, ar );
+   linopt_hashMatrix( lp );
 
    /* Clean up. */
    free(ia);
@@ -583,7 +798,13 @@ static int opt_onoff( const char *str, int def )
 /**
  * @brief Solves the linear optimization problem.
  *
+ * By default the simplex is warm started from the basis of the last solved
+ * problem with the same shape, or the last basis of this problem if it was
+ * modified since being solved. Setting "memo" to true also remembers the
+ * solution, and returns it directly if the exact same problem is solved again.
+ *
  *    @luatparam LinOpt lp Linear program to modify.
+ *    @luatparam[opt=nil] table params GLPK parameters as strings, plus the booleans "warm" (default true) and "memo" (default false).
  *    @luatreturn number The value of the primal funcation.
  *    @luatreturn table Table of column values.
  * @luafunc solve
@@ -591,10 +812,13 @@ static int opt_onoff( const char *str, int def )
 static int linoptL_solve( lua_State *L )
 {
    LuaLinOpt_t *lp = luaL_checklinopt(L,1);
-   double z;
-   int ret, ismip;
+   double z, *val;
+   int ret, ismip, warm, memo, tm_lim;
+   uint64_t key = 0;
+   LinOptMemo *m;
    glp_iocp parm_iocp;
    glp_smcp parm_smcp;
+   Uint64 start = SDL_GetPerformanceCounter();
 #if DEBUGGING
    Uint32 starttime = SDL_GetTicks();
 #endif /* DEBUGGING */
@@ -603,15 +827,25 @@ static int linoptL_solve( lua_State *L )
    ismip = (glp_get_num_int( lp->prob ) > 0);
    glp_init_smcp(&parm_smcp);
    parm_smcp.msg_lev = GLP_MSG_ERR;
-   parm_smcp.tm_lim = LINOPT_MAX_TM;
+   /* Replays can't have the result depend on how fast the solver ran. */
+   tm_lim = replay_isDeterministic() ? INT_MAX : LINOPT_MAX_TM;
+   parm_smcp.tm_lim = tm_lim;
    if (ismip) {
       glp_init_iocp(&parm_iocp);
       parm_iocp.msg_lev  = GLP_MSG_ERR;
-      parm_iocp.tm_lim = LINOPT_MAX_TM;
+      parm_iocp.tm_lim = tm_lim;
    }
 
    /* Load parameters. */
+   warm = 1;
+   memo = 0;
    if (!lua_isnoneornil(L,2)) {
+      lua_getfield(L,2,"warm");
+      if (!lua_isnil(L,-1))
+         warm = lua_toboolean(L,-1);
+      lua_getfield(L,2,"memo");
+      memo = lua_toboolean(L,-1);
+      lua_pop(L,2);
       GETOPT_SMCP( meth,    opt_meth,    METH_DEF );
       GETOPT_SMCP( pricing, opt_pricing, PRICING_DEF );
       GETOPT_SMCP( r_test,  opt_r_test,  R_TEST_DEF );
@@ -650,9 +884,39 @@ static int linoptL_solve( lua_State *L )
    }
 #endif
 
+   linopt_nsolves++;
+
+   /* See if the exact same problem was already solved. */
+   if (memo) {
+      key = linopt_hashProblem( lp, &parm_smcp, ismip ? &parm_iocp : NULL );
+      m = &linopt_memo[ key % LINOPT_MEMO_SIZE ];
+      if ((m->val != NULL) && (m->key == key) &&
+            (m->ncols == lp->ncols) && (m->nrows == lp->nrows)) {
+         linopt_nmemo++;
+         linopt_pushSolution( L, m->z, m->val, m->ncols, m->nrows );
+         linopt_time += (double)(SDL_GetPerformanceCounter()-start) / (double)SDL_GetPerformanceFrequency();
+         return 3;
+      }
+   }
+
    /* Optimization. */
    if (!ismip || !parm_iocp.presolve) {
+      /* GLPK starts from the current basis. Use the optimal basis of the last
+       * problem with the same shape, which is usually this same problem
+       * before changing some bounds, otherwise whatever the last solve left. */
+      if (warm && (linopt_loadBasis( lp ) || lp->solved))
+         linopt_nwarm++;
+      else {
+         glp_std_basis( lp->prob );
+         linopt_ncold++;
+      }
       ret = glp_simplex( lp->prob, &parm_smcp );
+      if ((ret == GLP_EBADB) || (ret == GLP_ESING) || (ret == GLP_ECOND)) {
+         /* Reused basis doesn't work with these coefficients. */
+         glp_std_basis( lp->prob );
+         ret = glp_simplex( lp->prob, &parm_smcp );
+      }
+      lp->solved = 1;
       if ((ret != 0) && (ret != GLP_ETMLIM)) {
          lua_pushnil(L);
          lua_pushstring(L, linopt_error(ret));
@@ -665,6 +929,8 @@ static int linoptL_solve( lua_State *L )
          lua_pushstring(L, linopt_status(ret));
          return 2;
       }
+      if (warm)
+         linopt_saveBasis( lp );
    }
    if (ismip) {
       ret = glp_intopt( lp->prob, &parm_iocp );
@@ -681,32 +947,28 @@ static int linoptL_solve( lua_State *L )
          return 2;
       }
    }
+   /* Get the solution. */
    z = glp_get_obj_val( lp->prob );
+   val = malloc( (lp->ncols+lp->nrows) * sizeof(double) );
+   for (int i=1; i<=lp->ncols; i++)
+      val[i-1] = ismip ? glp_mip_col_val( lp->prob, i ) : glp_get_col_prim( lp->prob, i );
+   for (int i=1; i<=lp->nrows; i++)
+      val[lp->ncols+i-1] = ismip ? glp_mip_row_val( lp->prob, i ) : glp_get_row_prim( lp->prob, i );
+   linopt_pushSolution( L, z, val, lp->ncols, lp->nrows );
 
-   /* Output function value. */
-   lua_pushnumber(L,z);
-
-   /* Go over variables and store them. */
-   lua_newtable(L); /* t */
-   for (int i=1; i<=lp->ncols; i++) {
-      if (ismip)
-         z = glp_mip_col_val( lp->prob, i );
-      else
-         z = glp_get_col_prim( lp->prob, i );
-      lua_pushnumber( L, z ); /* t, z */
-      lua_rawseti( L, -2, i ); /* t */
-   }
-
-   /* Go over constraints and store them. */
-   lua_newtable(L); /* t */
-   for (int i=1; i<=lp->nrows; i++) {
-      if (ismip)
-         z = glp_mip_row_val( lp->prob, i );
-      else
-         z = glp_get_row_prim( lp->prob, i );
-      lua_pushnumber( L, z ); /* t, z */
-      lua_rawseti( L, -2, i ); /* t */
+   /* Remember it. */
+   if (memo) {
+      m = &linopt_memo[ key % LINOPT_MEMO_SIZE ];
+      free( m->val );
+      m->key   = key;
+      m->ncols = lp->ncols;
+      m->nrows = lp->nrows;
+      m->z     = z;
+      m->val   = val;
    }
+   else
+      free( val );
+   linopt_time += (double)(SDL_GetPerformanceCounter()-start) / (double)SDL_GetPerformanceFrequency();
 
    /* Complain about time. */
 #if DEBUGGING
@@ -748,6 +1010,8 @@ static int linoptL_readProblem( lua_State *L )
    }
    lp.ncols = glp_get_num_cols( lp.prob );
    lp.nrows = glp_get_num_rows( lp.prob );
+   lp.solved = 0;
+   linopt_hashMatrix( &lp );
    if (maximize)
       glp_set_obj_dir( lp.prob, GLP_MAX );
    lua_pushlinopt( L, lp );
@@ -775,3 +1039,32 @@ static int linoptL_writeProblem( lua_State *L )
    lua_pushboolean( L, ret==0 );
    return 1;
 }
+
+/**
+ * @brief Gets statistics of all the solves done so far.
+ *
+ * @usage st = linopt.stats()
+ *
+ *    @luatparam[opt=false] boolean reset Whether to reset the statistics after getting them.
+ *    @luatreturn table Table with the number of calls to solve ("solves"), those answered by the memo ("memo"), simplex runs started from a previous basis ("warm") or from scratch ("cold"), and the total time spent solving in seconds ("time").
+ * @luafunc stats
+ */
+static int linoptL_stats( lua_State *L )
+{
+   lua_newtable(L);
+   lua_pushinteger(L,linopt_nsolves);
+   lua_setfield(L,-2,"solves");
+   lua_pushinteger(L,linopt_nmemo);
+   lua_setfield(L,-2,"memo");
+   lua_pushinteger(L,linopt_nwarm);
+   lua_setfield(L,-2,"warm");
+   lua_pushinteger(L,linopt_ncold);
+   lua_setfield(L,-2,"cold");
+   lua_pushnumber(L,linopt_time);
+   lua_setfield(L,-2,"time");
+   if (lua_toboolean(L,1)) {
+      linopt_nsolves = linopt_nmemo = linopt_nwarm = linopt_ncold = 0;
+      linopt_time = 0.;
+   }
+   return 1;
+}
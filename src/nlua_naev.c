@@ -28,11 +28,16 @@
 #include "nluadef.h"
 #include "nstring.h"
 #include "pause.h"
+#include "physfsrwops.h"
 #include "player.h"
 #include "plugin.h"
+#include "profile.h"
 #include "semver.h"
 
 static int cache_table = LUA_NOREF; /* No reference. */
+#define PROFILE_LUA_MAX   64 /**< Most zones naev.profile.push() can have open. */
+static int profile_lua_depth[PROFILE_LUA_MAX]; /**< Profiler depth right after each zone opened by naev.profile.push(). */
+static int profile_lua_n = 0; /**< Number of zones opened by naev.profile.push() still open. */
 
 /* Naev methods. */
 static int naevL_version( lua_State *L );
@@ -65,6 +70,15 @@ static int naevL_pause( lua_State *L );
 static int naevL_unpause( lua_State *L );
 static int naevL_hasTextInput( lua_State *L );
 static int naevL_setTextInput( lua_State *L );
+static int naevL_profileStart( lua_State *L );
+static int naevL_profileStop( lua_State *L );
+static int naevL_profileEnabled( lua_State *L );
+static int naevL_profilePush( lua_State *L );
+static int naevL_profilePop( lua_State *L );
+static int naevL_profileZone( lua_State *L );
+static int naevL_profileOverlay( lua_State *L );
+static int naevL_profileExport( lua_State *L );
+static int naevL_profileStats( lua_State *L );
 #if DEBUGGING
 static int naevL_envs( lua_State *L );
 #endif /* DEBUGGING */
@@ -105,6 +119,19 @@ static const luaL_Reg naev_methods[] = {
    {0,0}
 }; /**< Naev Lua methods. */
 
+static const luaL_Reg naev_profile_methods[] = {
+   { "start", naevL_profileStart },
+   { "stop", naevL_profileStop },
+   { "enabled", naevL_profileEnabled },
+   { "push", naevL_profilePush },
+   { "pop", naevL_profilePop },
+   { "zone", naevL_profileZone },
+   { "overlay", naevL_profileOverlay },
+   { "export", naevL_profileExport },
+   { "stats", naevL_profileStats },
+   {0,0}
+}; /**< Naev profiler Lua methods. */
+
 /**
  * @brief Loads the Naev Lua library.
  *
@@ -115,6 +142,18 @@ int nlua_loadNaev( nlua_env env )
 {
    nlua_register(env, "naev", naev_methods, 0);
 
+   /* The profiler goes in naev.profile, the naev table is shared. */
+   nlua_getenv(naevL, env, "naev");    /* naev */
+   lua_getfield(naevL, -1, "profile"); /* naev, profile */
+   if (lua_isnil(naevL, -1)) {
+      lua_pop(naevL, 1);               /* naev */
+      lua_newtable(naevL);             /* naev, profile */
+      luaL_register(naevL, NULL, naev_profile_methods);
+      lua_setfield(naevL, -2, "profile"); /* naev */
+      lua_pushnil(naevL);              /* naev, nil */
+   }
+   lua_pop(naevL, 2);                  /* */
+
    /* Create cache. */
    if (cache_table == LUA_NOREF) {
       lua_newtable( naevL );
@@ -822,3 +861,194 @@ static int naevL_envs( lua_State *L )
    return 1;
 }
 #endif /* DEBUGGING */
+
+/**
+ * @brief Starts recording profiler zones at the end of the frame.
+ *
+ * Zones are recorded from Naev as well as from naev.profile.push() and
+ * naev.profile.zone(), and can be exported with naev.profile.export().
+ *
+ * @usage naev.profile.start()
+ *
+ * @luafunc profile.start
+ */
+static int naevL_profileStart( lua_State *L )
+{
+   (void) L;
+   profile_request( 1 );
+   return 0;
+}
+
+/**
+ * @brief Stops recording profiler zones at the end of the frame.
+ *
+ * @luafunc profile.stop
+ */
+static int naevL_profileStop( lua_State *L )
+{
+   (void) L;
+   profile_request( 0 );
+   return 0;
+}
+
+/**
+ * @brief Checks to see if the profiler is recording.
+ *
+ *    @luatreturn boolean Whether or not profiler zones are being recorded.
+ * @luafunc profile.enabled
+ */
+static int naevL_profileEnabled( lua_State *L )
+{
+   lua_pushboolean( L, profile_enabled );
+   return 1;
+}
+
+/**
+ * @brief Opens a profiler zone, which must be closed with naev.profile.pop()
+ *        before the Lua code returns.
+ *
+ * Zones still open at the end of the frame, such as when an error is raised
+ * between the push and the pop, are closed then.
+ *
+ * @usage naev.profile.push( "spawn" ) ; spawn() ; naev.profile.pop()
+ *
+ *    @luatparam string name Name of the zone.
+ * @luafunc profile.push
+ */
+static int naevL_profilePush( lua_State *L )
+{
+   const char *name = luaL_checkstring( L, 1 );
+   if (!profile_enabled || (profile_lua_n >= PROFILE_LUA_MAX))
+      return 0;
+   if (profile_push( profile_zone( "lua", name ) ))
+      profile_lua_depth[ profile_lua_n++ ] = profile_depth();
+   return 0;
+}
+
+/**
+ * @brief Closes the last profiler zone opened with naev.profile.push().
+ *
+ * @luafunc profile.pop
+ */
+static int naevL_profilePop( lua_State *L )
+{
+   (void) L;
+   if (profile_lua_n <= 0)
+      return 0;
+   /* Only close the zone if it is the innermost one, it may already have
+    * been closed at the end of a frame or be under a zone opened from C. */
+   if (profile_depth() == profile_lua_depth[ --profile_lua_n ])
+      profile_pop();
+   return 0;
+}
+
+/**
+ * @brief Closes the profiler zones opened from Lua that are still open.
+ *
+ * Called at the end of a frame, when any zone deeper than the frame's own is
+ * left over from naev.profile.push().
+ *
+ *    @param depth Profiler depth of the frame.
+ */
+void nlua_profileClose( int depth )
+{
+   while ((profile_lua_n > 0) && (profile_lua_depth[ profile_lua_n-1 ] > depth))
+      profile_lua_n--;
+   profile_popTo( depth );
+}
+
+/**
+ * @brief Runs a function inside a profiler zone.
+ *
+ * @usage local r = naev.profile.zone( "equip", equip_generic, p )
+ *
+ *    @luatparam string name Name of the zone.
+ *    @luatparam function func Function to run.
+ *    @luaparam ... Arguments to pass to the function.
+ *    @return The values returned by the function.
+ * @luafunc profile.zone
+ */
+static int naevL_profileZone( lua_State *L )
+{
+   const char *name = luaL_checkstring( L, 1 );
+   int pushed, ret;
+   luaL_checktype( L, 2, LUA_TFUNCTION );
+
+   pushed = profile_enabled && profile_push( profile_zone( "lua", name ) );
+   ret = lua_pcall( L, lua_gettop(L)-2, LUA_MULTRET, 0 );
+   if (pushed)
+      profile_pop();
+   if (ret != 0)
+      lua_error( L );
+   return lua_gettop(L) - 1;
+}
+
+/**
+ * @brief Shows or hides the profiler overlay with the zones taking the most
+ *        time while recording.
+ *
+ *    @luatparam boolean enable Whether to show the overlay.
+ * @luafunc profile.overlay
+ */
+static int naevL_profileOverlay( lua_State *L )
+{
+   profile_setOverlay( lua_toboolean( L, 1 ) );
+   return 0;
+}
+
+/**
+ * @brief Exports the recorded profiler zones as a Chrome trace that can be
+ *        opened with chrome://tracing or https://ui.perfetto.dev.
+ *
+ * @usage naev.profile.export( "profile.json" )
+ *
+ *    @luatparam string filename File to write to, relative to the save directory.
+ *    @luatreturn boolean Whether or not the trace was written.
+ * @luafunc profile.export
+ */
+static int naevL_profileExport( lua_State *L )
+{
+   const char *filename = luaL_checkstring( L, 1 );
+   SDL_RWops *rw = PHYSFSRWOPS_openWrite( filename );
+   if (rw == NULL) {
+      WARN(_("Unable to open '%s' for writing: %s"), filename, PHYSFS_getErrorByCode( PHYSFS_getLastErrorCode() ) );
+      lua_pushboolean( L, 0 );
+      return 1;
+   }
+   lua_pushboolean( L, profile_export( rw ) == 0 );
+   SDL_RWclose( rw );
+   return 1;
+}
+
+/**
+ * @brief Gets the rolling statistics of the profiler zones run on the main
+ *        thread.
+ *
+ * @usage for k,z in ipairs(naev.profile.stats()) do print( z.name, z.avg ) end
+ *
+ *    @luatreturn table Table of zones, each with the "category" and "name"
+ *                strings, and the "avg" and "peak" times per frame in
+ *                milliseconds and "calls" per frame numbers.
+ * @luafunc profile.stats
+ */
+static int naevL_profileStats( lua_State *L )
+{
+   const char *cat, *name;
+   double avg, peak, calls;
+   lua_newtable( L );
+   for (int i=0; profile_getStats( i, &cat, &name, &avg, &peak, &calls ); i++) {
+      lua_newtable( L );
+      lua_pushstring( L, cat );
+      lua_setfield( L, -2, "category" );
+      lua_pushstring( L, name );
+      lua_setfield( L, -2, "name" );
+      lua_pushnumber( L, avg );
+      lua_setfield( L, -2, "avg" );
+      lua_pushnumber( L, peak );
+      lua_setfield( L, -2, "peak" );
+      lua_pushnumber( L, calls );
+      lua_setfield( L, -2, "calls" );
+      lua_rawseti( L, -2, i+1 );
+   }
+   return 1;
+}
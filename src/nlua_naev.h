@@ -6,3 +6,4 @@
 #include "nlua.h"
 
 int nlua_loadNaev( nlua_env env );
+void nlua_profileClose( int depth );
@@ -30,6 +30,7 @@
 static int outfitL_eq( lua_State *L );
 static int outfitL_get( lua_State *L );
 static int outfitL_getAll( lua_State *L );
+static int outfitL_search( lua_State *L );
 static int outfitL_name( lua_State *L );
 static int outfitL_nameRaw( lua_State *L );
 static int outfitL_type( lua_State *L );
@@ -53,6 +54,7 @@ static const luaL_Reg outfitL_methods[] = {
    { "__eq", outfitL_eq },
    { "get", outfitL_get },
    { "getAll", outfitL_getAll },
+   { "search", outfitL_search },
    { "name", outfitL_name },
    { "nameRaw", outfitL_nameRaw },
    { "type", outfitL_type },
@@ -243,6 +245,32 @@ static int outfitL_getAll( lua_State *L )
    return 1;
 }
 
+/**
+ * @brief Searches the text of all the outfits like the map find dialogue does.
+ *
+ *    @luatparam string str Text to search for, case insensitively.
+ *    @luatparam[opt=false] boolean full Whether to search all the text (type, description, summary, etc.) or only the translated names.
+ *    @luatreturn Table Table containing all the outfits that match.
+ * @luafunc search
+ */
+static int outfitL_search( lua_State *L )
+{
+   const char *str = luaL_checkstring(L,1);
+   int full = lua_toboolean(L,2);
+   const Outfit *outfits = outfit_getAll();
+   char *match = outfit_searchText( str, full );
+   int n = 1;
+   lua_newtable(L); /* t */
+   for (int i=0; i<array_size(outfits); i++) {
+      if (!match[i])
+         continue;
+      lua_pushoutfit( L, (Outfit*) &outfits[i] );
+      lua_rawseti( L, -2, n++ );
+   }
+   free( match );
+   return 1;
+}
+
 /**
  * @brief Gets the translated name of the outfit.
  *
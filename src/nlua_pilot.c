@@ -9,6 +9,10 @@
  * These bindings control the spobs and systems.
  */
 /** @cond */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+
 #include "naev.h"
 /** @endcond */
 
@@ -19,6 +23,7 @@
 #include "camera.h"
 #include "damagetype.h"
 #include "debug.h"
+#include "equippool.h"
 #include "escort.h"
 #include "gui.h"
 #include "land_outfits.h"
@@ -97,6 +102,8 @@ static int pilotL_outfitToggle( lua_State *L );
 static int pilotL_rename( lua_State *L );
 static int pilotL_position( lua_State *L );
 static int pilotL_velocity( lua_State *L );
+static int pilotL_positionXY( lua_State *L );
+static int pilotL_velocityXY( lua_State *L );
 static int pilotL_isStopped( lua_State *L );
 static int pilotL_dir( lua_State *L );
 static int pilotL_evasion( lua_State *L );
@@ -141,6 +148,9 @@ static int pilotL_outfitAddSlot( lua_State *L );
 static int pilotL_outfitRmSlot( lua_State *L );
 static int pilotL_outfitAddIntrinsic( lua_State *L );
 static int pilotL_outfitRmIntrinsic( lua_State *L );
+static int pilotL_equipPoolGet( lua_State *L );
+static int pilotL_equipPoolAdd( lua_State *L );
+static int pilotL_equipPoolStats( lua_State *L );
 static int pilotL_setFuel( lua_State *L );
 static int pilotL_intrinsicReset( lua_State *L );
 static int pilotL_intrinsicSet( lua_State *L );
@@ -252,6 +262,8 @@ static const luaL_Reg pilotL_methods[] = {
    { "rename", pilotL_rename },
    { "pos", pilotL_position },
    { "vel", pilotL_velocity },
+   { "posXY", pilotL_positionXY },
+   { "velXY", pilotL_velocityXY },
    { "isStopped", pilotL_isStopped },
    { "dir", pilotL_dir },
    { "evasion", pilotL_evasion },
@@ -320,6 +332,9 @@ static const luaL_Reg pilotL_methods[] = {
    { "outfitRmSlot", pilotL_outfitRmSlot },
    { "outfitAddIntrinsic", pilotL_outfitAddIntrinsic },
    { "outfitRmIntrinsic", pilotL_outfitRmIntrinsic },
+   { "equipPoolGet", pilotL_equipPoolGet },
+   { "equipPoolAdd", pilotL_equipPoolAdd },
+   { "equipPoolStats", pilotL_equipPoolStats },
    { "setFuel", pilotL_setFuel },
    { "intrinsicReset", pilotL_intrinsicReset },
    { "intrinsicSet", pilotL_intrinsicSet },
@@ -2190,6 +2205,45 @@ static int pilotL_velocity( lua_State *L )
    return 1;
 }
 
+/**
+ * @brief Gets the pilot's position as coordinates.
+ *
+ * Unlike pilot.pos this does not create a new vector, so it is cheaper to use
+ * in scripts that run every frame.
+ *
+ * @usage x, y = p:posXY()
+ *
+ *    @luatparam Pilot p Pilot to get the position of.
+ *    @luatreturn number X coordinate of the pilot's position.
+ *    @luatreturn number Y coordinate of the pilot's position.
+ * @luafunc posXY
+ */
+static int pilotL_positionXY( lua_State *L )
+{
+   Pilot *p = luaL_validpilot(L,1);
+   lua_pushnumber(L, p->solid->pos.x);
+   lua_pushnumber(L, p->solid->pos.y);
+   return 2;
+}
+
+/**
+ * @brief Gets the pilot's velocity as coordinates.
+ *
+ * @usage vx, vy = p:velXY()
+ *
+ *    @luatparam Pilot p Pilot to get the velocity of.
+ *    @luatreturn number X coordinate of the pilot's velocity.
+ *    @luatreturn number Y coordinate of the pilot's velocity.
+ * @luafunc velXY
+ */
+static int pilotL_velocityXY( lua_State *L )
+{
+   Pilot *p = luaL_validpilot(L,1);
+   lua_pushnumber(L, p->solid->vel.x);
+   lua_pushnumber(L, p->solid->vel.y);
+   return 2;
+}
+
 /**
  * @brief Checks to see if a pilot is stopped.
  *
@@ -3246,6 +3300,187 @@ static int pilotL_outfitRmIntrinsic( lua_State *L )
    return 1;
 }
 
+/**
+ * @brief Mixes the bits of a hash.
+ */
+static uint64_t pilotL_hashMix( uint64_t h )
+{
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+   h *= 0xc4ceb9fe1a85ec53ULL;
+   h ^= h >> 33;
+   return h;
+}
+
+/**
+ * @brief Hashes a Lua value by its contents for the loadout pool key.
+ *
+ * Tables are hashed by contents independently of the traversal order and game
+ * objects by what they refer to. Anything else, like functions, other
+ * userdata or tables nested too deep, would only hash by address, so a later
+ * call could never get the same key.
+ *
+ *    @param L Lua state.
+ *    @param ind Index of the value.
+ *    @param depth How deep into nested tables to go.
+ *    @param[out] h Hash of the value.
+ *    @return 0 on success, -1 if the value can't be hashed by contents.
+ */
+static int pilotL_equipPoolHash( lua_State *L, int ind, int depth, uint64_t *h )
+{
+   double d;
+   size_t len;
+   const char *str;
+
+   switch (lua_type(L,ind)) {
+      case LUA_TNIL:
+         *h = 0;
+         return 0;
+      case LUA_TBOOLEAN:
+         *h = pilotL_hashMix( 1 + lua_toboolean(L,ind) );
+         return 0;
+      case LUA_TNUMBER:
+         d = lua_tonumber(L,ind);
+         memcpy( h, &d, sizeof(*h) );
+         *h = pilotL_hashMix( *h ^ 0x6e756d );
+         return 0;
+      case LUA_TSTRING:
+         str = lua_tolstring(L,ind,&len);
+         *h = 14695981039346656037ULL;
+         for (size_t i=0; i<len; i++) {
+            *h ^= (unsigned char)str[i];
+            *h *= 1099511628211ULL;
+         }
+         return 0;
+      case LUA_TTABLE:
+         if (depth <= 0)
+            return -1;
+         if (ind < 0)
+            ind = lua_gettop(L) + ind + 1;
+         *h = 0x7461626c65;
+         lua_pushnil(L);
+         while (lua_next(L,ind) != 0) {
+            uint64_t hk, hv;
+            if (pilotL_equipPoolHash( L, -2, depth-1, &hk ) ||
+                  pilotL_equipPoolHash( L, -1, depth-1, &hv )) {
+               lua_pop(L,2);
+               return -1;
+            }
+            *h += pilotL_hashMix( hk * 31 + hv );
+            lua_pop(L,1);
+         }
+         *h = pilotL_hashMix( *h );
+         return 0;
+      case LUA_TUSERDATA:
+         if (lua_isoutfit(L,ind))
+            *h = (uint64_t)(uintptr_t)lua_tooutfit(L,ind) ^ 0x6f7574;
+         else if (lua_isship(L,ind))
+            *h = (uint64_t)(uintptr_t)lua_toship(L,ind) ^ 0x736869;
+         else if (lua_iscommodity(L,ind))
+            *h = (uint64_t)(uintptr_t)lua_tocommodity(L,ind) ^ 0x636f6d;
+         else if (lua_isfaction(L,ind))
+            *h = (uint64_t)lua_tofaction(L,ind) ^ 0x666163;
+         else if (lua_isspob(L,ind))
+            *h = (uint64_t)lua_tospob(L,ind) ^ 0x73706f;
+         else if (lua_issystem(L,ind))
+            *h = (uint64_t)lua_tosystem(L,ind) ^ 0x737973;
+         else
+            return -1;
+         *h = pilotL_hashMix( *h );
+         return 0;
+      default:
+         return -1;
+   }
+}
+
+/**
+ * @brief Tries to equip a pilot with a loadout from the engine's loadout pool.
+ *
+ * Pools are keyed by the pilot's ship, the nebula volatility of the current
+ * system and all the extra arguments, which should identify the equipment
+ * script and its parameters. Once enough loadouts have been solved for a key
+ * (set by the equip_pool option), pilots get a random one of them. Arguments
+ * that can't be hashed by contents, like functions, disable pooling.
+ *
+ * @usage data, key = p:equipPoolGet( "empire", opt_params )
+ *
+ *    @luatparam Pilot p Pilot to equip.
+ *    @luaparam ... Values identifying the equipment script and its parameters.
+ *    @luareturn The data stored with the loadout if the pilot got equipped, or nil if it has to be solved.
+ *    @luatreturn string|nil Key of the pool to pass to equipPoolAdd, or nil if the pilot can't be pooled.
+ * @luafunc equipPoolGet
+ * @see equipPoolAdd
+ */
+static int pilotL_equipPoolGet( lua_State *L )
+{
+   char buf[32];
+   int data;
+   Pilot *p = luaL_validpilot(L,1);
+   uint64_t key = pilotL_hashMix( (uint64_t)(uintptr_t)p->ship );
+   key ^= pilotL_hashMix( (uint64_t)(cur_system->nebu_volatility * 1000.) + 1 );
+   for (int i=2; i<=lua_gettop(L); i++) {
+      uint64_t h;
+      if (pilotL_equipPoolHash( L, i, 4, &h )) {
+         lua_pushnil(L);
+         lua_pushnil(L);
+         return 2;
+      }
+      key = pilotL_hashMix( key * 31 + h );
+   }
+
+   if (equippool_get( p, key, &data ))
+      lua_rawgeti( L, LUA_REGISTRYINDEX, data );
+   else
+      lua_pushnil(L);
+   snprintf( buf, sizeof(buf), "%016"PRIx64, key );
+   lua_pushstring(L,buf);
+   return 2;
+}
+
+/**
+ * @brief Adds the loadout a pilot was just equipped with to the engine's loadout pool.
+ *
+ *    @luatparam Pilot p Pilot that was equipped.
+ *    @luatparam string key Key of the pool as returned by equipPoolGet.
+ *    @luaparam data Data to return from equipPoolGet when the loadout is reused.
+ *    @luatparam[opt=0] number solvetime Time it took to solve the loadout in seconds.
+ * @luafunc equipPoolAdd
+ * @see equipPoolGet
+ */
+static int pilotL_equipPoolAdd( lua_State *L )
+{
+   const Pilot *p = luaL_validpilot(L,1);
+   uint64_t key = strtoull( luaL_checkstring(L,2), NULL, 16 );
+   double solvetime = luaL_optnumber(L,4,0.);
+   int data;
+   lua_pushvalue(L,3);
+   data = luaL_ref( L, LUA_REGISTRYINDEX );
+   equippool_add( p, key, data, solvetime );
+   return 0;
+}
+
+/**
+ * @brief Gets the statistics of the engine's loadout pool.
+ *
+ * @usage hits, misses, saved = pilot.equipPoolStats()
+ *
+ *    @luatreturn number Number of pilots equipped from the pool.
+ *    @luatreturn number Number of pilots whose loadout had to be solved.
+ *    @luatreturn number Estimated solving time saved in seconds.
+ * @luafunc equipPoolStats
+ */
+static int pilotL_equipPoolStats( lua_State *L )
+{
+   int hits, misses;
+   double saved;
+   equippool_stats( &hits, &misses, &saved );
+   lua_pushinteger(L,hits);
+   lua_pushinteger(L,misses);
+   lua_pushnumber(L,saved);
+   return 3;
+}
+
 /**
  * @brief Sets the fuel of a pilot.
  *
@@ -3383,7 +3618,7 @@ static int pilotL_effectAdd( lua_State *L )
    const EffectData *efx = effect_get( effectname );
    if (efx != NULL) {
       if (!effect_add( &p->effects, efx, duration, scale, p->id ))
-         pilot_calcStats( p );
+         pilot_calcStatsLayers( p, PILOT_STATS_EFFECTS );
       lua_pushboolean(L,1);
    }
    else
@@ -3407,7 +3642,7 @@ static int pilotL_effectRm( lua_State *L )
    const EffectData *efx = effect_get( effectname );
    if (efx != NULL) {
       if (effect_rm( &p->effects, efx, all ))
-         pilot_calcStats( p );
+         pilot_calcStatsLayers( p, PILOT_STATS_EFFECTS );
    }
    return 0;
 }
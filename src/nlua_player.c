@@ -2043,11 +2043,13 @@ static int playerL_canDiscover( lua_State *L )
  *
  *    @luatparam[opt="autosave"] string name What to name the save.
  *    @luatparam[opt=nil] Spob|string Spob or name of spob to save the player at.
+ *    @luatparam[opt=false] boolean sync Whether to wait for the save to be written to disk instead of doing it in the background.
  * @luafunc save
  */
 static int playerL_save( lua_State *L )
 {
    const char *savename = luaL_optstring( L, 1, "autosave" );
+   int sync = lua_toboolean( L, 3 );
    Spob *savespob = NULL;
    Spob *prevspob;
    if (!lua_isnoneornil(L,2))
@@ -2062,7 +2064,10 @@ static int playerL_save( lua_State *L )
       prevspob = land_spob;
       land_spob = savespob;
    }
-   lua_pushboolean( L, save_all_with_name( savename ) );
+   if (sync)
+      lua_pushboolean( L, save_all_with_name_sync( savename ) );
+   else
+      lua_pushboolean( L, save_all_with_name( savename ) );
    if (savespob != NULL)
       land_spob = prevspob;
 
@@ -2084,6 +2089,11 @@ static int playerL_saveBackup( lua_State *L )
       NLUA_ERROR(L,_("Can not back up save to 'autosave'."));
    snprintf( file, sizeof(file), "saves/%s/autosave.ns", player.name );
    snprintf( backup, sizeof(backup), "saves/%s/%s.ns", player.name, filename );
+   /* Don't back up an old autosave if writing the new one failed. */
+   if (save_sync() < 0) {
+      lua_pushboolean( L, 0 );
+      return 1;
+   }
    lua_pushboolean( L, ndata_copyIfExists(file, backup) );
    return 1;
 }
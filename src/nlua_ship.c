@@ -31,6 +31,7 @@ static const ShipOutfitSlot* ship_outfitSlotFromID( const Ship *s, int id );
 static int shipL_eq( lua_State *L );
 static int shipL_get( lua_State *L );
 static int shipL_getAll( lua_State *L );
+static int shipL_search( lua_State *L );
 static int shipL_name( lua_State *L );
 static int shipL_nameRaw( lua_State *L );
 static int shipL_baseType( lua_State *L );
@@ -56,6 +57,7 @@ static const luaL_Reg shipL_methods[] = {
    { "__eq", shipL_eq },
    { "get", shipL_get },
    { "getAll", shipL_getAll },
+   { "search", shipL_search },
    { "name", shipL_name },
    { "nameRaw", shipL_nameRaw },
    { "baseType", shipL_baseType },
@@ -248,6 +250,30 @@ static int shipL_getAll( lua_State *L )
    return 1;
 }
 
+/**
+ * @brief Searches the text of all the ships like the map find dialogue does.
+ *
+ *    @luatparam string str Text to search for, case insensitively.
+ *    @luatreturn table A table containing all the ships that match.
+ * @luafunc search
+ */
+static int shipL_search( lua_State *L )
+{
+   const char *str = luaL_checkstring(L,1);
+   const Ship *ships = ship_getAll();
+   char *match = ship_searchText( str );
+   int n = 1;
+   lua_newtable(L); /* t */
+   for (int i=0; i<array_size(ships); i++) {
+      if (!match[i])
+         continue;
+      lua_pushship( L, &ships[i] );
+      lua_rawseti( L, -2, n++ );
+   }
+   free( match );
+   return 1;
+}
+
 /**
  * @brief Gets the translated name of the ship.
  *
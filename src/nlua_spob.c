@@ -914,6 +914,7 @@ static int spobL_setKnown( lua_State *L )
       spob_rmFlag( p, SPOB_KNOWN );
 
    if (changed) {
+      space_knownChanged();
       ovr_refresh();
       /* Update outfits image array. */
       outfits_updateEquipmentOutfits();
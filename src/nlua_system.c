@@ -52,6 +52,8 @@ static int systemL_addGatherable( lua_State *L );
 static int systemL_presences( lua_State *L );
 static int systemL_spobs( lua_State *L );
 static int systemL_presence( lua_State *L );
+static int systemL_presenceRebuild( lua_State *L );
+static int systemL_presenceStats( lua_State *L );
 static int systemL_radius( lua_State *L );
 static int systemL_isknown( lua_State *L );
 static int systemL_setknown( lua_State *L );
@@ -83,6 +85,8 @@ static const luaL_Reg system_methods[] = {
    { "presences", systemL_presences },
    { "spobs", systemL_spobs },
    { "presence", systemL_presence },
+   { "presenceRebuild", systemL_presenceRebuild },
+   { "presenceStats", systemL_presenceStats },
    { "radius", systemL_radius },
    { "known", systemL_isknown },
    { "setKnown", systemL_setknown },
@@ -829,6 +833,48 @@ static int systemL_presence( lua_State *L )
    return 1;
 }
 
+/**
+ * @brief Rebuilds the presence of all the systems from scratch.
+ *
+ * Presence is normally kept up to date incrementally when spobs change, this
+ * is mainly useful for testing and benchmarking.
+ *
+ * @usage system.presenceRebuild()
+ *
+ * @luafunc presenceRebuild
+ */
+static int systemL_presenceRebuild( lua_State *L )
+{
+   (void) L;
+   space_reconstructPresences();
+   return 0;
+}
+
+/**
+ * @brief Gets statistics of the presence rebuilds done so far.
+ *
+ * @usage st = system.presenceStats()
+ *
+ *    @luatreturn table Table with the number of full rebuilds ("full"), incremental rebuilds ("incremental"), systems rebuilt incrementally ("systems"), and the total time spent rebuilding in seconds ("time").
+ * @luafunc presenceStats
+ */
+static int systemL_presenceStats( lua_State *L )
+{
+   int full, incremental, systems;
+   double time;
+   space_presenceStats( &full, &incremental, &systems, &time );
+   lua_newtable(L);
+   lua_pushinteger(L,full);
+   lua_setfield(L,-2,"full");
+   lua_pushinteger(L,incremental);
+   lua_setfield(L,-2,"incremental");
+   lua_pushinteger(L,systems);
+   lua_setfield(L,-2,"systems");
+   lua_pushnumber(L,time);
+   lua_setfield(L,-2,"time");
+   return 1;
+}
+
 /**
  * @brief Gets the radius of the system.
  *
@@ -902,6 +948,7 @@ static int systemL_setknown( lua_State *L )
             jp_rmFlag( &sys->jumps[i], JP_KNOWN );
      }
    }
+   space_knownChanged();
 
    /* Update outfits image array. */
    outfits_updateEquipmentOutfits();
@@ -24,12 +24,16 @@ static int vectorL_new( lua_State *L );
 static int vectorL_newP( lua_State *L );
 static int vectorL_tostring( lua_State *L );
 static int vectorL_add__( lua_State *L );
+static int vectorL_addi( lua_State *L );
 static int vectorL_add( lua_State *L );
 static int vectorL_sub__( lua_State *L );
+static int vectorL_subi( lua_State *L );
 static int vectorL_sub( lua_State *L );
 static int vectorL_mul__( lua_State *L );
+static int vectorL_muli( lua_State *L );
 static int vectorL_mul( lua_State *L );
 static int vectorL_div__( lua_State *L );
+static int vectorL_divi( lua_State *L );
 static int vectorL_div( lua_State *L );
 static int vectorL_dot( lua_State *L );
 static int vectorL_get( lua_State *L );
@@ -47,12 +51,16 @@ static const luaL_Reg vector_methods[] = {
    { "__tostring", vectorL_tostring },
    { "__add", vectorL_add },
    { "add", vectorL_add__ },
+   { "addi", vectorL_addi },
    { "__sub", vectorL_sub },
    { "sub", vectorL_sub__ },
+   { "subi", vectorL_subi },
    { "__mul", vectorL_mul },
    { "mul", vectorL_mul__ },
+   { "muli", vectorL_muli },
    { "__div", vectorL_div },
    { "div", vectorL_div__ },
+   { "divi", vectorL_divi },
    { "dot", vectorL_dot },
    { "get", vectorL_get },
    { "polar", vectorL_polar },
@@ -315,6 +323,49 @@ static int vectorL_add__( lua_State *L )
    return 1;
 }
 
+/**
+ * @brief Adds a vector or some cartesian coordinates to a vector in place.
+ *
+ * Unlike add, this returns the vector itself instead of a copy, so it does
+ * not create a new vector.
+ *
+ * @usage my_vec:addi( your_vec )
+ * @usage my_vec:addi( 5, 3 ):muli( 2 )
+ *
+ *    @luatparam Vec2 v Vector to add to.
+ *    @luatparam number|Vec2 x X coordinate or vector to add.
+ *    @luatparam number|nil y Y coordinate or nil to add.
+ *    @luatreturn Vec2 The same vector.
+ * @luafunc addi
+ */
+static int vectorL_addi( lua_State *L )
+{
+   vec2 *v1;
+   double x, y;
+
+   /* Get self. */
+   v1    = luaL_checkvector(L,1);
+
+   /* Get rest of parameters. */
+   if (lua_isvector(L,2)) {
+      vec2 *v2 = lua_tovector(L,2);
+      x = v2->x;
+      y = v2->y;
+   }
+   else if ((lua_gettop(L) > 2) && lua_isnumber(L,2) && lua_isnumber(L,3)) {
+      x = lua_tonumber(L,2);
+      y = lua_tonumber(L,3);
+   }
+   else {
+      NLUA_INVALID_PARAMETER(L);
+      return 0;
+   }
+
+   vec2_cset( v1, v1->x + x, v1->y + y );
+   lua_pushvalue( L, 1 );
+   return 1;
+}
+
 /**
  * @brief Subtracts two vectors or a vector and some cartesian coordinates.
  *
@@ -388,6 +439,48 @@ static int vectorL_sub__( lua_State *L )
    return 1;
 }
 
+/**
+ * @brief Subtracts a vector or some cartesian coordinates from a vector in
+ *        place.
+ *
+ * Unlike sub, this returns the vector itself instead of a copy.
+ *
+ * @usage my_vec:subi( your_vec )
+ *
+ *    @luatparam Vec2 v Vector to subtract from.
+ *    @luatparam number|Vec2 x X coordinate or vector to subtract.
+ *    @luatparam number|nil y Y coordinate or nil to subtract.
+ *    @luatreturn Vec2 The same vector.
+ * @luafunc subi
+ */
+static int vectorL_subi( lua_State *L )
+{
+   vec2 *v1;
+   double x, y;
+
+   /* Get self. */
+   v1    = luaL_checkvector(L,1);
+
+   /* Get rest of parameters. */
+   if (lua_isvector(L,2)) {
+      vec2 *v2 = lua_tovector(L,2);
+      x = v2->x;
+      y = v2->y;
+   }
+   else if ((lua_gettop(L) > 2) && lua_isnumber(L,2) && lua_isnumber(L,3)) {
+      x = lua_tonumber(L,2);
+      y = lua_tonumber(L,3);
+   }
+   else {
+      NLUA_INVALID_PARAMETER(L);
+      return 0;
+   }
+
+   vec2_cset( v1, v1->x - x, v1->y - y );
+   lua_pushvalue( L, 1 );
+   return 1;
+}
+
 /**
  * @brief Multiplies a vector by a number.
  *
@@ -440,6 +533,27 @@ static int vectorL_mul__( lua_State *L )
    return 1;
 }
 
+/**
+ * @brief Multiplies a vector by a number in place.
+ *
+ * Unlike mul, this returns the vector itself instead of a copy.
+ *
+ * @usage my_vec:muli( 3 )
+ *
+ *    @luatparam Vec2 v Vector to multiply.
+ *    @luatparam number mod Amount to multiply by.
+ *    @luatreturn Vec2 The same vector.
+ * @luafunc muli
+ */
+static int vectorL_muli( lua_State *L )
+{
+   vec2 *v1    = luaL_checkvector(L,1);
+   double mod  = luaL_checknumber(L,2);
+   vec2_cset( v1, v1->x * mod, v1->y * mod );
+   lua_pushvalue( L, 1 );
+   return 1;
+}
+
 /**
  * @brief Divides a vector by a number.
  *
@@ -480,6 +594,27 @@ static int vectorL_div__( lua_State *L )
    return 1;
 }
 
+/**
+ * @brief Divides a vector by a number in place.
+ *
+ * Unlike div, this returns the vector itself instead of a copy.
+ *
+ * @usage my_vec:divi( 3 )
+ *
+ *    @luatparam Vec2 v Vector to divide.
+ *    @luatparam number mod Amount to divide by.
+ *    @luatreturn Vec2 The same vector.
+ * @luafunc divi
+ */
+static int vectorL_divi( lua_State *L )
+{
+   vec2 *v1    = luaL_checkvector(L,1);
+   double mod  = luaL_checknumber(L,2);
+   vec2_cset( v1, v1->x / mod, v1->y / mod );
+   lua_pushvalue( L, 1 );
+   return 1;
+}
+
 /**
  * @brief Dot product of two vectors.
  *
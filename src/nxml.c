@@ -12,6 +12,7 @@
 
 #include "nxml.h"
 
+#include "datapack.h"
 #include "ndata.h"
 #include "nstring.h"
 
@@ -77,6 +78,12 @@ xmlDocPtr xml_parsePhysFS( const char* filename )
    char *buf;
    size_t bufsize;
    xmlDocPtr doc;
+   int packed;
+
+   /* Get the already parsed document from the data pack if the file is in it. */
+   doc = datapack_parse( filename, &packed );
+   if (packed)
+      return doc;
 
    /* @TODO: Don't slurp?
     * Can we directly create an InputStream backed by PHYSFS_*, or use SAX? */
@@ -25,6 +25,7 @@
 #include "damagetype.h"
 #include "log.h"
 #include "mapData.h"
+#include "nameidx.h"
 #include "ndata.h"
 #include "nfile.h"
 #include "nlua.h"
@@ -41,6 +42,7 @@
 #include "ship.h"
 #include "slots.h"
 #include "spfx.h"
+#include "textindex.h"
 #include "unistd.h"
 
 #define outfit_setProp(o,p)      ((o)->properties |= p) /**< Checks outfit property. */
@@ -53,8 +55,17 @@
  * the stack
  */
 static Outfit* outfit_stack = NULL; /**< Stack of outfits. */
+static NameIdx outfit_nidx = NAMEIDX_INIT( Outfit, name ); /**< Index of the outfits by name. */
 static char **license_stack = NULL; /**< Stack of available licenses. */
 
+/*
+ * Search indices.
+ */
+static TextIndex *outfit_tidx       = NULL; /**< Index of all the searchable outfit text. */
+static TextIndex *outfit_tidx_name  = NULL; /**< Index of the translated outfit names. */
+static char *outfit_tidx_lang       = NULL; /**< Language the indices were built for. */
+static int outfit_tidx_lua          = 0; /**< Whether the Lua generated descriptions are indexed. */
+
 /*
  * Helper stuff for setting up short descriptions for outfits.
  */
@@ -84,6 +95,7 @@ if (fabs(val) > 1e-5) { \
  */
 /* misc */
 static OutfitType outfit_strToOutfitType( char *buf );
+static void outfit_searchIndex (void);
 /* parsing */
 static int outfit_loadDir( char *dir );
 static int outfit_parseDamage( Damage *dmg, xmlNodePtr node );
@@ -131,8 +143,8 @@ const Outfit* outfit_get( const char* name )
  */
 const Outfit* outfit_getW( const char* name )
 {
-   const Outfit s = {.name = (char*)name };
-   return bsearch( &s, outfit_stack, array_size(outfit_stack), sizeof(Outfit), outfit_cmp );
+   int i = nameidx_get( &outfit_nidx, outfit_stack, array_size(outfit_stack), name );
+   return (i < 0) ? NULL : &outfit_stack[i];
 }
 
 /**
@@ -148,10 +160,75 @@ const Outfit* outfit_getAll (void)
  */
 const char *outfit_existsCase( const char* name )
 {
-   for (int i=0; i<array_size(outfit_stack); i++)
-      if (strcasecmp(name,outfit_stack[i].name)==0)
-         return outfit_stack[i].name;
-   return NULL;
+   int i = nameidx_getCase( &outfit_nidx, outfit_stack, array_size(outfit_stack), name );
+   return (i < 0) ? NULL : outfit_stack[i].name;
+}
+
+/**
+ * @brief Builds the search indices for the current language.
+ *
+ * Only static text gets indexed here, text generated by Lua is added the first
+ * time it is needed.
+ */
+static void outfit_searchIndex (void)
+{
+   int n = array_size(outfit_stack);
+   const char *lang = gettext_getLanguage();
+
+   /* Still up to date. */
+   if ((outfit_tidx_lang != NULL) && (strcmp( lang, outfit_tidx_lang ) == 0))
+      return;
+
+   textindex_free( outfit_tidx );
+   textindex_free( outfit_tidx_name );
+   free( outfit_tidx_lang );
+   outfit_tidx       = textindex_create( n );
+   outfit_tidx_name  = textindex_create( n );
+   outfit_tidx_lang  = strdup( lang );
+   outfit_tidx_lua   = 0;
+
+   for (int i=0; i<n; i++) {
+      const Outfit *o = &outfit_stack[i];
+      textindex_add( outfit_tidx_name, i, _(o->name) );
+      textindex_add( outfit_tidx, i, _(o->name) );
+      textindex_add( outfit_tidx, i, o->typename );
+      textindex_add( outfit_tidx, i, o->condstr );
+      textindex_add( outfit_tidx, i, _(o->desc_raw) );
+      textindex_add( outfit_tidx, i, o->desc_extra );
+      textindex_add( outfit_tidx, i, o->summary_raw );
+   }
+}
+
+/**
+ * @brief Searches the text of all the outfits.
+ *
+ * Matches the same outfits as running strcasestr on the translated name or, if
+ * full is set, also on the type name, condition, description and summary.
+ *
+ *    @param needle String to look for, case insensitively.
+ *    @param full Whether to search all the text or only the names.
+ *    @return Newly allocated array of flags indexed like outfit_getAll(), set for the outfits that match.
+ */
+char *outfit_searchText( const char *needle, int full )
+{
+   char *match = malloc( MAX( 1, array_size(outfit_stack) ) );
+
+   outfit_searchIndex();
+   if (!full) {
+      textindex_search( outfit_tidx_name, needle, match );
+      return match;
+   }
+
+   /* Descriptions generated by Lua need the outfits to be fully loaded, so
+    * add them when first needed. */
+   if (!outfit_tidx_lua) {
+      for (int i=0; i<array_size(outfit_stack); i++)
+         if (outfit_stack[i].lua_descextra != LUA_NOREF)
+            textindex_add( outfit_tidx, i, outfit_description( &outfit_stack[i] ) );
+      outfit_tidx_lua = 1;
+   }
+   textindex_search( outfit_tidx, needle, match );
+   return match;
 }
 
 /**
@@ -160,21 +237,24 @@ const char *outfit_existsCase( const char* name )
 char **outfit_searchFuzzyCase( const char* name, int *n )
 {
    int len, nstack;
-   char **names;
+   char **names, *match;
 
    /* Overallocate to maximum. */
    nstack = array_size(outfit_stack);
    names = malloc( sizeof(char*) * nstack );
 
    /* Do fuzzy search. */
+   match = outfit_searchText( name, 0 );
    len = 0;
    for (int i=0; i<nstack; i++) {
-      if (strcasestr( _(outfit_stack[i].name), name ) != NULL) {
+      if (match[i]) {
          names[len] = outfit_stack[i].name;
          len++;
       }
    }
 
+   free(match);
+
    /* Free if empty. */
    if (len == 0) {
       free(names);
@@ -1139,7 +1219,7 @@ static int outfit_loadPLG( Outfit *temp, const char *buf, unsigned int bolt )
    asprintf( &file, "%s%s.xml", OUTFIT_POLYGON_PATH, buf );
 
    /* See if the file does exist. */
-   if (!PHYSFS_exists(file)) {
+   if (!ndata_exists(file)) {
       WARN(_("%s xml collision polygon does not exist!\n \
                Please use the script 'polygon_from_sprite.py' \
 that can be found in Naev's artwork repo."), file);
@@ -1991,6 +2071,8 @@ static void outfit_parseSMap( Outfit *temp, const xmlNodePtr parent )
    temp->u.map->systems = array_create(StarSystem*);
    temp->u.map->spobs  = array_create(Spob*);
    temp->u.map->jumps   = array_create(JumpPoint*);
+   temp->u.map->unknown = -1;
+   temp->u.map->known_gen = 0;
 
    do {
       xml_onlyNodes(node);
@@ -2500,6 +2582,7 @@ int outfit_load (void)
    noutfits = array_size(outfit_stack);
    /* Sort up licenses. */
    qsort( outfit_stack, noutfits, sizeof(Outfit), outfit_cmp );
+   nameidx_invalidate( &outfit_nidx );
    if (license_stack != NULL)
       qsort( license_stack, array_size(license_stack), sizeof(char*), strsort );
 
@@ -2644,6 +2727,9 @@ int outfit_loadPost (void)
          WARN(_("Outfit '%s' has inexistent license requirement '%s'!"), o->name, o->license);
    }
 
+   /* Index the static text for searching. */
+   outfit_searchIndex();
+
    return 0;
 }
 
@@ -2727,6 +2813,9 @@ int outfit_licenseExists( const char *name )
  */
 void outfit_free (void)
 {
+   /* Cached descriptions point to the outfits. */
+   pilot_outfitLDescExtraClear();
+
    for (int i=0; i < array_size(outfit_stack); i++) {
       Outfit *o = &outfit_stack[i];
 
@@ -2802,4 +2891,13 @@ void outfit_free (void)
 
    array_free(outfit_stack);
    array_free(license_stack);
+   nameidx_free( &outfit_nidx );
+
+   /* Free search indices. */
+   textindex_free( outfit_tidx );
+   textindex_free( outfit_tidx_name );
+   free( outfit_tidx_lang );
+   outfit_tidx       = NULL;
+   outfit_tidx_name  = NULL;
+   outfit_tidx_lang  = NULL;
 }
@@ -416,6 +416,7 @@ const char* outfit_summary( const Outfit *o );
  */
 const char *outfit_existsCase( const char* name );
 char **outfit_searchFuzzyCase( const char* name, int *n );
+char *outfit_searchText( const char *needle, int full );
 
 /*
  * Filter.
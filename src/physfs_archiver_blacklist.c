@@ -13,11 +13,11 @@
 #include <pcre2.h>
 #include "physfs.h"
 
+#include "physfs_archiver_blacklist.h"
+
 #include "array.h"
 #include "log.h"
 
-#define BLACKLIST_FILENAME    "naev.BLACKLIST"
-
 /**
  * @brief Represents a file in a directory. Used to enumerate files.
  */
@@ -3,6 +3,8 @@
  */
 #pragma once
 
+#define BLACKLIST_FILENAME    "naev.BLACKLIST" /**< Name the blacklist is mounted as. */
+
 int blacklist_append( const char *path );
 int blacklist_init (void);
 void blacklist_exit (void);
@@ -954,7 +954,7 @@ void pilot_cooldown( Pilot *p, int dochecks )
 
    /* Disable active outfits. */
    if (pilot_outfitOffAll( p ) > 0)
-      pilot_calcStats( p );
+      pilot_calcStatsLayers( p, PILOT_STATS_ACTIVE );
 
    /* Calculate the ship's overall heat. */
    heat_capacity = p->heat_C;
@@ -1663,7 +1663,7 @@ void pilot_updateDisable( Pilot* p, unsigned int shooter )
 
       /* Disable active outfits. */
       if (pilot_outfitOffAll( p ) > 0)
-         pilot_calcStats( p );
+         pilot_calcStatsLayers( p, PILOT_STATS_ACTIVE );
 
       pilot_setFlag( p,PILOT_DISABLED ); /* set as disabled */
       /* Run hook */
@@ -2388,7 +2388,7 @@ void pilot_update( Pilot* pilot, double dt )
 
    /* Must recalculate stats because something changed state. */
    if (nchg > 0)
-      pilot_calcStats( pilot );
+      pilot_calcStatsLayers( pilot, PILOT_STATS_ACTIVE | PILOT_STATS_EFFECTS );
 
    /* purpose fallthrough to get the movement like disabled */
    if (pilot_isDisabled(pilot) || pilot_isFlag(pilot, PILOT_COOLDOWN)) {
@@ -3650,6 +3650,7 @@ void pilots_update( double dt )
    }
 
    /* Have all the pilots think. */
+   ai_frameStart();
    for (int i=0; i<array_size(pilot_stack); i++) {
       Pilot *p = pilot_stack[i];
 
@@ -3758,6 +3759,8 @@ void pilot_clearTimers( Pilot *pilot )
 
    pilot->ptimer     = 0.; /* Pilot timer. */
    pilot->tcontrol   = 0.; /* AI control timer. */
+   pilot->tcontrol_len = 0.; /* AI control tick length. */
+   pilot->stats_dirty = PILOT_STATS_ALL; /* No stat layers computed yet. */
    pilot->stimer     = 0.; /* Shield timer. */
    pilot->dtimer     = 0.; /* Disable timer. */
    pilot->otimer     = 0.; /* Outfit timer. */
@@ -3776,7 +3779,7 @@ void pilot_clearTimers( Pilot *pilot )
 
    /* Must recalculate stats. */
    if (n > 0)
-      pilot_calcStats( pilot );
+      pilot_calcStatsLayers( pilot, PILOT_STATS_ACTIVE );
 }
 
 /**
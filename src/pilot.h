@@ -282,6 +282,13 @@ typedef struct Pilot_ {
    /* Ship statistics. */
    ShipStats intrinsic_stats; /**< Intrinsic statistics to the ship create on the fly. */
    ShipStats stats;  /**< Pilot's copy of ship statistics, used for comparisons.. */
+   ShipStats stats_ship; /**< Cached ship base layer of the stats. */
+   ShipStats stats_passive; /**< Cached passive outfit layer of the stats. */
+   ShipStats stats_active; /**< Cached active outfit layer of the stats. */
+   ShipStats stats_effects; /**< Cached effect layer of the stats. */
+   unsigned int stats_dirty; /**< Stat layers that have to be recomputed. */
+   unsigned int stats_fingerprint; /**< Hash of the stats, changes when they do. */
+   unsigned int outfit_gen; /**< Bumped whenever an outfit or intrinsic outfit is added or removed. */
 
    /* Ship effects. */
    Effect *effects; /**< Pilot's current activated effects. */
@@ -340,6 +347,7 @@ typedef struct Pilot_ {
    AI_Profile* ai;   /**< AI personality profile */
    int lua_mem;      /**< AI memory. */
    double tcontrol;  /**< timer for control tick */
+   double tcontrol_len; /**< Length of the current control tick. */
    double timer[MAX_AI_TIMERS]; /**< Timers for AI */
    Task* task;       /**< current action */
    unsigned int shoot_indicator; /**< Indicator to inform the AI if a seeker has been shot recently. */
@@ -534,7 +534,7 @@ int pilot_stealth( Pilot *p )
 
    /* Got into stealth. */
    if (!pilot_outfitLOnstealth( p ))
-      pilot_calcStats(p);
+      pilot_calcStatsLayers( p, PILOT_STATS_ACTIVE );
    p->ew_stealth_timer = 0.;
 
    /* Run hook. */
@@ -553,7 +553,7 @@ void pilot_destealth( Pilot *p )
    pilot_rmFlag( p, PILOT_STEALTH );
    p->ew_stealth_timer = 0.;
    if (!pilot_outfitLOnstealth( p ))
-      pilot_calcStats(p);
+      pilot_calcStatsLayers( p, PILOT_STATS_ACTIVE );
 
    /* Run hook. */
    const HookParam hparam = { .type = HOOK_PARAM_BOOL, .u.b = 0 };
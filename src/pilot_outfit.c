@@ -21,6 +21,7 @@
 #include "pause.h"
 #include "pilot.h"
 #include "player.h"
+#include "profile.h"
 #include "slots.h"
 #include "space.h"
 #include "nlua.h"
@@ -28,11 +29,34 @@
 #include "nlua_pilotoutfit.h"
 #include "nlua_outfit.h"
 
+/*
+ * Stat recomputation counters.
+ */
+static int pilot_stats_full    = 0; /**< Number of full stat recomputes. */
+static int pilot_stats_partial = 0; /**< Number of partial stat recomputes. */
+
+#define DESCEXTRA_CACHE_SIZE  256 /**< Number of cached Lua outfit descriptions. */
+
+/**
+ * @brief A cached result of an outfit's descextra Lua function.
+ */
+typedef struct DescExtraCache_ {
+   const Outfit *outfit;      /**< Outfit described, NULL if unused. */
+   unsigned int id;           /**< ID of the viewing pilot, 0 if none. */
+   unsigned int fingerprint;  /**< Stats fingerprint of the viewing pilot. */
+   const char *lang;          /**< Language the description was generated in. */
+   char *text;                /**< Generated description. */
+} DescExtraCache;
+static DescExtraCache descextra_cache[DESCEXTRA_CACHE_SIZE]; /**< Direct mapped description cache. */
+static int descextra_hits     = 0; /**< Number of descriptions found in the cache. */
+static int descextra_misses   = 0; /**< Number of descriptions generated. */
+
 /*
  * Prototypes.
  */
 static int pilot_hasOutfitLimit( const Pilot *p, const char *limit );
-static void pilot_calcStatsSlot( Pilot *pilot, PilotOutfitSlot *slot );
+static void pilot_calcStatsSlot( Pilot *pilot, PilotOutfitSlot *slot, ShipStats *passive, ShipStats *active );
+static void pilot_statsFingerprint( Pilot *pilot );
 
 /**
  * @brief Updates the lockons on the pilot's launchers
@@ -277,6 +301,9 @@ int pilot_addOutfitRaw( Pilot* pilot, const Outfit* outfit, PilotOutfitSlot *s )
    /* Set the outfit. */
    s->state    = PILOT_OUTFIT_OFF;
    s->outfit   = outfit;
+   pilot->outfit_gen++;
+   if (pilot_isFlag( pilot, PILOT_PLAYER ) || pilot_isFlag( pilot, PILOT_PLAYER_FLEET ))
+      player_outfitsEquippedChanged();
 
    /* Set some default parameters. */
    s->timer    = 0.;
@@ -450,6 +477,9 @@ int pilot_rmOutfitRaw( Pilot* pilot, PilotOutfitSlot *s )
    ret         = (s->outfit==NULL);
    s->outfit   = NULL;
    s->weapset  = -1;
+   pilot->outfit_gen++;
+   if (pilot_isFlag( pilot, PILOT_PLAYER ) || pilot_isFlag( pilot, PILOT_PLAYER_FLEET ))
+      player_outfitsEquippedChanged();
 
    /* Remove secondary and such if necessary. */
    if (pilot->afterburner == s)
@@ -847,16 +877,24 @@ void pilot_fillAmmo( Pilot* pilot )
 
 /**
  * @brief Computes the stats for a pilot's slot.
+ *
+ *    @param pilot Pilot the slot belongs to.
+ *    @param slot Slot to compute stats of.
+ *    @param passive Passive layer to add stats to or NULL if it is up to date.
+ *    @param active Active layer to add stats to or NULL if it is up to date.
  */
-static void pilot_calcStatsSlot( Pilot *pilot, PilotOutfitSlot *slot )
+static void pilot_calcStatsSlot( Pilot *pilot, PilotOutfitSlot *slot, ShipStats *passive, ShipStats *active )
 {
    const Outfit *o = slot->outfit;
-   ShipStats *s = &pilot->stats;
+   ShipStats *layer;
 
    /* Outfit must exist. */
    if (o==NULL)
       return;
 
+   /* Activated outfits have their own layer so toggling them is cheap. */
+   layer = (slot->active) ? active : passive;
+
    /* Modify CPU. */
    pilot->cpu           += outfit_cpu(o);
 
@@ -876,9 +914,10 @@ static void pilot_calcStatsSlot( Pilot *pilot, PilotOutfitSlot *slot )
    if (outfit_isAfterburner(o)) /* Afterburner */
       pilot->afterburner = slot; /* Set afterburner */
 
-   /* Lua mods apply their stats. */
-   if (slot->lua_mem != LUA_NOREF)
-      ss_statsMerge( &pilot->stats, &slot->lua_stats );
+   /* Lua mods apply their stats, these change at runtime so they go with the
+    * active layer. */
+   if ((active != NULL) && (slot->lua_mem != LUA_NOREF))
+      ss_statsMerge( active, &slot->lua_stats );
 
    /* Has update function. */
    if (o->lua_update != LUA_NOREF)
@@ -890,7 +929,8 @@ static void pilot_calcStatsSlot( Pilot *pilot, PilotOutfitSlot *slot )
       if (slot->active && !(slot->state==PILOT_OUTFIT_ON))
          return;
       /* Add stats. */
-      ss_statsModFromList( s, o->stats );
+      if (layer != NULL)
+         ss_statsModFromList( layer, o->stats );
 
    }
    else if (outfit_isAfterburner(o)) { /* Afterburner */
@@ -898,13 +938,15 @@ static void pilot_calcStatsSlot( Pilot *pilot, PilotOutfitSlot *slot )
       if (slot->active && !(slot->state==PILOT_OUTFIT_ON))
          return;
       /* Add stats. */
-      ss_statsModFromList( s, o->stats );
+      if (layer != NULL)
+         ss_statsModFromList( layer, o->stats );
       pilot_setFlag( pilot, PILOT_AFTERBURNER ); /* We use old school flags for this still... */
       pilot->energy_loss += pilot->afterburner->outfit->u.afb.energy; /* energy loss */
    }
    else {
       /* Always add stats for non mod/afterburners. */
-      ss_statsModFromList( s, o->stats );
+      if (layer != NULL)
+         ss_statsModFromList( layer, o->stats );
    }
 }
 
@@ -914,9 +956,31 @@ static void pilot_calcStatsSlot( Pilot *pilot, PilotOutfitSlot *slot )
  *    @param pilot Pilot to recalculate his stats.
  */
 void pilot_calcStats( Pilot* pilot )
+{
+   pilot_calcStatsLayers( pilot, PILOT_STATS_ALL );
+}
+
+/**
+ * @brief Recalculates the pilot's stats when only some of the layers changed.
+ *
+ * The ship stats are cached as separate layers that get merged together, so
+ * that toggling an active outfit or an effect doesn't have to go over all the
+ * outfits again. Derived values are always recomputed.
+ *
+ *    @param pilot Pilot to recalculate his stats.
+ *    @param layers Layers that have changed (PILOT_STATS_*).
+ */
+void pilot_calcStatsLayers( Pilot* pilot, unsigned int layers )
 {
    double ac, sc, ec, tm; /* temporary health coefficients to set */
-   ShipStats *s;
+   ShipStats *s, *passive, *active;
+
+   /* Layers may still be dirty from before. */
+   pilot->stats_dirty |= layers;
+   if (pilot->stats_dirty == PILOT_STATS_ALL)
+      pilot_stats_full++;
+   else
+      pilot_stats_partial++;
 
    /*
     * Set up the basic stuff
@@ -956,24 +1020,47 @@ void pilot_calcStats( Pilot* pilot )
    /* Stats. */
    s = &pilot->stats;
    tm = s->time_mod;
-   *s = pilot->ship->stats_array;
 
-   /* Player gets difficulty applied. */
-   if (pilot_isPlayer(pilot))
-      difficulty_apply( s );
+   /* Ship layer, player gets difficulty applied. */
+   if (pilot->stats_dirty & PILOT_STATS_SHIP) {
+      pilot->stats_ship = pilot->ship->stats_array;
+      if (pilot_isPlayer(pilot))
+         difficulty_apply( &pilot->stats_ship );
+   }
+
+   /* Outfit layers only get reset if they have to be recomputed. */
+   passive = NULL;
+   if (pilot->stats_dirty & PILOT_STATS_PASSIVE) {
+      passive = &pilot->stats_passive;
+      ss_statsInit( passive );
+   }
+   active = NULL;
+   if (pilot->stats_dirty & PILOT_STATS_ACTIVE) {
+      active = &pilot->stats_active;
+      ss_statsInit( active );
+   }
 
    /* Now add outfit changes */
    pilot->mass_outfit   = 0.;
    for (int i=0; i<array_size(pilot->outfit_intrinsic); i++)
-      pilot_calcStatsSlot( pilot, &pilot->outfit_intrinsic[i] );
+      pilot_calcStatsSlot( pilot, &pilot->outfit_intrinsic[i], passive, active );
    for (int i=0; i<array_size(pilot->outfits); i++)
-      pilot_calcStatsSlot( pilot, pilot->outfits[i] );
+      pilot_calcStatsSlot( pilot, pilot->outfits[i], passive, active );
+   if (passive != NULL)
+      ss_statsMerge( passive, &pilot->intrinsic_stats );
+
+   /* Effect layer. */
+   if (pilot->stats_dirty & PILOT_STATS_EFFECTS) {
+      ss_statsInit( &pilot->stats_effects );
+      effect_compute( &pilot->stats_effects, pilot->effects );
+   }
+   pilot->stats_dirty = 0;
 
    /* Merge stats. */
-   ss_statsMerge( &pilot->stats, &pilot->intrinsic_stats );
-
-   /* Compute effects. */
-   effect_compute( &pilot->stats, pilot->effects );
+   *s = pilot->stats_ship;
+   ss_statsMerge( s, &pilot->stats_passive );
+   ss_statsMerge( s, &pilot->stats_active );
+   ss_statsMerge( s, &pilot->stats_effects );
 
    /* Apply system effects. */
    if (cur_system->stats != NULL)
@@ -1078,6 +1165,18 @@ void pilot_calcStats( Pilot* pilot )
       player_resetSpeed();
 }
 
+/**
+ * @brief Gets the number of stat recomputes done so far.
+ *
+ *    @param[out] full Number of recomputes of all the layers.
+ *    @param[out] partial Number of recomputes of only some layers.
+ */
+void pilot_calcStatsCount( int *full, int *partial )
+{
+   *full    = pilot_stats_full;
+   *partial = pilot_stats_partial;
+}
+
 /**
  * @brief Cures the pilot as if he was landed.
  */
@@ -1147,6 +1246,31 @@ void pilot_updateMass( Pilot *pilot )
    }
    /* Need to recalculate electronic warfare mass change. */
    pilot_ewUpdateStatic( pilot );
+
+   /* Stats or mass may have changed. */
+   pilot_statsFingerprint( pilot );
+}
+
+/**
+ * @brief Updates the fingerprint of the stats and mass of a pilot.
+ *
+ * Used to tell when cached outfit descriptions for the pilot are stale.
+ */
+static void pilot_statsFingerprint( Pilot *pilot )
+{
+   /* FNV-1a. */
+   unsigned int h = 2166136261u;
+   const unsigned char *b = (const unsigned char*) &pilot->stats;
+   for (size_t i=0; i<sizeof(ShipStats); i++) {
+      h ^= b[i];
+      h *= 16777619u;
+   }
+   b = (const unsigned char*) &pilot->solid->mass;
+   for (size_t i=0; i<sizeof(double); i++) {
+      h ^= b[i];
+      h *= 16777619u;
+   }
+   pilot->stats_fingerprint = h;
 }
 
 /**
@@ -1170,6 +1294,19 @@ int pilot_slotIsActive( const PilotOutfitSlot *o )
    return 1;
 }
 
+/**
+ * @brief Runs an outfit callback on a slot, profiling outfits with Lua.
+ */
+static void pilot_outfitLRunSlot( Pilot *p, PilotOutfitSlot *po, void (*const func)( const Pilot *p, PilotOutfitSlot *po, const void *data ), const void *data )
+{
+   if (profile_enabled && (po->outfit->lua_env != LUA_NOREF)) {
+      NPROFILE_ZONE_DYN( "outfit", po->outfit->name );
+      func( p, po, data );
+   }
+   else
+      func( p, po, data );
+}
+
 /**
  * @brief Wrapper that does all the work for us.
  */
@@ -1180,17 +1317,17 @@ static void pilot_outfitLRun( Pilot *p, void (*const func)( const Pilot *p, Pilo
       PilotOutfitSlot *po = p->outfits[i];
       if (po->outfit==NULL)
          continue;
-      func( p, po, data );
+      pilot_outfitLRunSlot( p, po, func, data );
    }
    for (int i=0; i<array_size(p->outfit_intrinsic); i++) {
       PilotOutfitSlot *po = &p->outfit_intrinsic[i];
       if (po->outfit==NULL)
          continue;
-      func( p, po, data );
+      pilot_outfitLRunSlot( p, po, func, data );
    }
    /* Recalculate if anything changed. */
    if (pilotoutfit_modified)
-      pilot_calcStats( p );
+      pilot_calcStatsLayers( p, PILOT_STATS_ACTIVE );
 }
 static void outfitLRunWarning( const Pilot *p, const Outfit *o, const char *name, const char *error )
 {
@@ -1213,13 +1350,73 @@ static void pilot_outfitLmem( PilotOutfitSlot *po, nlua_env env )
    nlua_setenv( naevL, env, "mem" ); /* */
 }
 
+/**
+ * @brief Gets the cache slot of an outfit description.
+ */
+static DescExtraCache *pilot_outfitLDescExtraSlot( unsigned int id, unsigned int fingerprint, const Outfit *o )
+{
+   size_t h = (size_t)o;
+   h ^= (h >> 7);
+   h = h*31 + id;
+   h = h*31 + fingerprint;
+   return &descextra_cache[ h % DESCEXTRA_CACHE_SIZE ];
+}
+
+/**
+ * @brief Clears the cache of Lua generated outfit descriptions.
+ */
+void pilot_outfitLDescExtraClear (void)
+{
+   for (int i=0; i<DESCEXTRA_CACHE_SIZE; i++) {
+      free( descextra_cache[i].text );
+      memset( &descextra_cache[i], 0, sizeof(DescExtraCache) );
+   }
+}
+
+/**
+ * @brief Gets the hit and miss counts of the outfit description cache.
+ *
+ *    @param[out] hits Number of descriptions found in the cache.
+ *    @param[out] misses Number of descriptions that had to be generated.
+ */
+void pilot_outfitLDescExtraCount( int *hits, int *misses )
+{
+   *hits    = descextra_hits;
+   *misses  = descextra_misses;
+}
+
+/**
+ * @brief Gets the extra description of an outfit, running the descextra Lua
+ * function if necessary.
+ *
+ * The results are cached per outfit, viewing pilot stats and language.
+ */
 static const char* pilot_outfitLDescExtra( const Pilot *p, const Outfit *o )
 {
    static char descextra[STRMAX];
-   const char *de;
+   const char *de, *lang;
+   unsigned int id, fingerprint;
+   DescExtraCache *c;
    if (o->lua_descextra == LUA_NOREF)
       return o->desc_extra;
 
+   /* See if it's cached. Copy it out as the cache slot can be reused. The
+    * outfit list is part of the fingerprint as descriptions can depend on
+    * outfits that change neither the stats nor the mass, such as intrinsic
+    * skills, and those aren't always followed by pilot_calcStats(). */
+   id          = (p != NULL) ? p->id : 0;
+   fingerprint = (p != NULL) ? (p->stats_fingerprint ^ (p->outfit_gen * 2654435761u)) : 0;
+   lang        = gettext_getLanguage();
+   c = pilot_outfitLDescExtraSlot( id, fingerprint, o );
+   if ((c->outfit == o) && (c->id == id) && (c->fingerprint == fingerprint) &&
+         (c->lang != NULL) && (strcmp( c->lang, lang ) == 0)) {
+      descextra_hits++;
+      strncpy( descextra, c->text, sizeof(descextra)-1 );
+      descextra[ sizeof(descextra)-1 ] = '\0';
+      return descextra;
+   }
+   descextra_misses++;
+
    /* Set up the function: init( p, po ) */
    lua_rawgeti(naevL, LUA_REGISTRYINDEX, o->lua_descextra); /* f */
    if (p != NULL)
@@ -1231,11 +1428,21 @@ static const char* pilot_outfitLDescExtra( const Pilot *p, const Outfit *o )
       outfitLRunWarning( p, o, "descextra", lua_tostring(naevL,-1) );
       lua_pop(naevL, 1);
       descextra[0] = '\0';
-      return descextra;
    }
-   de = luaL_checkstring( naevL, -1 );
-   strncpy( descextra, de, sizeof(descextra) );
-   lua_pop( naevL, 1 );
+   else {
+      de = luaL_checkstring( naevL, -1 );
+      strncpy( descextra, de, sizeof(descextra)-1 );
+      descextra[ sizeof(descextra)-1 ] = '\0';
+      lua_pop( naevL, 1 );
+   }
+
+   /* Store in the cache. */
+   free( c->text );
+   c->outfit      = o;
+   c->id          = id;
+   c->fingerprint = fingerprint;
+   c->lang        = lang;
+   c->text        = strdup( descextra );
    return descextra;
 }
 
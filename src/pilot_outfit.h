@@ -7,6 +7,13 @@
 
 #define PILOT_OUTFIT_LUA_UPDATE_DT     (1.0/10.0)   /* How often the Lua outfits run their update script (in seconds).  */
 
+/* Cached stat layers, see pilot_calcStatsLayers(). */
+#define PILOT_STATS_SHIP      (1<<0) /**< Ship base stats with difficulty. */
+#define PILOT_STATS_PASSIVE   (1<<1) /**< Passive outfits and intrinsic stats. */
+#define PILOT_STATS_ACTIVE    (1<<2) /**< Activated outfits and Lua outfit stats. */
+#define PILOT_STATS_EFFECTS   (1<<3) /**< Effects. */
+#define PILOT_STATS_ALL       (PILOT_STATS_SHIP | PILOT_STATS_PASSIVE | PILOT_STATS_ACTIVE | PILOT_STATS_EFFECTS) /**< All the layers. */
+
 /* Augmentations of normal pilot API. */
 const char* pilot_outfitDescription( const Pilot *pilot, const Outfit *o );
 const char* pilot_outfitSummary( const Pilot *pilot, const Outfit *o );
@@ -45,6 +52,10 @@ void pilot_lockClear( Pilot *p );
 
 /* Other. */
 void pilot_calcStats( Pilot *pilot );
+void pilot_calcStatsLayers( Pilot *pilot, unsigned int layers );
+void pilot_calcStatsCount( int *full, int *partial );
+void pilot_outfitLDescExtraClear (void);
+void pilot_outfitLDescExtraCount( int *hits, int *misses );
 void pilot_updateMass( Pilot *pilot );
 void pilot_healLanded( Pilot *pilot );
 PilotOutfitSlot *pilot_getSlotByName( Pilot *pilot, const char *name );
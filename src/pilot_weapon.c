@@ -190,7 +190,7 @@ void pilot_weapSetPress( Pilot* p, int id, int type )
          else if (type < 0) {
             ws->active = 0;
             if (pilot_weaponSetShootStop( p, ws, -1 )) /* De-activate weapon set. */
-               pilot_calcStats( p ); /* Just in case there is a activated outfit here. */
+               pilot_calcStatsLayers( p, PILOT_STATS_ACTIVE ); /* Just in case there is a activated outfit here. */
          }
          break;
 
@@ -238,7 +238,7 @@ void pilot_weapSetPress( Pilot* p, int id, int type )
             }
             /* Recalculate if anything changed. */
             if (pilotoutfit_modified)
-               pilot_calcStats( p );
+               pilot_calcStatsLayers( p, PILOT_STATS_ACTIVE );
          }
          /* Must recalculate stats. */
          if (n > 0) {
@@ -246,7 +246,7 @@ void pilot_weapSetPress( Pilot* p, int id, int type )
             if (isstealth)
                pilot_destealth( p );
             else
-               pilot_calcStats( p );
+               pilot_calcStatsLayers( p, PILOT_STATS_ACTIVE );
          }
 
          break;
@@ -740,7 +740,7 @@ void pilot_shootStop( Pilot* p, int level )
 
    /* Stop and see if must recalculate. */
    if (pilot_weaponSetShootStop( p, ws, level ))
-      pilot_calcStats( p );
+      pilot_calcStatsLayers( p, PILOT_STATS_ACTIVE );
 }
 
 /**
@@ -1504,7 +1504,7 @@ void pilot_afterburn (Pilot *p)
       p->afterburner->state  = PILOT_OUTFIT_ON;
       p->afterburner->stimer = outfit_duration( p->afterburner->outfit );
       pilot_setFlag(p,PILOT_AFTERBURNER);
-      pilot_calcStats( p );
+      pilot_calcStatsLayers( p, PILOT_STATS_ACTIVE );
       pilot_destealth( p ); /* No afterburning stealth. */
 
       /* @todo Make this part of a more dynamic activated outfit sound system. */
@@ -1531,7 +1531,7 @@ void pilot_afterburnOver (Pilot *p)
    if (p->afterburner->state == PILOT_OUTFIT_ON) {
       p->afterburner->state  = PILOT_OUTFIT_OFF;
       pilot_rmFlag(p,PILOT_AFTERBURNER);
-      pilot_calcStats( p );
+      pilot_calcStatsLayers( p, PILOT_STATS_ACTIVE );
 
       /* @todo Make this part of a more dynamic activated outfit sound system. */
       sound_playPos(p->afterburner->outfit->u.afb.sound_off,
@@ -59,6 +59,7 @@
 #include "player_fleet.h"
 #include "player_inventory.h"
 #include "rng.h"
+#include "save.h"
 #include "shiplog.h"
 #include "sound.h"
 #include "space.h"
@@ -112,6 +113,9 @@ static double player_hailTimer = 0.; /**< Timer for hailing. */
  */
 static PlayerShip_t* player_stack      = NULL;  /**< Stack of ships player has, excluding their current one (player.ps). */
 static PlayerOutfit_t *player_outfits  = NULL;  /**< Outfits player has. */
+static int *player_outfits_idx      = NULL;  /**< Position in player_outfits of each outfit indexed like outfit_getAll(), -1 if not owned. */
+static int *player_outfits_equipped = NULL;  /**< Amount of each outfit equipped on the player's ships, indexed like outfit_getAll(). */
+static int player_outfits_dirty     = 1;     /**< Whether player_outfits_equipped has to be recomputed. */
 
 /*
  * player global properties
@@ -294,6 +298,22 @@ void player_new (void)
    gui_load( gui_pick() );
 }
 
+/**
+ * @brief Creates a new player without asking anything, for tests.
+ *
+ * Unlike player_new() it doesn't show the intro nor start the start mission
+ * and event.
+ *
+ *    @param name Name of the player.
+ *    @return 0 on success.
+ */
+int player_newTest( const char *name )
+{
+   player_newSetup();
+   player.name = strdup( name );
+   return player_newMake();
+}
+
 /**
  * @brief Actually creates a new player.
  *
@@ -467,6 +487,7 @@ static PlayerShip_t *player_newShipMake( const char *name )
 
    /* Grow memory. */
    ps = (player.p == NULL) ? &player.ps : &array_grow( &player_stack );
+   player_outfitsEquippedChanged();
    memset( ps, 0, sizeof(PlayerShip_t) );
    pilot_setFlagRaw( flags, PILOT_PLAYER_FLEET );
    /* Create the ship. */
@@ -676,6 +697,7 @@ void player_rmShip( const char *shipname )
       free( ps->acquired );
 
       array_erase( &player_stack, ps, ps+1 );
+      player_outfitsEquippedChanged();
    }
 
    /* Update ship list if landed. */
@@ -741,6 +763,11 @@ void player_cleanup (void)
 
    array_free(player_outfits);
    player_outfits  = NULL;
+   free(player_outfits_idx);
+   player_outfits_idx = NULL;
+   free(player_outfits_equipped);
+   player_outfits_equipped = NULL;
+   player_outfits_dirty = 1;
 
    array_free(missions_done);
    missions_done = NULL;
@@ -2699,6 +2726,33 @@ PlayerShip_t *player_getPlayerShip( const char *shipname )
    return NULL;
 }
 
+/**
+ * @brief Rebuilds the index of the positions of the outfits in player_outfits.
+ */
+static void player_outfitsReindex (void)
+{
+   int n = array_size( outfit_getAll() );
+   if (player_outfits_idx == NULL)
+      player_outfits_idx = malloc( MAX( 1, n ) * sizeof(int) );
+   for (int i=0; i<n; i++)
+      player_outfits_idx[i] = -1;
+   for (int i=0; i<array_size(player_outfits); i++)
+      player_outfits_idx[ player_outfits[i].o - outfit_getAll() ] = i;
+}
+
+/**
+ * @brief Gets the position of an outfit in player_outfits.
+ *
+ *    @param o Outfit to look up.
+ *    @return Position of the outfit or -1 if the player has none.
+ */
+static int player_outfitPos( const Outfit *o )
+{
+   if (player_outfits_idx == NULL)
+      player_outfitsReindex();
+   return player_outfits_idx[ o - outfit_getAll() ];
+}
+
 /**
  * @brief Gets how many of the outfit the player owns.
  *
@@ -2707,6 +2761,8 @@ PlayerShip_t *player_getPlayerShip( const char *shipname )
  */
 int player_outfitOwned( const Outfit* o )
 {
+   int pos;
+
    /* Special case map. */
    if ((outfit_isMap(o) && map_isUseless(o)) ||
          (outfit_isLocalMap(o) && localmap_isUseless(o)))
@@ -2723,24 +2779,61 @@ int player_outfitOwned( const Outfit* o )
       return 1;
 
    /* Try to find it. */
-   for (int i=0; i<array_size(player_outfits); i++)
-      if (player_outfits[i].o == o)
-         return player_outfits[i].q;
+   pos = player_outfitPos( o );
+   if (pos >= 0)
+      return player_outfits[pos].q;
 
    return 0;
 }
 
+/**
+ * @brief Marks the amount of outfits equipped on the player's ships as changed.
+ */
+void player_outfitsEquippedChanged (void)
+{
+   player_outfits_dirty = 1;
+}
+
+/**
+ * @brief Adds the outfits equipped on a ship to the equipped counts.
+ */
+static void player_outfitsEquippedAdd( const Pilot *p )
+{
+   if (p == NULL)
+      return;
+   for (int i=0; i<array_size(p->outfits); i++) {
+      const Outfit *o = p->outfits[i]->outfit;
+      if (o != NULL)
+         player_outfits_equipped[ o - outfit_getAll() ]++;
+   }
+}
+
+/**
+ * @brief Gets the amount of an outfit equipped on all the player's ships.
+ *
+ * The counts are recomputed from all the ships only after they change.
+ */
+static int player_outfitEquipped( const Outfit *o )
+{
+   if (player_outfits_dirty) {
+      int n = array_size( outfit_getAll() );
+      if (player_outfits_equipped == NULL)
+         player_outfits_equipped = malloc( MAX( 1, n ) * sizeof(int) );
+      memset( player_outfits_equipped, 0, n * sizeof(int) );
+      player_outfitsEquippedAdd( player.p );
+      for (int i=0; i<array_size(player_stack); i++)
+         player_outfitsEquippedAdd( player_stack[i].p );
+      player_outfits_dirty = 0;
+   }
+   return player_outfits_equipped[ o - outfit_getAll() ];
+}
+
 /**
  * Total number of an outfit owned by the player (including equipped).
  */
 int player_outfitOwnedTotal( const Outfit* o )
 {
-   int q = player_outfitOwned(o);
-   q += pilot_numOutfit( player.p, o );
-   for (int i=0; i<array_size(player_stack); i++)
-      q += pilot_numOutfit( player_stack[i].p, o );
-
-   return q;
+   return player_outfitOwned(o) + player_outfitEquipped(o);
 }
 
 /**
@@ -2783,6 +2876,7 @@ int player_getOutfitsFiltered( const Outfit **outfits,
    /* We'll sort. */
    qsort( player_outfits, array_size(player_outfits),
          sizeof(PlayerOutfit_t), player_outfitCompare );
+   player_outfitsReindex();
 
    for (int i=0; i<array_size(player_outfits); i++)
       outfits[i] = (Outfit*)player_outfits[i].o;
@@ -2810,6 +2904,7 @@ int player_numOutfits (void)
 int player_addOutfit( const Outfit *o, int quantity )
 {
    PlayerOutfit_t *po;
+   int pos;
 
    /* Validity check. */
    if (quantity == 0)
@@ -2840,11 +2935,10 @@ int player_addOutfit( const Outfit *o, int quantity )
    }
 
    /* Try to find it. */
-   for (int i=0; i<array_size(player_outfits); i++) {
-      if (player_outfits[i].o == o) {
-         player_outfits[i].q  += quantity;
-         return quantity;
-      }
+   pos = player_outfitPos( o );
+   if (pos >= 0) {
+      player_outfits[pos].q  += quantity;
+      return quantity;
    }
 
    /* Allocate if needed. */
@@ -2853,6 +2947,7 @@ int player_addOutfit( const Outfit *o, int quantity )
    /* Add the outfit. */
    po->o = o;
    po->q = quantity;
+   player_outfits_idx[ o - outfit_getAll() ] = array_size(player_outfits)-1;
    return quantity;
 }
 
@@ -2865,24 +2960,28 @@ int player_addOutfit( const Outfit *o, int quantity )
  */
 int player_rmOutfit( const Outfit *o, int quantity )
 {
+   int q, pos, last;
+
    /* Try to find it. */
-   for (int i=0; i<array_size(player_outfits); i++) {
-      if (player_outfits[i].o != o)
-         continue;
-      /* See how many to remove. */
-      int q = MIN( player_outfits[i].q, quantity );
-      player_outfits[i].q -= q;
+   pos = player_outfitPos( o );
+   if (pos < 0)
+      return 0; /* Nothing removed. */
 
-      /* See if must remove element. */
-      if (player_outfits[i].q <= 0)
-         array_erase( &player_outfits, &player_outfits[i], &player_outfits[i+1] );
+   /* See how many to remove. */
+   q = MIN( player_outfits[pos].q, quantity );
+   player_outfits[pos].q -= q;
 
-      /* Return removed outfits. */
-      return q;
+   /* See if must remove element, the last one takes its place. */
+   if (player_outfits[pos].q <= 0) {
+      last = array_size(player_outfits)-1;
+      player_outfits[pos] = player_outfits[last];
+      player_outfits_idx[ player_outfits[pos].o - outfit_getAll() ] = pos;
+      player_outfits_idx[ o - outfit_getAll() ] = -1;
+      array_resize( &player_outfits, last );
    }
 
-   /* Nothing removed. */
-   return 0;
+   /* Return removed outfits. */
+   return q;
 }
 
 /*
@@ -3482,7 +3581,7 @@ static int player_saveShip( xmlTextWriterPtr writer, PlayerShip_t *pship )
  */
 static int player_saveMetadata( xmlTextWriterPtr writer )
 {
-   time_t t = time(NULL);
+   time_t t = save_time();
    double diff = difftime( t, player.time_since_save );
 
    /* Compute elapsed time. */
@@ -3491,7 +3590,7 @@ static int player_saveMetadata( xmlTextWriterPtr writer )
    player.time_since_save = t;
 
    /* Save the stuff. */
-   xmlw_saveTime(writer, "last_played", time(NULL));
+   xmlw_saveTime(writer, "last_played", t);
    xmlw_saveTime(writer, "date_created", player.date_created);
 
    /* Meta-data. */
@@ -4227,6 +4326,7 @@ static int player_parseShip( xmlNodePtr parent, int is_player )
    if (is_player)
       pilot_setFlagRaw( flags, PILOT_PLAYER );
    pilot_setFlagRaw( flags, PILOT_NO_OUTFITS );
+   pilot_setFlagRaw( flags, PILOT_PLAYER_FLEET );
 
    /* Handle certain 0.10.0-alpha saves where it's possible that... */
    if (!is_player && strcmp( name, player.p->name ) == 0) {
@@ -4555,6 +4655,7 @@ static int player_parseShip( xmlNodePtr parent, int is_player )
       array_push_back( &player_stack, ps );
    else
       player.ps = ps;
+   player_outfitsEquippedChanged();
 
    return 0;
 }
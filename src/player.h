@@ -170,6 +170,7 @@ extern int snd_hypJump; /**< Hyperspace jump sound. */
  */
 int player_init (void);
 void player_new (void);
+int player_newTest( const char *name );
 PlayerShip_t* player_newShip( const Ship* ship, const char *def_name,
       int trade, const char *acquired, int noname );
 void player_cleanup (void);
@@ -230,6 +231,7 @@ void player_rmShip( const char *shipname );
  */
 int player_outfitOwned( const Outfit *o );
 int player_outfitOwnedTotal( const Outfit* o );
+void player_outfitsEquippedChanged (void);
 const PlayerOutfit_t* player_getOutfits (void);
 int player_getOutfitsFiltered( const Outfit **outfits,
       int(*filter)( const Outfit *o ), const char *name );
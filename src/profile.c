@@ -0,0 +1,705 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file profile.c
+ *
+ * @brief Hierarchical frame profiler.
+ *
+ * Code is split into zones with NPROFILE_ZONE() and friends, or naev.profile
+ * from Lua. When enabled, every zone that closes gets written to a ring buffer
+ * of the thread that ran it, which can be exported in the Chrome trace event
+ * format to be opened with chrome://tracing or https://ui.perfetto.dev. Zones
+ * closed on the main thread also keep rolling per frame statistics that can
+ * be shown in game.
+ *
+ * When disabled, zones cost a single branch on profile_enabled.
+ */
+/** @cond */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "naev.h"
+/** @endcond */
+
+#include "profile.h"
+
+#include "font.h"
+#include "log.h"
+#include "nstring.h"
+#include "opengl.h"
+
+#define PROFILE_ZONES_MAX     4096     /**< Maximum number of distinct zones. */
+#define PROFILE_HASH_SIZE     8192     /**< Slots in the zone hash table, power of two. */
+#define PROFILE_THREADS_MAX   32       /**< Maximum number of threads recording. */
+#define PROFILE_RING_SIZE     (1<<18)  /**< Events kept per thread, power of two. */
+#define PROFILE_RING_SLACK    1024     /**< Oldest events skipped when exporting other threads. */
+#define PROFILE_STACK_MAX     64       /**< Maximum zone nesting per thread. */
+#define PROFILE_WINDOW        60       /**< Frames over which the peak is taken. */
+#define PROFILE_EMA           0.05     /**< Weight of the last frame in the rolling averages. */
+#define PROFILE_OVERLAY_ZONES 20       /**< Zones shown in the overlay. */
+#define PROFILE_WRITE_BUF     65536    /**< Size of the export write buffer. */
+
+/**
+ * @brief A named zone with the statistics of the main thread.
+ */
+typedef struct ProfileZone_ {
+   char *cat;           /**< Category. */
+   char *name;          /**< Name. */
+   uint32_t hash;       /**< Hash of the category and name. */
+   Uint64 frame_time;   /**< Time spent in the zone this frame. */
+   int frame_calls;     /**< Times the zone was closed this frame. */
+   double avg;          /**< Rolling average of the time per frame in ms. */
+   double calls;        /**< Rolling average of the calls per frame. */
+   double peak;         /**< Largest time per frame over the last window in ms. */
+   double peak_cur;     /**< Largest time per frame of the current window in ms. */
+} ProfileZone;
+
+/**
+ * @brief A zone that was run.
+ */
+typedef struct ProfileEvent_ {
+   Uint64 start;  /**< Performance counter when opened. */
+   Uint64 end;    /**< Performance counter when closed. */
+   int zone;      /**< Zone. */
+   int depth;     /**< Nesting depth. */
+} ProfileEvent;
+
+/**
+ * @brief A zone that is open.
+ */
+typedef struct ProfileOpen_ {
+   Uint64 start;  /**< Performance counter when opened. */
+   int zone;      /**< Zone. */
+} ProfileOpen;
+
+/**
+ * @brief Per thread recording state.
+ */
+typedef struct ProfileThread_ {
+   int id;                 /**< Index of the thread, used as trace tid. */
+   int main;               /**< Whether it is the main thread that keeps stats. */
+   unsigned int session;   /**< Session the stack belongs to. */
+   int active;             /**< Whether a thread is using it, otherwise it can be reused. */
+   ProfileEvent *ring;     /**< Ring buffer of closed zones. */
+   Uint64 head;            /**< Number of events ever written to the ring. */
+   ProfileOpen stack[PROFILE_STACK_MAX]; /**< Zones currently open. */
+   int depth;              /**< Number of zones currently open. */
+} ProfileThread;
+
+int profile_enabled = 0; /**< Whether zones are being recorded. */
+
+static int profile_overlay       = 0; /**< Whether the overlay is shown. */
+static int profile_pending       = -1; /**< Requested state to apply at the frame boundary, -1 if none. */
+static unsigned int profile_session = 0; /**< Incremented every time recording starts. */
+static Uint64 profile_t0         = 0; /**< Performance counter when initialized. */
+static Uint64 profile_tstart     = 0; /**< Performance counter when the session started. */
+static int profile_window        = 0; /**< Frames into the peak window. */
+static SDL_threadID profile_mainid = 0; /**< Main thread. */
+static SDL_mutex *profile_lock   = NULL; /**< Protects adding zones and threads. */
+
+static ProfileZone profile_zones[PROFILE_ZONES_MAX]; /**< Zones. */
+static int profile_nzones        = 0; /**< Number of zones. */
+static int profile_hashtab[PROFILE_HASH_SIZE]; /**< Zone index plus one by hash, 0 if empty. */
+static ProfileThread *profile_threads[PROFILE_THREADS_MAX]; /**< Recording states, some may be free to reuse. */
+static int profile_nthreads      = 0; /**< Number of recording states. */
+static _Thread_local ProfileThread *profile_self = NULL; /**< Recording state of this thread. */
+
+/**
+ * @brief Buffered writer for the export.
+ */
+typedef struct ProfileWriter_ {
+   SDL_RWops *rw; /**< Output. */
+   char *buf;     /**< Pending output. */
+   size_t n;      /**< Bytes pending. */
+   int err;       /**< Whether writing failed. */
+} ProfileWriter;
+
+/*
+ * Prototypes.
+ */
+static uint32_t profile_hash( const char *cat, const char *name );
+static int profile_lookup( uint32_t h, const char *cat, const char *name, int *slot );
+static ProfileThread *profile_thread (void);
+static void profile_stats (void);
+static int profile_cmpAvg( const void *p1, const void *p2 );
+static void writer_flush( ProfileWriter *w );
+PRINTF_FORMAT( 2, 3 ) static void writer_printf( ProfileWriter *w, const char *fmt, ... );
+static void writer_string( ProfileWriter *w, const char *s );
+
+/**
+ * @brief Initializes the profiler, must be called from the main thread.
+ */
+void profile_init (void)
+{
+   profile_lock   = SDL_CreateMutex();
+   profile_mainid = SDL_ThreadID();
+   profile_t0     = SDL_GetPerformanceCounter();
+   profile_tstart = profile_t0;
+}
+
+/**
+ * @brief Frees the profiler.
+ */
+void profile_exit (void)
+{
+   profile_enabled = 0;
+   for (int i=0; i<profile_nthreads; i++) {
+      free( profile_threads[i]->ring );
+      free( profile_threads[i] );
+   }
+   profile_nthreads = 0;
+   profile_self = NULL;
+   for (int i=0; i<profile_nzones; i++) {
+      free( profile_zones[i].cat );
+      free( profile_zones[i].name );
+   }
+   profile_nzones = 0;
+   memset( profile_hashtab, 0, sizeof(profile_hashtab) );
+   SDL_DestroyMutex( profile_lock );
+   profile_lock = NULL;
+}
+
+/**
+ * @brief Starts recording a new session, discarding the statistics.
+ */
+void profile_start (void)
+{
+   if (profile_enabled)
+      return;
+   profile_session++;
+   profile_tstart = SDL_GetPerformanceCounter();
+   for (int i=0; i<profile_nzones; i++) {
+      ProfileZone *z = &profile_zones[i];
+      z->frame_time  = 0;
+      z->frame_calls = 0;
+      z->avg         = 0.;
+      z->calls       = 0.;
+      z->peak        = 0.;
+      z->peak_cur    = 0.;
+   }
+   profile_window  = 0;
+   profile_enabled = 1;
+}
+
+/**
+ * @brief Stops recording, what was recorded can still be exported.
+ */
+void profile_stop (void)
+{
+   profile_enabled = 0;
+}
+
+/**
+ * @brief Starts or stops recording at the next frame boundary.
+ *
+ * Used from Lua, which runs inside zones that have to be closed first.
+ *
+ *    @param enable Whether to record.
+ */
+void profile_request( int enable )
+{
+   profile_pending = !!enable;
+}
+
+/**
+ * @brief Sets whether the overlay is shown while recording.
+ */
+void profile_setOverlay( int enable )
+{
+   profile_overlay = enable;
+}
+
+/**
+ * @brief Ends a frame, must be called from the main thread outside of zones.
+ *
+ * Nested main loops call it with the zones of the outer loop still open, in
+ * which case requested state changes wait for the outer loop.
+ */
+void profile_frame (void)
+{
+   ProfileThread *t = profile_self;
+   int depth = ((t==NULL) || (t->session != profile_session)) ? 0 : t->depth;
+
+   if (profile_enabled)
+      profile_stats();
+
+   if ((profile_pending >= 0) && (depth == 0)) {
+      if (profile_pending)
+         profile_start();
+      else
+         profile_stop();
+      profile_pending = -1;
+   }
+}
+
+/**
+ * @brief Rolls the frame times of the zones into their statistics.
+ */
+static void profile_stats (void)
+{
+   double toms = 1000. / (double)SDL_GetPerformanceFrequency();
+   int endwindow = (++profile_window >= PROFILE_WINDOW);
+
+   for (int i=0; i<profile_nzones; i++) {
+      ProfileZone *z = &profile_zones[i];
+      double ms = (double)z->frame_time * toms;
+      z->avg     += PROFILE_EMA * (ms - z->avg);
+      z->calls   += PROFILE_EMA * ((double)z->frame_calls - z->calls);
+      z->peak_cur = MAX( z->peak_cur, ms );
+      if (endwindow) {
+         z->peak     = z->peak_cur;
+         z->peak_cur = 0.;
+      }
+      z->frame_time  = 0;
+      z->frame_calls = 0;
+   }
+   if (endwindow)
+      profile_window = 0;
+}
+
+/**
+ * @brief FNV-1a hash of a zone.
+ */
+static uint32_t profile_hash( const char *cat, const char *name )
+{
+   uint32_t h = 2166136261u;
+   for (const char *s=cat; *s!='\0'; s++)
+      h = (h ^ (unsigned char)*s) * 16777619u;
+   h = (h ^ ':') * 16777619u;
+   for (const char *s=name; *s!='\0'; s++)
+      h = (h ^ (unsigned char)*s) * 16777619u;
+   return h;
+}
+
+/**
+ * @brief Looks up a zone in the hash table.
+ *
+ *    @param h Hash of the zone.
+ *    @param cat Category of the zone.
+ *    @param name Name of the zone.
+ *    @param[out] slot Empty slot where the zone would go if not found.
+ *    @return The zone or -1 if not found.
+ */
+static int profile_lookup( uint32_t h, const char *cat, const char *name, int *slot )
+{
+   for (uint32_t i=h; ; i++) {
+      int s = i & (PROFILE_HASH_SIZE-1);
+      int z = __atomic_load_n( &profile_hashtab[s], __ATOMIC_ACQUIRE );
+      if (z == 0) {
+         *slot = s;
+         return -1;
+      }
+      z--;
+      if ((profile_zones[z].hash == h) && (strcmp(profile_zones[z].name, name)==0)
+            && (strcmp(profile_zones[z].cat, cat)==0))
+         return z;
+   }
+}
+
+/**
+ * @brief Gets a zone by name, creating it if needed.
+ *
+ * Zones are never removed, so lookups don't need locking.
+ *
+ *    @param cat Category of the zone, such as "ai" or "hook".
+ *    @param name Name of the zone.
+ *    @return The zone or -1 if there are too many.
+ */
+int profile_zone( const char *cat, const char *name )
+{
+   ProfileZone *z;
+   uint32_t h;
+   int id, slot;
+
+   if (name == NULL)
+      name = "?";
+   h  = profile_hash( cat, name );
+   id = profile_lookup( h, cat, name, &slot );
+   if (id >= 0)
+      return id;
+
+   /* Look again under the lock in case another thread added it. */
+   SDL_mutexP( profile_lock );
+   id = profile_lookup( h, cat, name, &slot );
+   if ((id < 0) && (profile_nzones < PROFILE_ZONES_MAX)) {
+      id = profile_nzones;
+      z = &profile_zones[id];
+      memset( z, 0, sizeof(ProfileZone) );
+      z->cat   = strdup( cat );
+      z->name  = strdup( name );
+      z->hash  = h;
+      profile_nzones++;
+      __atomic_store_n( &profile_hashtab[slot], id+1, __ATOMIC_RELEASE );
+   }
+   SDL_mutexV( profile_lock );
+   return id;
+}
+
+/**
+ * @brief Gets a zone by name, caching it at the call site.
+ *
+ *    @param cat Category of the zone.
+ *    @param name Name of the zone.
+ *    @param[in,out] id Cached zone, -1 if not looked up yet.
+ *    @return The zone or -1 if there are too many.
+ */
+int profile_zoneCached( const char *cat, const char *name, int *id )
+{
+   if (*id < 0)
+      *id = profile_zone( cat, name );
+   return *id;
+}
+
+/**
+ * @brief Gets the recording state of the current thread, creating it if needed.
+ *
+ * The state of a thread that exited is reused, ring buffer included, so
+ * threads coming and going don't use up the slots.
+ */
+static ProfileThread *profile_thread (void)
+{
+   ProfileThread *t;
+
+   if (profile_self != NULL)
+      return profile_self;
+
+   SDL_mutexP( profile_lock );
+   for (int i=0; i<profile_nthreads; i++) {
+      t = profile_threads[i];
+      if (t->active)
+         continue;
+      t->active  = 1;
+      t->main    = (SDL_ThreadID() == profile_mainid);
+      t->session = profile_session;
+      t->depth   = 0;
+      SDL_mutexV( profile_lock );
+      profile_self = t;
+      return t;
+   }
+   if (profile_nthreads >= PROFILE_THREADS_MAX) {
+      SDL_mutexV( profile_lock );
+      return NULL;
+   }
+   t = calloc( 1, sizeof(ProfileThread) );
+   t->ring = malloc( PROFILE_RING_SIZE * sizeof(ProfileEvent) );
+   t->id   = profile_nthreads;
+   t->active = 1;
+   t->main = (SDL_ThreadID() == profile_mainid);
+   t->session = profile_session;
+   profile_threads[ profile_nthreads++ ] = t;
+   SDL_mutexV( profile_lock );
+
+   profile_self = t;
+   return t;
+}
+
+/**
+ * @brief Releases the recording state of the current thread, which is about
+ *        to exit, so another thread can reuse it.
+ */
+void profile_threadExit (void)
+{
+   ProfileThread *t = profile_self;
+   if (t == NULL)
+      return;
+   SDL_mutexP( profile_lock );
+   t->depth  = 0;
+   t->active = 0;
+   SDL_mutexV( profile_lock );
+   profile_self = NULL;
+}
+
+/**
+ * @brief Opens a zone on the current thread.
+ *
+ *    @param zone Zone to open.
+ *    @return 1 if opened and profile_pop() has to be called, 0 otherwise.
+ */
+int profile_push( int zone )
+{
+   ProfileThread *t;
+
+   if (zone < 0)
+      return 0;
+   t = profile_thread();
+   if (t == NULL)
+      return 0;
+
+   /* Zones left open by a previous session are gone. */
+   if (t->session != profile_session) {
+      t->session = profile_session;
+      t->depth   = 0;
+   }
+   if (t->depth >= PROFILE_STACK_MAX)
+      return 0;
+
+   t->stack[t->depth].zone  = zone;
+   t->stack[t->depth].start = SDL_GetPerformanceCounter();
+   t->depth++;
+   return 1;
+}
+
+/**
+ * @brief Closes the last zone opened on the current thread.
+ */
+void profile_pop (void)
+{
+   ProfileThread *t = profile_self;
+   ProfileOpen *o;
+   ProfileEvent *e;
+   Uint64 end;
+
+   if ((t == NULL) || (t->depth <= 0))
+      return;
+   end = SDL_GetPerformanceCounter();
+   if (t->session != profile_session) {
+      t->depth = 0;
+      return;
+   }
+   o = &t->stack[ --t->depth ];
+
+   e = &t->ring[ t->head & (PROFILE_RING_SIZE-1) ];
+   e->start = o->start;
+   e->end   = end;
+   e->zone  = o->zone;
+   e->depth = t->depth;
+   __atomic_store_n( &t->head, t->head+1, __ATOMIC_RELEASE );
+
+   if (t->main) {
+      ProfileZone *z = &profile_zones[ o->zone ];
+      int outer = 0;
+      /* Recursive zones only count the outermost time. */
+      for (int i=0; i<t->depth; i++) {
+         if (t->stack[i].zone == o->zone) {
+            outer = 1;
+            break;
+         }
+      }
+      if (!outer)
+         z->frame_time += end - o->start;
+      z->frame_calls++;
+   }
+}
+
+/**
+ * @brief Gets the number of zones open on the current thread.
+ *
+ *    @return Number of zones open.
+ */
+int profile_depth (void)
+{
+   const ProfileThread *t = profile_self;
+   if ((t == NULL) || (t->session != profile_session))
+      return 0;
+   return t->depth;
+}
+
+/**
+ * @brief Closes zones on the current thread until only depth are left open.
+ *
+ *    @param depth Number of zones to leave open.
+ */
+void profile_popTo( int depth )
+{
+   while (profile_depth() > depth)
+      profile_pop();
+}
+
+/**
+ * @brief Cleanup handler of NPROFILE_ZONE().
+ */
+void profile_scopeEnd( const int *pushed )
+{
+   if (*pushed)
+      profile_pop();
+}
+
+/**
+ * @brief Gets the statistics of a zone.
+ *
+ *    @param i Zone to get, from 0.
+ *    @param[out] cat Category.
+ *    @param[out] name Name.
+ *    @param[out] avg Rolling average of the time per frame in ms.
+ *    @param[out] peak Largest time per frame in ms over the last second or so.
+ *    @param[out] calls Rolling average of calls per frame.
+ *    @return 1 if the zone exists, 0 otherwise.
+ */
+int profile_getStats( int i, const char **cat, const char **name, double *avg, double *peak, double *calls )
+{
+   const ProfileZone *z;
+   if ((i < 0) || (i >= profile_nzones))
+      return 0;
+   z = &profile_zones[i];
+   *cat   = z->cat;
+   *name  = z->name;
+   *avg   = z->avg;
+   *peak  = MAX( z->peak, z->peak_cur );
+   *calls = z->calls;
+   return 1;
+}
+
+/**
+ * @brief Sorts zones by decreasing average time.
+ */
+static int profile_cmpAvg( const void *p1, const void *p2 )
+{
+   const ProfileZone *z1 = &profile_zones[ *(const int*)p1 ];
+   const ProfileZone *z2 = &profile_zones[ *(const int*)p2 ];
+   if (z1->avg > z2->avg)
+      return -1;
+   else if (z1->avg < z2->avg)
+      return +1;
+   return *(const int*)p1 - *(const int*)p2;
+}
+
+/**
+ * @brief Renders the zones taking the most time in the top right corner.
+ */
+void profile_render (void)
+{
+   static int order[PROFILE_ZONES_MAX];
+   char buf[128], zone[64];
+   double x, y, w, h;
+   int n;
+
+   if (!profile_enabled || !profile_overlay)
+      return;
+
+   for (int i=0; i<profile_nzones; i++)
+      order[i] = i;
+   qsort( order, profile_nzones, sizeof(int), profile_cmpAvg );
+   n = MIN( profile_nzones, PROFILE_OVERLAY_ZONES );
+
+   snprintf( buf, sizeof(buf), "%-32s %7s %7s %6s", _("Zone"), _("avg ms"), _("peak"), _("calls") );
+   w = gl_printWidthRaw( &gl_defFontMono, buf );
+   h = (n+1) * (gl_defFontMono.h + 5.) + 5.;
+   x = SCREEN_W - w - 20.;
+   y = SCREEN_H - 15. - gl_defFontMono.h;
+   gl_renderRect( x-5., y+gl_defFontMono.h+5.-h, w+10., h, &cBlackHilight );
+   gl_printRaw( &gl_defFontMono, x, y, &cFontGrey, -1., buf );
+   for (int i=0; i<n; i++) {
+      const ProfileZone *z = &profile_zones[ order[i] ];
+      y -= gl_defFontMono.h + 5.;
+      snprintf( zone, sizeof(zone), "%s:%s", z->cat, z->name );
+      snprintf( buf, sizeof(buf), "%-32.32s %7.2f %7.2f %6.1f", zone, z->avg, MAX(z->peak, z->peak_cur), z->calls );
+      gl_printRaw( &gl_defFontMono, x, y, &cFontWhite, -1., buf );
+   }
+}
+
+/**
+ * @brief Writes out the pending export output.
+ */
+static void writer_flush( ProfileWriter *w )
+{
+   if ((w->n > 0) && (SDL_RWwrite( w->rw, w->buf, 1, w->n ) != w->n))
+      w->err = 1;
+   w->n = 0;
+}
+
+/**
+ * @brief Writes formatted export output.
+ */
+static void writer_printf( ProfileWriter *w, const char *fmt, ... )
+{
+   va_list ap;
+   int len;
+
+   for (int tries=0; tries<2; tries++) {
+      va_start( ap, fmt );
+      len = vsnprintf( &w->buf[w->n], PROFILE_WRITE_BUF - w->n, fmt, ap );
+      va_end( ap );
+      if ((len >= 0) && ((size_t)len < PROFILE_WRITE_BUF - w->n)) {
+         w->n += len;
+         return;
+      }
+      writer_flush( w );
+   }
+   w->err = 1;
+}
+
+/**
+ * @brief Writes a string as a JSON string.
+ */
+static void writer_string( ProfileWriter *w, const char *s )
+{
+   writer_printf( w, "\"" );
+   for (; *s!='\0'; s++) {
+      unsigned char c = *s;
+      if (w->n + 8 >= PROFILE_WRITE_BUF)
+         writer_flush( w );
+      if ((c == '"') || (c == '\\')) {
+         w->buf[w->n++] = '\\';
+         w->buf[w->n++] = c;
+      }
+      else if (c < 0x20)
+         w->n += snprintf( &w->buf[w->n], 8, "\\u%04x", c );
+      else
+         w->buf[w->n++] = c;
+   }
+   writer_printf( w, "\"" );
+}
+
+/**
+ * @brief Exports the events of the last session in the Chrome trace event format.
+ *
+ * Threads other than the caller may still be recording, so the oldest events
+ * of their ring buffers, which could be getting overwritten, are skipped.
+ *
+ *    @param rw Where to write, not closed.
+ *    @return 0 on success.
+ */
+int profile_export( SDL_RWops *rw )
+{
+   ProfileWriter w;
+   double tous = 1e6 / (double)SDL_GetPerformanceFrequency();
+   int nthreads, nevents;
+
+   w.rw  = rw;
+   w.buf = malloc( PROFILE_WRITE_BUF );
+   w.n   = 0;
+   w.err = 0;
+
+   SDL_mutexP( profile_lock );
+   nthreads = profile_nthreads;
+   SDL_mutexV( profile_lock );
+
+   writer_printf( &w, "{\"traceEvents\":[\n" );
+   writer_printf( &w, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"%s\"}}", APPNAME );
+   nevents = 0;
+   for (int i=0; i<nthreads; i++) {
+      const ProfileThread *t = profile_threads[i];
+      Uint64 head = __atomic_load_n( &t->head, __ATOMIC_ACQUIRE );
+      Uint64 n    = (t == profile_self) ? PROFILE_RING_SIZE : PROFILE_RING_SIZE - PROFILE_RING_SLACK;
+      n = MIN( n, head );
+
+      writer_printf( &w, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+            t->id+1, t->main ? "main" : "thread", t->id );
+      for (Uint64 j=head-n; j<head; j++) {
+         const ProfileEvent *e = &t->ring[ j & (PROFILE_RING_SIZE-1) ];
+         const ProfileZone *z = &profile_zones[ e->zone ];
+         if (e->start < profile_tstart)
+            continue;
+         writer_printf( &w, ",\n{\"name\":" );
+         writer_string( &w, z->name );
+         writer_printf( &w, ",\"cat\":" );
+         writer_string( &w, z->cat );
+         writer_printf( &w, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+               (double)(e->start - profile_t0) * tous, (double)(e->end - e->start) * tous, t->id+1 );
+         nevents++;
+      }
+   }
+   writer_printf( &w, "\n],\"displayTimeUnit\":\"ms\"}\n" );
+   writer_flush( &w );
+   free( w.buf );
+
+   if (w.err) {
+      WARN(_("Failed to write the profiler trace: %s"), SDL_GetError());
+      return -1;
+   }
+   DEBUG(n_("Wrote %d profiler event", "Wrote %d profiler events", nevents), nevents);
+   return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+#pragma once
+
+/** @cond */
+#include "SDL.h"
+/** @endcond */
+
+#define PROFILE_CONCAT_( a, b )  a##b /**< Helper for PROFILE_CONCAT. */
+#define PROFILE_CONCAT( a, b )   PROFILE_CONCAT_( a, b ) /**< Pastes after expanding. */
+
+/**
+ * @brief Profiles the rest of the enclosing scope as a zone with a fixed name.
+ *
+ * Costs a single branch when the profiler is disabled.
+ */
+#define NPROFILE_ZONE( cat, name ) \
+   static int PROFILE_CONCAT( profile_id_, __LINE__ ) = -1; \
+   __attribute__((cleanup(profile_scopeEnd))) int PROFILE_CONCAT( profile_scope_, __LINE__ ) = \
+      profile_enabled && profile_push( profile_zoneCached( cat, name, &PROFILE_CONCAT( profile_id_, __LINE__ ) ) )
+
+/**
+ * @brief Profiles the rest of the enclosing scope as a zone whose name is only
+ *        known at run time, such as an AI profile or hook stack.
+ */
+#define NPROFILE_ZONE_DYN( cat, name ) \
+   __attribute__((cleanup(profile_scopeEnd))) int PROFILE_CONCAT( profile_scope_, __LINE__ ) = \
+      profile_enabled && profile_push( profile_zone( cat, name ) )
+
+/**
+ * @brief Opens a zone with a fixed name that is closed by NPROFILE_END() with
+ *        the same tag.
+ *
+ * Only for straight-line code: both ends must be reached in the same scope.
+ * Whether the zone was opened is kept in a variable named after the tag, so
+ * the matching NPROFILE_END() only closes it if it was.
+ */
+#define NPROFILE_BEGIN( tag, cat, name ) \
+   static int PROFILE_CONCAT( profile_id_, tag ) = -1; \
+   int PROFILE_CONCAT( profile_pushed_, tag ) = \
+      profile_enabled && profile_push( profile_zoneCached( cat, name, &PROFILE_CONCAT( profile_id_, tag ) ) )
+
+/**
+ * @brief Closes the zone opened by NPROFILE_BEGIN() with the same tag.
+ */
+#define NPROFILE_END( tag ) \
+   do { \
+      if (PROFILE_CONCAT( profile_pushed_, tag )) \
+         profile_pop(); \
+   } while (0)
+
+extern int profile_enabled; /**< Whether zones are being recorded. */
+
+/* Init/exit. */
+void profile_init (void);
+void profile_exit (void);
+void profile_threadExit (void);
+
+/* Control. */
+void profile_start (void);
+void profile_stop (void);
+void profile_request( int enable );
+void profile_frame (void);
+void profile_setOverlay( int enable );
+int profile_export( SDL_RWops *rw );
+
+/* Zones. */
+int profile_zone( const char *cat, const char *name );
+int profile_zoneCached( const char *cat, const char *name, int *id );
+int profile_push( int zone );
+void profile_pop (void);
+int profile_depth (void);
+void profile_popTo( int depth );
+void profile_scopeEnd( const int *pushed );
+
+/* Stats. */
+int profile_getStats( int i, const char **cat, const char **name, double *avg, double *peak, double *calls );
+void profile_render (void);
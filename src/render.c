@@ -13,6 +13,7 @@
 #include "opengl.h"
 #include "pause.h"
 #include "player.h"
+#include "profile.h"
 #include "space.h"
 #include "spfx.h"
 #include "toolkit.h"
@@ -206,30 +207,38 @@ void render_all( double game_dt, double real_dt )
    gl_defViewport();
 
    /* Background stuff */
+   NPROFILE_BEGIN( background, "render", "background" );
    space_render( real_dt ); /* Nebula looks really weird otherwise. */
    hooks_run( "renderbg" );
    spobs_render();
    spfx_render(SPFX_LAYER_BACK);
    weapons_render(WEAPON_LAYER_BG, dt);
+   NPROFILE_END( background );
    /* Middle stuff */
+   NPROFILE_BEGIN( middle, "render", "middle" );
    player_renderUnderlay(dt);
    pilots_render();
    weapons_render(WEAPON_LAYER_FG, dt);
    spfx_render(SPFX_LAYER_MIDDLE);
+   NPROFILE_END( middle );
    /* Foreground stuff */
+   NPROFILE_BEGIN( foreground, "render", "foreground" );
    player_render(dt);
    spfx_render(SPFX_LAYER_FRONT);
    space_renderOverlay(dt);
    gui_renderReticles(dt);
    pilots_renderOverlay();
    hooks_run( "renderfg" );
+   NPROFILE_END( foreground );
 
    /* Process game stuff only. */
    if (pp_game)
       render_fbo_list( dt, pp_shaders_list[PP_LAYER_GAME], &cur, !(pp_final || pp_gui) );
 
    /* GUi stuff. */
+   NPROFILE_BEGIN( gui, "render", "gui" );
    gui_render(dt);
+   NPROFILE_END( gui );
 
    if (pp_gui)
       render_fbo_list( dt, pp_shaders_list[PP_LAYER_GUI], &cur, !pp_final );
@@ -238,10 +247,15 @@ void render_all( double game_dt, double real_dt )
    gl_viewport( 0, 0, gl_screen.nw, gl_screen.nh );
 
    /* Top stuff. */
+   NPROFILE_BEGIN( top, "render", "top" );
    ovr_render( real_dt ); /* Using real_dt is sort of a hack for now. */
    hooks_run( "rendertop" );
    display_fps( real_dt ); /* Exception using real_dt. */
+   NPROFILE_END( top );
+   NPROFILE_BEGIN( toolkit, "render", "toolkit" );
    toolkit_render( real_dt );
+   NPROFILE_END( toolkit );
+   profile_render();
 
    /* Final post-processing. */
    if (pp_final)
@@ -0,0 +1,491 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file replay.c
+ *
+ * @brief Records and plays back sessions tick for tick.
+ *
+ * A recording holds the seed the random number generator was started with,
+ * followed by, for every frame, the input events handled before it and the
+ * time step it was run with. Playing it back from startup with the same data
+ * and saves reproduces the session, so the frame times of a bad session can
+ * be compared across builds. Input timing, such as key repeat and double
+ * clicks, uses the tick count of the frame, which is also recorded.
+ *
+ * When playing back, the event loops get the recorded events from
+ * replay_pollEvent() in place of the ones from SDL, up to the next frame. This
+ * way nested loops, like the ones of dialogues, handle the same events in the
+ * same passes as when recording.
+ *
+ * While recording or playing back, things that otherwise depend on the wall
+ * clock, like the system warm-up, the time limit of the linear optimizer and
+ * how much Lua garbage is collected per frame, do a fixed amount of work
+ * instead (see replay_isDeterministic()). Every frame also stores a checksum
+ * of the game state, and the first frame where the playback doesn't match is
+ * reported.
+ */
+/** @cond */
+#include <stdlib.h>
+#include <string.h>
+
+#include "naev.h"
+/** @endcond */
+
+#include "replay.h"
+
+#include "array.h"
+#include "conf.h"
+#include "dialogue.h"
+#include "input.h"
+#include "log.h"
+#include "player.h"
+#include "rng.h"
+
+#define REPLAY_MAGIC    "NAEVRPL" /**< Start of a recording, including the terminating NUL. */
+#define REPLAY_VERSION  2         /**< Version of the recording format. */
+#define REPLAY_EVENT    'E'       /**< Record of an input event. */
+#define REPLAY_FRAME    'F'       /**< Record of a frame. */
+
+#define REPLAY_TEST_FRAMES 60     /**< Frames the replay test runs after closing its dialogue. */
+
+extern void main_loop( int update ); /* from naev.c */
+
+/**
+ * @brief What the replay subsystem is doing.
+ */
+typedef enum ReplayMode_ {
+   REPLAY_OFF,    /**< Not recording nor playing. */
+   REPLAY_RECORD, /**< Recording a session. */
+   REPLAY_PLAY,   /**< Playing back a session. */
+} ReplayMode;
+
+static ReplayMode replay_mode = REPLAY_OFF; /**< Current mode. */
+static SDL_RWops *replay_rw   = NULL; /**< Recording being written or read. */
+static Uint32 replay_ticks    = 0; /**< Tick count of the current frame. */
+static unsigned int replay_nframes = 0; /**< Frames recorded or played. */
+static unsigned int replay_nevents = 0; /**< Events recorded or played. */
+static int replay_done        = 0; /**< Playback reached the end of the recording. */
+static int replay_next        = -1; /**< Type of the next record if already read, or -1. */
+static unsigned int replay_diverged = 0; /**< First frame that didn't match the recording, or 0. */
+static Uint64 replay_tlast    = 0; /**< Performance counter at the last frame. */
+static double *replay_times   = NULL; /**< Wall clock time of every frame in ms (array.h). */
+
+/*
+ * Prototypes.
+ */
+static int replay_readHeader( uint32_t *seed );
+static void replay_writeHeader( uint32_t seed );
+static void replay_end( const char *reason );
+static void replay_diverge( unsigned int frame );
+static int replay_peek (void);
+static int replay_readEvent( SDL_Event *event );
+static void replay_report (void);
+static uint32_t replay_checksum (void);
+static int replay_cmpTime( const void *p1, const void *p2 );
+
+/**
+ * @brief Starts recording or playing back, depending on the configuration.
+ *
+ * Must be called after the random number generator has been initialized and
+ * before anything uses it.
+ */
+void replay_init (void)
+{
+   uint32_t seed;
+
+   if (conf.replay_play != NULL) {
+      replay_rw = SDL_RWFromFile( conf.replay_play, "rb" );
+      if (replay_rw == NULL) {
+         WARN(_("Unable to open replay '%s': %s"), conf.replay_play, SDL_GetError());
+         return;
+      }
+      if (replay_readHeader( &seed )) {
+         WARN(_("Replay '%s' is not a valid recording from this build."), conf.replay_play);
+         SDL_RWclose( replay_rw );
+         replay_rw = NULL;
+         return;
+      }
+      replay_mode = REPLAY_PLAY;
+      LOG(_("Playing back replay '%s' with seed %u"), conf.replay_play, seed);
+   }
+   else if (conf.replay_record != NULL) {
+      replay_rw = SDL_RWFromFile( conf.replay_record, "wb" );
+      if (replay_rw == NULL) {
+         WARN(_("Unable to open replay '%s' for writing: %s"), conf.replay_record, SDL_GetError());
+         return;
+      }
+      seed = randint();
+      replay_writeHeader( seed );
+      replay_mode = REPLAY_RECORD;
+      LOG(_("Recording replay '%s' with seed %u"), conf.replay_record, seed);
+   }
+   else
+      return;
+
+   rng_seed( seed );
+   replay_times = array_create( double );
+   replay_ticks = SDL_GetTicks();
+}
+
+/**
+ * @brief Stops recording or playing back, logging the frame times.
+ */
+void replay_exit (void)
+{
+   if (replay_mode == REPLAY_OFF)
+      return;
+   replay_report();
+   SDL_RWclose( replay_rw );
+   replay_rw = NULL;
+   array_free( replay_times );
+   replay_times = NULL;
+   replay_mode = REPLAY_OFF;
+}
+
+/**
+ * @brief Reads the header of a recording.
+ *
+ *    @param[out] seed Seed of the random number generator.
+ *    @return 0 on success.
+ */
+static int replay_readHeader( uint32_t *seed )
+{
+   char magic[sizeof(REPLAY_MAGIC)];
+   if ((SDL_RWread( replay_rw, magic, sizeof(magic), 1 ) != 1)
+         || (memcmp( magic, REPLAY_MAGIC, sizeof(magic) ) != 0))
+      return -1;
+   if (SDL_ReadLE32( replay_rw ) != REPLAY_VERSION)
+      return -1;
+   /* Events are stored as is, so they must match the SDL we were built with. */
+   if (SDL_ReadLE32( replay_rw ) != sizeof(SDL_Event))
+      return -1;
+   *seed = SDL_ReadLE32( replay_rw );
+   return 0;
+}
+
+/**
+ * @brief Writes the header of a recording.
+ *
+ *    @param seed Seed of the random number generator.
+ */
+static void replay_writeHeader( uint32_t seed )
+{
+   SDL_RWwrite( replay_rw, REPLAY_MAGIC, sizeof(REPLAY_MAGIC), 1 );
+   SDL_WriteLE32( replay_rw, REPLAY_VERSION );
+   SDL_WriteLE32( replay_rw, sizeof(SDL_Event) );
+   SDL_WriteLE32( replay_rw, seed );
+}
+
+/**
+ * @brief Checks to see if a session is being recorded.
+ */
+int replay_isRecording (void)
+{
+   return (replay_mode == REPLAY_RECORD);
+}
+
+/**
+ * @brief Checks to see if a session is being played back.
+ */
+int replay_isPlaying (void)
+{
+   return (replay_mode == REPLAY_PLAY) && !replay_done;
+}
+
+/**
+ * @brief Checks to see if the playback should skip rendering.
+ */
+int replay_isHeadless (void)
+{
+   return replay_isPlaying() && conf.replay_headless;
+}
+
+/**
+ * @brief Checks to see if the playback should run as fast as possible.
+ */
+int replay_isUncapped (void)
+{
+   return replay_isPlaying() && conf.replay_uncapped;
+}
+
+/**
+ * @brief Checks to see if things that depend on the wall clock should do a
+ *        fixed amount of work instead, so the session can be reproduced.
+ */
+int replay_isDeterministic (void)
+{
+   return replay_isRecording() || replay_isPlaying();
+}
+
+/**
+ * @brief Computes a checksum of the game state.
+ *
+ * Covers the random number generator and the player's ship, which is enough
+ * to notice most divergences soon after they happen.
+ */
+static uint32_t replay_checksum (void)
+{
+   uint32_t h = 2166136261U; /* FNV-1a. */
+   uint32_t rng = rng_state();
+   const unsigned char *b = (const unsigned char*)&rng;
+   for (size_t i=0; i<sizeof(rng); i++)
+      h = (h ^ b[i]) * 16777619U;
+   if (player.p != NULL) {
+      double s[4] = { player.p->solid->pos.x, player.p->solid->pos.y,
+            player.p->solid->vel.x, player.p->solid->vel.y };
+      b = (const unsigned char*)s;
+      for (size_t i=0; i<sizeof(s); i++)
+         h = (h ^ b[i]) * 16777619U;
+   }
+   return h;
+}
+
+/**
+ * @brief Records an input event about to be handled.
+ *
+ * Our own events, which get pushed again when playing back, and events
+ * pointing to memory are left out.
+ *
+ *    @param event Event being handled.
+ */
+void replay_event( const SDL_Event *event )
+{
+   if (replay_mode != REPLAY_RECORD)
+      return;
+   if ((event->type >= SDL_USEREVENT) || (event->type == SDL_DROPFILE)
+         || (event->type == SDL_DROPTEXT))
+      return;
+   SDL_WriteU8( replay_rw, REPLAY_EVENT );
+   SDL_RWwrite( replay_rw, event, sizeof(SDL_Event), 1 );
+   replay_nevents++;
+}
+
+/**
+ * @brief Polls for an event, to be used by the event loops in place of
+ *        SDL_PollEvent().
+ *
+ * When playing back, input from SDL is dropped and the recorded events are
+ * returned instead, until the end of the frame they were recorded in. Quitting
+ * and our own events, which get pushed again when playing back, still come
+ * from SDL first, as they did when recording.
+ *
+ *    @param[out] event Event that was polled.
+ *    @return 1 if there was an event.
+ */
+int replay_pollEvent( SDL_Event *event )
+{
+   if (!replay_isPlaying())
+      return SDL_PollEvent( event );
+
+   while (SDL_PollEvent( event ))
+      if ((event->type == SDL_QUIT) || (event->type >= SDL_USEREVENT))
+         return 1;
+   return replay_readEvent( event );
+}
+
+/**
+ * @brief Gets the type of the next record of the playback without consuming
+ *        it.
+ *
+ *    @return Type of the next record, or -1 if the recording ended.
+ */
+static int replay_peek (void)
+{
+   Uint8 type;
+
+   if (replay_done)
+      return -1;
+   if (replay_next < 0) {
+      if (SDL_RWread( replay_rw, &type, 1, 1 ) != 1) {
+         replay_end( NULL );
+         return -1;
+      }
+      replay_next = type;
+   }
+   return replay_next;
+}
+
+/**
+ * @brief Reads the next event of the playback, unless the frame ends first.
+ *
+ *    @param[out] event Event that was read.
+ *    @return 1 if an event was read.
+ */
+static int replay_readEvent( SDL_Event *event )
+{
+   if (replay_peek() != REPLAY_EVENT)
+      return 0;
+   replay_next = -1;
+   if (SDL_RWread( replay_rw, event, sizeof(SDL_Event), 1 ) != 1) {
+      replay_end( _("truncated event") );
+      return 0;
+   }
+   replay_nevents++;
+   return 1;
+}
+
+/**
+ * @brief Reports that the playback no longer matches the recording, only the
+ *        first time it happens.
+ *
+ *    @param frame Frame where it was noticed.
+ */
+static void replay_diverge( unsigned int frame )
+{
+   if (replay_diverged != 0)
+      return;
+   replay_diverged = frame;
+   WARN(_("Replay diverged from the recording at frame %u"), replay_diverged);
+}
+
+/**
+ * @brief Starts a frame.
+ *
+ * When recording, the time step and a checksum of the state are written out.
+ * When playing back, the time step is replaced by the recorded one and the
+ * checksum is compared. Events that no event loop polled are handled here so
+ * they are not lost, but they mean the playback already went its own way.
+ *
+ *    @param[in,out] dt Real time step of the frame.
+ */
+void replay_frame( double *dt )
+{
+   Uint64 t, bits;
+   uint32_t sum;
+
+   if (replay_mode == REPLAY_OFF)
+      return;
+
+   t = SDL_GetPerformanceCounter();
+   if (replay_tlast != 0)
+      array_push_back( &replay_times, (double)(t - replay_tlast) * 1000. / (double)SDL_GetPerformanceFrequency() );
+   replay_tlast = t;
+
+   if (replay_mode == REPLAY_RECORD) {
+      replay_ticks = SDL_GetTicks();
+      memcpy( &bits, dt, sizeof(bits) );
+      SDL_WriteU8( replay_rw, REPLAY_FRAME );
+      SDL_WriteLE64( replay_rw, bits );
+      SDL_WriteLE32( replay_rw, replay_ticks );
+      SDL_WriteLE32( replay_rw, replay_checksum() );
+      replay_nframes++;
+      return;
+   }
+
+   while (!replay_done) {
+      SDL_Event event;
+      int type = replay_peek();
+
+      if (type == REPLAY_EVENT) {
+         replay_diverge( replay_nframes+1 );
+         if (replay_readEvent( &event ))
+            input_handle( &event );
+      }
+      else if (type == REPLAY_FRAME) {
+         replay_next = -1;
+         bits = SDL_ReadLE64( replay_rw );
+         memcpy( dt, &bits, sizeof(bits) );
+         replay_ticks = SDL_ReadLE32( replay_rw );
+         sum = SDL_ReadLE32( replay_rw );
+         replay_nframes++;
+         if (sum != replay_checksum())
+            replay_diverge( replay_nframes );
+         return;
+      }
+      else if (type >= 0) {
+         replay_end( _("unknown record") );
+         return;
+      }
+   }
+}
+
+/**
+ * @brief Gets the tick count to use for input timing.
+ *
+ * It is the one of the current frame when recording or playing back, so both
+ * see the same.
+ */
+Uint32 replay_getTicks (void)
+{
+   if (replay_mode == REPLAY_OFF)
+      return SDL_GetTicks();
+   return replay_ticks;
+}
+
+/**
+ * @brief Runs the scripted session of the replay test and quits.
+ *
+ * Opens a dialogue that gets closed by a key press, then runs some frames.
+ * Recording it and playing it back checks that the events get handled in the
+ * same frames, which is where nested loops tend to go wrong. The key press is
+ * pushed as if it came from SDL, so it gets recorded, and it is dropped for
+ * the recorded one when playing back.
+ */
+void replay_test (void)
+{
+   SDL_Event event;
+
+   memset( &event, 0, sizeof(event) );
+   event.type = SDL_KEYDOWN;
+   event.key.state = SDL_PRESSED;
+   event.key.keysym.sym = SDLK_RETURN;
+   SDL_PushEvent( &event );
+   event.type = SDL_KEYUP;
+   event.key.state = SDL_RELEASED;
+   SDL_PushEvent( &event );
+   dialogue_msgRaw( _("Replay Test"), _("Closed by a key press.") );
+
+   for (int i=0; i<REPLAY_TEST_FRAMES; i++)
+      main_loop( 1 );
+   LOG(_("Replay test ran %u frames"), replay_nframes);
+   naev_quit();
+}
+
+/**
+ * @brief Ends the playback and quits.
+ *
+ *    @param reason Why the recording is not valid, or NULL if it just ended.
+ */
+static void replay_end( const char *reason )
+{
+   replay_done = 1;
+   if (reason != NULL)
+      WARN(_("Replay stopped after %u frames: %s"), replay_nframes, reason);
+   else
+      LOG(_("Replay finished after %u frames"), replay_nframes);
+   naev_quit();
+}
+
+/**
+ * @brief Sorts frame times.
+ */
+static int replay_cmpTime( const void *p1, const void *p2 )
+{
+   double t1 = *(const double*)p1;
+   double t2 = *(const double*)p2;
+   return (t1 > t2) - (t1 < t2);
+}
+
+/**
+ * @brief Logs the distribution of the frame times.
+ */
+static void replay_report (void)
+{
+   int n = array_size( replay_times );
+   double mean = 0.;
+
+   LOG(n_("Replay: %u frame", "Replay: %u frames", replay_nframes), replay_nframes);
+   LOG(n_("Replay: %u input event", "Replay: %u input events", replay_nevents), replay_nevents);
+   if (replay_diverged > 0)
+      LOG(_("Replay: diverged at frame %u"), replay_diverged);
+   if (n == 0)
+      return;
+
+   qsort( replay_times, n, sizeof(double), replay_cmpTime );
+   for (int i=0; i<n; i++)
+      mean += replay_times[i];
+   mean /= n;
+   LOG(_("Replay: frame time mean %.3f ms, median %.3f ms, 90%% %.3f ms, 99%% %.3f ms, max %.3f ms"),
+         mean, replay_times[n/2], replay_times[(n*9)/10], replay_times[(n*99)/100], replay_times[n-1]);
+}
@@ -0,0 +1,28 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+#pragma once
+
+/** @cond */
+#include "SDL.h"
+/** @endcond */
+
+/* Init/exit. */
+void replay_init (void);
+void replay_exit (void);
+
+/* State. */
+int replay_isRecording (void);
+int replay_isPlaying (void);
+int replay_isHeadless (void);
+int replay_isUncapped (void);
+int replay_isDeterministic (void);
+
+/* Hooks into the main loop. */
+void replay_event( const SDL_Event *event );
+int replay_pollEvent( SDL_Event *event );
+void replay_frame( double *dt );
+Uint32 replay_getTicks (void);
+
+/* Testing. */
+void replay_test (void);
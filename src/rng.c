@@ -82,6 +82,32 @@ void rng_init (void)
       mt_genArray();
 }
 
+/**
+ * @brief Reinitializes the random subsystem from a seed, so the numbers that
+ *        follow are always the same.
+ *
+ *    @param seed Seed to use.
+ */
+void rng_seed( uint32_t seed )
+{
+   mt_initArray( seed );
+   for (int i=0; i<10; i++) /* generate numbers to get away from poor initial values */
+      mt_genArray();
+}
+
+/**
+ * @brief Gets a digest of the state of the random number generator.
+ *
+ * Changes whenever a number is drawn, so two runs that drew different
+ * amounts of numbers are told apart.
+ *
+ *    @return Digest of the current state.
+ */
+uint32_t rng_state (void)
+{
+   return MT[ mt_pos % 624 ] ^ ((uint32_t)mt_pos * 2654435761U) ^ mt_y;
+}
+
 /**
  * @fn static uint32_t rng_timeEntropy (void)
  *
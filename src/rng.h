@@ -3,6 +3,10 @@
  */
 #pragma once
 
+/** @cond */
+#include <stdint.h>
+/** @endcond */
+
 /**
  * @brief Gets a random number between L and H (L <= RNG <= H).
  *
@@ -40,6 +44,8 @@
 
 /* Init */
 void rng_init (void);
+void rng_seed( uint32_t seed );
+uint32_t rng_state (void);
 
 /* Random functions */
 unsigned int randint (void);
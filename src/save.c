@@ -8,7 +8,14 @@
  */
 /** @cond */
 #include <errno.h>
+#include <fcntl.h>
 #include "physfs.h"
+#include "SDL_thread.h"
+#if WIN32
+#include <windows.h>
+#else /* WIN32 */
+#include <unistd.h>
+#endif /* WIN32 */
 
 #include "naev.h"
 /** @endcond */
@@ -34,9 +41,30 @@
 #include "plugin.h"
 #include "shiplog.h"
 #include "start.h"
+#include "threadpool.h"
 #include "unidiff.h"
 
+/**
+ * @brief A save being written out.
+ *
+ * The game state is captured into the document on the main thread, the rest
+ * only touches what is here and can run on a worker thread.
+ */
+typedef struct SaveJob_ {
+   xmlDocPtr doc;       /**< Captured game state. */
+   char *path;          /**< PhysicsFS path of the save. */
+   char index[SAVE_INDEX_MAX]; /**< Header index without the size and modification time. */
+   size_t index_len;    /**< Length of the header index, 0 if the save can't be described. */
+   Uint32 capture;      /**< Milliseconds spent capturing the state. */
+} SaveJob;
+
+#define SAVE_TEST_PILOT    "Save Test" /**< Pilot created by the save test. */
+#define SAVE_TEST_ROUNDS   3     /**< Pairs of saves compared by the save test. */
+
 int save_loaded   = 0; /**< Just loaded the saved game. */
+static time_t save_time_pinned = 0; /**< Time saves record instead of the current one, or 0. */
+static SDL_sem *save_sem = NULL; /**< Held while a save is being written. */
+static int save_result = 0; /**< Result of writing the last save, protected by save_sem. */
 
 /*
  * prototypes
@@ -62,6 +90,12 @@ extern int economy_sysSave( xmlTextWriterPtr writer ); /**< Saves the economy st
 extern int diff_save( xmlTextWriterPtr writer ); /**< Saves the universe diffs. */
 /* static */
 static int save_data( xmlTextWriterPtr writer );
+static int save_indexAdd( char *buf, size_t *l, const char *key, const char *val );
+static int save_captureIndex( SaveJob *job );
+static int save_writeIndex( const SaveJob *job );
+static int save_fsync( const char *path );
+static int save_write( void *data );
+static int save_allInternal( const char *name, int async );
 
 /**
  * @brief Saves all the player's game data.
@@ -86,6 +120,216 @@ static int save_data( xmlTextWriterPtr writer )
    return 0;
 }
 
+/**
+ * @brief Appends a "key value" line to a header index.
+ *
+ *    @return 0 on success, -1 if it can't be represented or doesn't fit.
+ */
+static int save_indexAdd( char *buf, size_t *l, const char *key, const char *val )
+{
+   if (val == NULL)
+      return 0;
+   if (strchr( val, '\n' ) != NULL)
+      return -1;
+   *l += scnprintf( &buf[*l], SAVE_INDEX_MAX-*l, "%s %s\n", key, val );
+   return (*l >= SAVE_INDEX_MAX-1) ? -1 : 0;
+}
+
+/**
+ * @brief Captures the game state part of the header index of a save.
+ *
+ *    @param job Save to capture the index of.
+ *    @return 0 on success, -1 if the save can't be described.
+ */
+static int save_captureIndex( SaveJob *job )
+{
+   char *buf = job->index;
+   const plugin_t *plugins = plugin_list();
+   int cycles, periods, seconds;
+   double rem;
+   size_t l;
+   int ret = 0;
+
+   ntime_getR( &cycles, &periods, &seconds, &rem );
+   l = scnprintf( buf, SAVE_INDEX_MAX, "credits %"CREDITS_PRI"\n", player.p->credits );
+   l += scnprintf( &buf[l], SAVE_INDEX_MAX-l, "date %d %d %d\n", cycles, periods, seconds );
+   ret |= save_indexAdd( buf, &l, "naev", naev_version( 0 ) );
+   ret |= save_indexAdd( buf, &l, "data", start_name() );
+   ret |= save_indexAdd( buf, &l, "name", player.name );
+   ret |= save_indexAdd( buf, &l, "location", (land_spob!=NULL) ? land_spob->name : NULL );
+   ret |= save_indexAdd( buf, &l, "chapter", player.chapter );
+   ret |= save_indexAdd( buf, &l, "difficulty", player.difficulty );
+   ret |= save_indexAdd( buf, &l, "ship_name", player.p->name );
+   ret |= save_indexAdd( buf, &l, "ship_model", player.p->ship->name );
+   for (int i=0; i<array_size(plugins); i++)
+      ret |= save_indexAdd( buf, &l, "plugin", plugin_name( &plugins[i] ) );
+   ret |= save_indexAdd( buf, &l, "end", "" );
+
+   job->index_len = ret ? 0 : l;
+   return ret;
+}
+
+/**
+ * @brief Writes the header index of a save.
+ *
+ * This is a small line-based file next to the save with everything the load
+ * menu displays, so listing saves doesn't need to parse each of them. It
+ * records the size and modification time of the save it describes, and is
+ * ignored if they don't match (\see load_loadIndex).
+ *
+ *    @param job Save that was just written.
+ *    @return 0 on success.
+ */
+static int save_writeIndex( const SaveJob *job )
+{
+   char buf[SAVE_INDEX_MAX], idx[PATH_MAX];
+   size_t l;
+   PHYSFS_Stat stat;
+   PHYSFS_File *f;
+   int ret = 0;
+
+   snprintf( idx, sizeof(idx), "%s"SAVE_INDEX_EXT, job->path );
+
+   /* Can't describe this save, make sure no stale index is left around. */
+   if (job->index_len == 0) {
+      PHYSFS_delete( idx );
+      return -1;
+   }
+
+   if (!PHYSFS_stat( job->path, &stat )) {
+      WARN( _("PhysicsFS: Cannot stat %s: %s"), job->path,
+            _(PHYSFS_getErrorByCode( PHYSFS_getLastErrorCode() ) ) );
+      PHYSFS_delete( idx );
+      return -1;
+   }
+
+   l = scnprintf( buf, sizeof(buf), SAVE_INDEX_HEADER"\n" );
+   l += scnprintf( &buf[l], sizeof(buf)-l, "size %"PRId64"\n", (int64_t)stat.filesize );
+   l += scnprintf( &buf[l], sizeof(buf)-l, "modtime %"PRId64"\n", (int64_t)stat.modtime );
+   if (l + job->index_len >= sizeof(buf)) {
+      PHYSFS_delete( idx );
+      return -1;
+   }
+   memcpy( &buf[l], job->index, job->index_len );
+   l += job->index_len;
+
+   f = PHYSFS_openWrite( idx );
+   if (f == NULL) {
+      WARN(_("Unable to open '%s' for writing: %s"), idx,
+            _(PHYSFS_getErrorByCode( PHYSFS_getLastErrorCode() ) ) );
+      return -1;
+   }
+   if (PHYSFS_writeBytes( f, buf, l ) != (PHYSFS_sint64)l) {
+      WARN(_("Unable to write '%s': %s"), idx,
+            _(PHYSFS_getErrorByCode( PHYSFS_getLastErrorCode() ) ) );
+      ret = -1;
+   }
+   PHYSFS_close( f );
+   if (ret)
+      PHYSFS_delete( idx );
+   return ret;
+}
+
+/**
+ * @brief Flushes a written file to disk.
+ *
+ *    @param path Real path of the file.
+ *    @return 0 on success.
+ */
+static int save_fsync( const char *path )
+{
+#if !WIN32
+   int fd, ret;
+   fd = open( path, O_RDONLY );
+   if (fd < 0)
+      return -1;
+   ret = fsync( fd );
+   close( fd );
+   return ret;
+#else /* !WIN32 */
+   (void) path;
+   return 0;
+#endif /* !WIN32 */
+}
+
+/**
+ * @brief Writes a captured save to disk.
+ *
+ * Serializes (and compresses if enabled) to a temporary file which replaces
+ * the save once it is completely on disk, so a crash at any point leaves
+ * either the old or the new save intact. Only touches the job so it can run
+ * on a worker thread, and frees it when done.
+ *
+ *    @param data SaveJob to write.
+ *    @return 0 on success.
+ */
+static int save_write( void *data )
+{
+   SaveJob *job = data;
+   char file[PATH_MAX], tmpfile[PATH_MAX];
+   Uint32 time = SDL_GetTicks();
+   int ret = -1;
+
+   snprintf( file, sizeof(file), "%s/%s", PHYSFS_getWriteDir(), job->path ); /* TODO: write via physfs */
+   snprintf( tmpfile, sizeof(tmpfile), "%s"SAVE_TMP_EXT, file );
+   if (xmlSaveFileEnc(tmpfile, job->doc, "UTF-8") < 0) {
+      WARN(_("Failed to write saved game!  You'll most likely have to restore it by copying your backup saved game over your current saved game."));
+      remove( tmpfile );
+      goto err;
+   }
+   if (save_fsync( tmpfile ))
+      WARN(_("Unable to flush '%s' to disk: %s"), tmpfile, strerror(errno));
+#if WIN32
+   /* rename() does not overwrite on Windows. */
+   if (!MoveFileEx( tmpfile, file, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH )) {
+      WARN(_("Unable to move '%s' to '%s': error %lu"), tmpfile, file, (unsigned long)GetLastError());
+      remove( tmpfile );
+      goto err;
+   }
+#else /* WIN32 */
+   if (rename( tmpfile, file )) {
+      WARN(_("Unable to move '%s' to '%s': %s"), tmpfile, file, strerror(errno));
+      remove( tmpfile );
+      goto err;
+   }
+#endif /* WIN32 */
+
+   /* Index for the load menu. Failing here just makes listing slower. */
+   save_writeIndex( job );
+   ret = 0;
+
+   if (conf.devmode) {
+      time = SDL_GetTicks() - time;
+      DEBUG( _("Saved '%s' (captured in %.3f s, written in %.3f s)"), job->path, job->capture/1000., time/1000. );
+   }
+
+err:
+   xmlFreeDoc( job->doc );
+   free( job->path );
+   free( job );
+   save_result = ret;
+   SDL_SemPost( save_sem );
+   return ret;
+}
+
+/**
+ * @brief Waits for any save being written to be done.
+ *
+ * Has to be called before reading or modifying saves on disk.
+ *
+ *    @return The result of writing the last save, 0 on success.
+ */
+int save_sync (void)
+{
+   int ret;
+   if (save_sem == NULL)
+      return 0;
+   SDL_SemWait( save_sem );
+   ret = save_result;
+   SDL_SemPost( save_sem );
+   return ret;
+}
+
 /**
  * @brief Saves the current game.
  *
@@ -99,23 +343,59 @@ int save_all (void)
 /**
  * @brief Saves the current game.
  *
+ * The game state is captured immediately, but it is written to disk in the
+ * background. Use save_sync() to wait for it to be on disk and to know
+ * whether writing it worked.
+ *
  *    @param name Name of custom snapshot.
  *    @return 0 on success.
  */
 int save_all_with_name( const char *name )
+{
+   return save_allInternal( name, 1 );
+}
+
+/**
+ * @brief Saves the current game and waits for it to be written to disk.
+ *
+ *    @param name Name of custom snapshot.
+ *    @return 0 on success.
+ */
+int save_all_with_name_sync( const char *name )
+{
+   return save_allInternal( name, 0 );
+}
+
+/**
+ * @brief Saves the current game.
+ *
+ *    @param name Name of custom snapshot.
+ *    @param async Whether to write the save to disk on a worker thread.
+ *    @return 0 on success, the result of writing is only known when not async.
+ */
+static int save_allInternal( const char *name, int async )
 {
    char file[PATH_MAX];
    const plugin_t *plugins = plugin_list();
    xmlDocPtr doc;
    xmlTextWriterPtr writer;
+   SaveJob *job;
+   Uint32 tcapture = SDL_GetTicks();
 
    /* Do not save if saving is off. */
    if (player_isFlag(PLAYER_NOSAVE))
       return 0;
 
+   /* Only one save gets written at a time. */
+   if (save_sem == NULL)
+      save_sem = SDL_CreateSemaphore( 1 );
+   SDL_SemWait( save_sem );
+
    /* Create the writer. */
    writer = xmlNewTextWriterDoc(&doc, conf.save_compress);
    if (writer == NULL) {
+      save_result = -1;
+      SDL_SemPost( save_sem );
       ERR(_("testXmlwriterDoc: Error creating the xml writer"));
       return -1;
    }
@@ -134,7 +414,7 @@ int save_all_with_name( const char *name )
    xmlw_endElem(writer); /* "version" */
 
    /* Save last played. */
-   xmlw_saveTime( writer, "last_played", time(NULL) );
+   xmlw_saveTime( writer, "last_played", save_time() );
 
    /* Save plugins. */
    xmlw_startElem(writer,"plugins");
@@ -181,25 +461,110 @@ int save_all_with_name( const char *name )
       save_loaded = 0;
    }
 
-   /* Critical section, if crashes here player's game gets corrupted.
-    * Luckily we have a copy just in case... */
    xmlFreeTextWriter(writer);
-   snprintf(file, sizeof(file), "%s/saves/%s/%s.ns", PHYSFS_getWriteDir(), player.name, name); /* TODO: write via physfs */
-   if (xmlSaveFileEnc(file, doc, "UTF-8") < 0) {
-      WARN(_("Failed to write saved game!  You'll most likely have to restore it by copying your backup saved game over your current saved game."));
-      goto err;
-   }
-   xmlFreeDoc(doc);
 
-   return 0;
+   /* Everything needed to write it out is captured now. */
+   job = calloc( 1, sizeof(SaveJob) );
+   job->doc = doc;
+   snprintf(file, sizeof(file), "saves/%s/%s.ns", player.name, name);
+   job->path = strdup( file );
+   save_captureIndex( job );
+   job->capture = SDL_GetTicks() - tcapture;
+
+   /* Critical section, if crashes while writing the player's game can get
+    * corrupted. Luckily we have a copy just in case... */
+   if (async && (threadpool_newJob( save_write, job ) == 0))
+      return 0;
+   return save_write( job );
 
 err_writer:
    xmlFreeTextWriter(writer);
-err:
    xmlFreeDoc(doc);
+   save_result = -1;
+   SDL_SemPost( save_sem );
    return -1;
 }
 
+/**
+ * @brief Gets the time saves record as the current one.
+ *
+ * It is pinned by save_test() so two saves only differ by the game state.
+ */
+time_t save_time (void)
+{
+   return (save_time_pinned != 0) ? save_time_pinned : time(NULL);
+}
+
+/**
+ * @brief Checks that saving in the background writes exactly the same file
+ *        as saving synchronously.
+ *
+ * Creates a new pilot and saves it both ways a few times, changing the game
+ * state in between, with the time the saves record pinned.
+ *
+ *    @return 0 if every pair of saves is identical.
+ */
+int save_test (void)
+{
+   const char *names[2] = { "save_test_sync", "save_test_async" };
+   char path[PATH_MAX];
+   int ret = 0;
+
+   if (player_newTest( SAVE_TEST_PILOT )) {
+      WARN(_("Save test could not create a pilot"));
+      return -1;
+   }
+
+   save_time_pinned = time(NULL);
+   for (int i=0; (i<SAVE_TEST_ROUNDS) && (ret==0); i++) {
+      char *data[2];
+      size_t len[2], off;
+
+      player_modCredits( 1000*(i+1) );
+      if ((save_all_with_name_sync( names[0] ) != 0) ||
+            (save_all_with_name( names[1] ) != 0) || (save_sync() != 0)) {
+         WARN(_("Save test could not save"));
+         ret = -1;
+         break;
+      }
+
+      for (int j=0; j<2; j++) {
+         snprintf( path, sizeof(path), "saves/%s/%s.ns", player.name, names[j] );
+         data[j] = ndata_read( path, &len[j] );
+      }
+      if ((data[0] == NULL) || (data[1] == NULL)) {
+         WARN(_("Save test could not read the saves back"));
+         ret = -1;
+      }
+      else {
+         for (off=0; (off<len[0]) && (off<len[1]) && (data[0][off]==data[1][off]); off++);
+         if ((off < len[0]) || (off < len[1])) {
+            WARN(_("Background and synchronous saves differ at byte %lu of round %d"),
+                  (unsigned long)off, i+1);
+            ret = -1;
+         }
+      }
+      free( data[0] );
+      free( data[1] );
+   }
+   save_time_pinned = 0;
+
+   /* Leave nothing behind. */
+   for (int j=0; j<2; j++) {
+      snprintf( path, sizeof(path), "saves/%s/%s.ns", player.name, names[j] );
+      PHYSFS_delete( path );
+      snprintf( path, sizeof(path), "saves/%s/%s.ns"SAVE_INDEX_EXT, player.name, names[j] );
+      PHYSFS_delete( path );
+   }
+   snprintf( path, sizeof(path), "saves/%s", player.name );
+   PHYSFS_delete( path );
+
+   if (ret == 0)
+      LOG(n_("Background and synchronous saves are identical in %d round",
+            "Background and synchronous saves are identical in %d rounds", SAVE_TEST_ROUNDS), SAVE_TEST_ROUNDS);
+   return ret;
+}
+
 /**
  * @brief Reload the current saved game.
  */
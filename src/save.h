@@ -3,6 +3,19 @@
  */
 #pragma once
 
+/** @cond */
+#include <time.h>
+/** @endcond */
+
+#define SAVE_INDEX_EXT     ".idx" /**< Appended to a save's path to get its header index. */
+#define SAVE_INDEX_HEADER  "naev_save_index 1" /**< First line of an index, bump when the format changes. */
+#define SAVE_INDEX_MAX     4096 /**< Maximum size of a header index in bytes. */
+#define SAVE_TMP_EXT       ".tmp" /**< Appended to a save's path while it is being written. */
+
 int save_all (void);
 int save_all_with_name( const char *name );
+int save_all_with_name_sync( const char *name );
+int save_sync (void);
 void save_reload (void);
+time_t save_time (void);
+int save_test (void);
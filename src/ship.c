@@ -20,12 +20,14 @@
 #include "colour.h"
 #include "conf.h"
 #include "log.h"
+#include "nameidx.h"
 #include "ndata.h"
 #include "nfile.h"
 #include "nstring.h"
 #include "nxml.h"
 #include "shipstats.h"
 #include "slots.h"
+#include "textindex.h"
 #include "toolkit.h"
 #include "unistd.h"
 
@@ -44,6 +46,9 @@
 #define STATS_DESC_MAX 256 /**< Maximum length for statistics description. */
 
 static Ship* ship_stack = NULL; /**< Stack of ships available in the game. */
+static NameIdx ship_nidx = NAMEIDX_INIT( Ship, name ); /**< Index of the ships by name. */
+static TextIndex *ship_tidx = NULL; /**< Index of all the searchable ship text. */
+static char *ship_tidx_lang = NULL; /**< Language the index was built for. */
 
 /*
  * Prototypes
@@ -52,6 +57,7 @@ static int ship_loadGFX( Ship *temp, const char *buf, int sx, int sy, int engine
 static int ship_loadPLG( Ship *temp, const char *buf, int size_hint );
 static int ship_parse( Ship *temp, const char *filename );
 static void ship_freeSlot( ShipOutfitSlot* s );
+static void ship_searchIndex (void);
 
 /**
  * @brief Compares two ship pointers for qsort.
@@ -86,8 +92,8 @@ const Ship* ship_get( const char* name )
  */
 const Ship* ship_getW( const char* name )
 {
-   const Ship s = {.name = (char*)name };
-   return bsearch( &s, ship_stack, array_size(ship_stack), sizeof(Ship), ship_cmp );
+   int i = nameidx_get( &ship_nidx, ship_stack, array_size(ship_stack), name );
+   return (i < 0) ? NULL : &ship_stack[i];
 }
 
 /**
@@ -95,10 +101,8 @@ const Ship* ship_getW( const char* name )
  */
 const char *ship_existsCase( const char* name )
 {
-   for (int i=0; i<array_size(ship_stack); i++)
-      if (strcasecmp(name,ship_stack[i].name)==0)
-         return ship_stack[i].name;
-   return NULL;
+   int i = nameidx_getCase( &ship_nidx, ship_stack, array_size(ship_stack), name );
+   return (i < 0) ? NULL : ship_stack[i].name;
 }
 
 /**
@@ -109,6 +113,53 @@ const Ship* ship_getAll (void)
    return ship_stack;
 }
 
+/**
+ * @brief Builds the search index for the current language.
+ */
+static void ship_searchIndex (void)
+{
+   int n = array_size(ship_stack);
+   const char *lang = gettext_getLanguage();
+
+   /* Still up to date. */
+   if ((ship_tidx_lang != NULL) && (strcmp( lang, ship_tidx_lang ) == 0))
+      return;
+
+   textindex_free( ship_tidx );
+   free( ship_tidx_lang );
+   ship_tidx      = textindex_create( n );
+   ship_tidx_lang = strdup( lang );
+
+   for (int i=0; i<n; i++) {
+      const Ship *s = &ship_stack[i];
+      textindex_add( ship_tidx, i, _(s->name) );
+      if (s->license != NULL)
+         textindex_add( ship_tidx, i, _(s->license) );
+      textindex_add( ship_tidx, i, _(ship_classDisplay( s )) );
+      if (s->fabricator != NULL)
+         textindex_add( ship_tidx, i, _(s->fabricator) );
+      if (s->description != NULL)
+         textindex_add( ship_tidx, i, _(s->description) );
+   }
+}
+
+/**
+ * @brief Searches the text of all the ships.
+ *
+ * Matches the same ships as running strcasestr on the translated name,
+ * license, class, fabricator and description.
+ *
+ *    @param needle String to look for, case insensitively.
+ *    @return Newly allocated array of flags indexed like ship_getAll(), set for the ships that match.
+ */
+char *ship_searchText( const char *needle )
+{
+   char *match = malloc( MAX( 1, array_size(ship_stack) ) );
+   ship_searchIndex();
+   textindex_search( ship_tidx, needle, match );
+   return match;
+}
+
 /**
  * @brief Comparison function for qsort().
  */
@@ -475,14 +526,14 @@ static int ship_loadGFX( Ship *temp, const char *buf, int sx, int sy, int engine
 
    /* Load the 3d model */
    snprintf(str, sizeof(str), SHIP_3DGFX_PATH"%s/%s/%s.obj", base, buf, buf);
-   if (PHYSFS_exists(str)) {
+   if (ndata_exists(str)) {
       temp->gfx_3d = object_loadFromFile(str);
    }
 
    /* Load the space sprite. */
    ext = ".webp";
    snprintf( str, sizeof(str), SHIP_GFX_PATH"%s/%s%s", base, buf, ext );
-   if (!PHYSFS_exists(str)) {
+   if (!ndata_exists(str)) {
       ext = ".png";
       snprintf( str, sizeof(str), SHIP_GFX_PATH"%s/%s%s", base, buf, ext );
    }
@@ -520,7 +571,7 @@ static int ship_loadPLG( Ship *temp, const char *buf, int size_hint )
    snprintf( file, sizeof(file), "%s%s.xml", SHIP_POLYGON_PATH, buf );
 
    /* See if the file does exist. */
-   if (!PHYSFS_exists(file)) {
+   if (!ndata_exists(file)) {
       WARN(_("%s xml collision polygon does not exist!\n \
                Please use the script 'polygon_from_sprite.py' if sprites are used,\n \
                And 'polygonSTL.py' if 3D model is used in game.\n \
@@ -1045,9 +1096,14 @@ int ships_load (void)
       free( ship_files[i] );
    }
    qsort( ship_stack, array_size(ship_stack), sizeof(Ship), ship_cmp );
+   nameidx_invalidate( &ship_nidx );
 
    /* Shrink stack. */
    array_shrink(&ship_stack);
+
+   /* Index the text for searching. */
+   ship_searchIndex();
+
    if (conf.devmode) {
       time = SDL_GetTicks() - time;
       DEBUG( n_( "Loaded %d Ship in %.3f s", "Loaded %d Ships in %.3f s", array_size(ship_stack) ), array_size(ship_stack), time/1000. );
@@ -1122,6 +1178,13 @@ void ships_free (void)
 
    array_free(ship_stack);
    ship_stack = NULL;
+   nameidx_free( &ship_nidx );
+
+   /* Free search index. */
+   textindex_free( ship_tidx );
+   free( ship_tidx_lang );
+   ship_tidx      = NULL;
+   ship_tidx_lang = NULL;
 }
 
 static void ship_freeSlot( ShipOutfitSlot* s )
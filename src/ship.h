@@ -181,6 +181,7 @@ const Ship* ship_get( const char* name );
 const Ship* ship_getW( const char* name );
 const char *ship_existsCase( const char* name );
 const Ship* ship_getAll (void);
+char *ship_searchText( const char *needle );
 const char* ship_class( const Ship* s );
 const char* ship_classDisplay( const Ship* s );
 const char *ship_classToString( ShipClass class );
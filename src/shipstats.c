@@ -187,6 +187,26 @@ static const ShipStatsLookup ss_lookup[] = {
    N__ELEM( SS_TYPE_SENTINEL )
 };
 
+/**
+ * @brief Contiguous block of ShipStats fields that get merged the same way.
+ */
+typedef struct ShipStatsBlock_ {
+   size_t start;  /**< Byte offset of the first field. */
+   size_t end;    /**< Byte offset past the last field. */
+} ShipStatsBlock;
+#define SS_BLOCK( first, last ) \
+   { .start=offsetof( ShipStats, first ), .end=offsetof( ShipStats, last )+sizeof(((ShipStats*)NULL)->last) }
+static const ShipStatsBlock ss_blockMul = SS_BLOCK( speed_mod, mining_bonus ); /**< Doubles that get multiplied. */
+static const ShipStatsBlock ss_blockAdd = SS_BLOCK( speed, jam_chance ); /**< Doubles that get added. */
+static const ShipStatsBlock ss_blockInt = SS_BLOCK( fuel, crew ); /**< Integers that get added. */
+static const ShipStatsBlock ss_blockBool = SS_BLOCK( misc_hidden_jump_detect, misc_reverse_thrust ); /**< Booleans that get or'd. */
+
+/**
+ * @brief Stat names sorted alphabetically for looking them up.
+ */
+static ShipStatsType ss_sorted[ SS_TYPE_SENTINEL ];
+static int ss_nsorted = 0; /**< Number of elements in ss_sorted, 0 until it is built. */
+
 /*
  * Prototypes.
  */
@@ -327,11 +347,38 @@ int ss_sort( ShipStatList **ll )
 int ss_check (void)
 {
    for (ShipStatsType i=0; i<=SS_TYPE_SENTINEL; i++) {
+      const ShipStatsBlock *blk;
+
       if (ss_lookup[i].type != i) {
          WARN(_("ss_lookup: %s should have id %d but has %d"),
                ss_lookup[i].name, i, ss_lookup[i].type );
          return -1;
       }
+      if (ss_lookup[i].name == NULL)
+         continue;
+
+      /* Has to be in the block that gets merged the right way. */
+      switch (ss_lookup[i].data) {
+         case SS_DATA_TYPE_DOUBLE:
+            blk = &ss_blockMul;
+            break;
+         case SS_DATA_TYPE_DOUBLE_ABSOLUTE:
+         case SS_DATA_TYPE_DOUBLE_ABSOLUTE_PERCENT:
+            blk = &ss_blockAdd;
+            break;
+         case SS_DATA_TYPE_INTEGER:
+            blk = &ss_blockInt;
+            break;
+         case SS_DATA_TYPE_BOOLEAN:
+         default:
+            blk = &ss_blockBool;
+            break;
+      }
+      if ((ss_lookup[i].offset < blk->start) || (ss_lookup[i].offset >= blk->end)) {
+         WARN(_("ss_lookup: %s is not in the ShipStats block matching its type"),
+               ss_lookup[i].name );
+         return -1;
+      }
    }
 
    return 0;
@@ -342,38 +389,17 @@ int ss_check (void)
  */
 int ss_statsInit( ShipStats *stats )
 {
-   char *ptr;
+   double *mul;
+   size_t n;
 
    /* Clear the memory. */
    memset( stats, 0, sizeof(ShipStats) );
 
-   ptr = (char*) stats;
-   for (int i=0; i<SS_TYPE_SENTINEL; i++) {
-      const ShipStatsLookup *sl = &ss_lookup[ i ];
-
-      /* Only want valid names. */
-      if (sl->name == NULL)
-         continue;
-
-      /* Handle doubles. */
-      switch (sl->data) {
-         case SS_DATA_TYPE_DOUBLE:
-            {
-               double *dbl;
-               char *fieldptr = &ptr[ sl->offset ];
-               memcpy(&dbl, &fieldptr, sizeof(double*));
-               *dbl  = 1.0;
-               break;
-            }
-
-            /* No need to set, memset does the work. */
-         case SS_DATA_TYPE_DOUBLE_ABSOLUTE:
-         case SS_DATA_TYPE_DOUBLE_ABSOLUTE_PERCENT:
-         case SS_DATA_TYPE_INTEGER:
-         case SS_DATA_TYPE_BOOLEAN:
-            break;
-      }
-   }
+   /* Multipliers default to 1, the rest is handled by memset. */
+   mul = (double*) &((char*)stats)[ ss_blockMul.start ];
+   n = (ss_blockMul.end-ss_blockMul.start) / sizeof(double);
+   for (size_t i=0; i<n; i++)
+      mul[i] = 1.0;
 
    return 0;
 }
@@ -386,49 +412,41 @@ int ss_statsInit( ShipStats *stats )
  */
 int ss_statsMerge( ShipStats *dest, const ShipStats *src )
 {
-   int *destint;
-   const int *srcint;
-   double *destdbl;
-   const double *srcdbl;
-   char *destptr;
-   const char *srcptr;
-
-   destptr = (char*) dest;
-   srcptr = (const char*) src;
-   for (int i=0; i<SS_TYPE_SENTINEL; i++) {
-      const ShipStatsLookup *sl = &ss_lookup[ i ];
-
-      /* Only want valid names. */
-      if (sl->name == NULL)
-         continue;
-
-      switch (sl->data) {
-         case SS_DATA_TYPE_DOUBLE:
-            destdbl = (double*) &destptr[ sl->offset ];
-            srcdbl = (const double*) &srcptr[ sl->offset ];
-            *destdbl = (*destdbl) * (*srcdbl);
-            break;
-
-         case SS_DATA_TYPE_DOUBLE_ABSOLUTE:
-         case SS_DATA_TYPE_DOUBLE_ABSOLUTE_PERCENT:
-            destdbl = (double*) &destptr[ sl->offset ];
-            srcdbl = (const double*) &srcptr[ sl->offset ];
-            *destdbl = (*destdbl) + (*srcdbl);
-            break;
-
-         case SS_DATA_TYPE_INTEGER:
-            destint = (int*) &destptr[ sl->offset ];
-            srcint = (const int*) &srcptr[ sl->offset ];
-            *destint = (*destint) + (*srcint);
-            break;
-
-         case SS_DATA_TYPE_BOOLEAN:
-            destint = (int*) &destptr[ sl->offset ];
-            srcint = (const int*) &srcptr[ sl->offset ];
-            *destint = !!((*destint) + (*srcint));
-            break;
-      }
-   }
+   char *destptr = (char*) dest;
+   const char *srcptr = (const char*) src;
+   double *restrict destdbl;
+   const double *restrict srcdbl;
+   int *restrict destint;
+   const int *restrict srcint;
+   size_t n;
+
+   /* Multiplicative doubles. */
+   destdbl = (double*) &destptr[ ss_blockMul.start ];
+   srcdbl = (const double*) &srcptr[ ss_blockMul.start ];
+   n = (ss_blockMul.end-ss_blockMul.start) / sizeof(double);
+   for (size_t i=0; i<n; i++)
+      destdbl[i] *= srcdbl[i];
+
+   /* Additive doubles. */
+   destdbl = (double*) &destptr[ ss_blockAdd.start ];
+   srcdbl = (const double*) &srcptr[ ss_blockAdd.start ];
+   n = (ss_blockAdd.end-ss_blockAdd.start) / sizeof(double);
+   for (size_t i=0; i<n; i++)
+      destdbl[i] += srcdbl[i];
+
+   /* Integers. */
+   destint = (int*) &destptr[ ss_blockInt.start ];
+   srcint = (const int*) &srcptr[ ss_blockInt.start ];
+   n = (ss_blockInt.end-ss_blockInt.start) / sizeof(int);
+   for (size_t i=0; i<n; i++)
+      destint[i] += srcint[i];
+
+   /* Booleans. */
+   destint = (int*) &destptr[ ss_blockBool.start ];
+   srcint = (const int*) &srcptr[ ss_blockBool.start ];
+   n = (ss_blockBool.end-ss_blockBool.start) / sizeof(int);
+   for (size_t i=0; i<n; i++)
+      destint[i] = !!(destint[i] + srcint[i]);
 
    return 0;
 }
@@ -583,17 +601,48 @@ size_t ss_offsetFromType( ShipStatsType type )
    return ss_lookup[ type ].offset;
 }
 
+/**
+ * @brief Compares two stat types by name.
+ */
+static int ss_sortedCmp( const void *a, const void *b )
+{
+   const ShipStatsType *ta = (const ShipStatsType*) a;
+   const ShipStatsType *tb = (const ShipStatsType*) b;
+   return strcmp( ss_lookup[ *ta ].name, ss_lookup[ *tb ].name );
+}
+
+/**
+ * @brief Compares a name with a stat type.
+ */
+static int ss_sortedSearch( const void *key, const void *elem )
+{
+   const ShipStatsType *t = (const ShipStatsType*) elem;
+   return strcmp( (const char*) key, ss_lookup[ *t ].name );
+}
+
 /**
  * @brief Gets the type from the name.
  *
+ * O(log n) look up on a table sorted by name that is built on first use.
+ *
  *    @param name Name to get type of.
  *    @return Type matching the name.
  */
 ShipStatsType ss_typeFromName( const char *name )
 {
-   for (int i=0; i<SS_TYPE_SENTINEL; i++)
-      if ((ss_lookup[i].name != NULL) && (strcmp(name,ss_lookup[i].name)==0))
-         return ss_lookup[i].type;
+   const ShipStatsType *t;
+
+   /* Build the sorted table. */
+   if (ss_nsorted == 0) {
+      for (int i=0; i<SS_TYPE_SENTINEL; i++)
+         if (ss_lookup[i].name != NULL)
+            ss_sorted[ ss_nsorted++ ] = ss_lookup[i].type;
+      qsort( ss_sorted, ss_nsorted, sizeof(ShipStatsType), ss_sortedCmp );
+   }
+
+   t = bsearch( name, ss_sorted, ss_nsorted, sizeof(ShipStatsType), ss_sortedSearch );
+   if (t != NULL)
+      return *t;
 
    WARN(_("ss_typeFromName: No ship stat matching '%s'"), name);
    return SS_TYPE_NIL;
@@ -177,6 +177,10 @@ typedef struct ShipStatList_ {
 /**
  * @brief Represents ship statistics, properties ship can use.
  *
+ * The fields are grouped in contiguous blocks by how they get merged, so that
+ * ss_statsMerge() can go over each block as an array. Every stat has to go in
+ * the block matching its type, ss_check() makes sure of it.
+ *
  * Doubles:
  *  These are normalized and centered around 1 so they are in the [0:2]
  *  range, with 1. being default. This value then modulates the stat's base
@@ -195,40 +199,26 @@ typedef struct ShipStatList_ {
  *  1 or 0 values wher 1 indicates property is set.
  */
 typedef struct ShipStats_ {
+   /*
+    * Doubles, merged by multiplying. Must start with speed_mod and end with mining_bonus.
+    */
    /* Movement. */
-   double speed;              /**< Speed modifier. */
-   double turn;               /**< Turn modifier. */
-   double thrust;             /**< Thrust modifier. */
    double speed_mod;          /**< Speed multiplier. */
    double turn_mod;           /**< Turn multiplier. */
    double thrust_mod;         /**< Thrust multiplier. */
 
    /* Health. */
-   double energy;             /**< Energy modifier. */
-   double energy_regen;       /**< Energy regeneration modifier. */
    double energy_mod;         /**< Energy multiplier. */
    double energy_regen_mod;   /**< Energy regeneration multiplier. */
-   double energy_regen_malus; /**< Energy usage (flat). */
-   double energy_loss;        /**< Energy modifier (flat and linear). */
-   double shield;             /**< Shield modifier. */
-   double shield_regen;       /**< Shield regeneration modifier. */
    double shield_mod;         /**< Shield multiplier. */
    double shield_regen_mod;   /**< Shield regeneration multiplier. */
-   double shield_regen_malus; /**< Shield usage (flat). */
-   double armour;             /**< Armour modifier. */
-   double armour_regen;       /**< Armour regeneration modifier. */
    double armour_mod;         /**< Armour multiplier. */
    double armour_regen_mod;   /**< Armour regeneration multiplier. */
-   double armour_regen_malus; /**< Armour regeneration (flat). */
-   double damage;             /**< Damage over time. */
-   double disable;            /**< Disable over time. */
 
    /* General */
    double cargo_mod;          /**< Cargo space multiplier. */
    double fuel_mod;           /**< Fuel capacity multiplier. */
    double cpu_mod;            /**< CPU multiplier. */
-   double cpu_max;            /**< CPU modifier. */
-   double absorb;             /**< Flat damage absorption. */
 
    /* Freighter-type. */
    double jump_delay;      /**< Modulates the time that passes during a hyperspace jump. */
@@ -283,31 +273,61 @@ typedef struct ShipStats_ {
    double tur_energy;      /**< Consumption rate of turrets. */
    double tur_dam_as_dis;  /**< Damage as disable for turrets. */
 
-   /* Jamming. */
-   double jam_chance;      /**< Jamming chance. */
-
-   /* Engine limits. */
-   double engine_limit_rel; /**< Engine limit modifier. */
-   double engine_limit;     /**< Engine limit. */
-
    /* Misc. */
-   double nebu_absorb;     /**< Shield nebula resistance. */
-   double nebu_visibility; /**< Nebula visibility. */
-   int misc_instant_jump;  /**< Do not require brake or chargeup to jump. */
-   int misc_reverse_thrust;/**< Slows down the ship instead of turning it around. */
-   double asteroid_scan;   /**< Distance at which asteroids can be scanned. */
-   double mining_bonus;    /**< Bonus when mining asteroids. */
-   int misc_hidden_jump_detect; /**< Degree of hidden jump detection. */
-   int fuel;               /**< Maximum fuel modifier. */
-   double fuel_regen;      /**< Absolute fuel regeneration. */
-   int cargo;              /**< Maximum cargo modifier. */
-   int crew;               /**< Crew modifier. */
+   double engine_limit_rel; /**< Engine limit modifier. */
    double loot_mod;        /**< Boarding loot reward bonus. */
    double time_mod;        /**< Time dilation modifier. */
    double time_speedup;    /**< Makes the pilot operate at higher speeds. */
    double cooldown_time;   /**< Modifies cooldown time. */
    double jump_distance;   /**< Modifies how far the pilot can jump from the jump point. */
    double jump_warmup;     /**< Modifies the time that is necessary to jump. */
+   double mining_bonus;    /**< Bonus when mining asteroids. */
+
+   /*
+    * Absolute doubles and percents, merged by adding. Must start with speed and end with jam_chance.
+    */
+   /* Movement. */
+   double speed;              /**< Speed modifier. */
+   double turn;               /**< Turn modifier. */
+   double thrust;             /**< Thrust modifier. */
+
+   /* Health. */
+   double energy;             /**< Energy modifier. */
+   double energy_regen;       /**< Energy regeneration modifier. */
+   double energy_regen_malus; /**< Energy usage (flat). */
+   double energy_loss;        /**< Energy modifier (flat and linear). */
+   double shield;             /**< Shield modifier. */
+   double shield_regen;       /**< Shield regeneration modifier. */
+   double shield_regen_malus; /**< Shield usage (flat). */
+   double armour;             /**< Armour modifier. */
+   double armour_regen;       /**< Armour regeneration modifier. */
+   double armour_regen_malus; /**< Armour regeneration (flat). */
+   double damage;             /**< Damage over time. */
+   double disable;            /**< Disable over time. */
+
+   /* Misc. */
+   double cpu_max;            /**< CPU modifier. */
+   double engine_limit;     /**< Engine limit. */
+   double fuel_regen;      /**< Absolute fuel regeneration. */
+   double asteroid_scan;   /**< Distance at which asteroids can be scanned. */
+   double nebu_visibility; /**< Nebula visibility. */
+   double absorb;             /**< Flat damage absorption. */
+   double nebu_absorb;     /**< Shield nebula resistance. */
+   double jam_chance;      /**< Jamming chance. */
+
+   /*
+    * Integers, merged by adding. Must start with fuel and end with crew.
+    */
+   int fuel;               /**< Maximum fuel modifier. */
+   int cargo;              /**< Maximum cargo modifier. */
+   int crew;               /**< Crew modifier. */
+
+   /*
+    * Booleans, merged with or. Must start with misc_hidden_jump_detect and end with misc_reverse_thrust.
+    */
+   int misc_hidden_jump_detect; /**< Degree of hidden jump detection. */
+   int misc_instant_jump;  /**< Do not require brake or chargeup to jump. */
+   int misc_reverse_thrust;/**< Slows down the ship instead of turning it around. */
 } ShipStats;
 
 /*
@@ -56,6 +56,7 @@
 #include "player.h"
 #include "nopenal.h"
 #include "nlua_spfx.h"
+#include "threadpool.h"
 
 #define SOUND_FADEOUT         100
 #define SOUND_VOICES           64   /**< Maximum number of simultaneous sounds to play, must be at least 16. */
@@ -77,8 +78,34 @@ typedef struct alSound_ {
    double length; /**< Length of the buffer. */
    int channels; /**< Number of channels of the buffer. */
    ALuint buf; /**< Buffer data. */
+   int loaded; /**< 1 if the buffer is uploaded, 0 if not decoded yet and -1 if decoding failed. */
 } alSound;
 
+/**
+ * @struct alSoundPCM
+ *
+ * @brief Decoded sound data waiting to be uploaded to OpenAL.
+ */
+typedef struct alSoundPCM_ {
+   ALenum format; /**< OpenAL format of the data. */
+   ALsizei freq; /**< Sample rate. */
+   int channels; /**< Number of channels. */
+   int bits; /**< Bits per sample. */
+   void *data; /**< Sample data. */
+   ALsizei size; /**< Size of the sample data in bytes. */
+} alSoundPCM;
+
+/**
+ * @struct SoundDecodeJob
+ *
+ * @brief Sound decoded by a worker thread at start up.
+ */
+typedef struct SoundDecodeJob_ {
+   alSound *snd; /**< Sound to decode. */
+   alSoundPCM pcm; /**< Decoded data. */
+   int ret; /**< Result of decoding. */
+} SoundDecodeJob;
+
 /**
  * @typedef voice_state_t
  * @brief The state of a voice.
@@ -158,6 +185,11 @@ static double snd_compression_gain = 0.; /**< Current compression gain. */
  */
 /* General. */
 static int sound_makeList (void);
+static void sound_loadAll (void);
+static int sound_decodeJob( void *data );
+static int sound_decode( const alSound *snd, alSoundPCM *pcm );
+static void sound_upload( alSound *snd, alSoundPCM *pcm, const char *name );
+static int sound_load( alSound *snd );
 static void sound_free( alSound *snd );
 /* Voices. */
 
@@ -222,8 +254,10 @@ static int al_enableEFX (void);
 static int al_playVoice( alVoice *v, alSound *s,
       ALfloat px, ALfloat py, ALfloat vx, ALfloat vy, ALint relative );
 static int al_load( alSound *snd, SDL_RWops *rw, const char *name );
-static int al_loadWav( ALuint *buf, SDL_RWops *rw );
-static int al_loadOgg( ALuint *buf, OggVorbis_File *vf );
+static int al_decode( alSoundPCM *pcm, SDL_RWops *rw, const char *name );
+static int al_decodeWav( alSoundPCM *pcm, SDL_RWops *rw );
+static int al_decodeOgg( alSoundPCM *pcm, OggVorbis_File *vf );
+static void al_upload( ALuint *buf, alSoundPCM *pcm );
 /*
  * Pausing.
  */
@@ -617,9 +651,9 @@ int sound_init (void)
       music_disabled = 1;
    }
 
-   /* Parse conf. */
+   /* Parse conf. Sounds still get registered so that their names resolve. */
    if (sound_disabled && music_disabled)
-      return 0;
+      return sound_makeList();
 
    /* Initialize sound backend. */
    ret = sound_al_init();
@@ -627,6 +661,7 @@ int sound_init (void)
       sound_disabled = 1;
       music_disabled = 1;
       WARN(_("Sound disabled."));
+      sound_makeList();
       return ret;
    }
 
@@ -672,9 +707,14 @@ int sound_init (void)
  */
 void sound_exit (void)
 {
-   /* Nothing to disable. */
-   if (sound_disabled || !sound_initialized)
+   /* Nothing to disable, but sounds may have been registered. */
+   if (sound_disabled || !sound_initialized) {
+      for (int i=0; i<array_size(sound_list); i++)
+         sound_free( &sound_list[i] );
+      array_free( sound_list );
+      sound_list = NULL;
       return;
+   }
 
    if (voice_mutex != NULL) {
       voiceLock();
@@ -729,6 +769,7 @@ void sound_exit (void)
    for (int i=0; i<array_size(sound_list); i++)
       sound_free( &sound_list[i] );
    array_free( sound_list );
+   sound_list = NULL;
 
    /* Clean up EFX stuff. */
    if (al_info.efx == AL_TRUE) {
@@ -763,9 +804,6 @@ void sound_exit (void)
  */
 int sound_get( const char* name )
 {
-   if (sound_disabled)
-      return 0;
-
    for (int i=0; i<array_size(sound_list); i++)
       if (strcmp(name, sound_list[i].name)==0)
          return i;
@@ -785,6 +823,13 @@ double sound_getLength( int sound )
    if (sound_disabled)
       return 0.;
 
+   if ((sound < 0) || (sound >= array_size(sound_list)))
+      return 0.;
+
+   /* Length is only known once decoded. */
+   if (sound_load( &sound_list[sound] ))
+      return 0.;
+
    return sound_list[sound].length;
 }
 
@@ -805,11 +850,13 @@ int sound_play( int sound )
    if ((sound < 0) || (sound >= array_size(sound_list)))
       return -1;
 
-   /* Gets a new voice. */
-   v = voice_new();
-
    /* Get the sound. */
    s = &sound_list[sound];
+   if (sound_load( s ))
+      return -1;
+
+   /* Gets a new voice. */
+   v = voice_new();
 
    /* Try to play the sound. */
    if (al_playVoice( v, s, 0., 0., 0., 0., AL_TRUE ))
@@ -862,11 +909,13 @@ int sound_playPos( int sound, double px, double py, double vx, double vy )
          return 0;
    }
 
-   /* Gets a new voice. */
-   v = voice_new();
-
    /* Get the sound. */
    s = &sound_list[sound];
+   if (sound_load( s ))
+      return -1;
+
+   /* Gets a new voice. */
+   v = voice_new();
 
    /* Try to play the sound. */
    if (al_playVoice( v, s, px, py, vx, vy, AL_FALSE ))
@@ -1209,14 +1258,15 @@ void sound_setSpeed( double s )
 
 /**
  * @brief Makes the list of available sounds.
+ *
+ * Sounds are only registered here. Unless decoding is deferred to first use
+ *  with the sound_lazy option, they are then all decoded in parallel.
  */
 static int sound_makeList (void)
 {
    char** files;
    int suflen;
-
-   if (sound_disabled)
-      return 0;
+   Uint32 time = SDL_GetTicks();
 
    /* get the file list */
    files = PHYSFS_enumerateFiles( SOUND_PATH );
@@ -1227,9 +1277,8 @@ static int sound_makeList (void)
    /* load the profiles */
    suflen = strlen(SOUND_SUFFIX_WAV);
    for (size_t i=0; files[i]!=NULL; i++) {
-      int len;
       char path[PATH_MAX];
-      SDL_RWops *rw;
+      alSound *snd;
       int flen = strlen(files[i]);
 
       /* Must be longer than suffix. */
@@ -1241,19 +1290,27 @@ static int sound_makeList (void)
             (strncmp( &files[i][flen - suflen], SOUND_SUFFIX_OGG, suflen)!=0))
          continue;
 
-      /* Load the sound. */
+      /* Register the sound. */
       snprintf( path, sizeof(path), SOUND_PATH"%s", files[i] );
-      rw = PHYSFSRWOPS_openRead( path );
+      snd = &array_grow( &sound_list );
+      memset( snd, 0, sizeof(alSound) );
+      snd->filename = strdup( path );
 
       /* remove the suffix */
-      len = flen - suflen;
-      files[i][len] = '\0';
-
-      source_newRW( rw, files[i], 0 );
-      SDL_RWclose( rw );
+      files[i][flen - suflen] = '\0';
+      snd->name = strdup( files[i] );
    }
 
-   DEBUG( n_("Loaded %d Sound", "Loaded %d Sounds", array_size(sound_list)), array_size(sound_list) );
+   /* Decode everything up front. */
+   if (!sound_disabled && !conf.sound_lazy)
+      sound_loadAll();
+
+   if (conf.devmode) {
+      time = SDL_GetTicks() - time;
+      DEBUG( n_("Loaded %d Sound in %.3f s", "Loaded %d Sounds in %.3f s", array_size(sound_list)), array_size(sound_list), time/1000. );
+   }
+   else
+      DEBUG( n_("Loaded %d Sound", "Loaded %d Sounds", array_size(sound_list)), array_size(sound_list) );
 
    /* Clean up. */
    PHYSFS_freeList( files );
@@ -1261,6 +1318,114 @@ static int sound_makeList (void)
    return 0;
 }
 
+/**
+ * @brief Decodes all the registered sounds on the threadpool.
+ *
+ * Decoding happens on the worker threads, while the OpenAL uploads are done
+ *  afterwards from the calling thread.
+ */
+static void sound_loadAll (void)
+{
+   int n = 0;
+   SoundDecodeJob *jobs;
+
+   jobs = calloc( array_size(sound_list), sizeof(SoundDecodeJob) );
+   for (int i=0; i<array_size(sound_list); i++)
+      if (!sound_list[i].loaded)
+         jobs[n++].snd = &sound_list[i];
+
+   /* Decode on the threadpool. */
+   if (n > 0) {
+      ThreadQueue *queue = vpool_create();
+      for (int i=0; i<n; i++)
+         vpool_enqueue( queue, sound_decodeJob, &jobs[i] );
+      vpool_wait( queue );
+   }
+
+   /* Upload to OpenAL. */
+   for (int i=0; i<n; i++) {
+      if (jobs[i].ret == 0)
+         sound_upload( jobs[i].snd, &jobs[i].pcm, jobs[i].snd->filename );
+      else
+         jobs[i].snd->loaded = -1;
+   }
+   free( jobs );
+}
+
+/**
+ * @brief Threadpool wrapper for sound_decode.
+ */
+static int sound_decodeJob( void *data )
+{
+   SoundDecodeJob *job = data;
+   job->ret = sound_decode( job->snd, &job->pcm );
+   return job->ret;
+}
+
+/**
+ * @brief Decodes a registered sound from its file. Does not touch OpenAL.
+ *
+ *    @param snd Sound to decode.
+ *    @param[out] pcm Decoded data.
+ *    @return 0 on success.
+ */
+static int sound_decode( const alSound *snd, alSoundPCM *pcm )
+{
+   int ret;
+   SDL_RWops *rw = PHYSFSRWOPS_openRead( snd->filename );
+   if (rw == NULL) {
+      WARN(_("Failed to load sound file '%s'."), snd->filename);
+      return -1;
+   }
+   ret = al_decode( pcm, rw, snd->filename );
+   SDL_RWclose( rw );
+   return ret;
+}
+
+/**
+ * @brief Uploads decoded data to a sound's OpenAL buffer.
+ *
+ *    @param snd Sound to upload to.
+ *    @param pcm Decoded data, gets freed.
+ *    @param name Name for debugging purposes.
+ */
+static void sound_upload( alSound *snd, alSoundPCM *pcm, const char *name )
+{
+   if ((pcm->freq==0) || (pcm->bits==0) || (pcm->channels==0)) {
+      WARN(_("Something went wrong when loading sound file '%s'."), name);
+      snd->length = 0;
+   }
+   else
+      snd->length = (double)pcm->size / (double)(pcm->freq * (pcm->bits/8) * pcm->channels);
+   snd->channels = pcm->channels;
+
+   al_upload( &snd->buf, pcm );
+   snd->loaded = 1;
+}
+
+/**
+ * @brief Makes sure a sound is decoded and uploaded, loading it if needed.
+ *
+ *    @param snd Sound to load.
+ *    @return 0 if the sound is ready to play.
+ */
+static int sound_load( alSound *snd )
+{
+   alSoundPCM pcm;
+
+   if (snd->loaded > 0)
+      return 0;
+   if (snd->loaded < 0)
+      return -1;
+
+   if (sound_decode( snd, &pcm )) {
+      snd->loaded = -1;
+      return -1;
+   }
+   sound_upload( snd, &pcm, snd->filename );
+   return 0;
+}
+
 /**
  * @brief Sets the volume.
  *
@@ -1323,6 +1488,9 @@ static void sound_free( alSound *snd )
    free(snd->filename);
 
    /* Free internals. */
+   if (snd->loaded <= 0)
+      return;
+
    soundLock();
 
    alDeleteBuffers( 1, &snd->buf );
@@ -1420,6 +1588,8 @@ int sound_playGroup( int group, int sound, int once )
       return -1;
 
    s = &sound_list[sound];
+   if (sound_load( s ))
+      return -1;
    for (int i=0; i<al_ngroups; i++) {
       alGroup_t *g;
 
@@ -1801,6 +1971,7 @@ int source_newRW( SDL_RWops *rw, const char *name, unsigned int flags )
    sndl = &array_grow( &sound_list );
    memcpy( sndl, &snd, sizeof(alSound) );
    sndl->name = strdup( name );
+   sndl->loaded = 1;
 
    return sndl-sound_list;
 }
@@ -1857,19 +2028,16 @@ static alGroup_t *al_getGroup( int group )
 }
 
 /**
- * @brief Loads a wav file from the rw if possible.
- *
- * @note Closes the rw.
+ * @brief Decodes a wav file from the rw if possible.
  *
- *    @param buf Buffer to load wav into.
+ *    @param[out] pcm Decoded data.
  *    @param rw Data for the wave.
  */
-static int al_loadWav( ALuint *buf, SDL_RWops *rw )
+static int al_decodeWav( alSoundPCM *pcm, SDL_RWops *rw )
 {
    SDL_AudioSpec wav_spec;
    Uint32 wav_length;
    Uint8 *wav_buffer;
-   ALenum format;
 
    SDL_RWseek( rw, 0, SEEK_SET );
 
@@ -1883,32 +2051,28 @@ static int al_loadWav( ALuint *buf, SDL_RWops *rw )
    switch (wav_spec.format) {
       case AUDIO_U8:
       case AUDIO_S8:
-         format = (wav_spec.channels==1) ? AL_FORMAT_MONO8 : AL_FORMAT_STEREO8;
+         pcm->format = (wav_spec.channels==1) ? AL_FORMAT_MONO8 : AL_FORMAT_STEREO8;
+         pcm->bits   = 8;
          break;
       case AUDIO_U16LSB:
       case AUDIO_S16LSB:
-         format = (wav_spec.channels==1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+         pcm->format = (wav_spec.channels==1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+         pcm->bits   = 16;
          break;
       case AUDIO_U16MSB:
       case AUDIO_S16MSB:
          WARN( _("Big endian WAVs unsupported!") );
+         free( wav_buffer );
          return -1;
       default:
          WARN( _("Invalid WAV format!") );
+         free( wav_buffer );
          return -1;
    }
-
-   /* Load into openal. */
-   soundLock();
-   /* Create new buffer. */
-   alGenBuffers( 1, buf );
-   /* Put into the buffer. */
-   alBufferData( *buf, format, wav_buffer, wav_length, wav_spec.freq );
-   al_checkErr();
-   soundUnlock();
-
-   /* Clean up. */
-   free( wav_buffer );
+   pcm->freq     = wav_spec.freq;
+   pcm->channels = wav_spec.channels;
+   pcm->data     = wav_buffer;
+   pcm->size     = wav_length;
    return 0;
 }
 
@@ -1933,18 +2097,17 @@ static const char* vorbis_getErr( int err )
 }
 
 /**
- * @brief Loads an ogg file from a tested format if possible.
+ * @brief Decodes an ogg file from a tested format if possible.
  *
- *    @param buf Buffer to load ogg into.
+ *    @param[out] pcm Decoded data.
  *    @param vf Vorbisfile containing the song.
  */
-static int al_loadOgg( ALuint *buf, OggVorbis_File *vf )
+static int al_decodeOgg( alSoundPCM *pcm, OggVorbis_File *vf )
 {
    int ret;
    long i;
    int section;
    vorbis_info *info;
-   ALenum format;
    ogg_int64_t len;
    char *data;
    long bytes_read;
@@ -1958,7 +2121,6 @@ static int al_loadOgg( ALuint *buf, OggVorbis_File *vf )
 
    /* Get file information. */
    info   = ov_info( vf, -1 );
-   format = (info->channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
    len    = ov_pcm_total( vf, -1 ) * info->channels * sizeof(short);
 
    /* Allocate memory. */
@@ -1977,36 +2139,38 @@ static int al_loadOgg( ALuint *buf, OggVorbis_File *vf )
       i += bytes_read;
    }
 
-   soundLock();
-   /* Create new buffer. */
-   alGenBuffers( 1, buf );
-   /* Put into buffer. */
-   alBufferData( *buf, format, data, len, info->rate );
-   al_checkErr();
-   soundUnlock();
+   pcm->format   = (info->channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+   pcm->freq     = info->rate;
+   pcm->channels = info->channels;
+   pcm->bits     = 16;
+   pcm->data     = data;
+   pcm->size     = len;
 
    /* Clean up. */
-   free(data);
    ov_clear(vf);
 
    return 0;
 }
 
 /**
- * @brief Loads the sound.
+ * @brief Decodes a sound without touching OpenAL, so it is safe to call from
+ *        worker threads.
  *
- *    @param buf Buffer to load.
+ *    @param[out] pcm Decoded data.
  *    @param rw File to load from.
  *    @param name Name for debugging purposes.
+ *    @return 0 on success.
  */
-int sound_al_buffer( ALuint *buf, SDL_RWops *rw, const char *name )
+static int al_decode( alSoundPCM *pcm, SDL_RWops *rw, const char *name )
 {
    int ret;
    OggVorbis_File vf;
 
+   memset( pcm, 0, sizeof(alSoundPCM) );
+
    /* Check to see if it's an Ogg. */
    if (ov_test_callbacks( rw, &vf, NULL, 0, sound_al_ovcall_noclose )==0)
-      ret = al_loadOgg( buf, &vf );
+      ret = al_decodeOgg( pcm, &vf );
 
    /* Otherwise try WAV. */
    else {
@@ -2014,22 +2178,51 @@ int sound_al_buffer( ALuint *buf, SDL_RWops *rw, const char *name )
       ov_clear(&vf);
 
       /* Try to load Wav. */
-      ret = al_loadWav( buf, rw );
+      ret = al_decodeWav( pcm, rw );
    }
 
    /* Failed to load. */
-   if (ret != 0) {
+   if (ret != 0)
       WARN(_("Failed to load sound file '%s'."), name);
-      return ret;
-   }
 
-   soundLock();
+   return ret;
+}
 
-   /* Check for errors. */
+/**
+ * @brief Uploads decoded data into a new OpenAL buffer.
+ *
+ *    @param buf Buffer to create.
+ *    @param pcm Decoded data, gets freed.
+ */
+static void al_upload( ALuint *buf, alSoundPCM *pcm )
+{
+   soundLock();
+   /* Create new buffer. */
+   alGenBuffers( 1, buf );
+   /* Put into buffer. */
+   alBufferData( *buf, pcm->format, pcm->data, pcm->size, pcm->freq );
    al_checkErr();
-
    soundUnlock();
 
+   /* Clean up. */
+   free( pcm->data );
+   pcm->data = NULL;
+}
+
+/**
+ * @brief Loads the sound.
+ *
+ *    @param buf Buffer to load.
+ *    @param rw File to load from.
+ *    @param name Name for debugging purposes.
+ */
+int sound_al_buffer( ALuint *buf, SDL_RWops *rw, const char *name )
+{
+   alSoundPCM pcm;
+   int ret = al_decode( &pcm, rw, name );
+   if (ret != 0)
+      return ret;
+   al_upload( buf, &pcm );
    return 0;
 }
 
@@ -2042,33 +2235,11 @@ int sound_al_buffer( ALuint *buf, SDL_RWops *rw, const char *name )
  */
 int al_load( alSound *snd, SDL_RWops *rw, const char *name )
 {
-   ALint freq, bits, channels, size;
-   int ret = sound_al_buffer( &snd->buf, rw, name );
-   if (ret != 0) {
-      WARN(_("Failed to load sound file '%s'."), name);
+   alSoundPCM pcm;
+   int ret = al_decode( &pcm, rw, name );
+   if (ret != 0)
       return ret;
-   }
-
-   soundLock();
-
-   /* Get the length of the sound. */
-   alGetBufferi( snd->buf, AL_FREQUENCY, &freq );
-   alGetBufferi( snd->buf, AL_BITS, &bits );
-   alGetBufferi( snd->buf, AL_CHANNELS, &channels );
-   alGetBufferi( snd->buf, AL_SIZE, &size );
-   if ((freq==0) || (bits==0) || (channels==0)) {
-      WARN(_("Something went wrong when loading sound file '%s'."), name);
-      snd->length = 0;
-   }
-   else
-      snd->length = (double)size / (double)(freq * (bits/8) * channels);
-   snd->channels = channels;
-
-   /* Check for errors. */
-   al_checkErr();
-
-   soundUnlock();
-
+   sound_upload( snd, &pcm, name );
    return 0;
 }
 
@@ -32,6 +32,7 @@
 #include "menu.h"
 #include "mission.h"
 #include "music.h"
+#include "nameidx.h"
 #include "ndata.h"
 #include "nebula.h"
 #include "nfile.h"
@@ -50,7 +51,7 @@
 #include "pause.h"
 #include "pilot.h"
 #include "player.h"
-#include "queue.h"
+#include "replay.h"
 #include "rng.h"
 #include "sound.h"
 #include "spfx.h"
@@ -80,22 +81,14 @@ typedef struct spob_lua_file_s {
 
 static spob_lua_file *spob_lua_stack = NULL; /**< Handles spob Lua chunks. */
 
-/*
- * spob <-> system name stack
- */
-static char** spobname_stack = NULL; /**< Spob name stack corresponding to system. */
-static char** systemname_stack = NULL; /**< System name stack corresponding to spob. */
-
 /*
  * Arrays.
  */
 StarSystem *systems_stack = NULL; /**< Star system stack. */
 static Spob *spob_stack = NULL; /**< Spob stack. */
 static VirtualSpob *vspob_stack = NULL; /**< Virtual spob stack. */
-#ifdef DEBUGGING
-static int systemstack_changed = 0; /**< Whether or not the systems_stack was changed after loading. */
-static int spobstack_changed = 0; /**< Whether or not the spob_stack was changed after loading. */
-#endif /* DEBUGGING */
+static NameIdx system_nidx = NAMEIDX_INIT( StarSystem, name ); /**< Index of the systems by name. */
+static NameIdx spob_nidx = NAMEIDX_INIT( Spob, name ); /**< Index of the spobs by name. */
 static MapShader **mapshaders = NULL; /**< Map shaders. */
 
 /*
@@ -108,6 +101,8 @@ static glTexture *jumpbuoy_gfx = NULL; /**< Jump buoy graphics. */
 static int space_fchg = 0; /**< Faction change counter, to avoid unnecessary calls. */
 static int space_simulating = 0; /**< Are we simulating space? */
 static int space_simulating_effects = 0; /**< Are we doing special effects? */
+static int space_simulating_fast = 0; /**< Are we fast forwarding without collisions? */
+static unsigned int space_known_gen = 1; /**< Generation of the known flags, see space_knownChanged(). */
 static Spob *space_landQueueSpob = NULL;
 
 /*
@@ -115,6 +110,20 @@ static Spob *space_landQueueSpob = NULL;
  */
 int space_spawn = 1; /**< Spawn enabled by default. */
 
+/*
+ * Presence updating.
+ */
+static int presence_full = 1; /**< Whether the next update has to rebuild all the presences. */
+static int *presence_dirtysys = NULL; /**< Array (array.h): Per system id, whether its presence has to be rebuilt. */
+static int *presence_dirtyfct = NULL; /**< Array (array.h): Per faction id, whether its presence has to be rebuilt. */
+static int *presence_dirtylist = NULL; /**< Array (array.h): Ids of the systems marked in presence_dirtysys. */
+static int *presence_visited = NULL; /**< Array (array.h): Per system id, last search that visited it. */
+static int presence_visit = 0; /**< Id of the current neighbourhood search. */
+static int presence_nfull = 0; /**< Number of full presence rebuilds. */
+static int presence_nincr = 0; /**< Number of incremental presence rebuilds. */
+static int presence_nsys = 0; /**< Number of systems rebuilt incrementally. */
+static double presence_time = 0.; /**< Time spent rebuilding presences. */
+
 /*
  * Internal Prototypes.
  */
@@ -133,6 +142,11 @@ static int system_parseAsteroidField( const xmlNodePtr node, StarSystem *sys );
 static int system_parseAsteroidExclusion( const xmlNodePtr node, StarSystem *sys );
 /* misc */
 static int getPresenceIndex( StarSystem *sys, int faction );
+static void system_presenceReindex( StarSystem *sys );
+static const SystemNeighbour *system_spillNeighbours( StarSystem *sys, int hidden, int range );
+static void system_spillClear (void);
+static void space_presenceMarkSpob( StarSystem *sys, const Spob *spob );
+static void space_presenceMarkVirtual( StarSystem *sys, const VirtualSpob *va );
 static void system_scheduler( double dt, int init );
 /* Markers. */
 static int space_addMarkerSystem( int sysid, MissionMarkerType type );
@@ -344,7 +358,13 @@ void system_updateAsteroids( StarSystem *sys )
  */
 int spob_setFaction( Spob *p, int faction )
 {
+   const char *sysname = spob_getSystem( p->name );
+   StarSystem *sys = (sysname != NULL) ? system_get( sysname ) : NULL;
+
+   /* Presence has to be rebuilt around the spob for both factions. */
+   space_presenceMarkSpob( sys, p );
    p->presence.faction = faction;
+   space_presenceMarkSpob( sys, p );
    return 0;
 }
 
@@ -857,10 +877,17 @@ StarSystem* system_getAll (void)
  */
 const char *system_existsCase( const char* sysname )
 {
-   for (int i=0; i<array_size(systems_stack); i++)
-      if (strcasecmp(sysname, systems_stack[i].name)==0)
-         return systems_stack[i].name;
-   return NULL;
+   int i = nameidx_getCase( &system_nidx, systems_stack, array_size(systems_stack), sysname );
+   return (i < 0) ? NULL : systems_stack[i].name;
+}
+
+/**
+ * @brief Updates the name lookups after spobs or systems were renamed.
+ */
+void space_namesChanged (void)
+{
+   nameidx_invalidate( &system_nidx );
+   nameidx_invalidate( &spob_nidx );
 }
 
 /**
@@ -913,23 +940,14 @@ static int system_cmp( const void *p1, const void *p2 )
  */
 StarSystem* system_get( const char* sysname )
 {
-   if (sysname == NULL)
-      return NULL;
+   int i;
 
-#ifdef DEBUGGING
-   if (systemstack_changed) {
-      for (int i=0; i<array_size(systems_stack); i++)
-         if (strcmp(systems_stack[i].name, sysname)==0)
-            return &systems_stack[i];
-      WARN(_("System '%s' not found in stack"), sysname);
+   if (sysname == NULL)
       return NULL;
-   }
-#endif /* DEBUGGING */
 
-   const StarSystem s = {.name = (char*)sysname};
-   StarSystem *found = bsearch( &s, systems_stack, array_size(systems_stack), sizeof(StarSystem), system_cmp );
-   if (found != NULL)
-      return found;
+   i = nameidx_get( &system_nidx, systems_stack, array_size(systems_stack), sysname );
+   if (i >= 0)
+      return &systems_stack[i];
 
    WARN(_("System '%s' not found in stack"), sysname);
    return NULL;
@@ -965,10 +983,8 @@ int system_index( const StarSystem *sys )
  */
 int spob_hasSystem( const char* spobname )
 {
-   for (int i=0; i<array_size(spobname_stack); i++)
-      if (strcmp(spobname_stack[i],spobname)==0)
-         return 1;
-   return 0;
+   int i = nameidx_get( &spob_nidx, spob_stack, array_size(spob_stack), spobname );
+   return (i >= 0) && (spob_stack[i].sys_id >= 0);
 }
 
 /**
@@ -979,9 +995,9 @@ int spob_hasSystem( const char* spobname )
  */
 char* spob_getSystem( const char* spobname )
 {
-   for (int i=0; i<array_size(spobname_stack); i++)
-      if (strcmp(spobname_stack[i],spobname)==0)
-         return systemname_stack[i];
+   int i = nameidx_get( &spob_nidx, spob_stack, array_size(spob_stack), spobname );
+   if ((i >= 0) && (spob_stack[i].sys_id >= 0))
+      return systems_stack[ spob_stack[i].sys_id ].name;
    LOG(_("Spob '%s' is not placed in a system"), spobname);
    return NULL;
 }
@@ -1005,25 +1021,16 @@ static int spob_cmp( const void *p1, const void *p2 )
  */
 Spob* spob_get( const char* spobname )
 {
+   int i;
+
    if (spobname==NULL) {
       WARN(_("Trying to find NULL spob…"));
       return NULL;
    }
 
-#ifdef DEBUGGING
-   if (spobstack_changed) {
-      for (int i=0; i<array_size(spob_stack); i++)
-         if (strcmp(spob_stack[i].name, spobname)==0)
-            return &spob_stack[i];
-      WARN(_("Spob '%s' not found in the universe"), spobname);
-      return NULL;
-   }
-#endif /* DEBUGGING */
-
-   const Spob p = {.name = (char*)spobname};
-   Spob *found = bsearch( &p, spob_stack, array_size(spob_stack), sizeof(Spob), spob_cmp );
-   if (found != NULL)
-      return found;
+   i = nameidx_get( &spob_nidx, spob_stack, array_size(spob_stack), spobname );
+   if (i >= 0)
+      return &spob_stack[i];
 
    WARN(_("Spob '%s' not found in the universe"), spobname);
    return NULL;
@@ -1070,6 +1077,8 @@ Spob* spob_getAll (void)
  */
 void spob_setKnown( Spob *p )
 {
+   if (!spob_isKnown(p))
+      space_knownChanged();
    spob_setFlag(p, SPOB_KNOWN);
 }
 
@@ -1081,10 +1090,7 @@ void spob_setKnown( Spob *p )
  */
 int spob_exists( const char* spobname )
 {
-   for (int i=0; i<array_size(spob_stack); i++)
-      if (strcmp(spob_stack[i].name,spobname)==0)
-         return 1;
-   return 0;
+   return nameidx_get( &spob_nidx, spob_stack, array_size(spob_stack), spobname ) >= 0;
 }
 
 /**
@@ -1095,10 +1101,8 @@ int spob_exists( const char* spobname )
  */
 const char* spob_existsCase( const char* spobname )
 {
-   for (int i=0; i<array_size(spob_stack); i++)
-      if (strcasecmp(spob_stack[i].name,spobname)==0)
-         return spob_stack[i].name;
-   return NULL;
+   int i = nameidx_getCase( &spob_nidx, spob_stack, array_size(spob_stack), spobname );
+   return (i < 0) ? NULL : spob_stack[i].name;
 }
 
 /**
@@ -1453,6 +1457,7 @@ void space_update( double dt, double real_dt )
             continue;
 
          jp_setFlag( jp, JP_KNOWN );
+         space_knownChanged();
          player_message( _("You discovered a Jump Point.") );
          hparam[0].type  = HOOK_PARAM_STRING;
          hparam[0].u.str = "jump";
@@ -1492,6 +1497,62 @@ int space_isSimulationEffects (void)
    return space_simulating_effects;
 }
 
+/**
+ * @brief returns whether or not we're fast forwarding the simulation, in which case collisions are skipped.
+ */
+int space_isSimulationFast (void)
+{
+   return space_simulating_fast;
+}
+
+/**
+ * @brief Simulates the current system before the player gets to act.
+ *
+ * With adaptive time steps, the step starts at SYSTEM_SIMULATE_DT_FAST and
+ * grows as needed to fit what is left into the real time budget, given how
+ * long the steps have taken so far. Whatever doesn't fit in the budget is not
+ * simulated.
+ *
+ *    @param time Amount of time to simulate.
+ *    @param dt Regular time step.
+ *    @param adaptive Whether or not to use adaptive time steps.
+ *    @param budget Real time budget in seconds, or 0. for no limit.
+ *    @param[out] simulated Amount of time actually simulated.
+ *    @return Number of steps run.
+ */
+static int space_simulate( double time, double dt, int adaptive, double budget, double *simulated )
+{
+   int n;
+   double left, step;
+   Uint64 start = SDL_GetPerformanceCounter();
+
+   left  = time;
+   step  = adaptive ? MAX( dt, SYSTEM_SIMULATE_DT_FAST ) : dt;
+   for (n=0; left >= dt; n++) {
+      double elapsed;
+
+      update_routine( MIN( step, left ), 1 );
+      left -= MIN( step, left );
+      if (budget <= 0.)
+         continue;
+
+      /* Stop when out of budget. */
+      elapsed = (double)(SDL_GetPerformanceCounter()-start) / (double)SDL_GetPerformanceFrequency();
+      if (elapsed >= budget) {
+         n++;
+         break;
+      }
+
+      /* Adapt the step so the rest fits in the remaining budget. */
+      if (adaptive) {
+         step = left * (elapsed / (double)(n+1)) / (budget-elapsed);
+         step = CLAMP( MAX( dt, SYSTEM_SIMULATE_DT_FAST ), SYSTEM_SIMULATE_DT_MAX, step );
+      }
+   }
+   *simulated = time-left;
+   return n;
+}
+
 /**
  * @brief Initializes the system.
  *
@@ -1500,7 +1561,7 @@ int space_isSimulationEffects (void)
  */
 void space_init( const char* sysname, int do_simulate )
 {
-   int n, s;
+   int s;
    const double fps_min_simulation = fps_min * 2.;
    StarSystem *oldsys = cur_system;
 
@@ -1595,6 +1656,8 @@ void space_init( const char* sysname, int do_simulate )
    system_scheduler( 0., 1 );
 
    /* we now know this system */
+   if (!sys_isKnown(cur_system))
+      space_knownChanged();
    sys_setFlag(cur_system,SYSTEM_KNOWN);
 
    /* Simulate system. */
@@ -1612,23 +1675,30 @@ void space_init( const char* sysname, int do_simulate )
    }
    player_messageToggle( 0 );
    if (do_simulate) {
-      /* Uint32 time = SDL_GetTicks(); */
+      int npre, npost, fast;
+      double tpre, tpost, simpre, simpost;
+      Uint64 time = SDL_GetPerformanceCounter();
       s = sound_disabled;
       sound_disabled = 1;
       ntime_allowUpdate( 0 );
-      n = SYSTEM_SIMULATE_TIME_PRE / fps_min_simulation;
-      for (int i=0; i<n; i++)
-         update_routine( fps_min_simulation, 1 );
+      /* Replays need the same steps every time, so can't go by the wall clock. */
+      fast = conf.jump_warmup && !replay_isDeterministic();
+      /* Without effects, and without collisions when fast forwarding. */
+      space_simulating_fast = fast;
+      npre = space_simulate( SYSTEM_SIMULATE_TIME_PRE, fps_min_simulation, fast,
+            fast ? SYSTEM_SIMULATE_BUDGET_PRE : 0., &simpre );
+      tpre = (double)(SDL_GetPerformanceCounter()-time) / (double)SDL_GetPerformanceFrequency();
+      /* Final window runs at the regular time step with everything enabled. */
+      space_simulating_fast = 0;
       space_simulating_effects = 1;
-      n = SYSTEM_SIMULATE_TIME_POST / fps_min_simulation;
-      for (int i=0; i<n; i++)
-         update_routine( fps_min_simulation, 1 );
+      npost = space_simulate( SYSTEM_SIMULATE_TIME_POST, fps_min_simulation, 0,
+            fast ? SYSTEM_SIMULATE_BUDGET_POST : 0., &simpost );
+      tpost = (double)(SDL_GetPerformanceCounter()-time) / (double)SDL_GetPerformanceFrequency() - tpre;
       ntime_allowUpdate( 1 );
       sound_disabled = s;
-      /*
       if (conf.devmode)
-         DEBUG(_("System simulated in %.3f s"), (SDL_GetTicks()-time)/1000.);
-      */
+         DEBUG(_("System simulated in %.1f ms: %.1f s in %d steps taking %.1f ms, then %.1f s in %d steps taking %.1f ms"),
+               (tpre+tpost)*1000., simpre, npre, tpre*1000., simpost, npost, tpost*1000.);
    }
    player_messageToggle( 1 );
    if (player.p != NULL) {
@@ -1660,10 +1730,7 @@ Spob *spob_new (void)
    Spob *p, *old_stack;
    int realloced;
 
-#if DEBUGGING
-   if (!systems_loading)
-      spobstack_changed = 1;
-#else /* DEBUGGING */
+#ifndef DEBUGGING
    if (!systems_loading)
       WARN(_("Creating new spob in non-debugging mode. Things are probably going to break horribly."));
 #endif /* DEBUGGING */
@@ -1674,6 +1741,7 @@ Spob *spob_new (void)
    realloced   = (old_stack!=spob_stack);
    memset( p, 0, sizeof(Spob) );
    p->id       = array_size(spob_stack)-1;
+   p->sys_id   = -1;
    p->presence.faction = -1;
 
    /* Lua doesn't default to 0 as a safe value... */
@@ -1732,6 +1800,7 @@ static int spobs_load (void)
          int ret = spob_parse( &s, spob_files[i], stdList );
          if (ret == 0) {
             s.id = array_size( spob_stack );
+            s.sys_id = -1;
             array_push_back( &spob_stack, s );
          }
 
@@ -1745,6 +1814,7 @@ static int spobs_load (void)
    qsort( spob_stack, array_size(spob_stack), sizeof(Spob), spob_cmp );
    for (int j=0; j<array_size(spob_stack); j++)
       spob_stack[j].id = j;
+   nameidx_invalidate( &spob_nidx );
 
    /* Clean up. */
    array_free( spob_files );
@@ -2375,10 +2445,12 @@ int system_addSpob( StarSystem *sys, const char *spobname )
       return -1;
    array_push_back( &sys->spobs, spob );
    array_push_back( &sys->spobsid, spob->id );
+   space_presenceMarkSpob( sys, spob );
 
-   /* add spob <-> star system to name stack */
-   array_push_back( &spobname_stack, spob->name );
-   array_push_back( &systemname_stack, sys->name );
+   /* Systems only get their final ID once they are all loaded. */
+   if (!systems_loading)
+      spob->sys_id = sys->id;
+   space_knownChanged(); /* Maps skip spobs without a system. */
 
    economy_addQueuedUpdate();
    /* This is required to clear the player statistics for this spob */
@@ -2404,7 +2476,7 @@ int system_addSpob( StarSystem *sys, const char *spobname )
  */
 int system_rmSpob( StarSystem *sys, const char *spobname )
 {
-   int i, found;
+   int i;
    Spob *spob;
 
    if (sys == NULL) {
@@ -2424,27 +2496,18 @@ int system_rmSpob( StarSystem *sys, const char *spobname )
       return -1;
    }
 
-   /* Remove spob from system. */
+   /* Remove spob from system, presence gets updated by space_updatePresences(). */
+   space_presenceMarkSpob( sys, spob );
    array_erase( &sys->spobs, &sys->spobs[i], &sys->spobs[i+1] );
    array_erase( &sys->spobsid, &sys->spobsid[i], &sys->spobsid[i+1] );
 
-   /* Remove the presence. */
-   space_reconstructPresences(); /* TODO defer this if removing multiple spobs at once. */
-
-   /* Remove from the name stack thingy. */
-   found = 0;
-   for (i=0; i<array_size(spobname_stack); i++)
-      if (strcmp(spobname, spobname_stack[i])==0) {
-         array_erase( &spobname_stack, &spobname_stack[i], &spobname_stack[i+1] );
-         array_erase( &systemname_stack, &systemname_stack[i], &systemname_stack[i+1] );
-         found = 1;
-         break;
-      }
-   if (found == 0)
-      WARN(_("Unable to find spob '%s' and system '%s' in spob<->system stack."),
-            spobname, sys->name );
-
-   system_setFaction(sys);
+   /* The spob is no longer placed. */
+   if (spob->sys_id == sys->id) {
+      spob->sys_id = -1;
+      space_knownChanged(); /* Maps skip spobs without a system. */
+   }
+   else
+      WARN(_("Spob '%s' is not placed in system '%s'."), spobname, sys->name );
 
    economy_addQueuedUpdate();
 
@@ -2468,6 +2531,7 @@ int system_addVirtualSpob( StarSystem *sys, const char *spobname )
    if (va == NULL)
       return -1;
    array_push_back( &sys->spobs_virtual, va );
+   space_presenceMarkVirtual( sys, va );
 
    /* Economy is affected by presence. */
    economy_addQueuedUpdate();
@@ -2501,13 +2565,10 @@ int system_rmVirtualSpob( StarSystem *sys, const char *spobname )
       return -1;
    }
 
-   /* Remove virtual spob. */
+   /* Remove virtual spob, presence gets updated by space_updatePresences(). */
+   space_presenceMarkVirtual( sys, sys->spobs_virtual[i] );
    array_erase( &sys->spobs_virtual, &sys->spobs_virtual[i], &sys->spobs_virtual[i+1] );
 
-   /* Remove the presence. */
-   space_reconstructPresences(); /* TODO defer this if removing multiple spobs at once. */
-   system_setFaction(sys);
-
    economy_addQueuedUpdate();
 
    return 0;
@@ -2565,6 +2626,7 @@ int system_rmJump( StarSystem *sys, const char *jumpname )
 
    /* Remove jump from system. */
    array_erase( &sys->jumps, &sys->jumps[i], &sys->jumps[i+1] );
+   system_spillClear();
 
    /* Refresh presence */
    system_setFaction(sys);
@@ -2597,10 +2659,7 @@ StarSystem *system_new (void)
    StarSystem *sys;
    int id;
 
-#if DEBUGGING
-   if (!systems_loading)
-      systemstack_changed = 1;
-#else /* DEBUGGING */
+#ifndef DEBUGGING
    if (!systems_loading)
       WARN(_("Creating new system in non-debugging mode. Things are probably going to break horribly."));
 #endif /* DEBUGGING */
@@ -2664,6 +2723,9 @@ void system_reconstructJumps (StarSystem *sys)
  */
 void systems_reconstructJumps (void)
 {
+   /* Spill neighbourhoods depend on the jumps. */
+   system_spillClear();
+
    /* So we need to calculate the shortest jump. */
    for (int i=0; i<array_size(systems_stack); i++) {
       StarSystem *sys = &systems_stack[i];
@@ -3011,8 +3073,10 @@ static int sys_cmpSysFaction( const void *a, const void *b )
 void system_setFaction( StarSystem *sys )
 {
    /* Sort presences in descending order. */
-   if (array_size(sys->presence) != 0)
+   if (array_size(sys->presence) != 0) {
       qsort( sys->presence, array_size(sys->presence), sizeof(SystemPresence), sys_cmpSysFaction );
+      system_presenceReindex( sys );
+   }
 
    sys->faction = -1;
    for (int i=0; i<array_size(sys->presence); i++) {
@@ -3235,10 +3299,6 @@ int space_load (void)
    /* Loading. */
    systems_loading = 1;
 
-   /* Create some arrays. */
-   spobname_stack = array_create( char* );
-   systemname_stack = array_create( char* );
-
    /* Load jump point graphic - must be before systems_load(). */
    jumppoint_gfx = gl_newSprite(  SPOB_GFX_SPACE_PATH"jumppoint.webp", 4, 4, OPENGL_TEX_MIPMAPS );
    jumpbuoy_gfx = gl_newImage(  SPOB_GFX_SPACE_PATH"jumpbuoy.webp", 0 );
@@ -3351,9 +3411,13 @@ static int systems_load (void)
    }
    qsort( systems_stack, array_size(systems_stack), sizeof(StarSystem), system_cmp );
    for (int j=0; j<array_size(systems_stack); j++) {
-      systems_stack[j].id = j;
-      systems_stack[j].note = NULL; /* just to be sure */
+      StarSystem *sys = &systems_stack[j];
+      sys->id = j;
+      sys->note = NULL; /* just to be sure */
+      for (int k=0; k<array_size(sys->spobs); k++)
+         sys->spobs[k]->sys_id = j;
    }
+   nameidx_invalidate( &system_nidx );
 
    /*
     * Second pass - loads all the jump routes.
@@ -3518,8 +3582,8 @@ void space_exit (void)
    jumpbuoy_gfx = NULL;
 
    /* Free the names. */
-   array_free(spobname_stack);
-   array_free(systemname_stack);
+   nameidx_free( &spob_nidx );
+   nameidx_free( &system_nidx );
 
    /* Free the spobs. */
    for (int i=0; i < array_size(spob_stack); i++) {
@@ -3586,6 +3650,9 @@ void space_exit (void)
       free(sys->note);
       array_free(sys->jumps);
       array_free(sys->presence);
+      array_free(sys->presence_idx);
+      array_free(sys->spill[0]);
+      array_free(sys->spill[1]);
       array_free(sys->spobs);
       array_free(sys->spobsid);
       array_free(sys->spobs_virtual);
@@ -3605,6 +3672,17 @@ void space_exit (void)
    array_free(systems_stack);
    systems_stack = NULL;
 
+   /* Free the presence update state. */
+   array_free(presence_dirtysys);
+   array_free(presence_dirtyfct);
+   array_free(presence_dirtylist);
+   array_free(presence_visited);
+   presence_dirtysys = NULL;
+   presence_dirtyfct = NULL;
+   presence_dirtylist = NULL;
+   presence_visited = NULL;
+   presence_full = 1;
+
    /* Free asteroids stuff. */
    asteroids_free();
 
@@ -3638,6 +3716,28 @@ void space_clearKnown (void)
    }
    for (int j=0; j<array_size(spob_stack); j++)
       spob_rmFlag(&spob_stack[j],SPOB_KNOWN);
+   space_knownChanged();
+}
+
+/**
+ * @brief Notes that systems, spobs or jumps became known or unknown.
+ *
+ * Invalidates what is cached from the known flags, such as how much of each
+ * map outfit is still unknown.
+ */
+void space_knownChanged (void)
+{
+   space_known_gen++;
+}
+
+/**
+ * @brief Gets the generation of the known flags.
+ *
+ *    @return Number that changes every time space_knownChanged() is called.
+ */
+unsigned int space_knownGeneration (void)
+{
+   return space_known_gen;
 }
 
 /**
@@ -3918,6 +4018,7 @@ int space_sysLoad( xmlNodePtr parent )
 
          if (sys != NULL) { /* Must exist */
             sys_setFlag(sys,SYSTEM_KNOWN);
+            space_knownChanged();
 
             xmlr_attr_strd(cur,"pmarked",str);
             if (str != NULL) {
@@ -3982,44 +4083,208 @@ static int getPresenceIndex( StarSystem *sys, int faction )
       return 0;
    }
 
-   /* Go through the array (if created), looking for the faction. */
-   for (int i=0; i < array_size(sys->presence); i++)
-      if (sys->presence[i].faction == faction)
-         return i;
+   /* Look up the faction in the index. */
+   if (faction < 0) {
+      for (int i=0; i < array_size(sys->presence); i++)
+         if (sys->presence[i].faction == faction)
+            return i;
+   }
+   else if ((faction < array_size(sys->presence_idx)) && (sys->presence_idx[faction] >= 0))
+      return sys->presence_idx[faction];
 
    /* Grow the array. */
    n = array_size(sys->presence);
    memset(&array_grow(&sys->presence), 0, sizeof(SystemPresence));
    sys->presence[n].faction = faction;
 
+   /* Index the new element. */
+   if (faction >= 0) {
+      if (sys->presence_idx == NULL)
+         sys->presence_idx = array_create( int );
+      while (array_size(sys->presence_idx) <= faction)
+         array_push_back( &sys->presence_idx, -1 );
+      sys->presence_idx[faction] = n;
+   }
+
    return n;
 }
 
 /**
- * @brief Adds (or removes) some presence to a system.
+ * @brief Gets the index of the presence element for a faction without creating it.
  *
- *    @param sys Pointer to the system to add to or remove from.
+ *    @param sys Pointer to the system to check.
+ *    @param faction The index of the faction to search for.
+ *    @return The index of the presence array for faction or -1 if it has none.
+ */
+static int system_presenceLookup( const StarSystem *sys, int faction )
+{
+   if ((faction < 0) || (faction >= array_size(sys->presence_idx)))
+      return -1;
+   return sys->presence_idx[faction];
+}
+
+/**
+ * @brief Rebuilds the faction index of the presence array of a system.
+ *
+ *    @param sys System to reindex.
+ */
+static void system_presenceReindex( StarSystem *sys )
+{
+   for (int i=0; i<array_size(sys->presence_idx); i++)
+      sys->presence_idx[i] = -1;
+   for (int i=0; i<array_size(sys->presence); i++) {
+      int f = sys->presence[i].faction;
+      if ((f >= 0) && (f < array_size(sys->presence_idx)))
+         sys->presence_idx[f] = i;
+   }
+}
+
+/**
+ * @brief Sets a flag in an array indexed by id, growing it as necessary.
+ *
+ *    @param flags Array (array.h) of flags.
+ *    @param id Id to flag.
+ *    @return 1 if the flag was not set before.
+ */
+static int presence_flag( int **flags, int id )
+{
+   if (*flags == NULL)
+      *flags = array_create( int );
+   while (array_size(*flags) <= id)
+      array_push_back( flags, 0 );
+   if ((*flags)[id])
+      return 0;
+   (*flags)[id] = 1;
+   return 1;
+}
+
+/**
+ * @brief Checks to see if a flag is set in an array indexed by id.
+ */
+static int presence_isFlagged( const int *flags, int id )
+{
+   return (id >= 0) && (id < array_size(flags)) && flags[id];
+}
+
+/**
+ * @brief Gets the systems presence spills to from a system.
+ *
+ * The neighbourhood is computed with a breadth first search the first time
+ * and cached in the system until the jumps change.
+ *
+ *    @param sys System the presence comes from.
+ *    @param hidden Whether or not hidden jumps can be used.
+ *    @param range Range in jumps that has to be covered.
+ *    @return Array (array.h) of neighbours sorted by distance, may go past range.
+ */
+static const SystemNeighbour *system_spillNeighbours( StarSystem *sys, int hidden, int range )
+{
+   const StarSystem *cur;
+   int dist;
+
+   /* Already computed far enough. */
+   if ((sys->spill[hidden] != NULL) && (sys->spill_range[hidden] >= range))
+      return sys->spill[hidden];
+
+   /* Set up the search. */
+   if (sys->spill[hidden] == NULL)
+      sys->spill[hidden] = array_create( SystemNeighbour );
+   else
+      array_resize( &sys->spill[hidden], 0 );
+   if (presence_visited == NULL)
+      presence_visited = array_create( int );
+   while (array_size(presence_visited) < array_size(systems_stack))
+      array_push_back( &presence_visited, 0 );
+   presence_visit++;
+   presence_visited[ sys->id ] = presence_visit;
+
+   /* Breadth first search, using the output as the queue. */
+   cur  = sys;
+   dist = 0;
+   for (int n=0; ; n++) {
+      if (dist < range) {
+         for (int i=0; i<array_size(cur->jumps); i++) {
+            const JumpPoint *jp = &cur->jumps[i];
+            SystemNeighbour *nb;
+            if (jp_isFlag( jp, JP_EXITONLY ) || (!hidden && jp_isFlag( jp, JP_HIDDEN )))
+               continue;
+            if (presence_visited[ jp->target->id ] == presence_visit)
+               continue;
+            presence_visited[ jp->target->id ] = presence_visit;
+            nb = &array_grow( &sys->spill[hidden] );
+            nb->id   = jp->target->id;
+            nb->dist = dist+1;
+         }
+      }
+
+      /* Ran out of candidates. */
+      if (n >= array_size(sys->spill[hidden]))
+         break;
+      cur  = &systems_stack[ sys->spill[hidden][n].id ];
+      dist = sys->spill[hidden][n].dist;
+   }
+   sys->spill_range[hidden] = range;
+
+   return sys->spill[hidden];
+}
+
+/**
+ * @brief Clears the cached spill neighbourhoods, must be called when jumps change.
+ */
+static void system_spillClear (void)
+{
+   for (int i=0; i<array_size(systems_stack); i++) {
+      StarSystem *sys = &systems_stack[i];
+      for (int j=0; j<2; j++) {
+         array_free( sys->spill[j] );
+         sys->spill[j] = NULL;
+         sys->spill_range[j] = 0;
+      }
+   }
+
+   /* Incremental updates can't be trusted anymore. */
+   presence_full = 1;
+}
+
+/**
+ * @brief Adds presence of a single faction to a system.
+ *
+ *    @param sys System to add presence to.
+ *    @param faction Faction to add presence to.
+ *    @param base Base presence to add.
+ *    @param bonus Bonus presence to add.
+ *    @param filter Only add to systems and factions marked for rebuilding.
+ */
+static void system_presenceAdd( StarSystem *sys, int faction, double base, double bonus, int filter )
+{
+   int id;
+
+   if (filter && (!presence_isFlagged( presence_dirtysys, sys->id ) ||
+            !presence_isFlagged( presence_dirtyfct, faction )))
+      return;
+
+   id = getPresenceIndex(sys, faction);
+   sys->presence[id].base   = MAX( sys->presence[id].base, base );
+   sys->presence[id].bonus += bonus;
+   sys->presence[id].value  = sys->presence[id].base + sys->presence[id].bonus;
+}
+
+/**
+ * @brief Adds the presence of a spob to its system and the ones it spills to.
+ *
+ *    @param sys System the spob is in.
  *    @param ap Spob presence to add.
+ *    @param filter Only add to systems and factions marked for rebuilding.
  */
-void system_presenceAddSpob( StarSystem *sys, const SpobPresence *ap )
+static void system_presenceApply( StarSystem *sys, const SpobPresence *ap, int filter )
 {
-   int id, curSpill;
-   Queue q, qn;
-   StarSystem *cur;
-   double spillfactor;
+   const SystemNeighbour *nb;
    int faction = ap->faction;
    double base = ap->base;
    double bonus = ap->bonus;
-   double range = ap->range;
-   int usehidden = faction_usesHiddenJumps( faction );
+   int range = ap->range;
    const FactionGenerator *fgens;
 
-   /* Check for NULL and display a warning. */
-   if (sys == NULL) {
-      WARN("sys == NULL");
-      return;
-   }
-
    /* Check that we have a valid faction. */
    if (faction_isFaction(faction) == 0)
       return;
@@ -4032,95 +4297,139 @@ void system_presenceAddSpob( StarSystem *sys, const SpobPresence *ap )
    fgens = faction_generators( faction );
 
    /* Add the presence to the current system. */
-   id = getPresenceIndex(sys, faction);
-   sys->presence[id].base   = MAX( sys->presence[id].base, base );
-   sys->presence[id].bonus += bonus;
-   sys->presence[id].value  = sys->presence[id].base + sys->presence[id].bonus;
-   for (int i=0; i<array_size(fgens); i++) {
-      int x = getPresenceIndex(sys, fgens[i].id);
-      sys->presence[x].base   = MAX( sys->presence[x].base, MAX(0., base*fgens[i].weight) );
-      sys->presence[x].bonus += MAX(0., bonus*fgens[i].weight);
-      sys->presence[x].value  = sys->presence[x].base + sys->presence[x].bonus;
-   }
+   system_presenceAdd( sys, faction, base, bonus, filter );
+   for (int i=0; i<array_size(fgens); i++)
+      system_presenceAdd( sys, fgens[i].id, MAX(0., base*fgens[i].weight),
+            MAX(0., bonus*fgens[i].weight), filter );
 
    /* If there's no range, we're done here. */
    if (range < 1)
       return;
 
-   /* Add the spill. */
-   sys->spilled   = 1;
-   curSpill       = 0;
-   q              = q_create();
-   qn             = q_create();
-
-   /* Create the initial queue consisting of sys adjacencies. */
-   for (int i=0; i < array_size(sys->jumps); i++) {
-      if (sys->jumps[i].target->spilled == 0 && (usehidden || !jp_isFlag( &sys->jumps[i], JP_HIDDEN )) && !jp_isFlag( &sys->jumps[i], JP_EXITONLY )) {
-         q_enqueue( q, sys->jumps[i].target );
-         sys->jumps[i].target->spilled = 1;
-      }
+   /* Spill over the neighbourhood. */
+   nb = system_spillNeighbours( sys, faction_usesHiddenJumps( faction ) != 0, range );
+   for (int i=0; (i<array_size(nb)) && (nb[i].dist <= range); i++) {
+      StarSystem *cur = &systems_stack[ nb[i].id ];
+      double spillfactor = 1. / (1. + (double)nb[i].dist);
+
+      system_presenceAdd( cur, faction, base*spillfactor, bonus*spillfactor, filter );
+      for (int j=0; j<array_size(fgens); j++)
+         system_presenceAdd( cur, fgens[j].id, MAX(0., base*spillfactor*fgens[j].weight),
+               MAX(0., bonus*spillfactor*fgens[j].weight), filter );
    }
+}
 
-   /* If it's empty, something's wrong. */
-   if (q_isEmpty(q)) {
-      /* Means system isn't connected. */
-      /*WARN(_("q is empty after getting adjacencies of %s."), sys->name);*/
-      q_destroy(q);
-      q_destroy(qn);
-      goto sys_cleanup;
+/**
+ * @brief Adds (or removes) some presence to a system.
+ *
+ *    @param sys Pointer to the system to add to or remove from.
+ *    @param ap Spob presence to add.
+ */
+void system_presenceAddSpob( StarSystem *sys, const SpobPresence *ap )
+{
+   /* Check for NULL and display a warning. */
+   if (sys == NULL) {
+      WARN("sys == NULL");
       return;
    }
 
-   while (curSpill < range) {
-      int x;
+   system_presenceApply( sys, ap, 0 );
+}
 
-      /* Pull one off the current range queue. */
-      cur = q_dequeue(q);
+/**
+ * @brief Marks the systems and factions a spob presence affects for rebuilding.
+ *
+ * Has to be called both before and after the presence changes, so that the
+ * old and the new neighbourhoods get rebuilt by space_updatePresences().
+ *
+ *    @param sys System the spob is in.
+ *    @param ap Spob presence that is changing.
+ */
+static void space_presenceMark( StarSystem *sys, const SpobPresence *ap )
+{
+   const FactionGenerator *fgens;
+   const SystemNeighbour *nb;
 
-      /* Ran out of candidates before running out of spill range! */
-      if (cur == NULL)
-         break;
+   /* Everything will be rebuilt anyway. */
+   if ((sys == NULL) || presence_full)
+      return;
 
-      /* Enqueue all its adjacencies to the next range queue. */
-      for (int i=0; i<array_size(cur->jumps); i++) {
-         if (cur->jumps[i].target->spilled == 0 && (usehidden || !jp_isFlag( &cur->jumps[i], JP_HIDDEN )) && !jp_isFlag( &cur->jumps[i], JP_EXITONLY )) {
-            q_enqueue( qn, cur->jumps[i].target );
-            cur->jumps[i].target->spilled = 1;
-         }
-      }
+   /* Only presences that were actually added matter. */
+   if (faction_isFaction(ap->faction) == 0)
+      return;
+   if ((ap->base == 0.) && (ap->bonus == 0.))
+      return;
 
-      /* Spill some presence. */
-      x = getPresenceIndex(cur, faction);
-      spillfactor = 1. / (2. + (double)curSpill);
-      cur->presence[x].base   = MAX( cur->presence[x].base, base * spillfactor );
-      cur->presence[x].bonus += bonus * spillfactor;
-      cur->presence[x].value  = cur->presence[x].base + cur->presence[x].bonus;
-
-      for (int i=0; i<array_size(fgens); i++) {
-         int y = getPresenceIndex(cur, fgens[i].id);
-         cur->presence[y].base   = MAX( cur->presence[y].base, MAX(0., base*spillfactor*fgens[i].weight) );
-         cur->presence[y].bonus += MAX(0., bonus*spillfactor*fgens[i].weight );
-         cur->presence[y].value  = cur->presence[y].base + cur->presence[y].bonus;
-      }
+   /* Mark the factions. */
+   presence_flag( &presence_dirtyfct, ap->faction );
+   fgens = faction_generators( ap->faction );
+   for (int i=0; i<array_size(fgens); i++)
+      presence_flag( &presence_dirtyfct, fgens[i].id );
+
+   /* Mark the systems. */
+   if (presence_dirtylist == NULL)
+      presence_dirtylist = array_create( int );
+   if (presence_flag( &presence_dirtysys, sys->id ))
+      array_push_back( &presence_dirtylist, sys->id );
+   if (ap->range < 1)
+      return;
+   nb = system_spillNeighbours( sys, faction_usesHiddenJumps( ap->faction ) != 0, ap->range );
+   for (int i=0; (i<array_size(nb)) && (nb[i].dist <= ap->range); i++)
+      if (presence_flag( &presence_dirtysys, nb[i].id ))
+         array_push_back( &presence_dirtylist, nb[i].id );
+}
 
-      /* Check to see if we've finished this range and grab the next queue. */
-      if (q_isEmpty(q)) {
-         curSpill++;
-         q_destroy(q);
-         q  = qn;
-         qn = q_create();
-      }
-   }
+/**
+ * @brief Marks all the presences of a spob for rebuilding.
+ *
+ *    @param sys System the spob is in.
+ *    @param spob Spob to mark.
+ */
+static void space_presenceMarkSpob( StarSystem *sys, const Spob *spob )
+{
+   space_presenceMark( sys, &spob->presence );
+}
 
-   /* Destroy the queues. */
-   q_destroy(q);
-   q_destroy(qn);
+/**
+ * @brief Marks all the presences of a virtual spob for rebuilding.
+ *
+ *    @param sys System the virtual spob is in.
+ *    @param va Virtual spob to mark.
+ */
+static void space_presenceMarkVirtual( StarSystem *sys, const VirtualSpob *va )
+{
+   for (int i=0; i<array_size(va->presences); i++)
+      space_presenceMark( sys, &va->presences[i] );
+}
 
-sys_cleanup:
-   /* Clean up our mess. */
-   for (int i=0; i < array_size(systems_stack); i++)
-      systems_stack[i].spilled = 0;
-   return;
+/**
+ * @brief Checks to see if a spob presence touches any faction marked for rebuilding.
+ */
+static int space_presenceIsMarked( const SpobPresence *ap )
+{
+   const FactionGenerator *fgens;
+
+   if (presence_isFlagged( presence_dirtyfct, ap->faction ))
+      return 1;
+   if (faction_isFaction(ap->faction) == 0)
+      return 0;
+   fgens = faction_generators( ap->faction );
+   for (int i=0; i<array_size(fgens); i++)
+      if (presence_isFlagged( presence_dirtyfct, fgens[i].id ))
+         return 1;
+   return 0;
+}
+
+/**
+ * @brief Clears all the presence rebuild marks.
+ */
+static void space_presenceClearMarks (void)
+{
+   for (int i=0; i<array_size(presence_dirtylist); i++)
+      presence_dirtysys[ presence_dirtylist[i] ] = 0;
+   array_resize( &presence_dirtylist, 0 );
+   for (int i=0; i<array_size(presence_dirtyfct); i++)
+      presence_dirtyfct[i] = 0;
 }
 
 /**
@@ -4132,6 +4441,8 @@ sys_cleanup:
  */
 double system_getPresence( const StarSystem *sys, int faction )
 {
+   int id;
+
    /* Check for NULL and display a warning. */
 #if DEBUGGING
    if (sys == NULL) {
@@ -4140,11 +4451,10 @@ double system_getPresence( const StarSystem *sys, int faction )
    }
 #endif /* DEBUGGING */
 
-   /* Go through the array, looking for the faction. */
-   for (int i=0; i < array_size(sys->presence); i++) {
-      if (sys->presence[i].faction == faction)
-         return MAX(sys->presence[i].value, 0);
-   }
+   /* Look up the faction. */
+   id = system_presenceLookup( sys, faction );
+   if (id >= 0)
+      return MAX(sys->presence[id].value, 0);
 
    /* If it's not in there, it's zero. */
    return 0.;
@@ -4161,6 +4471,8 @@ double system_getPresence( const StarSystem *sys, int faction )
  */
 double system_getPresenceFull( const StarSystem *sys, int faction, double *base, double *bonus )
 {
+   int id;
+
    /* Check for NULL and display a warning. */
 #if DEBUGGING
    if (sys == NULL) {
@@ -4169,13 +4481,12 @@ double system_getPresenceFull( const StarSystem *sys, int faction, double *base,
    }
 #endif /* DEBUGGING */
 
-   /* Go through the array, looking for the faction. */
-   for (int i=0; i < array_size(sys->presence); i++) {
-      if (sys->presence[i].faction == faction) {
-         *base = sys->presence[i].base;
-         *bonus = sys->presence[i].bonus;
-         return MAX(sys->presence[i].value, 0);
-      }
+   /* Look up the faction. */
+   id = system_presenceLookup( sys, faction );
+   if (id >= 0) {
+      *base = sys->presence[id].base;
+      *bonus = sys->presence[id].bonus;
+      return MAX(sys->presence[id].value, 0);
    }
 
    /* If it's not in there, it's zero. */
@@ -4214,10 +4525,14 @@ void system_addAllSpobsPresence( StarSystem *sys )
  */
 void space_reconstructPresences( void )
 {
+   Uint64 start = SDL_GetPerformanceCounter();
+
    /* Reset the presence in each system. */
    for (int i=0; i<array_size(systems_stack); i++) {
       array_free(systems_stack[i].presence);
+      array_free(systems_stack[i].presence_idx);
       systems_stack[i].presence  = array_create( SystemPresence );
+      systems_stack[i].presence_idx = NULL;
       systems_stack[i].ownerpresence = 0.;
    }
 
@@ -4231,12 +4546,101 @@ void space_reconstructPresences( void )
       systems_stack[i].ownerpresence = system_getPresence( &systems_stack[i], systems_stack[i].faction );
    }
 
+   /* Everything is up to date now. */
+   space_presenceClearMarks();
+   presence_full = 0;
+   presence_nfull++;
+   presence_time += (double)(SDL_GetPerformanceCounter()-start) / (double)SDL_GetPerformanceFrequency();
+
    /* Have to redo the scheduler because everything changed. */
    /* TODO this actually ignores existing presence and will temporarily increase system presence more than normal... */
    if (cur_system != NULL)
       system_scheduler( 0., 1 );
 }
 
+/**
+ * @brief Rebuilds the presences that changed since the last update.
+ *
+ * Only the systems and factions marked by spob changes get rebuilt, unless
+ * the jumps changed, in which case everything is reconstructed.
+ */
+void space_updatePresences (void)
+{
+   Uint64 start;
+
+   if (presence_full) {
+      space_reconstructPresences();
+      return;
+   }
+   if (array_size(presence_dirtylist) == 0)
+      return;
+   start = SDL_GetPerformanceCounter();
+
+   /* Reset the marked presences. */
+   for (int i=0; i<array_size(presence_dirtylist); i++) {
+      StarSystem *sys = &systems_stack[ presence_dirtylist[i] ];
+      for (int j=0; j<array_size(sys->presence); j++) {
+         SystemPresence *sp = &sys->presence[j];
+         if (!presence_isFlagged( presence_dirtyfct, sp->faction ))
+            continue;
+         sp->base  = 0.;
+         sp->bonus = 0.;
+         sp->value = 0.;
+      }
+   }
+
+   /* Re-add the presences that touch them. */
+   for (int i=0; i<array_size(systems_stack); i++) {
+      StarSystem *sys = &systems_stack[i];
+      for (int j=0; j<array_size(sys->spobs); j++)
+         if (space_presenceIsMarked( &sys->spobs[j]->presence ))
+            system_presenceApply( sys, &sys->spobs[j]->presence, 1 );
+      for (int j=0; j<array_size(sys->spobs_virtual); j++)
+         for (int k=0; k<array_size(sys->spobs_virtual[j]->presences); k++)
+            if (space_presenceIsMarked( &sys->spobs_virtual[j]->presences[k] ))
+               system_presenceApply( sys, &sys->spobs_virtual[j]->presences[k], 1 );
+   }
+
+   /* Determine dominant faction. */
+   for (int i=0; i<array_size(presence_dirtylist); i++) {
+      StarSystem *sys = &systems_stack[ presence_dirtylist[i] ];
+      system_setFaction( sys );
+      sys->ownerpresence = system_getPresence( sys, sys->faction );
+   }
+
+   presence_nincr++;
+   presence_nsys += array_size(presence_dirtylist);
+   presence_time += (double)(SDL_GetPerformanceCounter()-start) / (double)SDL_GetPerformanceFrequency();
+
+   /* Redo the scheduler like a full reconstruction would. */
+   if ((cur_system != NULL) && presence_isFlagged( presence_dirtysys, cur_system->id )) {
+      for (int i=0; i<array_size(cur_system->presence); i++) {
+         cur_system->presence[i].curUsed = 0.;
+         cur_system->presence[i].timer   = 0.;
+      }
+      space_presenceClearMarks();
+      system_scheduler( 0., 1 );
+   }
+   else
+      space_presenceClearMarks();
+}
+
+/**
+ * @brief Gets statistics about the presence rebuilds.
+ *
+ *    @param[out] full Number of full rebuilds.
+ *    @param[out] incremental Number of incremental rebuilds.
+ *    @param[out] systems Number of systems rebuilt incrementally.
+ *    @param[out] time Time spent rebuilding in seconds.
+ */
+void space_presenceStats( int *full, int *incremental, int *systems, double *time )
+{
+   *full        = presence_nfull;
+   *incremental = presence_nincr;
+   *systems     = presence_nsys;
+   *time        = presence_time;
+}
+
 /**
  * @brief See if the system has a spob.
  *
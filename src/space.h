@@ -17,6 +17,10 @@
 
 #define SYSTEM_SIMULATE_TIME_PRE   25. /**< Time to simulate system before player is added, during this time special effect creation is disabled. */
 #define SYSTEM_SIMULATE_TIME_POST   5. /**< Time to simulate the system before the player is added, however, effects are added. */
+#define SYSTEM_SIMULATE_DT_FAST     0.1 /**< Smallest time step when fast forwarding the pre simulation. */
+#define SYSTEM_SIMULATE_DT_MAX      0.5 /**< Largest time step when fast forwarding the pre simulation. */
+#define SYSTEM_SIMULATE_BUDGET_PRE  0.1 /**< Real time budget in seconds for the pre simulation when fast forwarding. */
+#define SYSTEM_SIMULATE_BUDGET_POST 0.1 /**< Real time budget in seconds for the post simulation when fast forwarding. */
 #define MAX_HYPERSPACE_VEL    25. /**< Speed to brake to before jumping. */
 
 /*
@@ -69,6 +73,14 @@ typedef struct SpobPresence_ {
    int range;     /**< Range effect of the presence (in jumps). */
 } SpobPresence;
 
+/**
+ * @brief A system reachable from another one for presence spilling.
+ */
+typedef struct SystemNeighbour_ {
+   int id;        /**< ID of the neighbouring system. */
+   int dist;      /**< Distance in jumps. */
+} SystemNeighbour;
+
 /**
  * @struct VirtualSpob
  *
@@ -87,6 +99,7 @@ typedef struct VirtualSpob_ {
  */
 typedef struct Spob_ {
    int id;        /**< Spob ID. */
+   int sys_id;    /**< ID of the system the spob is in, -1 if not placed. */
    char *name;    /**< Spob name */
    char *display; /**< Name to be displayed to the player. Defaults to name if not set. */
    char *feature; /**< Name of the feature the spob provides if applicable. */
@@ -266,7 +279,9 @@ struct StarSystem_ {
 
    /* Presence. */
    SystemPresence *presence; /**< Array (array.h): Pointer to an array of presences in this system. */
-   int spilled;         /**< If the system has been spilled to yet. */
+   int *presence_idx;   /**< Array (array.h): Index into presence for each faction id, or -1. */
+   SystemNeighbour *spill[2]; /**< Array (array.h): Systems presence spills to, sorted by distance, without and with hidden jumps. */
+   int spill_range[2];  /**< Range the spill neighbourhoods were computed up to. */
    double ownerpresence;/**< Amount of presence the owning faction has in a system. */
 
    /* Markers. */
@@ -280,7 +295,7 @@ struct StarSystem_ {
    const MapShader *ms; /**< Map shader. */
 
    /* Economy. */
-   CommodityPrice *averagePrice;
+   CommodityPrice *averagePrice; /**< array: per-commodity averages used during price setup, indexed by commodity stack position. */
 
    /* Misc. */
    char **tags;         /**< Star system tags. */
@@ -382,6 +397,8 @@ double system_getPresence( const StarSystem *sys, int faction );
 double system_getPresenceFull( const StarSystem *sys, int faction, double *base, double *bonus );
 void system_addAllSpobsPresence( StarSystem *sys );
 void space_reconstructPresences( void );
+void space_updatePresences (void);
+void space_presenceStats( int *full, int *incremental, int *systems, double *time );
 void system_rmCurrentPresence( StarSystem *sys, int faction, double amount );
 
 /*
@@ -390,6 +407,7 @@ void system_rmCurrentPresence( StarSystem *sys, int faction, double amount );
 void space_update( double dt, double real_dt );
 int space_isSimulation (void);
 int space_isSimulationEffects (void);
+int space_isSimulationFast (void);
 
 /*
  * Graphics.
@@ -402,6 +420,7 @@ void space_gfxUnload( StarSystem *sys );
  */
 StarSystem* system_getAll (void);
 const char *system_existsCase( const char* sysname );
+void space_namesChanged (void);
 char **system_searchFuzzyCase( const char* sysname, int *n );
 StarSystem* system_get( const char* sysname );
 StarSystem* system_getIndex( int id );
@@ -421,6 +440,8 @@ double system_getClosestAng( const StarSystem *sys, int *pnt, int *jp, int *ast,
 int space_addMarker( int sys, MissionMarkerType type );
 int space_rmMarker( int sys, MissionMarkerType type );
 void space_clearKnown (void);
+void space_knownChanged (void);
+unsigned int space_knownGeneration (void);
 void space_clearMarkers (void);
 void space_clearComputerMarkers (void);
 int system_hasSpob( const StarSystem *sys );
@@ -0,0 +1,196 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file textindex.c
+ *
+ * @brief Trigram index to speed up substring searches over static text.
+ *
+ * Documents are identified by their index and can have text appended to them
+ * at any time. Text is folded the same way strcasestr does it, so searches
+ * give the same results as running strcasestr over every document, but only
+ * the documents that contain the rarest trigram of the needle get checked.
+ */
+/** @cond */
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "naev.h"
+/** @endcond */
+
+#include "textindex.h"
+
+#include "array.h"
+#include "nstring.h"
+
+#define TEXTINDEX_BUCKETS_BITS   12 /**< Bits of the trigram hash. */
+#define TEXTINDEX_BUCKETS        (1<<TEXTINDEX_BUCKETS_BITS) /**< Number of trigram buckets. */
+
+/**
+ * @brief The index itself.
+ */
+struct TextIndex_ {
+   int ndocs;        /**< Number of documents. */
+   char **text;      /**< Folded text of each document, NULL if none. */
+   int *buckets[TEXTINDEX_BUCKETS]; /**< Documents containing each trigram hash (array.h arrays). */
+};
+
+/*
+ * Prototypes.
+ */
+static char *textindex_fold( const char *str );
+static unsigned int textindex_hash( const char *s );
+
+/**
+ * @brief Folds a string for case insensitive comparison.
+ *
+ *    @param str String to fold.
+ *    @return Newly allocated folded string.
+ */
+static char *textindex_fold( const char *str )
+{
+   char *out = strdup( str );
+   for (char *c=out; *c!='\0'; c++)
+      *c = tolower( (unsigned char)*c );
+   return out;
+}
+
+/**
+ * @brief Hashes the trigram at the start of a string.
+ */
+static unsigned int textindex_hash( const char *s )
+{
+   uint32_t h = ((uint32_t)(unsigned char)s[0] << 16) |
+         ((uint32_t)(unsigned char)s[1] << 8) |
+         (uint32_t)(unsigned char)s[2];
+   return (h * 2654435761u) >> (32-TEXTINDEX_BUCKETS_BITS);
+}
+
+/**
+ * @brief Creates a new empty index.
+ *
+ *    @param ndocs Number of documents that will be indexed.
+ *    @return The new index.
+ */
+TextIndex *textindex_create( int ndocs )
+{
+   TextIndex *ti = calloc( 1, sizeof(TextIndex) );
+   ti->ndocs = ndocs;
+   ti->text  = calloc( ndocs, sizeof(char*) );
+   return ti;
+}
+
+/**
+ * @brief Frees an index.
+ *
+ *    @param ti Index to free.
+ */
+void textindex_free( TextIndex *ti )
+{
+   if (ti == NULL)
+      return;
+   for (int i=0; i<ti->ndocs; i++)
+      free( ti->text[i] );
+   free( ti->text );
+   for (int i=0; i<TEXTINDEX_BUCKETS; i++)
+      array_free( ti->buckets[i] );
+   free( ti );
+}
+
+/**
+ * @brief Appends text to a document.
+ *
+ * Separate pieces of text are kept apart so that matches can not span them.
+ *
+ *    @param ti Index to add to.
+ *    @param doc Document to add text to.
+ *    @param text Text to add.
+ */
+void textindex_add( TextIndex *ti, int doc, const char *text )
+{
+   char *folded;
+   size_t len;
+
+   if ((text == NULL) || (text[0] == '\0'))
+      return;
+
+   folded = textindex_fold( text );
+   len    = strlen( folded );
+   for (size_t i=0; i+2<len; i++) {
+      int **b = &ti->buckets[ textindex_hash( &folded[i] ) ];
+      if (*b == NULL)
+         *b = array_create( int );
+      /* Documents are added one piece of text at a time, so this catches
+       * nearly all duplicates. Any left over are harmless. */
+      else if ((array_size(*b) > 0) && ((*b)[array_size(*b)-1] == doc))
+         continue;
+      array_push_back( b, doc );
+   }
+
+   /* Append to the text, separated by a character that can't be searched. */
+   if (ti->text[doc] == NULL)
+      ti->text[doc] = folded;
+   else {
+      char *joined;
+      asprintf( &joined, "%s\n%s", ti->text[doc], folded );
+      free( ti->text[doc] );
+      free( folded );
+      ti->text[doc] = joined;
+   }
+}
+
+/**
+ * @brief Searches for a substring in all the documents.
+ *
+ *    @param ti Index to search.
+ *    @param needle String to search for, case insensitively.
+ *    @param[out] match Set to 1 for each document that contains the needle, and 0 otherwise. Must hold as many elements as documents.
+ *    @return Number of documents that matched.
+ */
+int textindex_search( const TextIndex *ti, const char *needle, char *match )
+{
+   char *folded = textindex_fold( needle );
+   size_t len = strlen( folded );
+   int n = 0;
+   const int *best = NULL;
+
+   memset( match, 0, ti->ndocs );
+
+   /* Short needles have no trigrams, have to look at everything. */
+   if (len < 3) {
+      for (int i=0; i<ti->ndocs; i++) {
+         if ((ti->text[i] != NULL) && (strstr( ti->text[i], folded ) != NULL)) {
+            match[i] = 1;
+            n++;
+         }
+      }
+      free( folded );
+      return n;
+   }
+
+   /* Only documents in the smallest bucket can match. */
+   for (size_t i=0; i+2<len; i++) {
+      const int *b = ti->buckets[ textindex_hash( &folded[i] ) ];
+      if (b == NULL) {
+         free( folded );
+         return 0;
+      }
+      if ((best == NULL) || (array_size(b) < array_size(best)))
+         best = b;
+   }
+
+   /* Candidates still have to be checked because of hash collisions. */
+   for (int i=0; i<array_size(best); i++) {
+      int d = best[i];
+      if (match[d])
+         continue;
+      if (strstr( ti->text[d], folded ) != NULL) {
+         match[d] = 1;
+         n++;
+      }
+   }
+
+   free( folded );
+   return n;
+}
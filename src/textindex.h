@@ -0,0 +1,14 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+#pragma once
+
+/**
+ * @brief Case folded trigram index over a set of documents.
+ */
+typedef struct TextIndex_ TextIndex;
+
+TextIndex *textindex_create( int ndocs );
+void textindex_free( TextIndex *ti );
+void textindex_add( TextIndex *ti, int doc, const char *text );
+int textindex_search( const TextIndex *ti, const char *needle, char *match );
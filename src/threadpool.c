@@ -36,6 +36,7 @@
 #include "threadpool.h"
 
 #include "log.h"
+#include "profile.h"
 
 
 #define THREADPOOL_TIMEOUT (5 * 100) /* The time a worker thread waits in ms. */
@@ -303,11 +304,17 @@ static int threadpool_worker( void *data )
          break;
 
       /* Do work :-) */
-      work->function( work->data );
+      {
+         NPROFILE_ZONE( "thread", "threadpool_job" );
+         work->function( work->data );
+      }
 
       /* Enqueue itself in the idle worker threads queue */
       tq_enqueue( work->idle, work );
    }
+   /* Let the next thread reuse the profiler state. */
+   profile_threadExit();
+
    /* Enqueue itself in the stopped worker threads queue when stopped */
    tq_enqueue( work->stopped, work );
 
@@ -29,6 +29,9 @@ static int iar_focusImage( Widget* iar, double bx, double by );
 static void iar_focus( Widget* iar, double bx, double by );
 static void iar_scroll( Widget* iar, int direction );
 static void iar_centerSelected( Widget *iar );
+/* Lazy filling. */
+static void iar_fillCell( Widget *iar, int pos );
+static void iar_fillVisible( Widget *iar );
 /* Misc. */
 static double iar_maxPos( Widget *iar );
 static void iar_setAltTextPos( Widget *iar, double bx, double by );
@@ -164,6 +167,9 @@ static void iar_render( Widget* iar, double bx, double by )
    /* background */
    toolkit_drawRect( x, y, iar->w, iar->h, &cBlack, NULL );
 
+   /* Make sure what is about to be shown is filled in. */
+   iar_fillVisible( iar );
+
    /*
     * Scrollbar.
     */
@@ -281,6 +287,7 @@ static void iar_renderOverlay( Widget* iar, double bx, double by )
       y = by + iar->y + iar->dat.iar.alty;
 
       /* Draw alt text. */
+      iar_fillCell( iar, iar->dat.iar.alt );
       alt = iar->dat.iar.images[iar->dat.iar.alt].alt;
       if (alt != NULL)
          toolkit_drawAltText( x, y, alt );
@@ -504,6 +511,44 @@ static void iar_cleanup( Widget* iar )
    }
 
    free( iar->dat.iar.images );
+
+   if (iar->dat.iar.freedata != NULL)
+      iar->dat.iar.freedata( iar->dat.iar.filldata );
+   iarfill_free( &iar->dat.iar.fill );
+}
+
+/**
+ * @brief Fills in a cell of a lazily filled image array if it wasn't yet.
+ *
+ *    @param iar Image array widget.
+ *    @param pos Cell to fill in.
+ */
+static void iar_fillCell( Widget *iar, int pos )
+{
+   if (iar->dat.iar.fillptr == NULL)
+      return;
+   if (iarfill_mark( &iar->dat.iar.fill, pos ))
+      iar->dat.iar.fillptr( &iar->dat.iar.images[pos], pos, iar->dat.iar.filldata );
+}
+
+/**
+ * @brief Fills in the cells of the visible rows and the ones around them.
+ *
+ *    @param iar Image array widget.
+ */
+static void iar_fillVisible( Widget *iar )
+{
+   int first, last;
+   double h, yspace;
+
+   if (iar->dat.iar.fillptr == NULL)
+      return;
+
+   iar_getDim( iar, NULL, &h, NULL, &yspace );
+   iarfill_window( &first, &last, iar->dat.iar.nelements, iar->dat.iar.xelem,
+         iar->dat.iar.pos, iar->h, h+yspace, IARFILL_MARGIN );
+   for (int i=first; i<=last; i++)
+      iar_fillCell( iar, i );
 }
 
 /**
@@ -872,6 +917,39 @@ void toolkit_setImageArrayAccept( unsigned int wid, const char *name, void (*fpt
    wgt->dat.iar.accept = fptr;
 }
 
+/**
+ * @brief Makes an Image Array fill in its cells only when they are about to
+ *        be shown.
+ *
+ * The cells passed to window_addImageArray() only need to have the caption
+ * set, the rest is filled in by fill as the cells scroll into view or get
+ * hovered.
+ *
+ *    @param wid Window where image array is.
+ *    @param name Name of the image array.
+ *    @param fill Function that fills in a cell given its position and data.
+ *    @param data Data to pass to fill.
+ *    @param freedata Function to free data with when the image array is
+ *           destroyed, may be NULL.
+ */
+void toolkit_setImageArrayFill( unsigned int wid, const char *name,
+      void (*fill)(ImageArrayCell*,int,void*), void *data, void (*freedata)(void*) )
+{
+   Widget *wgt = iar_getWidget( wid, name );
+   if (wgt == NULL) {
+      if (freedata != NULL)
+         freedata( data );
+      return;
+   }
+   if (wgt->dat.iar.freedata != NULL)
+      wgt->dat.iar.freedata( wgt->dat.iar.filldata );
+   iarfill_free( &wgt->dat.iar.fill );
+   iarfill_init( &wgt->dat.iar.fill, wgt->dat.iar.nelements );
+   wgt->dat.iar.fillptr    = fill;
+   wgt->dat.iar.filldata   = data;
+   wgt->dat.iar.freedata   = freedata;
+}
+
 /**
  * @brief Gets the number of visible elements in an image array.
  *
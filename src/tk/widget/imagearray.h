@@ -6,6 +6,7 @@
 #include "colour.h"
 #include "font.h"
 #include "opengl.h"
+#include "tk/widget/imagearray_fill.h"
 
 typedef struct ImageArrayCell_ {
    glTexture* image; /**< Image to display. */
@@ -40,6 +41,10 @@ typedef struct WidgetImageArrayData_ {
    void (*rmptr) (unsigned int,const char*); /**< Right click callback. */
    void (*dblptr) (unsigned int,const char*); /**< Double click callback (for one selection). */
    void (*accept) (unsigned int, const char*); /**< Accept function pointer (when hitting enter). */
+   void (*fillptr) (ImageArrayCell*,int,void*); /**< Fills in a cell when it is about to be shown, NULL if all are filled. */
+   void *filldata; /**< Data passed to fillptr. */
+   void (*freedata) (void*); /**< Frees filldata. */
+   IarFill fill; /**< Which cells have been filled in. */
 } WidgetImageArrayData;
 
 /**
@@ -71,5 +76,7 @@ int toolkit_saveImageArrayData( unsigned int wid, const char *name,
       iar_data_t *iar_data );
 int toolkit_unsetSelection( unsigned int wid, const char *name );
 void toolkit_setImageArrayAccept( unsigned int wid, const char *name, void (*fptr)(unsigned int,const char*) );
+void toolkit_setImageArrayFill( unsigned int wid, const char *name,
+      void (*fill)(ImageArrayCell*,int,void*), void *data, void (*freedata)(void*) );
 int toolkit_getImageArrayVisibleElements( unsigned int wid, const char *name );
 int toolkit_simImageArrayVisibleElements( int w, int h, int iw, int ih );
@@ -0,0 +1,91 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file imagearray_fill.c
+ *
+ * @brief Book keeping for image arrays that fill in their cells lazily.
+ *
+ * Cells are only filled in when they are about to be shown, that is when
+ * they are in the rows around the viewport or get hovered. Doesn't depend on
+ * OpenGL or the rest of the toolkit so it can be tested on its own.
+ */
+/** @cond */
+#include <math.h>
+#include <stdlib.h>
+/** @endcond */
+
+#include "tk/widget/imagearray_fill.h"
+
+/**
+ * @brief Initializes the fill state of an image array with no cells filled.
+ *
+ *    @param f Fill state to initialize.
+ *    @param nelem Number of cells of the image array.
+ */
+void iarfill_init( IarFill *f, int nelem )
+{
+   f->nelem    = nelem;
+   f->nfilled  = 0;
+   f->filled   = calloc( (nelem > 0) ? nelem : 1, sizeof(char) );
+}
+
+/**
+ * @brief Frees the fill state of an image array.
+ */
+void iarfill_free( IarFill *f )
+{
+   free( f->filled );
+   f->filled   = NULL;
+   f->nelem    = 0;
+   f->nfilled  = 0;
+}
+
+/**
+ * @brief Marks a cell as filled in.
+ *
+ *    @param f Fill state.
+ *    @param pos Cell to mark.
+ *    @return 1 if the cell has to be filled in now, 0 if it already was or
+ *            doesn't exist.
+ */
+int iarfill_mark( IarFill *f, int pos )
+{
+   if ((f->filled == NULL) || (pos < 0) || (pos >= f->nelem) || f->filled[pos])
+      return 0;
+   f->filled[pos] = 1;
+   f->nfilled++;
+   return 1;
+}
+
+/**
+ * @brief Gets the cells that should be filled in for a scroll position.
+ *
+ *    @param[out] first First cell to fill in.
+ *    @param[out] last Last cell to fill in (inclusive), less than first if none.
+ *    @param nelem Number of cells.
+ *    @param xelem Number of cells per row.
+ *    @param pos Scroll position, distance from the top of the first row.
+ *    @param h Height of the viewport.
+ *    @param rowh Height of a row including the spacing.
+ *    @param margin Rows to fill in above and below the visible ones.
+ */
+void iarfill_window( int *first, int *last, int nelem, int xelem,
+      double pos, double h, double rowh, int margin )
+{
+   int r0, r1;
+
+   *first = 0;
+   *last  = -1;
+   if ((nelem <= 0) || (xelem <= 0) || (rowh <= 0.))
+      return;
+
+   r0 = (int)floor( pos / rowh ) - margin;
+   r1 = (int)floor( (pos + h) / rowh ) + margin;
+   if (r0 < 0)
+      r0 = 0;
+   *first = r0 * xelem;
+   *last  = (r1+1) * xelem - 1;
+   if (*last >= nelem)
+      *last = nelem-1;
+}
@@ -0,0 +1,21 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+#pragma once
+
+#define IARFILL_MARGIN  1 /**< Rows filled in above and below the visible ones. */
+
+/**
+ * @brief Keeps track of which cells of an image array have been filled in.
+ */
+typedef struct IarFill_ {
+   char *filled;  /**< Whether each cell has been filled in. */
+   int nelem;     /**< Number of cells. */
+   int nfilled;   /**< Number of cells filled in so far. */
+} IarFill;
+
+void iarfill_init( IarFill *f, int nelem );
+void iarfill_free( IarFill *f );
+int iarfill_mark( IarFill *f, int pos );
+void iarfill_window( int *first, int *last, int nelem, int xelem,
+      double pos, double h, double rowh, int margin );
@@ -21,6 +21,7 @@
 #include "conf.h"
 #include "array.h"
 #include "economy.h"
+#include "equippool.h"
 #include "log.h"
 #include "map_overlay.h"
 #include "ndata.h"
@@ -892,6 +893,9 @@ static int diff_patch( xmlNodePtr parent )
    memset(diff, 0, sizeof(UniDiff_t));
    xmlr_attr_strd(parent,"name",diff->name);
 
+   /* Equipment scripts may depend on the diffs. */
+   equippool_clear();
+
    node = parent->xmlChildrenNode;
    do {
       xml_onlyNodes(node);
@@ -1515,6 +1519,9 @@ static UniDiff_t *diff_newDiff (void)
  */
 static int diff_removeDiff( UniDiff_t *diff )
 {
+   /* Equipment scripts may depend on the diffs. */
+   equippool_clear();
+
    for (int i=0; i<array_size(diff->applied); i++) {
       UniHunk_t hunk = diff->applied[i];
       /* Invert the type for reverting. */
@@ -1781,7 +1788,7 @@ static int diff_checkUpdateUniverse (void)
    if (!diff_universe_changed || diff_universe_defer)
       return 0;
 
-   space_reconstructPresences();
+   space_updatePresences();
    safelanes_recalculate();
 
    /* Re-compute the economy. */
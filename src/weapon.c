@@ -992,6 +992,10 @@ static void weapon_update( Weapon* w, const double dt, WeaponLayer layer )
       }
    }
 
+   /* Collisions are skipped while fast forwarding the system simulation. */
+   if (space_isSimulationFast())
+      goto weapon_think;
+
    for (int i=0; i<array_size(pilot_stack); i++) {
       Pilot *p = pilot_stack[i];
 
@@ -1167,6 +1171,7 @@ static void weapon_update( Weapon* w, const double dt, WeaponLayer layer )
       }
    }
 
+weapon_think:
    /* smart weapons also get to think their next move */
    if (weapon_isSmart(w))
       (*w->think)(w,dt);
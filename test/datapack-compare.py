@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+
+# Builds the data pack, then loads the data once from the pack and once from
+# the XML files and checks that both give the same universe digest. The load
+# times of both are printed for comparison.
+
+import re
+import sys
+import subprocess
+
+naev = sys.argv[1:]
+digest_re = re.compile(r'Universe digest: ([0-9a-f]{16}), loaded in ([0-9.]+) s from the (.*)$')
+
+def run(*args):
+    proc = subprocess.run(naev + list(args),
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+            encoding='utf-8')
+    print(proc.stdout, end='')
+    return proc
+
+def digest(*args):
+    for line in run('--universe-digest', *args).stdout.splitlines():
+        m = digest_re.search(line)
+        if m is not None:
+            return m.group(1), float(m.group(2)), m.group(3)
+    sys.exit('No universe digest was logged.')
+
+if run('--build-datapack').returncode != 0:
+    sys.exit('Building the data pack failed.')
+
+pack = digest()
+xml = digest('--no-datapack')
+print(f'Data pack: {pack[0]} in {pack[1]:.3f} s from the {pack[2]}')
+print(f'XML files: {xml[0]} in {xml[1]:.3f} s from the {xml[2]}')
+
+if pack[2] != 'data pack':
+    sys.exit('The data pack was not used.')
+if pack[0] != xml[0]:
+    sys.exit('Loading from the data pack gives a different universe.')
@@ -0,0 +1,239 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file fontlayout.c
+ *
+ * @brief Benchmarks the text layout cache (\see font_layout.c).
+ *
+ * Lays out a set of strings like the ones drawn every frame by the GUI, once
+ * per simulated frame, with the line breaker of font.c (\see font_break.c)
+ * and FreeType advances plus kerning like its glyph stash. This is done once
+ * from scratch every frame and once through the layout cache, without needing
+ * an OpenGL context. Fails if both don't give the same line breaks.
+ *
+ * Usage: fontlayout [-b frames] [-w width] font [font ...]
+ */
+/** @cond */
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+/** @endcond */
+
+#include "font_break.h"
+#include "font_layout.h"
+
+#define FONT_H          12    /**< Font size being emulated. */
+#define GLYPH_LUT_SIZE  512   /**< Size of the advance look up table, like HASH_LUT_SIZE in font.c. */
+#define SKIP_RETURN     77    /**< Meson's "test skipped" return code. */
+#define LANG            "en"  /**< Language to break lines for. */
+
+/**
+ * @brief Cached metrics of a glyph, font.c keeps the same in its glyph stash.
+ */
+typedef struct Glyph_ {
+   uint32_t codepoint;  /**< Code point, 0 if unused. */
+   FT_UInt index;       /**< FreeType glyph index. */
+   double adv_x;        /**< Advance in pixels. */
+} Glyph;
+
+static Glyph glyphs[GLYPH_LUT_SIZE]; /**< Open addressed table of glyph metrics. */
+static FT_Face face; /**< Font being used. */
+static FT_UInt prev_index; /**< Glyph index of the previous character of the line, for kerning. */
+
+/**
+ * @brief Strings like the ones drawn by the GUI and land windows.
+ */
+static const char *corpus[] = {
+   "Autonav: approaching Jump Point to Delta Pavonis.",
+   "You have been hailed by a Dvaered Patrol. They demand you hand over your cargo.",
+   "Mission accomplished! You have been paid 125,000 ¤.",
+   "Fuel: 300/400 hL",
+   "Target: Pirate Admonisher (Hostile)",
+   "Armour: 82%  Shield: 47%  Energy: 100%",
+   "The Empire Shark is a small, agile fighter used to protect cargo lanes from pirate raiders.",
+   "Press #bF1#0 to open the star map and #bL#0 to land on the nearest planet.",
+   "Received message from Za'lek Scientist: \"We need your help to calibrate our drone array.\"",
+   "航行記録: 星系に到着しました。燃料が不足しています。",
+   "Credits: 1,234,567 ¤   Cargo: 12/30 t   Jumps: 3",
+   "Warning: hostile pilots detected in the system!",
+};
+
+static double now( void )
+{
+   struct timespec ts;
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+   return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Gets the metrics of a glyph, loading them from FreeType if needed.
+ */
+static const Glyph *get_glyph( uint32_t ch )
+{
+   unsigned int h = (ch * 2654435761u) & (GLYPH_LUT_SIZE-1);
+   while (glyphs[h].codepoint != 0) {
+      if (glyphs[h].codepoint == ch)
+         return &glyphs[h];
+      h = (h+1) & (GLYPH_LUT_SIZE-1);
+   }
+   glyphs[h].codepoint = ch;
+   glyphs[h].index = FT_Get_Char_Index( face, ch );
+   if (FT_Load_Glyph( face, glyphs[h].index, FT_LOAD_DEFAULT | FT_LOAD_NO_BITMAP ) == 0)
+      glyphs[h].adv_x = (double)face->glyph->metrics.horiAdvance / 64.;
+   else
+      glyphs[h].adv_x = 0.;
+   return &glyphs[h];
+}
+
+/**
+ * @brief Gets the advance of a character like font.c, kerned with the
+ *        previous character of the line.
+ */
+static float advance( void *data, uint32_t ch )
+{
+   (void) data;
+   const Glyph *g = get_glyph( ch );
+   float w = g->adv_x;
+   if (prev_index != 0) {
+      FT_Vector kern;
+      FT_Get_Kerning( face, prev_index, g->index, FT_KERNING_DEFAULT, &kern );
+      w += kern.x / 64;
+   }
+   prev_index = g->index;
+   return w;
+}
+
+/**
+ * @brief Breaks a string into lines with the line breaker of font.c, calling
+ *        out for each.
+ *
+ *    @return Number of lines.
+ */
+static int layout( const char *text, int width, glFontLayout *out, int *widths )
+{
+   glPrintLineIterator iter;
+   int n = 0;
+
+   memset( &iter, 0, sizeof(iter) );
+   iter.text   = text;
+   iter.width  = width;
+   for (;;) {
+      prev_index = 0; /* Kerning starts over every line. */
+      if (!font_breakNext( &iter, LANG, advance, NULL ))
+         return n;
+      if (out != NULL)
+         font_layoutAddLine( out, iter.l_begin, iter.l_end, iter.l_width );
+      if (widths != NULL)
+         widths[n] = iter.l_width;
+      n++;
+   }
+}
+
+int main( int argc, char **argv )
+{
+   FT_Library library;
+   int frames = 100;
+   int width = 300;
+   int ncorpus = sizeof(corpus)/sizeof(corpus[0]);
+   int ret = 0, tested = 0;
+   int c;
+
+   while ((c = getopt( argc, argv, "b:w:" )) != -1) {
+      switch (c) {
+         case 'b':
+            frames = atoi( optarg );
+            break;
+         case 'w':
+            width = atoi( optarg );
+            break;
+         default:
+            fprintf( stderr, "Usage: %s [-b frames] [-w width] font [font ...]\n", argv[0] );
+            return EXIT_FAILURE;
+      }
+   }
+   if (frames < 1)
+      frames = 1;
+
+   if (FT_Init_FreeType( &library )) {
+      fprintf( stderr, "FT_Init_FreeType failed.\n" );
+      return EXIT_FAILURE;
+   }
+
+   for (int f=optind; f<argc; f++) {
+      double t, t_direct, t_cached;
+      int hits, misses, nlines = 0;
+
+      if (FT_New_Face( library, argv[f], 0, &face )) {
+         fprintf( stderr, "Unable to load font '%s', skipping.\n", argv[f] );
+         continue;
+      }
+      FT_Set_Char_Size( face, 0, FONT_H * 64, 96, 96 );
+      FT_Select_Charmap( face, FT_ENCODING_UNICODE );
+      memset( glyphs, 0, sizeof(glyphs) );
+      font_layoutClear();
+
+      /* Lay out everything every frame. */
+      t = now();
+      for (int r=0; r<frames; r++)
+         for (int i=0; i<ncorpus; i++)
+            nlines += layout( corpus[i], width, NULL, NULL );
+      t_direct = now() - t;
+
+      /* Go through the cache. */
+      font_layoutStats( &hits, &misses );
+      t = now();
+      for (int r=0; r<frames; r++) {
+         for (int i=0; i<ncorpus; i++) {
+            glFontLayout *l = font_layoutGet( f, FONT_LAYOUT_LINES, width, corpus[i] );
+            if (l == NULL) {
+               l = font_layoutAdd( f, FONT_LAYOUT_LINES, width, corpus[i] );
+               layout( corpus[i], width, l, NULL );
+            }
+            nlines -= l->nlines;
+         }
+      }
+      t_cached = now() - t;
+      font_layoutStats( &c, &misses );
+      hits = c - hits;
+
+      /* Check the cached layouts are the same. */
+      for (int i=0; i<ncorpus; i++) {
+         int widths[64];
+         int n = layout( corpus[i], width, NULL, widths );
+         const glFontLayout *l = font_layoutGet( f, FONT_LAYOUT_LINES, width, corpus[i] );
+         int ok = (l != NULL) && (l->nlines == n);
+         for (int j=0; ok && (j<n); j++)
+            ok = (l->lines[j].width == widths[j]);
+         if (!ok) {
+            fprintf( stderr, "%s: cached layout of \"%s\" differs!\n", argv[f], corpus[i] );
+            ret = EXIT_FAILURE;
+         }
+      }
+      if (nlines != 0) {
+         fprintf( stderr, "%s: cached and direct layouts have different line counts!\n", argv[f] );
+         ret = EXIT_FAILURE;
+      }
+
+      tested++;
+      printf( "%s: %d strings x %d frames, direct %.3f us/string, cached %.3f us/string (%.1fx), %d hits\n",
+            argv[f], ncorpus, frames,
+            t_direct * 1e6 / (frames*ncorpus), t_cached * 1e6 / (frames*ncorpus),
+            t_direct / t_cached, hits );
+      FT_Done_Face( face );
+   }
+
+   font_layoutClear();
+   FT_Done_FreeType( library );
+
+   if (tested == 0) {
+      fprintf( stderr, "No fonts tested, are the fonts available?\n" );
+      return SKIP_RETURN;
+   }
+   return ret;
+}
@@ -0,0 +1,162 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file iarfill.c
+ *
+ * @brief Checks how many cells a lazily filled image array materializes
+ * (\see imagearray_fill.c).
+ *
+ * Emulates the outfitter image array going through a big list of outfits the
+ * way the widget does it every frame: opening it, scrolling down with the
+ * mouse wheel, dragging the scroll bar to the bottom and hovering cells.
+ * Fails if a visible cell is not filled in, or if many more cells than the
+ * ones shown get filled in.
+ *
+ * Usage: iarfill [-n cells]
+ */
+/** @cond */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+/** @endcond */
+
+#include "tk/widget/imagearray_fill.h"
+
+#define IAR_W     740.  /**< Width of the image array, like the outfitter. */
+#define IAR_H     480.  /**< Height of the image array. */
+#define IAR_ICON  64.   /**< Icon size. */
+#define FONT_H    12.   /**< Height of gl_smallFont. */
+
+static IarFill fill;       /**< Fill state being tested. */
+static int nelem;          /**< Number of cells. */
+static int xelem;          /**< Cells per row. */
+static double rowh;        /**< Height of a row including spacing. */
+static double cellh;       /**< Height of a cell. */
+static double pos;         /**< Scroll position. */
+static int errors = 0;     /**< Visible cells found not filled in. */
+
+/**
+ * @brief Gets the largest scroll position, like iar_maxPos().
+ */
+static double max_pos (void)
+{
+   int yelem = (nelem-1) / xelem + 1;
+   double hmax = yelem * rowh - IAR_H;
+   return (hmax < 0.) ? 0. : hmax;
+}
+
+/**
+ * @brief Renders a frame, like iar_render() with iar_fillVisible().
+ */
+static void render (void)
+{
+   int first, last;
+   int yelem = (nelem-1) / xelem + 1;
+
+   iarfill_window( &first, &last, nelem, xelem, pos, IAR_H, rowh, IARFILL_MARGIN );
+   for (int i=first; i<=last; i++)
+      iarfill_mark( &fill, i );
+
+   /* Every cell drawn must be filled in already. */
+   for (int j=0; j<yelem; j++) {
+      double ycurs = floor( IAR_H - (j+1)*rowh + pos );
+      if ((ycurs > IAR_H) || (ycurs + cellh < 0.))
+         continue;
+      for (int i=0; i<xelem; i++) {
+         int p = j*xelem + i;
+         if (p >= nelem)
+            break;
+         if (!fill.filled[p]) {
+            fprintf( stderr, "Visible cell %d not filled in at position %.1f.\n", p, pos );
+            errors++;
+         }
+      }
+   }
+}
+
+/**
+ * @brief Hovers a cell, like iar_renderOverlay() showing the alt text.
+ */
+static void hover( int p )
+{
+   iarfill_mark( &fill, p );
+}
+
+int main( int argc, char **argv )
+{
+   double w, space;
+   int c, visible, bound, nopen, nscroll, nbottom, nhover;
+
+   nelem = 1000;
+   while ((c = getopt( argc, argv, "n:" )) != -1) {
+      switch (c) {
+         case 'n':
+            nelem = atoi( optarg );
+            break;
+         default:
+            fprintf( stderr, "Usage: %s [-n cells]\n", argv[0] );
+            return EXIT_FAILURE;
+      }
+   }
+   if (nelem < 1)
+      nelem = 1;
+
+   /* Same dimensions as window_addImageArray() and iar_getDim(). */
+   xelem = floor( (IAR_W - 10.) / (IAR_ICON + 10.) );
+   w     = IAR_ICON + 10.;
+   cellh = IAR_ICON + 10. + 2. + FONT_H;
+   space = ((int)IAR_W - 10) % (int)w;
+   space /= (xelem + 1);
+   rowh  = cellh + round( space );
+   visible = (int)ceil( IAR_H / rowh + 1. ) * xelem;
+   bound = visible + 2 * IARFILL_MARGIN * xelem;
+
+   iarfill_init( &fill, nelem );
+
+   /* Open the image array. */
+   pos = 0.;
+   render();
+   nopen = fill.nfilled;
+
+   /* Scroll down a third of the list with the mouse wheel, a row per step. */
+   for (int i=0; i<(nelem / xelem) / 3; i++) {
+      pos = fmin( pos + rowh, max_pos() );
+      render();
+   }
+   nscroll = fill.nfilled;
+
+   /* Drag the scroll bar to the bottom. */
+   pos = max_pos();
+   render();
+   nbottom = fill.nfilled;
+
+   /* Hover the cells being shown and the first one. */
+   hover( nelem-1 );
+   hover( 0 );
+   nhover = fill.nfilled;
+
+   printf( "%d cells, %d per row, up to %d visible\n", nelem, xelem, visible );
+   printf( "%-36s %4d\n", "Filled in after opening:", nopen );
+   printf( "%-36s %4d\n", "Filled in after scrolling a third:", nscroll );
+   printf( "%-36s %4d\n", "Filled in after jumping to the end:", nbottom );
+   printf( "%-36s %4d\n", "Filled in after hovering:", nhover );
+   printf( "%-36s %4d\n", "Filled in eagerly:", nelem );
+
+   if (nopen > bound) {
+      fprintf( stderr, "Opening filled in %d cells, expected at most %d.\n", nopen, bound );
+      errors++;
+   }
+   if (nbottom - nscroll > bound) {
+      fprintf( stderr, "Jumping filled in %d cells, expected at most %d.\n", nbottom - nscroll, bound );
+      errors++;
+   }
+   if (nhover != nbottom) {
+      fprintf( stderr, "Hovering visible cells filled in %d more.\n", nhover - nbottom );
+      errors++;
+   }
+
+   iarfill_free( &fill );
+   return (errors > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
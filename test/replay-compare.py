@@ -0,0 +1,37 @@
+#!/usr/bin/env python3
+
+# Records the scripted session of the replay test, in which a dialogue gets
+# closed by a key press, then plays it back. Fails if the playback diverges
+# from the recording or doesn't run the same frames.
+
+import os
+import re
+import sys
+import subprocess
+
+replay = sys.argv[1]
+naev = sys.argv[2:]
+frames_re = re.compile(r'Replay test ran ([0-9]+) frames')
+
+def run(*args):
+    proc = subprocess.run(naev + ['--replay-test'] + list(args),
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+            encoding='utf-8')
+    print(proc.stdout, end='')
+    for line in proc.stdout.splitlines():
+        if 'Replay diverged' in line or 'Replay stopped' in line:
+            sys.exit(line)
+    for line in proc.stdout.splitlines():
+        m = frames_re.search(line)
+        if m is not None:
+            return int(m.group(1))
+    sys.exit('The replay test did not finish.')
+
+os.makedirs(os.path.dirname(replay), exist_ok=True)
+recorded = run('--record', replay)
+played = run('--replay', replay, '--replay-headless', '--replay-uncapped')
+print(f'Recorded {recorded} frames, played back {played} frames')
+
+if recorded != played:
+    sys.exit('The playback did not run the same frames as the recording.')
@@ -0,0 +1,210 @@
+/*
+ * See Licensing and Copyright notice in naev.h
+ */
+/**
+ * @file sdfcheck.c
+ *
+ * @brief Compares the font distance field generators (\see distance_field.c).
+ *
+ * Rasterizes the printable ASCII range and the CJK unified ideographs of the
+ * given fonts the same way font.c does, runs both make_distance_mapbf() and
+ * make_distance_mapbf_fh() on every glyph and reports the time taken by each
+ * as well as the worst-case difference in pixels. Fails if the difference
+ * near the glyph edges (where the font shader samples) exceeds the tolerance.
+ *
+ * Usage: sdfcheck [-b reps] [-t tolerance] font [font ...]
+ */
+/** @cond */
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+/** @endcond */
+
+#include "distance_field.h"
+
+#define SDF_SIZE        55    /**< Same as FONT_DISTANCE_FIELD_SIZE in font.c. */
+#define SDF_FONT_H      12    /**< Font size being emulated. */
+#define SDF_EFFECT_R    4     /**< Same as MAX_EFFECT_RADIUS in font.c. */
+#define SKIP_RETURN     77    /**< Meson's "test skipped" return code. */
+
+/**
+ * @brief Character range to test.
+ */
+typedef struct Range_ {
+   const char *name;
+   unsigned int start;
+   unsigned int end;
+} Range;
+
+static const Range ranges[] = {
+   { "ASCII", 0x21, 0x7E },
+   { "CJK", 0x4E00, 0x9FFF },
+};
+
+/**
+ * @brief Accumulated results for a font/range pair.
+ */
+typedef struct Stats_ {
+   int glyphs;
+   double t_edtaa3;  /**< Seconds spent in make_distance_mapbf. */
+   double t_fh;      /**< Seconds spent in make_distance_mapbf_fh. */
+   double maxdiff;   /**< Worst difference anywhere (pixels). */
+   double banddiff;  /**< Worst difference within the effect radius of the edge (pixels). */
+} Stats;
+
+static double now( void )
+{
+   struct timespec ts;
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+   return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Compares both transforms on a single bordered glyph.
+ */
+static void compare_glyph( unsigned char *buf, int rw, int rh, int border, int reps, Stats *st )
+{
+   double t, vmax_a, vmax_b;
+   float *a, *b;
+
+   t = now();
+   for (int r=0; r<reps; r++) {
+      a = make_distance_mapbf( buf, rw, rh, &vmax_a );
+      if (r < reps-1)
+         free( a );
+   }
+   st->t_edtaa3 += now() - t;
+
+   t = now();
+   for (int r=0; r<reps; r++) {
+      b = make_distance_mapbf_fh( buf, rw, rh, &vmax_b );
+      if (r < reps-1)
+         free( b );
+   }
+   st->t_fh += now() - t;
+
+   /* Compare in pixels, (0.5-v)*2*vmax is the signed distance. */
+   for (int i=0; i<rw*rh; i++) {
+      double da = (0.5-a[i]) * 2.*vmax_a;
+      double db = (0.5-b[i]) * 2.*vmax_b;
+      double d  = fabs( da-db );
+      if (d > st->maxdiff)
+         st->maxdiff = d;
+      if ((fabs(da) <= border) && (d > st->banddiff))
+         st->banddiff = d;
+   }
+   st->glyphs++;
+
+   free( a );
+   free( b );
+}
+
+/**
+ * @brief Runs a range of a font.
+ */
+static int run_range( FT_Face face, const Range *range, int reps, Stats *st )
+{
+   int b = 1 + ((SDF_EFFECT_R+1) * SDF_SIZE - 1) / SDF_FONT_H;
+   memset( st, 0, sizeof(Stats) );
+   for (unsigned int ch=range->start; ch<=range->end; ch++) {
+      FT_Bitmap bitmap;
+      FT_UInt glyph_index = FT_Get_Char_Index( face, ch );
+      unsigned char *buf;
+      int w, h, rw, rh;
+
+      if (glyph_index == 0)
+         continue;
+      if (FT_Load_Glyph( face, glyph_index, FT_LOAD_RENDER | FT_LOAD_NO_BITMAP | FT_LOAD_TARGET_NORMAL ))
+         continue;
+      bitmap = face->glyph->bitmap;
+      if (bitmap.buffer == NULL)
+         continue;
+
+      w  = bitmap.width;
+      h  = bitmap.rows;
+      rw = w+b*2;
+      rh = h+b*2;
+      buf = calloc( rw*rh, 1 );
+      for (int v=0; v<h; v++)
+         memcpy( &buf[ (b+v)*rw+b ], &bitmap.buffer[ v*bitmap.pitch ], w );
+      compare_glyph( buf, rw, rh, b, reps, st );
+      free( buf );
+   }
+   return st->glyphs;
+}
+
+int main( int argc, char **argv )
+{
+   FT_Library library;
+   double tol = 1.0;
+   int reps = 1;
+   int ret = 0, tested = 0;
+   int c;
+
+   while ((c = getopt( argc, argv, "b:t:" )) != -1) {
+      switch (c) {
+         case 'b':
+            reps = atoi( optarg );
+            break;
+         case 't':
+            tol = atof( optarg );
+            break;
+         default:
+            fprintf( stderr, "Usage: %s [-b reps] [-t tolerance] font [font ...]\n", argv[0] );
+            return EXIT_FAILURE;
+      }
+   }
+   if (reps < 1)
+      reps = 1;
+
+   if (FT_Init_FreeType( &library )) {
+      fprintf( stderr, "FT_Init_FreeType failed.\n" );
+      return EXIT_FAILURE;
+   }
+
+   for (int i=optind; i<argc; i++) {
+      FT_Face face;
+      FT_Matrix scale;
+
+      if (FT_New_Face( library, argv[i], 0, &face )) {
+         fprintf( stderr, "Unable to load font '%s', skipping.\n", argv[i] );
+         continue;
+      }
+      FT_Set_Char_Size( face, 0, SDF_FONT_H * 64, 96, 96 );
+      scale.xx = scale.yy = (FT_Fixed)SDF_SIZE*0x10000/SDF_FONT_H;
+      scale.xy = scale.yx = 0;
+      FT_Set_Transform( face, &scale, NULL );
+      FT_Select_Charmap( face, FT_ENCODING_UNICODE );
+
+      for (size_t j=0; j<sizeof(ranges)/sizeof(ranges[0]); j++) {
+         Stats st;
+         if (run_range( face, &ranges[j], reps, &st ) <= 0)
+            continue;
+         tested++;
+         printf( "%s [%s]: %d glyphs, edtaa3 %.3f ms, fh %.3f ms (%.2fx), max diff %.3f px (%.3f px near edge)\n",
+               argv[i], ranges[j].name, st.glyphs,
+               st.t_edtaa3 * 1000. / reps, st.t_fh * 1000. / reps,
+               st.t_edtaa3 / st.t_fh, st.maxdiff, st.banddiff );
+         if (st.banddiff > tol) {
+            fprintf( stderr, "%s [%s]: difference near edge %.3f px above tolerance %.3f px!\n",
+                  argv[i], ranges[j].name, st.banddiff, tol );
+            ret = EXIT_FAILURE;
+         }
+      }
+      FT_Done_Face( face );
+   }
+
+   distance_field_cleanup();
+   FT_Done_FreeType( library );
+
+   if (tested == 0) {
+      fprintf( stderr, "No glyphs tested, are the fonts available?\n" );
+      return SKIP_RETURN;
+   }
+   return ret;
+}
@@ -4,8 +4,16 @@ import os
 import sys
 import subprocess
 
-command = sys.argv[1:-1]
-pattern = sys.argv[-1]
+# Optional leading "--fail-on PATTERN" pairs make the test fail as soon as
+# PATTERN shows up in the output.
+args = sys.argv[1:]
+fail_patterns = []
+while len(args) >= 2 and args[0] == '--fail-on':
+    fail_patterns.append(args[1])
+    args = args[2:]
+
+command = args[:-1]
+pattern = args[-1]
 
 result = 1
 
@@ -17,6 +25,9 @@ proc = subprocess.Popen(command,
 
 for line in proc.stdout:
     print(line, end='')
+    if any(p in line for p in fail_patterns):
+        result = 1
+        break
     if pattern in line:
         result = 0
         break
@@ -0,0 +1,36 @@
+--[[
+Fills the current system with idle traders far away from the player and a
+battle close by to benchmark the AI level of detail scheduling. Run from the
+console while in space with devmode and showfps enabled, e.g.,
+
+   require "utils.benchmark.ai_lod"
+
+and compare the frame rate and the "AI: N calls, M skipped" counter with
+ai_lod set to true and false in the configuration file. The traders are idle
+and far away so they think least often, the battle is on screen so its pilots
+think every frame, moving the camera away from it puts them in the off screen
+tier.
+
+That the level of detail does not change how battles turn out is checked by
+running "naev --ai-lod-compare", which fights the same seeded battles off
+screen with and without it and compares the outcomes.
+--]]
+local vec2 = require "vec2"
+
+local ntraders = 200
+local nfighters = 20
+
+print("====== BENCHMARK START ======")
+local tstart = naev.clock()
+local center = player.pos()
+for i=1,ntraders do
+   local pos = center + vec2.newP( 20e3 + 10*i, 2*math.pi*i/ntraders )
+   pilot.add( "Llama", "Independent", pos )
+end
+for i=1,nfighters do
+   local pos = center + vec2.newP( 1000, 2*math.pi*i/nfighters )
+   pilot.add( "Hyena", (i%2==0) and "Pirate" or "Empire", pos )
+end
+local elapsed = naev.clock()-tstart
+print(string.format("Spawned %d pilots in %.3f s", ntraders+nfighters, elapsed))
+print("====== BENCHMARK END ======")
@@ -0,0 +1,46 @@
+--[[
+Spawns waves of fleets of different factions to benchmark the pool of solved
+NPC loadouts. The first waves have to solve every loadout until the pools are
+full, while the later ones should mostly reuse them. Run from the console,
+e.g.,
+
+   require "utils.benchmark.equip_pool"
+
+and compare with equip_pool set to 0 in the configuration file.
+--]]
+local fleet = require "fleet"
+local vec2 = require "vec2"
+
+local nwaves = 12
+local fleets = {
+   { {"Empire Lancelot", "Empire Lancelot", "Empire Admonisher"}, "Empire" },
+   { {"Dvaered Vendetta", "Dvaered Vendetta", "Dvaered Phalanx"}, "Dvaered" },
+   { {"Pirate Hyena", "Pirate Shark", "Pirate Admonisher"}, "Pirate" },
+   { {"Za'lek Light Drone", "Za'lek Sting", "Za'lek Demon"}, "Za'lek" },
+   { {"Llama", "Koala", "Rhino"}, "Trader" },
+   { {"Hyena", "Lancelot", "Pacifier"}, "Independent" },
+}
+
+print("====== BENCHMARK START ======")
+pilot.clear()
+local pos = player.pos() + vec2.new( 30e3, 0 )
+local h0, m0, s0 = pilot.equipPoolStats()
+local ttotal = 0
+for w=1,nwaves do
+   local n = 0
+   local tstart = naev.clock()
+   for _k,f in ipairs(fleets) do
+      n = n + #fleet.add( 1, f[1], f[2], pos, nil, {ai="dummy"} )
+   end
+   local elapsed = naev.clock()-tstart
+   ttotal = ttotal + elapsed
+   local h, m = pilot.equipPoolStats()
+   print(string.format("Wave %2d: %d pilots in %7.2f ms (%.2f ms each), %d pooled, %d solved so far",
+         w, n, elapsed*1000, elapsed*1000/n, h-h0, m-m0))
+   pilot.clear()
+end
+local h, m, s = pilot.equipPoolStats()
+h, m, s = h-h0, m-m0, s-s0
+print(string.format("Total: %.2f ms, pool hit rate %.1f%%, %.2f ms of solving saved",
+      ttotal*1000, 100*h/math.max(1,h+m), s*1000))
+print("====== BENCHMARK END ======")
@@ -1,6 +1,6 @@
 local equipopt = require 'equipopt'
 local benchmark = {}
-function benchmark.run( _testname, reps, sparams )
+function benchmark.run( _testname, reps, sparams, opt_params )
    local ships = {
       "Llama",
       "Hyena",
@@ -13,16 +13,17 @@ function benchmark.run( _testname, reps, sparams )
       "Kestrel",
       "Goddard",
    }
+   -- Use the templates directly, the wrappers would reuse pooled loadouts
    local factions = {
-      equipopt.generic,
-      equipopt.empire,
-      equipopt.zalek,
-      equipopt.dvaered,
-      equipopt.sirius,
-      equipopt.soromid,
-      equipopt.pirate,
-      equipopt.thurion,
-      equipopt.proteron,
+      require 'equipopt.templates.generic',
+      require 'equipopt.templates.empire',
+      require 'equipopt.templates.zalek',
+      require 'equipopt.templates.dvaered',
+      require 'equipopt.templates.sirius',
+      require 'equipopt.templates.soromid',
+      require 'equipopt.templates.pirate',
+      require 'equipopt.templates.thurion',
+      require 'equipopt.templates.proteron',
    }
 
    pilot.clear()
@@ -37,8 +38,7 @@ function benchmark.run( _testname, reps, sparams )
             local p = pilot.add( s, "Dummy", pos, nil, {naked=true} )
             if sparams then
                equipopt.optimize.sparams = sparams
-               f( p )
-               --f( p, {rnd=0.0})
+               f( p, opt_params )
             end
             p:rm()
          end
@@ -61,6 +61,29 @@ function benchmark.run( _testname, reps, sparams )
    return mean, stddev, vals
 end
 
+-- Compares cold and warm started solves, and the solution memo on problems without noise
+function benchmark.warmstart( reps, sparams )
+   local runs = {
+      { "Cold", { warm=false } },
+      { "Warm", { warm=true } },
+      { "Cold (no noise)", { warm=false, memo=false }, { rnd=0 } },
+      { "Warm+memo (no noise)", { warm=true, memo=true }, { rnd=0 } },
+   }
+   for k,r in ipairs(runs) do
+      local name, sp, op = r[1], tcopy( sparams or {} ), r[3]
+      for i,v in pairs(r[2]) do
+         sp[i] = v
+      end
+      linopt.stats( true )
+      local mean, stddev = benchmark.run( name, reps, sp, op )
+      local st = linopt.stats( true )
+      print(string.format("%-22s %10.3f (%.3f) ms, %5d solves in %8.3f ms, %5d warm, %5d cold, %5d memo",
+            name, mean, stddev, st.solves, st.time*1000, st.warm, st.cold, st.memo ))
+   end
+   -- Restore defaults
+   equipopt.optimize.sparams = nil
+end
+
 function benchmark.csv_open( header, reps )
    local csvfile = file.new("benchmark.csv")
    csvfile:open("w")
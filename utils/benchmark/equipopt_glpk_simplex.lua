@@ -8,6 +8,7 @@ local tstart = naev.clock()
 print("====== BENCHMARK START ======")
 local bl_mean, bl_stddev, bl_vals = benchmark.run( "Baseline", reps )
 local def_mean, def_stddev, def_vals = benchmark.run( "Defaults", reps, {} )
+benchmark.warmstart( reps )
 csvfile:write(string.format("%f,%f,-,-,-,-", bl_mean, bl_stddev ) )
 benchmark.csv_writereps( csvfile, bl_vals )
 csvfile:write(string.format("%f,%f,def,def,def,def", def_mean, def_stddev ) )
@@ -0,0 +1,38 @@
+--[[
+Benchmark of the player inventory lookups done by the outfitter and equipment
+screens, counting every outfit in the game both unequipped and including the
+ones equipped on the fleet. Maps go through the check of what is still
+unknown. Run from the console, e.g.,
+
+   require "utils.benchmark.inventory"
+--]]
+local nrounds = 20
+
+local function bench( name, func )
+   local n = 0
+   local tstart = naev.clock()
+   for _i=1,nrounds do
+      n = n + func()
+   end
+   local elapsed = naev.clock()-tstart
+   print(string.format("%-24s %8.3f ms per pass (%d owned)", name, elapsed*1000/nrounds, n/nrounds))
+end
+
+print("====== BENCHMARK START ======")
+local outfits = outfit.getAll()
+print(string.format("%d outfits, %d ships", #outfits, #player.ships()+1))
+bench( "unequipped", function ()
+   local n = 0
+   for _k,o in ipairs(outfits) do
+      n = n + player.numOutfit( o, true )
+   end
+   return n
+end )
+bench( "total", function ()
+   local n = 0
+   for _k,o in ipairs(outfits) do
+      n = n + player.numOutfit( o )
+   end
+   return n
+end )
+print("====== BENCHMARK END ======")
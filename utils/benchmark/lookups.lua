@@ -0,0 +1,55 @@
+--[[
+Benchmark of looking up spobs, systems, outfits, ships and factions by name
+from Lua, along with the system a spob is in, as done all over the missions
+and events. Gives the number of lookups per second. Run from the console,
+e.g.,
+
+   require "utils.benchmark.lookups"
+--]]
+local nrounds = 20
+
+local function names( list )
+   local out = {}
+   for _k,v in ipairs(list) do
+      table.insert( out, v:nameRaw() )
+   end
+   return out
+end
+
+local function bench( name, list, func )
+   local tstart = naev.clock()
+   for _i=1,nrounds do
+      for _k,v in ipairs(list) do
+         func( v )
+      end
+   end
+   local elapsed = naev.clock()-tstart
+   local n = #list*nrounds
+   print(string.format("%-16s %10.0f lookups/s (%d names)", name, n/elapsed, #list))
+end
+
+print("====== BENCHMARK START ======")
+local spobs = names( spob.getAll() )
+local systems = names( system.getAll() )
+local outfits = names( outfit.getAll() )
+local ships = names( ship.getAll() )
+
+-- There is no faction.getAll, so use the ones owning spobs
+local factions = {}
+local seen = {}
+for _k,s in ipairs(spob.getAll()) do
+   local f = s:faction()
+   if f and not seen[ f:nameRaw() ] then
+      seen[ f:nameRaw() ] = true
+      table.insert( factions, f:nameRaw() )
+   end
+end
+
+bench( "spob.get", spobs, function ( n ) spob.get( n ) end )
+bench( "spob.getS", spobs, function ( n ) spob.getS( n ) end )
+bench( "spob:system", spob.getAll(), function ( p ) p:system() end )
+bench( "system.get", systems, function ( n ) system.get( n ) end )
+bench( "outfit.get", outfits, function ( n ) outfit.get( n ) end )
+bench( "ship.get", ships, function ( n ) ship.get( n ) end )
+bench( "faction.get", factions, function ( n ) faction.get( n ) end )
+print("====== BENCHMARK END ======")
@@ -0,0 +1,98 @@
+--[[
+Benchmark of the faction presence rebuilds done when the universe changes.
+Toggles a few universe diffs that add, remove, or change the faction of spobs
+and compares the incremental rebuild of the affected systems with rebuilding
+all the presences from scratch. The result of each incremental rebuild is
+checked against a full one. Run from the console, e.g.,
+
+   require "utils.benchmark.presence"
+--]]
+local diffs = {
+   "collective_dead",
+   "flf_dead",
+   "flf_vs_empire",
+   "flf_pirate_ally",
+}
+local nfull = 20
+local nrounds = 5
+local tolerance = 1e-6
+
+-- Gets the presences of all the systems
+local function snapshot ()
+   local t = {}
+   for _k,s in ipairs(system.getAll()) do
+      t[s:nameRaw()] = s:presences()
+   end
+   return t
+end
+
+-- Gets the largest difference between two snapshots
+local function compare( a, b )
+   local worst = 0
+   for sys,pa in pairs(a) do
+      local pb = b[sys]
+      for f,v in pairs(pa) do
+         worst = math.max( worst, math.abs( v - (pb[f] or 0) ) )
+      end
+      for f,v in pairs(pb) do
+         worst = math.max( worst, math.abs( v - (pa[f] or 0) ) )
+      end
+   end
+   return worst
+end
+
+local function toggle( name )
+   if diff.isApplied( name ) then
+      diff.remove( name )
+   else
+      diff.apply( name )
+   end
+end
+
+print("====== BENCHMARK START ======")
+local applied = {}
+for _k,d in ipairs(diffs) do
+   applied[d] = diff.isApplied( d )
+end
+
+-- Full rebuilds
+local tstart = naev.clock()
+for _i=1,nfull do
+   system.presenceRebuild()
+end
+local tfull = (naev.clock()-tstart) / nfull
+print(string.format("Full rebuild: %.3f ms", tfull*1000))
+
+-- Incremental rebuilds
+local ninc, nfullinc, nsys, tinc = 0, 0, 0, 0
+local worst = 0
+for _r=1,nrounds do
+   for _k,d in ipairs(diffs) do
+      local st0 = system.presenceStats()
+      toggle( d )
+      local st = system.presenceStats()
+      ninc = ninc + st.incremental - st0.incremental
+      nfullinc = nfullinc + st.full - st0.full
+      nsys = nsys + st.systems - st0.systems
+      tinc = tinc + st.time - st0.time
+
+      -- Check against a full rebuild
+      local inc = snapshot()
+      system.presenceRebuild()
+      worst = math.max( worst, compare( inc, snapshot() ) )
+   end
+end
+tinc = tinc / math.max( 1, ninc+nfullinc )
+print(string.format("Incremental rebuild: %.3f ms (%d updates, %.1f systems each, %d fell back to full)",
+      tinc*1000, ninc, nsys/math.max(1,ninc), nfullinc))
+print(string.format("Speedup: %.1fx", tfull/math.max(tinc,1e-9)))
+print(string.format("Largest difference with a full rebuild: %g (%s)",
+      worst, (worst <= tolerance) and "OK" or "MISMATCH"))
+
+-- Restore the diffs
+for _k,d in ipairs(diffs) do
+   if diff.isApplied( d ) ~= applied[d] then
+      toggle( d )
+   end
+end
+print("====== BENCHMARK END ======")
@@ -0,0 +1,27 @@
+--[[
+Times saving in the background against saving synchronously. Run from the
+console while landed, e.g.,
+
+   require "utils.benchmark.save_async"
+
+With devmode enabled, the time spent capturing the game state and writing it
+out is also printed for each save. That both write exactly the same file is
+checked by the save_async test instead (naev --save-test).
+--]]
+local nsaves = 20
+
+print("====== BENCHMARK START ======")
+local tasync, tsync = 0, 0
+for _i=1,nsaves do
+   local t = naev.clock()
+   player.save( "benchmark_async" )
+   tasync = tasync + naev.clock()-t
+   -- Waits for the previous save to be written before starting
+   t = naev.clock()
+   player.save( "benchmark_sync", nil, true )
+   tsync = tsync + naev.clock()-t
+end
+print(string.format("Background save: %.3f ms blocking each", tasync*1000/nsaves))
+print(string.format("Synchronous save: %.3f ms blocking each", tsync*1000/nsaves))
+
+print("====== BENCHMARK END ======")
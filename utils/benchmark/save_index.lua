@@ -0,0 +1,20 @@
+--[[
+Generates a directory full of snapshots for the current pilot to benchmark the
+load menu. Run from the console while landed with devmode enabled, e.g.,
+
+   require "utils.benchmark.save_index"
+
+and then open the load menu: devmode prints "Loaded N Saves in X s". Deleting
+the "*.ns.idx" files in the pilot's save directory times the full parse
+fallback used for older saves.
+--]]
+local nsaves = 300
+
+print("====== BENCHMARK START ======")
+local tstart = naev.clock()
+for i=1,nsaves do
+   player.save( string.format("benchmark_%03d", i) )
+end
+local elapsed = naev.clock()-tstart
+print(string.format("Wrote %d snapshots in %.3f s (%.3f ms each)", nsaves, elapsed, elapsed*1000/nsaves))
+print("====== BENCHMARK END ======")
@@ -0,0 +1,72 @@
+--[[
+Benchmark of the text search used by the map find dialogue and the outfitter
+filter. Simulates typing a few queries one key at a time and compares the
+indexed search with a plain scan over the same text. Run from the console,
+e.g.,
+
+   require "utils.benchmark.search"
+--]]
+local queries = {
+   "laser",
+   "ion cannon",
+   "shield",
+   "fighter bay",
+   "za", -- Too short for the index
+   "xyzzy", -- No matches
+}
+
+-- Gets the prefixes typed while entering a string
+local function keystrokes( str )
+   local t = {}
+   for i=1,utf8.len(str) do
+      t[#t+1] = str:sub( 1, utf8.offset( str, i+1 )-1 )
+   end
+   return t
+end
+
+local function bench( name, func )
+   local nsearch = 0
+   local nfound = 0
+   local tstart = naev.clock()
+   for _k,q in ipairs(queries) do
+      for _j,s in ipairs(keystrokes(q)) do
+         nfound = nfound + #func(s)
+         nsearch = nsearch + 1
+      end
+   end
+   local elapsed = naev.clock()-tstart
+   print(string.format("%-20s %5d searches %8.3f ms each %8d results", name, nsearch, elapsed*1000/nsearch, nfound))
+end
+
+-- Plain scan regenerating the text every search like it was done before the index
+local function scan( list, getText )
+   return function( str )
+      local s = string.lower(str)
+      local r = {}
+      for _k,v in ipairs(list) do
+         if string.find( string.lower( getText(v) ), s, 1, true ) then
+            r[#r+1] = v
+         end
+      end
+      return r
+   end
+end
+
+print("====== BENCHMARK START ======")
+local outfits = outfit.getAll()
+local ships = ship.getAll()
+print(string.format("%d outfits, %d ships", #outfits, #ships))
+
+-- First search includes building the Lua generated part of the index
+local tstart = naev.clock()
+outfit.search( "a", true )
+print(string.format("First full outfit search: %.3f ms", (naev.clock()-tstart)*1000))
+
+bench( "outfit names", function (s) return outfit.search( s ) end )
+bench( "outfit full text", function (s) return outfit.search( s, true ) end )
+bench( "ship full text", function (s) return ship.search( s ) end )
+bench( "outfit names (scan)", scan( outfits, function (o) return o:name() end ) )
+bench( "outfit full (scan)", scan( outfits, function (o)
+   return o:name().."\n"..o:description().."\n"..o:summary()
+end ) )
+print("====== BENCHMARK END ======")
@@ -0,0 +1,46 @@
+--[[
+Micro-benchmark of the ship stats, recomputing the stats of fully fitted
+capital ships and looking stats up by name like the AI and outfit scripts do.
+Run from the console while in space, e.g.,
+
+   require "utils.benchmark.shipstats"
+--]]
+local vec2 = require "vec2"
+
+local ncalc = 1e4
+local nlookup = 1e5
+local ships = {
+   { "Empire Peacemaker", "Empire" },
+   { "Dvaered Goddard", "Dvaered" },
+   { "Pirate Kestrel", "Pirate" },
+}
+local stats = {
+   "speed_mod", "armour", "fwd_damage", "tur_firerate", "ew_detect",
+   "jam_chance", "cargo", "misc_instant_jump",
+}
+
+local function bench( name, n, func )
+   local tstart = naev.clock()
+   func()
+   local elapsed = naev.clock()-tstart
+   print(string.format("%-32s %8.3f ms %8.3f us each", name, elapsed*1000, elapsed*1e6/n))
+end
+
+print("====== BENCHMARK START ======")
+local pos = player.pos() + vec2.new( 30e3, 0 )
+for _k,s in ipairs(ships) do
+   local p = pilot.add( s[1], s[2], pos, nil, {ai="dummy"} )
+   print(string.format("%s with %d outfits", s[1], #p:outfitsList()))
+   bench( "calcStats", ncalc, function ()
+      for _i=1,ncalc do
+         p:calcStats()
+      end
+   end )
+   bench( "shipstat", nlookup, function ()
+      for i=1,nlookup do
+         p:shipstat( stats[ i % #stats + 1 ] )
+      end
+   end )
+   p:rm()
+end
+print("====== BENCHMARK END ======")
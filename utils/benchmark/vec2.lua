@@ -0,0 +1,72 @@
+--[[
+Micro-benchmark of the vec2 Lua API comparing operators and methods, which
+create a new vector every time, with the in-place methods and scalar
+accessors. Run from
+the console while in space, e.g.,
+
+   require "utils.benchmark.vec2"
+--]]
+local vec2 = require "vec2"
+
+local nops = 1e6
+
+local function bench( name, func )
+   collectgarbage("collect")
+   collectgarbage("stop")
+   local mem = collectgarbage("count")
+   local tstart = naev.clock()
+   func()
+   local elapsed = naev.clock()-tstart
+   local alloc = collectgarbage("count")-mem
+   collectgarbage("restart")
+   print(string.format("%-16s %8.3f s %10.1f KiB", name, elapsed, alloc))
+end
+
+print("====== BENCHMARK START ======")
+print(string.format("%d operations each", nops))
+local a = vec2.new( 1, 2 )
+local b = vec2.new( 3, 4 )
+bench( "operator +", function ()
+   local v = vec2.new()
+   for _i=1,nops do
+      v = a + b
+   end
+   return v
+end )
+bench( "method add", function ()
+   local v = vec2.new()
+   for _i=1,nops do
+      v:add( b )
+   end
+   return v
+end )
+bench( "method addi", function ()
+   local v = vec2.new()
+   for _i=1,nops do
+      v:addi( b )
+   end
+   return v
+end )
+bench( "addi x,y", function ()
+   local v = vec2.new()
+   for _i=1,nops do
+      v:addi( 1, 1 )
+   end
+   return v
+end )
+local p = player.pilot()
+bench( "pilot:pos()", function ()
+   local x = 0
+   for _i=1,nops do
+      x = x + p:pos():get()
+   end
+   return x
+end )
+bench( "pilot:posXY()", function ()
+   local x = 0
+   for _i=1,nops do
+      x = x + p:posXY()
+   end
+   return x
+end )
+print("====== BENCHMARK END ======")